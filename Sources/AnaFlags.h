@@ -32,6 +32,7 @@ enum AnaFlags
 	MOTION_IS_BACKWARD         = 0x00000040,
 	MOTION_SMALLEST_PLANE      = 0x00000080,
 //	MOTION_COMPENSATE_LUMA     = 0x00000100,
+	MOTION_PACKED_VECTORS      = 0x00000100, // MVPackedVectors format of the vector data
 //	MOTION_COMPENSATE_CHROMA_U = 0x00000200,
 //	MOTION_COMPENSATE_CHROMA_V = 0x00000400,
 	MOTION_USE_CHROMA_MOTION   = 0x00000800,
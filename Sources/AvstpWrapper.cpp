@@ -36,6 +36,7 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
  #include "AvstpFinder.h"
 #endif
 #include "AvstpWrapper.h"
+#include "ThreadPool.h"
 
 #if defined (_MSC_VER)
  #include "Windows.h"
@@ -61,6 +62,9 @@ Name: dtor
 
 AvstpWrapper::~AvstpWrapper ()
 {
+	_pool_ptr = 0;
+	_pool_uptr.reset ();
+
 #if defined (_MSC_VER)
 	::FreeLibrary (reinterpret_cast < ::HMODULE> (_dll_hnd));
 	_dll_hnd = 0;
@@ -158,17 +162,18 @@ AvstpWrapper::AvstpWrapper ()
 		0
 #endif
 	)
+,	_pool_uptr ()
 {
 #if defined (_MSC_VER)
 	if (_dll_hnd == 0)
 	{
 		::OutputDebugStringW (
-			L"AvstpWrapper: cannot find avstp.dll."
-			L"Usage restricted to single threading.\n"
+			L"AvstpWrapper: cannot find avstp.dll. "
+			L"Using the built-in thread pool.\n"
 		);
 //		throw std::runtime_error ("Cannot find avstp.dll.");
 #endif
-		assign_fallback ();
+		assign_builtin ();
 #if defined (_MSC_VER)
 	}
 
@@ -219,6 +224,43 @@ void	AvstpWrapper::assign_normal ()
 
 
 
+// Falls back to single threading if the pool is disabled or cannot be
+// started.
+void	AvstpWrapper::assign_builtin ()
+{
+	const int      nbr_threads = ThreadPool::get_nbr_threads_from_env ();
+	if (nbr_threads > 1)
+	{
+		try
+		{
+			_pool_uptr.reset (
+				new ThreadPool (nbr_threads, ThreadPool::get_pin_flag_from_env ())
+			);
+		}
+		catch (...)
+		{
+			_pool_uptr.reset ();
+		}
+	}
+
+	if (_pool_uptr.get () == 0)
+	{
+		assign_fallback ();
+	}
+	else
+	{
+		_pool_ptr = _pool_uptr.get ();
+		_avstp_get_interface_version_ptr = &fallback_get_interface_version_ptr;
+		_avstp_create_dispatcher_ptr     = &builtin_create_dispatcher_ptr;
+		_avstp_destroy_dispatcher_ptr    = &builtin_destroy_dispatcher_ptr;
+		_avstp_get_nbr_threads_ptr       = &builtin_get_nbr_threads_ptr;
+		_avstp_enqueue_task_ptr          = &builtin_enqueue_task_ptr;
+		_avstp_wait_completion_ptr       = &builtin_wait_completion_ptr;
+	}
+}
+
+
+
 void	AvstpWrapper::assign_fallback ()
 {
 	_avstp_get_interface_version_ptr = &fallback_get_interface_version_ptr;
@@ -231,6 +273,51 @@ void	AvstpWrapper::assign_fallback ()
 
 
 
+avstp_TaskDispatcher *	AvstpWrapper::builtin_create_dispatcher_ptr ()
+{
+	assert (_pool_ptr != 0);
+
+	return (_pool_ptr->create_dispatcher ());
+}
+
+
+
+void	AvstpWrapper::builtin_destroy_dispatcher_ptr (avstp_TaskDispatcher *td_ptr)
+{
+	assert (_pool_ptr != 0);
+
+	_pool_ptr->destroy_dispatcher (td_ptr);
+}
+
+
+
+int	AvstpWrapper::builtin_get_nbr_threads_ptr ()
+{
+	assert (_pool_ptr != 0);
+
+	return (_pool_ptr->get_nbr_threads ());
+}
+
+
+
+int	AvstpWrapper::builtin_enqueue_task_ptr (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr)
+{
+	assert (_pool_ptr != 0);
+
+	return (_pool_ptr->enqueue_task (td_ptr, task_ptr, user_data_ptr));
+}
+
+
+
+int	AvstpWrapper::builtin_wait_completion_ptr (avstp_TaskDispatcher *td_ptr)
+{
+	assert (_pool_ptr != 0);
+
+	return (_pool_ptr->wait_completion (td_ptr));
+}
+
+
+
 int	AvstpWrapper::fallback_get_interface_version_ptr ()
 {
 	return (avstp_INTERFACE_VERSION);
@@ -295,6 +382,7 @@ int	AvstpWrapper::fallback_wait_completion_ptr (avstp_TaskDispatcher *td_ptr)
 
 
 int	AvstpWrapper::_dummy_dispatcher;
+ThreadPool *	AvstpWrapper::_pool_ptr = 0;
 
 
 
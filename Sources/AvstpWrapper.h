@@ -6,7 +6,8 @@
 A convenient wrapper on top of the AVSTP low-level API.
 Take care of:
 - Library discovery and initialisation
-- Fallback to mono-threaded mode if not found
+- Fallback to the built-in ThreadPool if not found, or to mono-threaded
+  mode if the pool is disabled (MVTOOLS_THREADS=1, see ThreadPool.h)
 
 This is a singleton, you cannot construct it directly. Use use_instance()
 to access it from anywhere.
@@ -40,6 +41,11 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 
 #include "avstp.h"
 
+#include <memory>
+
+
+
+class ThreadPool;
 
 
 class AvstpWrapper
@@ -81,8 +87,16 @@ private:
 	void           resolve_name (T &fnc_ptr, const char *name_0);
 
 	void           assign_normal ();
+	void           assign_builtin ();
 	void           assign_fallback ();
 
+	static avstp_TaskDispatcher *
+	               builtin_create_dispatcher_ptr ();
+	static void    builtin_destroy_dispatcher_ptr (avstp_TaskDispatcher *td_ptr);
+	static int     builtin_get_nbr_threads_ptr ();
+	static int     builtin_enqueue_task_ptr (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr);
+	static int     builtin_wait_completion_ptr (avstp_TaskDispatcher *td_ptr);
+
 	static int     fallback_get_interface_version_ptr ();
 	static avstp_TaskDispatcher *
 	               fallback_create_dispatcher_ptr ();
@@ -101,7 +115,12 @@ private:
 
 	void *         _dll_hnd;	// Avoids loading windows.h just for HMODULE
 
+	std::unique_ptr <ThreadPool>
+	               _pool_uptr;
+
 	static int     _dummy_dispatcher;
+	static ThreadPool *
+	               _pool_ptr;	// For the static builtin_* functions
 
 
 
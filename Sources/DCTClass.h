@@ -32,7 +32,7 @@ public:
     int bits_per_pixel;
 
 //	DCTClass(int _sizex, int _sizey, int _dctshift0extra);
-//	~DCTClass();
+  virtual ~DCTClass() {}
   virtual void DCTBytes2D(const unsigned char *srcp0, int _src_pitch, unsigned char *dctp, int _dct_pitch) = 0;
 
 };
@@ -29,6 +29,7 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 #include	"DCTFactory.h"
 #include	"DCTFFTW.h"
 #include	"DCTINT.h"
+#include	"DCTSEP.h"
 
 #include	<cassert>
 
@@ -42,22 +43,27 @@ DCTFactory::DCTFactory(int dctmode, bool isse, int blksizex, int blksizey, int p
   , _blksizex(blksizex)
   , _blksizey(blksizey)
 #ifdef USE_FDCT88INT_ASM
-  , _fftw_flag(!(_isse && _blksizex == 8 && _blksizey == 8 && pixelsize == 1)) // only 8x8 is implemented as an int FFT
+  , _int_flag(_isse && _blksizex == 8 && _blksizey == 8 && pixelsize == 1) // only 8x8 is implemented as an int FFT
 #else
-  , _fftw_flag(false)
+  , _int_flag(false)
 #endif
+  , _sep_flag(!_int_flag && _isse && DCTSEP::is_supported(blksizex, blksizey, pixelsize, env.GetCPUFlags()))
+  , _fftw_flag(!_int_flag && !_sep_flag)
   , _pixelsize(pixelsize)
   , _bits_per_pixel(bits_per_pixel)
 
 {
   assert(dctmode != 0);
   
-  try {
-    fftfp.load(0); // no existing, load library
-  }
-  catch (const std::exception& e)
+  if (_fftw_flag)
   {
-    throw AvisynthError(e.what());
+    try {
+      fftfp.load(0); // no existing, load library
+    }
+    catch (const std::exception& e)
+    {
+      throw AvisynthError(e.what());
+    }
   }
 
   cpuflags = env.GetCPUFlags();
@@ -99,15 +105,16 @@ bool	DCTFactory::use_fftw() const
 DCTClass *	DCTFactory::do_create()
 {
 #ifdef USE_FDCT88INT_ASM
-  if (_fftw_flag)
+  if (_int_flag)
   {
-    return (new DCTFFTW(_blksizex, _blksizey, fftfp,  _dctmode, _pixelsize, _bits_per_pixel, cpuflags));
+    return (new DCTINT(_blksizex, _blksizey, _dctmode));
   }
-  return (new DCTINT(_blksizex, _blksizey, _dctmode));
-#else
-  // no integer asm 8x8 DCT
-  return (new DCTFFTW(_blksizex, _blksizey, fftfp, _dctmode, _pixelsize, _bits_per_pixel, cpuflags));
 #endif
+  if (_sep_flag)
+  {
+    return (new DCTSEP(_blksizex, _blksizey, _dctmode, _pixelsize, _bits_per_pixel));
+  }
+  return (new DCTFFTW(_blksizex, _blksizey, fftfp, _dctmode, _pixelsize, _bits_per_pixel, cpuflags));
 }
 
 
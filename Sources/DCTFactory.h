@@ -69,6 +69,8 @@ private:
   const int _blksizex;
   const int _blksizey;
   const bool _isse;
+  const bool _int_flag; // DCTINT, 8x8 8-bit asm
+  const bool _sep_flag; // DCTSEP
   const bool _fftw_flag;
   const int _pixelsize; // PF
   const int _bits_per_pixel;
@@ -0,0 +1,87 @@
+// Separable float DCT-II as two matrix products, AVX2
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "DCTSEP.h"
+#include <avisynth.h>
+#include <cmath>
+#include <cassert>
+#include "types.h"
+#include "def.h"
+
+static DCTSEPFunction *get_dctsep_function(int BlockX, int pixelsize)
+{
+  const bool is8 = (pixelsize == 1);
+  switch (BlockX)
+  {
+  case 64: return is8 ? DCT_Separable_avx2<uint8_t, 64> : DCT_Separable_avx2<uint16_t, 64>;
+  case 48: return is8 ? DCT_Separable_avx2<uint8_t, 48> : DCT_Separable_avx2<uint16_t, 48>;
+  case 32: return is8 ? DCT_Separable_avx2<uint8_t, 32> : DCT_Separable_avx2<uint16_t, 32>;
+  case 24: return is8 ? DCT_Separable_avx2<uint8_t, 24> : DCT_Separable_avx2<uint16_t, 24>;
+  case 16: return is8 ? DCT_Separable_avx2<uint8_t, 16> : DCT_Separable_avx2<uint16_t, 16>;
+  case 12: return is8 ? DCT_Separable_avx2<uint8_t, 12> : DCT_Separable_avx2<uint16_t, 12>;
+  case 8: return is8 ? DCT_Separable_avx2<uint8_t, 8> : DCT_Separable_avx2<uint16_t, 8>;
+  case 4: return is8 ? DCT_Separable_avx2<uint8_t, 4> : DCT_Separable_avx2<uint16_t, 4>;
+  default: return nullptr;
+  }
+}
+
+bool DCTSEP::is_supported(int _sizex, int _sizey, int _pixelsize, int cpu)
+{
+  return (cpu & CPUF_AVX2) != 0 && (cpu & CPUF_FMA3) != 0
+    && (_pixelsize == 1 || _pixelsize == 2)
+    && _sizey >= 1 && _sizey <= MAX_BLOCK_SIZE
+    && get_dctsep_function(_sizex, _pixelsize) != nullptr;
+}
+
+DCTSEP::DCTSEP(int _sizex, int _sizey, int _dctmode, int _pixelsize, int _bits_per_pixel)
+{
+  // members of the DCTClass
+  sizex = _sizex;
+  sizey = _sizey;
+  dctmode = _dctmode;
+  pixelsize = _pixelsize;
+  bits_per_pixel = _bits_per_pixel;
+
+  DCTPROC = get_dctsep_function(sizex, pixelsize);
+  assert(DCTPROC != nullptr);
+
+  // see DCTFFTW: 1/sqrt(2) / size2d for AC, 0.5 / 4 / size2d for DC
+  const int size2d = sizey * sizex;
+  const double normAC = 0.70710678118654752440084436210485 / size2d;
+  const double normDC = 0.5 / 4.0 / size2d;
+  fNormDC = float(normDC / normAC);
+
+  // FFTW_REDFT10: Y[k] = 2 * sum(n) X[n] * cos(pi * k * (2n + 1) / (2N))
+  const double pi = 3.14159265358979323846;
+  fCosY.resize(sizey * sizey);
+  for (int k = 0; k < sizey; k++)
+    for (int n = 0; n < sizey; n++)
+      fCosY[k * sizey + n] = float(2 * cos(pi * k * (2 * n + 1) / (2 * sizey)));
+  fCosXT.resize(sizex * sizex);
+  for (int n = 0; n < sizex; n++)
+    for (int k = 0; k < sizex; k++)
+      fCosXT[n * sizex + k] = float(2 * cos(pi * k * (2 * n + 1) / (2 * sizex)) * normAC);
+
+  fSrc.resize(size2d);
+  fTmp.resize(size2d);
+}
+
+void DCTSEP::DCTBytes2D(const unsigned char *srcp, int src_pitch, unsigned char *dctp, int dct_pitch)
+{
+  DCTPROC(srcp, src_pitch, dctp, dct_pitch, sizey, fCosY.data(), fCosXT.data(), fSrc.data(), fTmp.data(), fNormDC, bits_per_pixel);
+}
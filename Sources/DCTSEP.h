@@ -0,0 +1,46 @@
+// Separable float DCT-II as two matrix products, AVX2
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __MV_DCTSEP__
+#define __MV_DCTSEP__
+
+#include <vector>
+#include "DCTClass.h"
+#include "DCTSEP_avx2.h"
+
+// Same output as DCTFFTW (FFTW REDFT10 in both directions, same AC and DC
+// normalization), up to the float rounding. No plan, no FFTW library, no mutex.
+class DCTSEP
+  : public DCTClass
+{
+  std::vector<float> fCosY;  // sizey x sizey, DCT-II basis of the columns
+  std::vector<float> fCosXT; // sizex x sizex, transposed basis of the rows, AC normalization included
+  std::vector<float> fSrc;   // sizey x sizex
+  std::vector<float> fTmp;   // sizey x sizex, after the column pass
+  float fNormDC; // DC normalization relative to the AC one
+
+  DCTSEPFunction *DCTPROC;
+
+public:
+  DCTSEP(int _sizex, int _sizey, int _dctmode, int _pixelsize, int _bits_per_pixel);
+  void DCTBytes2D(const unsigned char *srcp0, int _src_pitch, unsigned char *dctp, int _dct_pitch);
+
+  static bool is_supported(int _sizex, int _sizey, int _pixelsize, int cpu);
+};
+
+#endif
@@ -0,0 +1,178 @@
+// Separable float DCT-II kernels, AVX2 + FMA
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#if defined (__GNUC__) && ! defined (__INTEL_COMPILER) && ! defined(__INTEL_LLVM_COMPILER)
+#include <x86intrin.h>
+// x86intrin.h includes header files for whatever instruction
+// sets are specified on the compiler command line, such as: xopintrin.h, fma4intrin.h
+#else
+#include <immintrin.h> // MS version of immintrin.h covers AVX, AVX2 and FMA3
+#endif // __GNUC__
+
+#include "DCTSEP_avx2.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include "def.h"
+
+// A row of nBlkSizeX floats is nBlkSizeX / 8 ymm registers, plus one xmm for the mod4 widths.
+// The loops over the registers of a row are unrolled at compile time so that the
+// accumulators stay in registers.
+template<typename F, int... j>
+static MV_FORCEINLINE void for_each_ymm(F &&f, std::integer_sequence<int, j...>)
+{
+  (f(j), ...);
+}
+
+template<int n8, typename F>
+static MV_FORCEINLINE void for_each_ymm(F &&f)
+{
+  for_each_ymm(f, std::make_integer_sequence<int, n8>());
+}
+
+template<typename pixel_t>
+static MV_FORCEINLINE __m256 load_pixels8(const pixel_t *p)
+{
+  if constexpr (sizeof(pixel_t) == 1)
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+  else
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))));
+}
+
+template<typename pixel_t>
+static MV_FORCEINLINE __m128 load_pixels4(const pixel_t *p)
+{
+  if constexpr (sizeof(pixel_t) == 1)
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(*reinterpret_cast<const int *>(p))));
+  else
+    return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+}
+
+// rounded, + middle pixel value, clamped
+template<typename pixel_t>
+static MV_FORCEINLINE void store_pixels8(pixel_t *p, __m256 v, __m256i half, __m128i max_pixel_value)
+{
+  const __m256i i = _mm256_add_epi32(_mm256_cvtps_epi32(v), half);
+  const __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+  if constexpr (sizeof(pixel_t) == 1)
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(w, w));
+  else
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_min_epu16(w, max_pixel_value));
+}
+
+template<typename pixel_t>
+static MV_FORCEINLINE void store_pixels4(pixel_t *p, __m128 v, __m128i half, __m128i max_pixel_value)
+{
+  const __m128i i = _mm_add_epi32(_mm_cvtps_epi32(v), half);
+  const __m128i w = _mm_packus_epi32(i, i);
+  if constexpr (sizeof(pixel_t) == 1)
+    *reinterpret_cast<int *>(p) = _mm_cvtsi128_si32(_mm_packus_epi16(w, w));
+  else
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_min_epu16(w, max_pixel_value));
+}
+
+template<typename pixel_t, int nBlkSizeX>
+void DCT_Separable_avx2(const uint8_t *pSrc8, int nSrcPitch, uint8_t *pDst8, int nDstPitch,
+  int nBlkSizeY, const float *pCosY, const float *pCosXT, float *pSrc, float *pTmp, float fNormDC, int bits_per_pixel)
+{
+  constexpr int n8 = nBlkSizeX / 8;
+  constexpr bool mod4 = (nBlkSizeX % 8) != 0;
+  static_assert(nBlkSizeX % 4 == 0 && nBlkSizeX <= 64, "DCT_Separable_avx2: unsupported width");
+
+  // pixels to float
+  for (int y = 0; y < nBlkSizeY; y++)
+  {
+    const pixel_t *pS = reinterpret_cast<const pixel_t *>(pSrc8 + nSrcPitch * y);
+    float *pF = pSrc + nBlkSizeX * y;
+    for_each_ymm<n8>([&](int j) { _mm256_storeu_ps(pF + j * 8, load_pixels8(pS + j * 8)); });
+    if constexpr (mod4)
+      _mm_storeu_ps(pF + n8 * 8, load_pixels4(pS + n8 * 8));
+  }
+
+  // columns: pTmp[k] = sum(n) CosY[k][n] * pSrc[n]
+  for (int k = 0; k < nBlkSizeY; k++)
+  {
+    __m256 acc[n8 > 0 ? n8 : 1];
+    __m128 acc4 = _mm_setzero_ps();
+    for_each_ymm<n8>([&](int j) { acc[j] = _mm256_setzero_ps(); });
+    const float *pC = pCosY + nBlkSizeY * k;
+    for (int n = 0; n < nBlkSizeY; n++)
+    {
+      const float *pF = pSrc + nBlkSizeX * n;
+      const __m256 c = _mm256_broadcast_ss(pC + n);
+      for_each_ymm<n8>([&](int j) { acc[j] = _mm256_fmadd_ps(c, _mm256_loadu_ps(pF + j * 8), acc[j]); });
+      if constexpr (mod4)
+        acc4 = _mm_fmadd_ps(_mm256_castps256_ps128(c), _mm_loadu_ps(pF + n8 * 8), acc4);
+    }
+    float *pT = pTmp + nBlkSizeX * k;
+    for_each_ymm<n8>([&](int j) { _mm256_storeu_ps(pT + j * 8, acc[j]); });
+    if constexpr (mod4)
+      _mm_storeu_ps(pT + n8 * 8, acc4);
+  }
+
+  // rows: out[k] = sum(m) pTmp[k][m] * CosXT[m], then to pixels
+  const int maxPixelValue = (1 << bits_per_pixel) - 1;
+  const int middlePixelValue = 1 << (bits_per_pixel - 1);
+  const __m256i half = _mm256_set1_epi32(middlePixelValue);
+  const __m128i max_pixel_value = _mm_set1_epi16((short)maxPixelValue);
+  float fDC = 0;
+
+  for (int k = 0; k < nBlkSizeY; k++)
+  {
+    __m256 acc[n8 > 0 ? n8 : 1];
+    __m128 acc4 = _mm_setzero_ps();
+    for_each_ymm<n8>([&](int j) { acc[j] = _mm256_setzero_ps(); });
+    const float *pT = pTmp + nBlkSizeX * k;
+    for (int m = 0; m < nBlkSizeX; m++)
+    {
+      const float *pC = pCosXT + nBlkSizeX * m;
+      const __m256 t = _mm256_broadcast_ss(pT + m);
+      for_each_ymm<n8>([&](int j) { acc[j] = _mm256_fmadd_ps(t, _mm256_loadu_ps(pC + j * 8), acc[j]); });
+      if constexpr (mod4)
+        acc4 = _mm_fmadd_ps(_mm256_castps256_ps128(t), _mm_loadu_ps(pC + n8 * 8), acc4);
+    }
+    if (k == 0)
+      fDC = (n8 > 0) ? _mm256_cvtss_f32(acc[0]) : _mm_cvtss_f32(acc4);
+
+    pixel_t *pD = reinterpret_cast<pixel_t *>(pDst8 + nDstPitch * k);
+    for_each_ymm<n8>([&](int j) { store_pixels8(pD + j * 8, acc[j], half, max_pixel_value); });
+    if constexpr (mod4)
+      store_pixels4(pD + n8 * 8, acc4, _mm256_castsi256_si128(half), max_pixel_value);
+  }
+
+  // DC is truncated like in DCTFFTW, to be compatible with integer DCTINT8
+  reinterpret_cast<pixel_t *>(pDst8)[0] = (pixel_t)std::min(maxPixelValue, std::max(0, int(fDC * fNormDC) + middlePixelValue));
+
+  _mm256_zeroupper();
+}
+
+// instantiate
+#define MAKE_FN(x) \
+template void DCT_Separable_avx2<uint8_t, x>(const uint8_t *, int, uint8_t *, int, int, const float *, const float *, float *, float *, float, int); \
+template void DCT_Separable_avx2<uint16_t, x>(const uint8_t *, int, uint8_t *, int, int, const float *, const float *, float *, float *, float, int);
+
+MAKE_FN(64)
+MAKE_FN(48)
+MAKE_FN(32)
+MAKE_FN(24)
+MAKE_FN(16)
+MAKE_FN(12)
+MAKE_FN(8)
+MAKE_FN(4)
+#undef MAKE_FN
@@ -0,0 +1,34 @@
+// Separable float DCT-II kernels, AVX2 + FMA
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __MV_DCTSEP_AVX2__
+#define __MV_DCTSEP_AVX2__
+
+#include <stdint.h>
+
+// pCosY: nBlkSizeY x nBlkSizeY, pCosXT: nBlkSizeX x nBlkSizeX, already scaled by the AC normalization.
+// pSrc and pTmp: nBlkSizeY x nBlkSizeX floats. fNormDC is applied on top of the AC one.
+typedef void (DCTSEPFunction)(const uint8_t *pSrc8, int nSrcPitch, uint8_t *pDst8, int nDstPitch,
+  int nBlkSizeY, const float *pCosY, const float *pCosXT, float *pSrc, float *pTmp, float fNormDC, int bits_per_pixel);
+
+// nBlkSizeX: 4, 8, 12, 16, 24, 32, 48 or 64, any nBlkSizeY up to 64
+template<typename pixel_t, int nBlkSizeX>
+void DCT_Separable_avx2(const uint8_t *pSrc8, int nSrcPitch, uint8_t *pDst8, int nDstPitch,
+  int nBlkSizeY, const float *pCosY, const float *pCosXT, float *pSrc, float *pTmp, float fNormDC, int bits_per_pixel);
+
+#endif
@@ -1,7 +1,9 @@
-#include "SSIMFunctions.h"
+#include "DWTFunctions.h"
+#include "DisMetric_avx2.h"
 #include "overlap.h"
 #include <map>
 #include <tuple>
+#include <type_traits>
 #include <stdint.h>
 #include "def.h"
 #include <immintrin.h>
@@ -83,10 +85,10 @@ static void DWT_C(const uint8_t* pSrc, int nSrcPitch, void* pA, void* pV, void*
 template<int nBlkWidth, int nBlkHeight, typename pixel_t>
 static void DWT_C(const uint8_t* pSrc, int nSrcPitch, void* pA, void* pV, void* pH, void* pD)
 {
-#define A pSrc[(iVP * 2) * nSrcPitch + iHP * 2]
-#define B pSrc[(iVP * 2) * nSrcPitch + iHP * 2 + 1]
-#define C pSrc[(((iVP * 2) + 1) * nSrcPitch) + iHP * 2 + 0]
-#define D pSrc[(((iVP * 2) + 1) * nSrcPitch) + iHP * 2 + 1]
+#define A reinterpret_cast<const pixel_t*>(pSrc + (iVP * 2) * nSrcPitch)[iHP * 2]
+#define B reinterpret_cast<const pixel_t*>(pSrc + (iVP * 2) * nSrcPitch)[iHP * 2 + 1]
+#define C reinterpret_cast<const pixel_t*>(pSrc + ((iVP * 2) + 1) * nSrcPitch)[iHP * 2 + 0]
+#define D reinterpret_cast<const pixel_t*>(pSrc + ((iVP * 2) + 1) * nSrcPitch)[iHP * 2 + 1]
 
   typedef typename std::conditional < sizeof(pixel_t) <= 2, int, float >::type target_t_dwt;
 
@@ -163,7 +165,11 @@ static void DWT_C(const uint8_t* pSrc, int nSrcPitch, void* pA, void* pV, void*
   }
 
 }
-
+
+#undef A
+#undef B
+#undef C
+#undef D
 
 DWT2DFunction* get_dwt_function(int BlockX, int BlockY, int bits_per_pixel, arch_t arch)
 {
@@ -176,19 +182,66 @@ DWT2DFunction* get_dwt_function(int BlockX, int BlockY, int bits_per_pixel, arch
   // BlkSizeX, BlkSizeY, bits_per_pixel, arch_t
   std::map<std::tuple<int, int, int, arch_t>, DWT2DFunction*> func_sad;
 #define MAKE_FN(x, y) func_sad[make_tuple(x, y, 8, NO_SIMD)] = DWT_C<x, y, uint8_t>; \
-func_sad[make_tuple(x, y, 16, NO_SIMD)] = DWT_C<x, y, uint16_t>;
-  // match with CopyCode.cpp and Overlap.cpp, and luma (variance.cpp) list
-  MAKE_FN(64, 64)
-    MAKE_FN(32, 32)
-    MAKE_FN(16, 16)
-    MAKE_FN(8, 8)
-    MAKE_FN(4, 4)
+func_sad[make_tuple(x, y, 16, NO_SIMD)] = DWT_C<x, y, uint16_t>; \
+func_sad[make_tuple(x, y, 32, NO_SIMD)] = DWT_C<x, y, float>;
+#define MAKE_AVX2_FN(x, y) MAKE_FN(x, y) \
+func_sad[make_tuple(x, y, 8, USE_AVX2)] = DWT_avx2<x, y, uint8_t>; \
+func_sad[make_tuple(x, y, 16, USE_AVX2)] = DWT_avx2<x, y, uint16_t>; \
+func_sad[make_tuple(x, y, 32, USE_AVX2)] = DWT_avx2<x, y, float>;
+  // match with VIFFunctions.cpp, AVX2 for even sizes
+  MAKE_AVX2_FN(64, 64)
+    MAKE_AVX2_FN(64, 48)
+    MAKE_AVX2_FN(64, 32)
+    MAKE_AVX2_FN(64, 16)
+    MAKE_AVX2_FN(48, 64)
+    MAKE_AVX2_FN(48, 48)
+    MAKE_AVX2_FN(48, 24)
+    MAKE_AVX2_FN(48, 12)
+    MAKE_AVX2_FN(32, 64)
+    MAKE_AVX2_FN(32, 32)
+    MAKE_AVX2_FN(32, 24)
+    MAKE_AVX2_FN(32, 16)
+    MAKE_AVX2_FN(32, 8)
+    MAKE_AVX2_FN(24, 48)
+    MAKE_AVX2_FN(24, 32)
+    MAKE_AVX2_FN(24, 24)
+    MAKE_AVX2_FN(24, 12)
+    MAKE_AVX2_FN(24, 6)
+    MAKE_AVX2_FN(16, 64)
+    MAKE_AVX2_FN(16, 32)
+    MAKE_AVX2_FN(16, 16)
+    MAKE_AVX2_FN(16, 12)
+    MAKE_AVX2_FN(16, 8)
+    MAKE_AVX2_FN(16, 4)
+    MAKE_AVX2_FN(16, 2)
+    MAKE_FN(16, 1)
+    MAKE_AVX2_FN(12, 48)
+    MAKE_AVX2_FN(12, 24)
+    MAKE_AVX2_FN(12, 16)
+    MAKE_AVX2_FN(12, 12)
+    MAKE_AVX2_FN(12, 6)
+    MAKE_FN(12, 3)
+    MAKE_AVX2_FN(8, 32)
+    MAKE_AVX2_FN(8, 16)
+    MAKE_AVX2_FN(8, 8)
+    MAKE_AVX2_FN(8, 4)
+    MAKE_AVX2_FN(8, 2)
+    MAKE_FN(8, 1)
+    MAKE_AVX2_FN(6, 24)
+    MAKE_AVX2_FN(6, 12)
+    MAKE_AVX2_FN(6, 6)
+    MAKE_FN(6, 3)
+    MAKE_AVX2_FN(4, 8)
+    MAKE_AVX2_FN(4, 4)
+    MAKE_AVX2_FN(4, 2)
+    MAKE_FN(4, 1)
+    MAKE_FN(3, 6)
+    MAKE_FN(3, 3)
+    MAKE_AVX2_FN(2, 4)
+    MAKE_AVX2_FN(2, 2)
+    MAKE_FN(2, 1)
+#undef MAKE_AVX2_FN
 #undef MAKE_FN
-
-  // AVX2
-//  func_sad[make_tuple(16, 16, 8, USE_AVX2)] = mvt_ssim_full_16x16_8_avx2; 
-//  func_sad[make_tuple(8, 8, 8, USE_AVX2)] = mvt_ssim_l_8x8_8_avx2;
-//  func_sad[make_tuple(4, 4, 8, USE_AVX2)] = mvt_ssim_l_4x4_8_avx2;
 
   DWT2DFunction* result = nullptr;
   arch_t archlist[] = { USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
@@ -17,6 +17,7 @@
 
 #include "DisMetric.h"
 #include "Math.h"
+#include <algorithm>
 
 DisMetric::DisMetric(int iBlkSizeX, int iBlkSizeY, int iBPP, int _pixelsize, arch_t _arch, int metric_flags)
 {
@@ -27,48 +28,28 @@ DisMetric::DisMetric(int iBlkSizeX, int iBlkSizeY, int iBPP, int _pixelsize, arc
   nMetricFlags = metric_flags;
   pixelsize = _pixelsize;
 
+  SAD = nullptr;
+  MOMENTS = nullptr;
+  MOMENTS_BATCH = nullptr;
+  VIF_FULL = nullptr;
+  VIF_FULL_BATCH = nullptr;
+  DWT2D = nullptr;
+
   if (metric_flags & MEF_SAD)
-  {
+  {
     SAD = get_sad_function(nBlkSizeX, nBlkSizeY, nBPP, arch);
   }
 
-  if (metric_flags & MEF_SSIM_L)
-  {
-    SSIM_L = get_ssim_function_l(nBlkSizeX, nBlkSizeY, nBPP, arch);
-  }
-
-  if (metric_flags & MEF_SSIM_CS)
-  {
-    SSIM_CS = get_ssim_function_cs(nBlkSizeX, nBlkSizeY, nBPP, arch);
-  }
-
-  if (metric_flags & MEF_SSIM_S)
-  {
-    SSIM_S = get_ssim_function_s(nBlkSizeX, nBlkSizeY, nBPP, arch);
-  }
-
-  if ((metric_flags & MEF_SSIM_CS) && (metric_flags & MEF_SSIM_L))
-  {
-    SSIM_FULL = get_ssim_function_full(nBlkSizeX, nBlkSizeY, nBPP, arch);
-  }
-
-  if (metric_flags & MEF_VIFA_DWT)
-  {
-    VIF_A = get_vif_function_a(nBlkSizeX, nBlkSizeY, nBPP, arch);
-  }
-
-  if (metric_flags & MEF_VIFE_DWT)
-  {
-    VIF_E = get_vif_function_e(nBlkSizeX, nBlkSizeY, nBPP, arch);
-  }
-
-  if ((metric_flags & MEF_VIFA_DWT) && (metric_flags & MEF_VIFE_DWT))
-  {
-    VIF_FULL = get_vif_function_full(nBlkSizeX, nBlkSizeY, nBPP, arch);
+  if (metric_flags & (MEF_SSIM_L | MEF_SSIM_CS | MEF_SSIM_S))
+  {
+    MOMENTS = get_moments_function(nBlkSizeX, nBlkSizeY, nBPP, arch);
+    MOMENTS_BATCH = get_moments_batch_function(nBlkSizeX, nBlkSizeY, nBPP, arch);
   }
 
-  if ((metric_flags & MEF_VIFA_DWT) || (metric_flags & MEF_VIFE_DWT))
+  if (metric_flags & (MEF_VIFA_DWT | MEF_VIFE_DWT))
   {
+    VIF_FULL = get_vif_function_full(nBlkSizeX, nBlkSizeY, nBPP, arch);
+    VIF_FULL_BATCH = get_vif_function_full_batch(nBlkSizeX, nBlkSizeY, nBPP, arch);
     DWT2D = get_dwt_function(nBlkSizeX, nBlkSizeY, nBPP, arch);
   }
 
@@ -95,59 +76,109 @@ int DisMetric::GetDisMetric(const uint8_t* pSrc, int nSrcPitch, const uint8_t* p
     iRetDisMetric += SAD(pSrc, nSrcPitch, pRef, nRefPitch);
   }
 
-  if ((nMetricFlags & MEF_SSIM_L) && !(nMetricFlags & MEF_SSIM_CS))
-  {
-    iRetDisMetric += (int)(((1.0f - SSIM_L(pSrc, nSrcPitch, pRef, nRefPitch)) * (float)(maxSAD >> 1)));
+  if (nMetricFlags & (MEF_SSIM_L | MEF_SSIM_CS | MEF_SSIM_S))
+  {
+    // single pass over the blocks for all the requested SSIM terms
+    SSIM_MOMENTS moments;
+    MOMENTS(pSrc, nSrcPitch, pRef, nRefPitch, &moments);
+    iRetDisMetric += GetSSIMDisMetric(moments);
   }
 
-  if ((nMetricFlags & MEF_SSIM_CS) && !(nMetricFlags & MEF_SSIM_L))
+  if (nMetricFlags & (MEF_VIFA_DWT | MEF_VIFE_DWT))
   {
-/*    float fCSpos_SADnorm = ((1.0f - SSIM_CS(pSrc, nSrcPitch, pRef, nRefPitch)) * (float)(maxSAD >> 1));
-    float fnorm = fCSpos_SADnorm /(float)maxSAD; // norm to 0..1
-    float fpc = powf(fnorm, 1.0f);
-    iRetDisMetric += (int)(fpc * (float)maxSAD * 0.04f);*/
-
-    iRetDisMetric += (int)(((1.0f - SSIM_CS(pSrc, nSrcPitch, pRef, nRefPitch)) * (float)(maxSAD >> 1)) * 0.04f); // SSIM may be low as -1.0f
+    // the full VIF computes both subbands in one pass, whatever the VIF flags
+    iRetDisMetric = AddVIFDisMetric(iRetDisMetric, VIF_FULL(pSrc, nSrcPitch, pRef, nRefPitch, DWT2D));
   }
 
-  if (nMetricFlags & MEF_SSIM_S)
-  {
-    iRetDisMetric += (int)(((1.0f - SSIM_S(pSrc, nSrcPitch, pRef, nRefPitch)) * (float)(maxSAD >> 1)) * 0.04f); // SSIM may be low as -1.0f
+  // todo: currently sum may be num of metrics * veryBigSAD ! may be norm max value to verybigsad ?
+
+  return iRetDisMetric;
+
+}
+
+void DisMetric::GetDisMetricBatch(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, int* pDisMetric)
+{
+  for (int i = 0; i < nRefs; i++)
+  {
+    pDisMetric[i] = (nMetricFlags & MEF_SAD) ? SAD(pSrc, nSrcPitch, ppRef[i], pRefPitch[i]) : 0;
   }
 
-  if ((nMetricFlags & MEF_SSIM_CS) && (nMetricFlags & MEF_SSIM_L))
-  {
-//    iRetDisMetric += (int)(((1.0f - SSIM_L(pSrc, nSrcPitch, pRef, nRefPitch) * SSIM_CS(pSrc, nSrcPitch, pRef, nRefPitch)) * (float)(maxSAD >> 1))); // SSIM may be low as -1.0f
-    iRetDisMetric += (int)(((1.0f - SSIM_FULL(pSrc, nSrcPitch, pRef, nRefPitch)) * (float)(maxSAD >> 1)) * 0.04f); // SSIM may be low as -1.0f
+  if (!(nMetricFlags & (MEF_SSIM_L | MEF_SSIM_CS | MEF_SSIM_S | MEF_VIFA_DWT | MEF_VIFE_DWT)))
+  {
+    return;
   }
 
-  if ((nMetricFlags & MEF_VIFA_DWT) && (nMetricFlags & MEF_VIFE_DWT))
-  {
-//    iRetDisMetric += (int)(((1.0f - VIF_FULL(pSrc, nSrcPitch, pRef, nRefPitch, DWT2D)) * (float)(maxSAD))); // VIF range ??? [0..1] forced
-    float fRetVIF = VIF_FULL(pSrc, nSrcPitch, pRef, nRefPitch, DWT2D);
-    iRetDisMetric += (int)(((1.0f - fRetVIF) * (float)(maxSAD)) * 0.02f); // VIF range ??? [0..1] forced
-    if (iRetDisMetric < 0)
+  for (int i0 = 0; i0 < nRefs; i0 += MAX_BATCH)
+  {
+    const int n = std::min(MAX_BATCH, nRefs - i0);
+
+    if (nMetricFlags & (MEF_SSIM_L | MEF_SSIM_CS | MEF_SSIM_S))
     {
-      iRetDisMetric = 0;
+      SSIM_MOMENTS moments[MAX_BATCH];
+      MOMENTS_BATCH(pSrc, nSrcPitch, ppRef + i0, pRefPitch + i0, n, moments);
+      for (int i = 0; i < n; i++)
+      {
+        pDisMetric[i0 + i] += GetSSIMDisMetric(moments[i]);
+      }
     }
 
-//    iRetDisMetric += (int)(((5.0f - VIF_FULL(pSrc, nSrcPitch, pRef, nRefPitch, DWT2D)) * (float)(maxSAD >> 2))); // VIF range ??? [0..1] ?
+    if (nMetricFlags & (MEF_VIFA_DWT | MEF_VIFE_DWT))
+    {
+      float fVIF[MAX_BATCH];
+      VIF_FULL_BATCH(pSrc, nSrcPitch, ppRef + i0, pRefPitch + i0, n, DWT2D, fVIF);
+      for (int i = 0; i < n; i++)
+      {
+        pDisMetric[i0 + i] = AddVIFDisMetric(pDisMetric[i0 + i], fVIF[i]);
+      }
+    }
   }
+}
 
-  if ((nMetricFlags & MEF_VIFA_DWT) && !(nMetricFlags & MEF_VIFE_DWT))
-  {
-    iRetDisMetric += (int)(((1.0f - VIF_FULL(pSrc, nSrcPitch, pRef, nRefPitch, DWT2D)) * (float)(maxSAD))); // VIF range ??? [0..1] forced
-//    iRetDisMetric += (int)(((5.0f - VIF_A(pSrc, nSrcPitch, pRef, nRefPitch, DWT2D)) * (float)(maxSAD >> 2))); // VIF range ??? [0..1] ?
+int DisMetric::GetSSIMDisMetric(const SSIM_MOMENTS& moments)
+{
+  int iDisMetric = 0;
+
+  SSIM_TERMS ssim;
+  SSIMTerms(moments, nBlkSizeX * nBlkSizeY, pixelsize, ssim);
+
+  if ((nMetricFlags & MEF_SSIM_L) && !(nMetricFlags & MEF_SSIM_CS))
+  {
+    iDisMetric += (int)(((1.0f - ssim.l) * (float)(maxSAD >> 1)));
   }
 
-  if (!(nMetricFlags & MEF_VIFA_DWT) && (nMetricFlags & MEF_VIFE_DWT))
-  {
-    iRetDisMetric += (int)(((1.0f - VIF_FULL(pSrc, nSrcPitch, pRef, nRefPitch, DWT2D)) * (float)(maxSAD))); // VIF range ??? [0..1] forced
-//    iRetDisMetric += (int)(((5.0f - VIF_E(pSrc, nSrcPitch, pRef, nRefPitch, DWT2D)) * (float)(maxSAD >> 2))); // VIF range ??? [0..1] ?
+  if ((nMetricFlags & MEF_SSIM_CS) && !(nMetricFlags & MEF_SSIM_L))
+  {
+    iDisMetric += (int)(((1.0f - ssim.c * ssim.s) * (float)(maxSAD >> 1)) * 0.04f); // SSIM may be low as -1.0f
   }
 
-  // todo: currently sum may be num of metrics * veryBigSAD ! may be norm max value to verybigsad ?
+  if (nMetricFlags & MEF_SSIM_S)
+  {
+    iDisMetric += (int)(((1.0f - ssim.s) * (float)(maxSAD >> 1)) * 0.04f); // SSIM may be low as -1.0f
+  }
 
-  return iRetDisMetric;
+  if ((nMetricFlags & MEF_SSIM_CS) && (nMetricFlags & MEF_SSIM_L))
+  {
+    iDisMetric += (int)(((1.0f - ssim.l * ssim.c * ssim.s) * (float)(maxSAD >> 1)) * 0.04f); // SSIM may be low as -1.0f
+  }
+
+  return iDisMetric;
+}
+
+// the VIF term is added to the other metrics, both VIF flags clamp the sum
+int DisMetric::AddVIFDisMetric(int iDisMetric, float fVIF)
+{
+  if ((nMetricFlags & MEF_VIFA_DWT) && (nMetricFlags & MEF_VIFE_DWT))
+  {
+    iDisMetric += (int)(((1.0f - fVIF) * (float)(maxSAD)) * 0.02f); // VIF range ??? [0..1] forced
+    if (iDisMetric < 0)
+    {
+      iDisMetric = 0;
+    }
+  }
+  else
+  {
+    iDisMetric += (int)(((1.0f - fVIF) * (float)(maxSAD))); // VIF range ??? [0..1] forced
+  }
 
+  return iDisMetric;
 }
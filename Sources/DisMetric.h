@@ -46,14 +46,11 @@ class DisMetric
 {
   SADFunction* SAD;  /* function which computes the sad */
 
-  SSIMFunction* SSIM_L; /* function which computes the SSIM luma only */
-  SSIMFunction* SSIM_CS; /* function which computes the SSIM contrast and structure */
-  SSIMFunction* SSIM_S; /* function which computes the SSIM structure */
-  SSIMFunction* SSIM_FULL; /* function which computes the SSIM full components (luma and contrast and structure) */
+  MOMENTSFunction* MOMENTS; /* function which computes the block moments shared by all the SSIM terms */
+  MOMENTSBATCHFunction* MOMENTS_BATCH; /* same for several reference blocks */
 
-  VIFFunction* VIF_A; /* function which computes the VIF DWT Approximation subband only */
-  VIFFunction* VIF_E; /* function which computes the VIF DWT Edges subband only */
-  VIFFunction* VIF_FULL; /* function which computes the VIF DWT full components */
+  VIFFunction* VIF_FULL; /* function which computes the VIF DWT full components, in a single pass for all the VIF flags */
+  VIFBATCHFunction* VIF_FULL_BATCH; /* same for several reference blocks */
 
   DWT2DFunction* DWT2D; /* for 2D DWT in VIF* functions*/
 
@@ -65,11 +62,21 @@ class DisMetric
   int nMetricFlags;
   sad_t maxSAD;
 
+  // max reference blocks per batch of the SSIM and VIF functions
+  static const int MAX_BATCH = 16;
+
+  int GetSSIMDisMetric(const SSIM_MOMENTS& moments);
+  int AddVIFDisMetric(int iDisMetric, float fVIF);
+
 public:
   DisMetric(int iBlkSizeX, int iBlkSizeY, int iBPP, int _pixelsize, arch_t _arch, int metric_flags);
   ~DisMetric();
 
 int GetDisMetric(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
+
+// Same metric of one source block against nRefs reference blocks, the source
+// block is loaded once for all of them
+void GetDisMetricBatch(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, int* pDisMetric);
 };
 
 
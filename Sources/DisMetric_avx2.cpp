@@ -0,0 +1,717 @@
+#if defined (__GNUC__) && ! defined (__INTEL_COMPILER)
+#include <x86intrin.h>
+// x86intrin.h includes header files for whatever instruction
+// sets are specified on the compiler command line, such as: xopintrin.h, fma4intrin.h
+#else
+#include <immintrin.h> // MS version of immintrin.h covers AVX, AVX2 and FMA3
+#endif // __GNUC__
+
+#include "DisMetric_avx2.h"
+#include "VIFFunctions.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include <stdint.h>
+#include "def.h"
+
+// Sums of x, y, x*x, y*y and x*y of samples in 32-bit lanes.
+// WIDE: samples over 8 bits, the products are accumulated in 64-bit lanes.
+template<bool WIDE>
+struct MomentsI
+{
+  __m256i sx = _mm256_setzero_si256();
+  __m256i sy = _mm256_setzero_si256();
+  __m256i sxx = _mm256_setzero_si256();
+  __m256i syy = _mm256_setzero_si256();
+  __m256i sxy = _mm256_setzero_si256();
+
+  static MV_FORCEINLINE __m256i mul_acc(__m256i acc, __m256i a, __m256i b)
+  {
+    if constexpr (!WIDE) {
+      return _mm256_add_epi32(acc, _mm256_mullo_epi32(a, b));
+    }
+    else {
+      // samples are never negative
+      const __m256i even = _mm256_mul_epu32(a, b);
+      const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+      return _mm256_add_epi64(acc, _mm256_add_epi64(even, odd));
+    }
+  }
+
+  // source sums only
+  MV_FORCEINLINE void add_x(__m256i x)
+  {
+    sx = _mm256_add_epi32(sx, x);
+    sxx = mul_acc(sxx, x, x);
+  }
+
+  // reference and cross sums only
+  MV_FORCEINLINE void add_y(__m256i x, __m256i y)
+  {
+    sy = _mm256_add_epi32(sy, y);
+    syy = mul_acc(syy, y, y);
+    sxy = mul_acc(sxy, x, y);
+  }
+
+  MV_FORCEINLINE void add(__m256i x, __m256i y)
+  {
+    add_x(x);
+    add_y(x, y);
+  }
+
+  static MV_FORCEINLINE double hsum32(__m256i a)
+  {
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+    s = _mm_add_epi32(s, _mm_srli_si128(s, 8));
+    s = _mm_add_epi32(s, _mm_srli_si128(s, 4));
+    return (double)(uint32_t)_mm_cvtsi128_si32(s);
+  }
+
+  static MV_FORCEINLINE double hsum64(__m256i a)
+  {
+    alignas(32) int64_t tmp[4];
+    _mm256_store_si256((__m256i*)tmp, a);
+    return (double)(tmp[0] + tmp[1] + tmp[2] + tmp[3]);
+  }
+
+  void store(SSIM_MOMENTS& m) const
+  {
+    m.sumX = hsum32(sx);
+    m.sumY = hsum32(sy);
+    m.sumXX = WIDE ? hsum64(sxx) : hsum32(sxx);
+    m.sumYY = WIDE ? hsum64(syy) : hsum32(syy);
+    m.sumXY = WIDE ? hsum64(sxy) : hsum32(sxy);
+  }
+};
+
+// Same sums for float samples, accumulated in double
+struct MomentsF
+{
+  __m256d sx = _mm256_setzero_pd();
+  __m256d sy = _mm256_setzero_pd();
+  __m256d sxx = _mm256_setzero_pd();
+  __m256d syy = _mm256_setzero_pd();
+  __m256d sxy = _mm256_setzero_pd();
+
+  static MV_FORCEINLINE __m256d lo_pd(__m256 x) { return _mm256_cvtps_pd(_mm256_castps256_ps128(x)); }
+  static MV_FORCEINLINE __m256d hi_pd(__m256 x) { return _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)); }
+
+  MV_FORCEINLINE void add4_x(__m256d x)
+  {
+    sx = _mm256_add_pd(sx, x);
+    sxx = _mm256_add_pd(sxx, _mm256_mul_pd(x, x));
+  }
+
+  MV_FORCEINLINE void add4_y(__m256d x, __m256d y)
+  {
+    sy = _mm256_add_pd(sy, y);
+    syy = _mm256_add_pd(syy, _mm256_mul_pd(y, y));
+    sxy = _mm256_add_pd(sxy, _mm256_mul_pd(x, y));
+  }
+
+  MV_FORCEINLINE void add_x(__m256 x)
+  {
+    add4_x(lo_pd(x));
+    add4_x(hi_pd(x));
+  }
+
+  MV_FORCEINLINE void add_y(__m256 x, __m256 y)
+  {
+    add4_y(lo_pd(x), lo_pd(y));
+    add4_y(hi_pd(x), hi_pd(y));
+  }
+
+  MV_FORCEINLINE void add(__m256 x, __m256 y)
+  {
+    add_x(x);
+    add_y(x, y);
+  }
+
+  static MV_FORCEINLINE double hsum(__m256d a)
+  {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+    return _mm_cvtsd_f64(s);
+  }
+
+  void store(SSIM_MOMENTS& m) const
+  {
+    m.sumX = hsum(sx);
+    m.sumY = hsum(sy);
+    m.sumXX = hsum(sxx);
+    m.sumYY = hsum(syy);
+    m.sumXY = hsum(sxy);
+  }
+};
+
+// NB bytes, zero-padded without reading past them
+template<int NB>
+static MV_FORCEINLINE __m128i load_bytes(const uint8_t* p)
+{
+  static_assert(NB > 0 && NB <= 16, "up to 16 bytes");
+  if constexpr (NB == 16) {
+    return _mm_loadu_si128((const __m128i*)p);
+  }
+  else if constexpr (NB == 8) {
+    return _mm_loadl_epi64((const __m128i*)p);
+  }
+  else if constexpr (NB % 4 == 0) {
+    const __m128i mask = _mm_cmpgt_epi32(_mm_set1_epi32(NB / 4), _mm_setr_epi32(0, 1, 2, 3));
+    return _mm_maskload_epi32((const int*)p, mask);
+  }
+  else {
+    // odd sizes, small blocks only
+    alignas(16) uint8_t buf[16] = {};
+    memcpy(buf, p, NB);
+    return _mm_load_si128((const __m128i*)buf);
+  }
+}
+
+template<int N>
+static MV_FORCEINLINE __m256 load_floats(const uint8_t* p)
+{
+  static_assert(N > 0 && N <= 8, "up to 8 floats");
+  if constexpr (N == 8) {
+    return _mm256_loadu_ps((const float*)p);
+  }
+  else {
+    const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(N), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    return _mm256_maskload_ps((const float*)p, mask);
+  }
+}
+
+// Samples in 32-bit lanes, 16 samples (two vectors) of a row at a time.
+// With N < 16, the row is zero-padded.
+// The one level DWT of two rows gives 8 coefficients of each subband, with
+// the definitions of DWT_C.
+template<typename pixel_t>
+struct Samples
+{
+  typedef __m256i vec_t;
+  typedef int dwt_t;
+  typedef MomentsI<(sizeof(pixel_t) > 1)> moments_t;
+
+  template<int N>
+  static MV_FORCEINLINE void load16(const uint8_t* p, vec_t& lo, vec_t& hi)
+  {
+    static_assert(N > 0 && N <= 16, "up to 16 samples");
+    if constexpr (sizeof(pixel_t) == 1) {
+      const __m128i v = load_bytes<N>(p);
+      lo = _mm256_cvtepu8_epi32(v);
+      hi = _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8));
+    }
+    else {
+      constexpr int NB = N * 2;
+      const __m128i v0 = load_bytes<std::min(NB, 16)>(p);
+      lo = _mm256_cvtepu16_epi32(v0);
+      if constexpr (NB > 16) {
+        hi = _mm256_cvtepu16_epi32(load_bytes<NB - 16>(p + 16));
+      }
+      else {
+        hi = _mm256_setzero_si256();
+      }
+    }
+  }
+
+  // truncation toward zero, as the C integer division
+  static MV_FORCEINLINE vec_t div4(vec_t x)
+  {
+    const __m256i round = _mm256_and_si256(_mm256_srai_epi32(x, 31), _mm256_set1_epi32(3));
+    return _mm256_srai_epi32(_mm256_add_epi32(x, round), 2);
+  }
+
+  template<int N>
+  static MV_FORCEINLINE void dwt16(const uint8_t* p0, const uint8_t* p1, vec_t& a, vec_t& v, vec_t& h, vec_t& d)
+  {
+    vec_t lo0, hi0, lo1, hi1;
+    load16<N>(p0, lo0, hi0);
+    load16<N>(p1, lo1, hi1);
+    // horizontal pairs, back in sample order
+    const __m256i s0 = _mm256_permute4x64_epi64(_mm256_hadd_epi32(lo0, hi0), _MM_SHUFFLE(3, 1, 2, 0)); // A + B
+    const __m256i s1 = _mm256_permute4x64_epi64(_mm256_hadd_epi32(lo1, hi1), _MM_SHUFFLE(3, 1, 2, 0)); // C + D
+    const __m256i d0 = _mm256_permute4x64_epi64(_mm256_hsub_epi32(lo0, hi0), _MM_SHUFFLE(3, 1, 2, 0)); // A - B
+    const __m256i d1 = _mm256_permute4x64_epi64(_mm256_hsub_epi32(lo1, hi1), _MM_SHUFFLE(3, 1, 2, 0)); // C - D
+    a = div4(_mm256_add_epi32(s0, s1));
+    v = div4(_mm256_sub_epi32(_mm256_setzero_si256(), _mm256_add_epi32(d0, d1)));
+    h = div4(_mm256_sub_epi32(s1, s0));
+    d = div4(_mm256_sub_epi32(d1, d0));
+  }
+
+  static MV_FORCEINLINE void store8(dwt_t* p, vec_t x)
+  {
+    _mm256_storeu_si256((__m256i*)p, x);
+  }
+
+  static MV_FORCEINLINE vec_t load8(const dwt_t* p)
+  {
+    return _mm256_loadu_si256((const __m256i*)p);
+  }
+
+  // square as float, after the integer product like the C version
+  static MV_FORCEINLINE __m256 sq_ps(vec_t x)
+  {
+    return _mm256_cvtepi32_ps(_mm256_mullo_epi32(x, x));
+  }
+};
+
+template<>
+struct Samples<float>
+{
+  typedef __m256 vec_t;
+  typedef float dwt_t;
+  typedef MomentsF moments_t;
+
+  template<int N>
+  static MV_FORCEINLINE void load16(const uint8_t* p, vec_t& lo, vec_t& hi)
+  {
+    static_assert(N > 0 && N <= 16, "up to 16 samples");
+    lo = load_floats<std::min(N, 8)>(p);
+    if constexpr (N > 8) {
+      hi = load_floats<N - 8>(p + 32);
+    }
+    else {
+      hi = _mm256_setzero_ps();
+    }
+  }
+
+  static MV_FORCEINLINE vec_t pairs(vec_t x)
+  {
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(x), _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+
+  template<int N>
+  static MV_FORCEINLINE void dwt16(const uint8_t* p0, const uint8_t* p1, vec_t& a, vec_t& v, vec_t& h, vec_t& d)
+  {
+    vec_t lo0, hi0, lo1, hi1;
+    load16<N>(p0, lo0, hi0);
+    load16<N>(p1, lo1, hi1);
+    const __m256 s0 = pairs(_mm256_hadd_ps(lo0, hi0)); // A + B
+    const __m256 s1 = pairs(_mm256_hadd_ps(lo1, hi1)); // C + D
+    const __m256 d0 = pairs(_mm256_hsub_ps(lo0, hi0)); // A - B
+    const __m256 d1 = pairs(_mm256_hsub_ps(lo1, hi1)); // C - D
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    a = _mm256_mul_ps(_mm256_add_ps(s0, s1), quarter);
+    v = _mm256_mul_ps(_mm256_sub_ps(_mm256_setzero_ps(), _mm256_add_ps(d0, d1)), quarter);
+    h = _mm256_mul_ps(_mm256_sub_ps(s1, s0), quarter);
+    d = _mm256_mul_ps(_mm256_sub_ps(d1, d0), quarter);
+  }
+
+  static MV_FORCEINLINE void store8(dwt_t* p, vec_t x)
+  {
+    _mm256_storeu_ps(p, x);
+  }
+
+  static MV_FORCEINLINE vec_t load8(const dwt_t* p)
+  {
+    return _mm256_loadu_ps(p);
+  }
+
+  static MV_FORCEINLINE __m256 sq_ps(vec_t x)
+  {
+    return _mm256_mul_ps(x, x);
+  }
+};
+
+static MV_FORCEINLINE float hsum_ps(__m256 a)
+{
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+
+// 16 samples of a row of the source against the same samples of NR references.
+// SRC: the source sums are accumulated in acc[0].
+template<typename pixel_t, int N, int NR, bool SRC>
+static MV_FORCEINLINE void moments16(typename Samples<pixel_t>::moments_t* acc, const uint8_t* pSrc, const uint8_t* const* pRef, int offset)
+{
+  typedef Samples<pixel_t> S;
+  typename S::vec_t xlo, xhi;
+  S::template load16<N>(pSrc + offset, xlo, xhi);
+  if constexpr (SRC) {
+    acc[0].add_x(xlo);
+    if constexpr (N > 8) {
+      acc[0].add_x(xhi);
+    }
+  }
+  for (int i = 0; i < NR; i++)
+  {
+    typename S::vec_t ylo, yhi;
+    S::template load16<N>(pRef[i] + offset, ylo, yhi);
+    acc[i].add_y(xlo, ylo);
+    if constexpr (N > 8) {
+      acc[i].add_y(xhi, yhi);
+    }
+  }
+}
+
+// Moments of NR reference blocks, the source rows are loaded once for all of them.
+// The source sums are only valid in pMoments[0], with SRC.
+template<int nBlkWidth, int nBlkHeight, typename pixel_t, int NR, bool SRC>
+static MV_FORCEINLINE void BlockMomentsN(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, SSIM_MOMENTS* pMoments)
+{
+  constexpr int NF = nBlkWidth / 16; // full chunks of 16 samples
+  constexpr int TAIL = nBlkWidth % 16;
+  constexpr int chunk_bytes = 16 * sizeof(pixel_t);
+
+  typename Samples<pixel_t>::moments_t acc[NR];
+  const uint8_t* pRef[NR];
+  for (int i = 0; i < NR; i++)
+    pRef[i] = ppRef[i];
+
+  for (int y = 0; y < nBlkHeight; y++)
+  {
+    for (int c = 0; c < NF; c++)
+    {
+      moments16<pixel_t, 16, NR, SRC>(acc, pSrc, pRef, c * chunk_bytes);
+    }
+    if constexpr (TAIL > 0) {
+      moments16<pixel_t, TAIL, NR, SRC>(acc, pSrc, pRef, NF * chunk_bytes);
+    }
+    pSrc += nSrcPitch;
+    for (int i = 0; i < NR; i++)
+      pRef[i] += pRefPitch[i];
+  }
+
+  for (int i = 0; i < NR; i++)
+    acc[i].store(pMoments[i]);
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void BlockMoments_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, SSIM_MOMENTS* pMoments)
+{
+  BlockMomentsN<nBlkWidth, nBlkHeight, pixel_t, 1, true>(pSrc, nSrcPitch, &pRef, &nRefPitch, pMoments);
+
+  _mm256_zeroupper();
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void BlockMomentsBatch_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, SSIM_MOMENTS* pMoments)
+{
+  if (nRefs <= 0)
+    return;
+
+  // the source sums come with the first group, references by groups of 4, 2 and 1
+  int i = std::min(nRefs, 4);
+  switch (i)
+  {
+  case 4: BlockMomentsN<nBlkWidth, nBlkHeight, pixel_t, 4, true>(pSrc, nSrcPitch, ppRef, pRefPitch, pMoments); break;
+  case 3: BlockMomentsN<nBlkWidth, nBlkHeight, pixel_t, 2, true>(pSrc, nSrcPitch, ppRef, pRefPitch, pMoments);
+    i = 2; break;
+  default: BlockMomentsN<nBlkWidth, nBlkHeight, pixel_t, 1, true>(pSrc, nSrcPitch, ppRef, pRefPitch, pMoments);
+    i = 1; break;
+  }
+  for (; i + 4 <= nRefs; i += 4)
+    BlockMomentsN<nBlkWidth, nBlkHeight, pixel_t, 4, false>(pSrc, nSrcPitch, ppRef + i, pRefPitch + i, pMoments + i);
+  if (i + 2 <= nRefs)
+  {
+    BlockMomentsN<nBlkWidth, nBlkHeight, pixel_t, 2, false>(pSrc, nSrcPitch, ppRef + i, pRefPitch + i, pMoments + i);
+    i += 2;
+  }
+  if (i < nRefs)
+    BlockMomentsN<nBlkWidth, nBlkHeight, pixel_t, 1, false>(pSrc, nSrcPitch, ppRef + i, pRefPitch + i, pMoments + i);
+
+  for (i = 1; i < nRefs; i++)
+  {
+    pMoments[i].sumX = pMoments[0].sumX;
+    pMoments[i].sumXX = pMoments[0].sumXX;
+  }
+
+  _mm256_zeroupper();
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void DWT_avx2(const uint8_t* pSrc, int nSrcPitch, void* pA, void* pV, void* pH, void* pD)
+{
+  typedef Samples<pixel_t> S;
+  typedef typename S::dwt_t dwt_t;
+
+  constexpr int iNumHpos = nBlkWidth / 2;
+  constexpr int iNumVpos = nBlkHeight / 2;
+  constexpr int NF = iNumHpos / 8; // full chunks of 8 coefficients
+  constexpr int TAIL = iNumHpos % 8;
+  constexpr int chunk_bytes = 16 * sizeof(pixel_t);
+  static_assert(iNumHpos > 0 && iNumVpos > 0, "even block sizes only");
+
+  dwt_t* pDstA = reinterpret_cast<dwt_t*>(pA);
+  dwt_t* pDstV = reinterpret_cast<dwt_t*>(pV);
+  dwt_t* pDstH = reinterpret_cast<dwt_t*>(pH);
+  dwt_t* pDstD = reinterpret_cast<dwt_t*>(pD);
+
+  // the null outputs are not written, see DWT_C
+  auto chunk = [&](auto n, const uint8_t* p0, const uint8_t* p1, int idx)
+  {
+    constexpr int N = decltype(n)::value;
+    typename S::vec_t a, v, h, d;
+    S::template dwt16<N * 2>(p0, p1, a, v, h, d);
+    alignas(32) dwt_t tmp[8];
+    const auto put = [&](dwt_t* pDst, typename S::vec_t x) {
+      if (pDst == nullptr)
+        return;
+      if constexpr (N == 8) {
+        S::store8(pDst + idx, x);
+      }
+      else {
+        S::store8(tmp, x);
+        memcpy(pDst + idx, tmp, N * sizeof(dwt_t));
+      }
+    };
+    put(pDstA, a);
+    put(pDstV, v);
+    put(pDstH, h);
+    put(pDstD, d);
+  };
+
+  for (int iVP = 0; iVP < iNumVpos; iVP++)
+  {
+    const uint8_t* p0 = pSrc + (iVP * 2) * nSrcPitch;
+    const uint8_t* p1 = p0 + nSrcPitch;
+    for (int c = 0; c < NF; c++)
+    {
+      chunk(std::integral_constant<int, 8>(), p0 + c * chunk_bytes, p1 + c * chunk_bytes, iVP * iNumHpos + c * 8);
+    }
+    if constexpr (TAIL > 0) {
+      chunk(std::integral_constant<int, TAIL>(), p0 + NF * chunk_bytes, p1 + NF * chunk_bytes, iVP * iNumHpos + NF * 8);
+    }
+  }
+
+  _mm256_zeroupper();
+}
+
+// DWT, approximation moments and edge magnitudes in a single pass over the
+// blocks, then a pass over the edge magnitudes for their deviations.
+// The source block is decomposed once, its coefficients and statistics are
+// kept for all the references.
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void VIF_DWT_FULL_BATCH_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, DWT2DFunction* /*pDWT2D*/, float* pVIF)
+{
+  typedef Samples<pixel_t> S;
+  typedef typename S::vec_t vec_t;
+  typedef typename S::dwt_t dwt_t;
+
+  constexpr int iNumHpos = nBlkWidth / 2;
+  constexpr int iNumVpos = nBlkHeight / 2;
+  constexpr int iN = iNumHpos * iNumVpos;
+  constexpr int NF = iNumHpos / 8; // full chunks of 8 coefficients
+  constexpr int TAIL = iNumHpos % 8;
+  constexpr int chunk_bytes = 16 * sizeof(pixel_t);
+  static_assert(iN > 0, "even block sizes only");
+
+  // the last chunk of a row may write 8 values, they are overwritten by the
+  // next row or land in the padding
+  dwt_t Xa[iN + 8];
+  float Xe[iN + 8];
+  float Ye[iN + 8];
+
+  const __m256 fMu = _mm256_set1_ps(0.45f); // H edges weight
+  const __m256 fLa = _mm256_set1_ps(0.45f); // V edges weight
+  const __m256 fPsi = _mm256_set1_ps(0.1f); // Diagonal edges weight
+
+  auto edges = [&](vec_t v, vec_t h, vec_t d)
+  {
+    const __m256 e = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fMu, S::sq_ps(v)), _mm256_mul_ps(fLa, S::sq_ps(h))), _mm256_mul_ps(fPsi, S::sq_ps(d)));
+    return _mm256_sqrt_ps(e);
+  };
+
+  // all the chunks of the block, zero-padded samples give null coefficients,
+  // they do not change the sums
+  auto for_chunks = [&](auto&& chunk)
+  {
+    for (int iVP = 0; iVP < iNumVpos; iVP++)
+    {
+      for (int c = 0; c < NF; c++)
+      {
+        chunk(std::integral_constant<int, 8>(), iVP, c * chunk_bytes, iVP * iNumHpos + c * 8);
+      }
+      if constexpr (TAIL > 0) {
+        chunk(std::integral_constant<int, TAIL>(), iVP, NF * chunk_bytes, iVP * iNumHpos + NF * 8);
+      }
+    }
+  };
+
+  // source
+  typename S::moments_t accX;
+  __m256 suXe = _mm256_setzero_ps();
+  for_chunks([&](auto n, int iVP, int offset, int idx)
+  {
+    constexpr int N = decltype(n)::value;
+    const uint8_t* p = pSrc + iVP * 2 * nSrcPitch + offset;
+    vec_t xa, xv, xh, xd;
+    S::template dwt16<N * 2>(p, p + nSrcPitch, xa, xv, xh, xd);
+    accX.add_x(xa);
+    const __m256 xe = edges(xv, xh, xd);
+    suXe = _mm256_add_ps(suXe, xe);
+    S::store8(Xa + idx, xa);
+    _mm256_storeu_ps(Xe + idx, xe);
+  });
+
+  SSIM_MOMENTS mX;
+  accX.store(mX);
+
+  const float fsuXe = hsum_ps(suXe) / (float)iN;
+  const __m256 muXe = _mm256_set1_ps(fsuXe);
+  __m256 sXe = _mm256_setzero_ps();
+  constexpr int idx_v = iN - iN % 8; // the scalar tails are only compiled when iN is not a multiple of 8
+  for (int idx = 0; idx < idx_v; idx += 8)
+  {
+    const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(Xe + idx), muXe);
+    sXe = _mm256_add_ps(sXe, _mm256_mul_ps(dx, dx));
+  }
+  float fsXe0 = hsum_ps(sXe);
+  if constexpr (iN % 8 != 0)
+  {
+    for (int idx = idx_v; idx < iN; idx++)
+    {
+      fsXe0 += (Xe[idx] - fsuXe) * (Xe[idx] - fsuXe);
+    }
+  }
+  const float fsXe = fsXe0 / (float)iN;
+
+  // references
+  for (int r = 0; r < nRefs; r++)
+  {
+    const uint8_t* pRef = ppRef[r];
+    const int nRefPitch = pRefPitch[r];
+
+    typename S::moments_t accY;
+    __m256 suYe = _mm256_setzero_ps();
+    for_chunks([&](auto n, int iVP, int offset, int idx)
+    {
+      constexpr int N = decltype(n)::value;
+      const uint8_t* p = pRef + iVP * 2 * nRefPitch + offset;
+      vec_t ya, yv, yh, yd;
+      S::template dwt16<N * 2>(p, p + nRefPitch, ya, yv, yh, yd);
+      // the source lanes past a row tail are not null, but the reference ones are
+      accY.add_y(S::load8(Xa + idx), ya);
+      const __m256 ye = edges(yv, yh, yd);
+      suYe = _mm256_add_ps(suYe, ye);
+      _mm256_storeu_ps(Ye + idx, ye);
+    });
+
+    // VIF_A
+    SSIM_MOMENTS mA;
+    accY.store(mA);
+    mA.sumX = mX.sumX;
+    mA.sumXX = mX.sumXX;
+    float fsX, fsY, fsXY;
+    VIFApproxVariances(mA, iN, std::is_floating_point<pixel_t>::value, fsX, fsY, fsXY);
+    const float fVIFa = VIFSubband(fsX, fsY, fsXY);
+
+    // VIF_E
+    const float fsuYe = hsum_ps(suYe) / (float)iN;
+
+    const __m256 muYe = _mm256_set1_ps(fsuYe);
+    __m256 sYe = _mm256_setzero_ps();
+    __m256 sXYe = _mm256_setzero_ps();
+    for (int idx = 0; idx < idx_v; idx += 8)
+    {
+      const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(Xe + idx), muXe);
+      const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(Ye + idx), muYe);
+      sYe = _mm256_add_ps(sYe, _mm256_mul_ps(dy, dy));
+      sXYe = _mm256_add_ps(sXYe, _mm256_mul_ps(dx, dy));
+    }
+    float fsYe = hsum_ps(sYe);
+    float fsXYe = hsum_ps(sXYe);
+
+    if constexpr (iN % 8 != 0)
+    {
+      for (int idx = idx_v; idx < iN; idx++)
+      {
+        fsYe += (Ye[idx] - fsuYe) * (Ye[idx] - fsuYe);
+        fsXYe += (Xe[idx] - fsuXe) * (Ye[idx] - fsuYe);
+      }
+    }
+
+    fsYe = fsYe / (float)iN;
+    fsXYe = fsXYe / (float)iN;
+
+    const float fVIFe = VIFSubband(fsXe, fsYe, fsXYe);
+
+    pVIF[r] = VIFCombine(fVIFa, fVIFe);
+  }
+
+  _mm256_zeroupper();
+}
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+float VIF_DWT_FULL_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, DWT2DFunction* pDWT2D)
+{
+  float fVIF;
+  VIF_DWT_FULL_BATCH_avx2<nBlkWidth, nBlkHeight, pixel_t>(pSrc, nSrcPitch, &pRef, &nRefPitch, 1, pDWT2D, &fVIF);
+  return fVIF;
+}
+
+// Instantiate
+// match with SSIMFunctions.cpp, DWTFunctions.cpp and VIFFunctions.cpp
+#define MAKE_MOMENTS_FN(x, y) \
+template void BlockMoments_avx2<x, y, uint8_t>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, SSIM_MOMENTS* pMoments); \
+template void BlockMoments_avx2<x, y, uint16_t>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, SSIM_MOMENTS* pMoments); \
+template void BlockMoments_avx2<x, y, float>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, SSIM_MOMENTS* pMoments); \
+template void BlockMomentsBatch_avx2<x, y, uint8_t>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, SSIM_MOMENTS* pMoments); \
+template void BlockMomentsBatch_avx2<x, y, uint16_t>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, SSIM_MOMENTS* pMoments); \
+template void BlockMomentsBatch_avx2<x, y, float>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, SSIM_MOMENTS* pMoments);
+#define MAKE_DWT_FN(x, y) \
+MAKE_MOMENTS_FN(x, y) \
+template void DWT_avx2<x, y, uint8_t>(const uint8_t* pSrc, int nSrcPitch, void* pA, void* pV, void* pH, void* pD); \
+template void DWT_avx2<x, y, uint16_t>(const uint8_t* pSrc, int nSrcPitch, void* pA, void* pV, void* pH, void* pD); \
+template void DWT_avx2<x, y, float>(const uint8_t* pSrc, int nSrcPitch, void* pA, void* pV, void* pH, void* pD); \
+template float VIF_DWT_FULL_avx2<x, y, uint8_t>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, DWT2DFunction* pDWT2D); \
+template float VIF_DWT_FULL_avx2<x, y, uint16_t>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, DWT2DFunction* pDWT2D); \
+template float VIF_DWT_FULL_avx2<x, y, float>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, DWT2DFunction* pDWT2D); \
+template void VIF_DWT_FULL_BATCH_avx2<x, y, uint8_t>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, DWT2DFunction* pDWT2D, float* pVIF); \
+template void VIF_DWT_FULL_BATCH_avx2<x, y, uint16_t>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, DWT2DFunction* pDWT2D, float* pVIF); \
+template void VIF_DWT_FULL_BATCH_avx2<x, y, float>(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, DWT2DFunction* pDWT2D, float* pVIF);
+MAKE_DWT_FN(64, 64)
+MAKE_DWT_FN(64, 48)
+MAKE_DWT_FN(64, 32)
+MAKE_DWT_FN(64, 16)
+MAKE_DWT_FN(48, 64)
+MAKE_DWT_FN(48, 48)
+MAKE_DWT_FN(48, 24)
+MAKE_DWT_FN(48, 12)
+MAKE_DWT_FN(32, 64)
+MAKE_DWT_FN(32, 32)
+MAKE_DWT_FN(32, 24)
+MAKE_DWT_FN(32, 16)
+MAKE_DWT_FN(32, 8)
+MAKE_DWT_FN(24, 48)
+MAKE_DWT_FN(24, 32)
+MAKE_DWT_FN(24, 24)
+MAKE_DWT_FN(24, 12)
+MAKE_DWT_FN(24, 6)
+MAKE_DWT_FN(16, 64)
+MAKE_DWT_FN(16, 32)
+MAKE_DWT_FN(16, 16)
+MAKE_DWT_FN(16, 12)
+MAKE_DWT_FN(16, 8)
+MAKE_DWT_FN(16, 4)
+MAKE_DWT_FN(16, 2)
+MAKE_MOMENTS_FN(16, 1)
+MAKE_DWT_FN(12, 48)
+MAKE_DWT_FN(12, 24)
+MAKE_DWT_FN(12, 16)
+MAKE_DWT_FN(12, 12)
+MAKE_DWT_FN(12, 6)
+MAKE_MOMENTS_FN(12, 3)
+MAKE_DWT_FN(8, 32)
+MAKE_DWT_FN(8, 16)
+MAKE_DWT_FN(8, 8)
+MAKE_DWT_FN(8, 4)
+MAKE_DWT_FN(8, 2)
+MAKE_MOMENTS_FN(8, 1)
+MAKE_DWT_FN(6, 24)
+MAKE_DWT_FN(6, 12)
+MAKE_DWT_FN(6, 6)
+MAKE_MOMENTS_FN(6, 3)
+MAKE_DWT_FN(4, 8)
+MAKE_DWT_FN(4, 4)
+MAKE_DWT_FN(4, 2)
+MAKE_MOMENTS_FN(4, 1)
+MAKE_MOMENTS_FN(3, 6)
+MAKE_MOMENTS_FN(3, 3)
+MAKE_DWT_FN(2, 4)
+MAKE_DWT_FN(2, 2)
+MAKE_MOMENTS_FN(2, 1)
+#undef MAKE_DWT_FN
+#undef MAKE_MOMENTS_FN
@@ -0,0 +1,46 @@
+// AVX2 kernels of the dissimilarity metrics: SSIM block moments, 2D DWT and VIF
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __DISMETRIC_AVX2__
+#define __DISMETRIC_AVX2__
+
+#include "types.h"
+#include "SSIMFunctions.h"
+#include <stdint.h>
+
+// pixel_t: uint8_t, uint16_t or float, any block size of the SSIM/VIF lists
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void BlockMoments_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, SSIM_MOMENTS* pMoments);
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void BlockMomentsBatch_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, SSIM_MOMENTS* pMoments);
+
+// even block sizes only
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void DWT_avx2(const uint8_t* pSrc, int nSrcPitch, void* pA, void* pV, void* pH, void* pD);
+
+// even block sizes only, computes the DWT itself: pDWT2D is not used.
+// The batch version decomposes the source block once for all the references.
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+float VIF_DWT_FULL_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, DWT2DFunction* pDWT2D);
+
+template<int nBlkWidth, int nBlkHeight, typename pixel_t>
+void VIF_DWT_FULL_BATCH_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, DWT2DFunction* pDWT2D, float* pVIF);
+
+#endif
@@ -21,6 +21,7 @@
 
 #include "FakeGroupOfPlanes.h"
 #include "FakePlaneOfBlocks.h"
+#include "MVSceneStats.h"
 
 // we need for _xRatioUV, but _yRatioUV is not used
 void FakeGroupOfPlanes::Create(int nBlkSizeX, int nBlkSizeY, int nLevelCount, int nPel, int nOverlapX, int nOverlapY, int _xRatioUV, int _yRatioUV, int _nBlkX, int _nBlkY, bool bMVsArrayOnly)
@@ -56,6 +57,7 @@ FakeGroupOfPlanes::FakeGroupOfPlanes()
 {
   //InitializeCriticalSection(&cs); // 16.03.08 moved here from ::Create
   planes = 0;
+  scene_stats = 0;
 }
 
 FakeGroupOfPlanes::~FakeGroupOfPlanes()
@@ -72,7 +74,7 @@ FakeGroupOfPlanes::~FakeGroupOfPlanes()
 
 // data_size = available data, in 32-bit words
 // Returns false on error.
-bool FakeGroupOfPlanes::Update(const int *array, int data_size)
+bool FakeGroupOfPlanes::Update(const int *array, int data_size, const MVSceneStats *stats)
 {
   //::EnterCriticalSection (&cs);
   std::lock_guard<std::mutex> lock(cs);
@@ -80,6 +82,7 @@ bool FakeGroupOfPlanes::Update(const int *array, int data_size)
   bool				ok_flag = true;
 
   validity = GetValidity(array);
+  scene_stats = stats;
   const int *		pA = 0;
   
   // Checks available data
@@ -126,5 +129,11 @@ bool FakeGroupOfPlanes::Update(const int *array, int data_size)
 
 bool FakeGroupOfPlanes::IsSceneChange(sad_t nThSCD1, int nThSCD2) const
 {
+  if (scene_stats != 0 && scene_stats->is_valid(planes[0]->GetBlockCount()))
+  {
+    const int sc = scene_stats->is_scene_change(nThSCD1, nThSCD2);
+    if (sc >= 0)
+      return (sc != 0);
+  }
   return planes[0]->IsSceneChange(nThSCD1, nThSCD2);
 }
@@ -23,6 +23,7 @@
 #include <mutex>
 
 class FakePlaneOfBlocks;
+class MVSceneStats;
 
 class FakeGroupOfPlanes
 {
@@ -34,6 +35,7 @@ class FakeGroupOfPlanes
    int xRatioUV_B; // PF
    int yRatioUV_B; 
   FakePlaneOfBlocks **planes;
+  const MVSceneStats *scene_stats; // in the header of the current vector frame, may be 0
 //   const unsigned char *compensatedPlane;
 //   const unsigned char *compensatedPlaneU;
 //   const unsigned char *compensatedPlaneV;
@@ -47,7 +49,7 @@ public :
     // we need for _xRatioUV, but _yRatioUV is not used
    void Create(int _nBlkSizeX, int _nBlkSizeY, int _nLevelCount, int _nPel, int _nOverlapX, int _nOverlapY, int _xRatioUV, int _yRatioUV, int _nBlkX, int _nBlkY, bool bMVsArrayOnly); 
 
-  bool Update(const int *array, int data_size);
+  bool Update(const int *array, int data_size, const MVSceneStats *stats = 0);
   bool IsSceneChange(sad_t nThSCD1, int nThSCD2) const;
 
   MV_FORCEINLINE const FakePlaneOfBlocks& operator[](const int i) const {
@@ -63,6 +65,7 @@ public :
   MV_FORCEINLINE int GetPitchUV() const { return nWidth_B / xRatioUV_B; }
 
   MV_FORCEINLINE const FakePlaneOfBlocks& GetPlane(int i) const { return *(planes[i]); }
+  MV_FORCEINLINE FakePlaneOfBlocks& GetPlane(int i) { return *(planes[i]); }
 };
 
 
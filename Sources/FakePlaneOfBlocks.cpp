@@ -50,10 +50,11 @@ FakePlaneOfBlocks::FakePlaneOfBlocks(int sizeX, int sizeY, int lv, int pel, int
    SIZE_T stSizeToAlloc = nBlkCount * sizeof(VECTOR) + RAND_OFFSET_MAX * L2L3_CACHE_LINE_SIZE;
 
    pbMVsArray_a = (BYTE*)VirtualAlloc(0, stSizeToAlloc, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE); // 4KByte page aligned address
-   pMVsArray = (VECTOR*)(pbMVsArray_a + random);
+   pMVsArrayOwn = (VECTOR*)(pbMVsArray_a + random);
 #else
-   pMVsArray = new VECTOR[nBlkCount]; // allocate in heap ?
+   pMVsArrayOwn = new VECTOR[nBlkCount]; // allocate in heap ?
 #endif
+   pMVsArray = pMVsArrayOwn;
 
 
   nLogPel = ilog2(nPel);
@@ -76,16 +77,15 @@ FakePlaneOfBlocks::~FakePlaneOfBlocks()
 #ifdef _WIN32
   VirtualFree(pbMVsArray_a, 0, MEM_RELEASE);
 #else
-  delete[] pMVsArray;
+  delete[] pMVsArrayOwn;
 #endif
 }
 
 void FakePlaneOfBlocks::Update(const int *array)
 {
-  // need to copy, pointer not keeped ?
-  if (bnMVsArrayOnly) // for faster MDegrain
+  if (bnMVsArrayOnly) // for faster MDegrain: no copy, the MVClip holds the frame
   {
-    memcpy(pMVsArray, array, nBlkCount * sizeof(VECTOR));
+    pMVsArray = reinterpret_cast<const VECTOR*>(array);
   }
   else // for compatibility with old filters/functions
   {
@@ -115,3 +115,14 @@ bool FakePlaneOfBlocks::IsSceneChange(sad_t nTh1, int nTh2) const
 
   return ( sum > nTh2 );
 }
+
+// copy on write: the vector frame may be shared with other filters
+VECTOR* FakePlaneOfBlocks::GetpMVsArrayWritable()
+{
+  if (pMVsArray != pMVsArrayOwn)
+  {
+    memcpy(pMVsArrayOwn, pMVsArray, nBlkCount * sizeof(VECTOR));
+    pMVsArray = pMVsArrayOwn;
+  }
+  return pMVsArrayOwn;
+}
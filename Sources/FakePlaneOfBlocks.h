@@ -42,9 +42,10 @@ class FakePlaneOfBlocks
 
   FakeBlockData *blocks;
 
-  VECTOR* pMVsArray; // working pointer
+  const VECTOR* pMVsArray; // working pointer: into the vector frame, or pMVsArrayOwn after GetpMVsArrayWritable
+  VECTOR* pMVsArrayOwn;
   BYTE* pbMVsArray_a; // allocated pointer
-  bool bnMVsArrayOnly;
+  bool bnMVsArrayOnly; // vectors read in place, the caller keeps the vector frame until the next Update
 
 public :
 
@@ -78,6 +79,7 @@ public :
   MV_FORCEINLINE int GetOverlapY() const { return nOverlapY; }
 
   MV_FORCEINLINE const VECTOR* GetpMVsArray() const { return pMVsArray; }
+  VECTOR* GetpMVsArrayWritable();
 };
 
 
@@ -0,0 +1,162 @@
+// Slice-parallel flow interpolation for MFlowInter and MFlowFps
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "FlowInterSlicer.h"
+#include "MaskFun.h"
+
+#include <cassert>
+
+FlowInterSlicer::FlowInterSlicer(bool mt_flag, int cpuFlags)
+  : _mt_flag(mt_flag)
+  , _cpuFlags(cpuFlags)
+  , _mode(FLOW_SIMPLE)
+  , _pdst(nullptr)
+  , _dst_pitch(0)
+  , _prefB(nullptr)
+  , _prefF(nullptr)
+  , _ref_pitch(0)
+  , _VXFullB(nullptr)
+  , _VXFullF(nullptr)
+  , _VYFullB(nullptr)
+  , _VYFullF(nullptr)
+  , _MaskB(nullptr)
+  , _MaskF(nullptr)
+  , _VXFullBB(nullptr)
+  , _VXFullFF(nullptr)
+  , _VYFullBB(nullptr)
+  , _VYFullFF(nullptr)
+  , _VPitch(0)
+  , _width(0)
+  , _time256(0)
+  , _nPel(1)
+{
+}
+
+template<typename pixel_t>
+void FlowInterSlicer::FlowInterSimple(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256, int nPel)
+{
+  run<pixel_t>(FLOW_SIMPLE, pdst, dst_pitch, prefB, prefF, ref_pitch,
+    VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
+    VPitch, width, height, time256, nPel,
+    nullptr, nullptr, nullptr, nullptr);
+}
+
+template<typename pixel_t>
+void FlowInterSlicer::FlowInter(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256, int nPel)
+{
+  run<pixel_t>(FLOW_INTER, pdst, dst_pitch, prefB, prefF, ref_pitch,
+    VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
+    VPitch, width, height, time256, nPel,
+    nullptr, nullptr, nullptr, nullptr);
+}
+
+template<typename pixel_t>
+void FlowInterSlicer::FlowInterExtra(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256, int nPel,
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF)
+{
+  run<pixel_t>(FLOW_EXTRA, pdst, dst_pitch, prefB, prefF, ref_pitch,
+    VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
+    VPitch, width, height, time256, nPel,
+    VXFullBB, VXFullFF, VYFullBB, VYFullFF);
+}
+
+template<typename pixel_t>
+void FlowInterSlicer::run(FlowMode mode, uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256, int nPel,
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF)
+{
+  _mode = mode;
+  _pdst = pdst;
+  _dst_pitch = dst_pitch;
+  _prefB = prefB;
+  _prefF = prefF;
+  _ref_pitch = ref_pitch;
+  _VXFullB = VXFullB;
+  _VXFullF = VXFullF;
+  _VYFullB = VYFullB;
+  _VYFullF = VYFullF;
+  _MaskB = MaskB;
+  _MaskF = MaskF;
+  _VXFullBB = VXFullBB;
+  _VXFullFF = VXFullFF;
+  _VYFullBB = VYFullBB;
+  _VYFullFF = VYFullFF;
+  _VPitch = VPitch;
+  _width = width;
+  _time256 = time256;
+  _nPel = nPel;
+
+  Slicer slicer(_mt_flag);
+  slicer.start(height, *this, &FlowInterSlicer::flow_slice<pixel_t>, 8);
+  slicer.wait();
+}
+
+template<typename pixel_t>
+void FlowInterSlicer::flow_slice(Slicer::TaskData &td)
+{
+  assert(&td != 0);
+
+  const int y = td._y_beg;
+  const int height = td._y_end - td._y_beg;
+  // the reference planes are nPel times higher
+  uint8_t *pdst = _pdst + y * _dst_pitch;
+  const uint8_t *prefB = _prefB + y * _ref_pitch * _nPel;
+  const uint8_t *prefF = _prefF + y * _ref_pitch * _nPel;
+  const int voffset = y * _VPitch;
+
+  switch (_mode)
+  {
+  case FLOW_SIMPLE:
+    ::FlowInterSimple<pixel_t>(pdst, _dst_pitch, prefB, prefF, _ref_pitch,
+      _VXFullB + voffset, _VXFullF + voffset, _VYFullB + voffset, _VYFullF + voffset, _MaskB + voffset, _MaskF + voffset,
+      _VPitch, _width, height, _time256, _nPel, _cpuFlags);
+    break;
+  case FLOW_INTER:
+    ::FlowInter<pixel_t>(pdst, _dst_pitch, prefB, prefF, _ref_pitch,
+      _VXFullB + voffset, _VXFullF + voffset, _VYFullB + voffset, _VYFullF + voffset, _MaskB + voffset, _MaskF + voffset,
+      _VPitch, _width, height, _time256, _nPel, _cpuFlags);
+    break;
+  case FLOW_EXTRA:
+    ::FlowInterExtra<pixel_t>(pdst, _dst_pitch, prefB, prefF, _ref_pitch,
+      _VXFullB + voffset, _VXFullF + voffset, _VYFullB + voffset, _VYFullF + voffset, _MaskB + voffset, _MaskF + voffset,
+      _VPitch, _width, height, _time256, _nPel,
+      _VXFullBB + voffset, _VXFullFF + voffset, _VYFullBB + voffset, _VYFullFF + voffset, _cpuFlags);
+    break;
+  }
+}
+
+// instantiate
+#define MAKE_FN(pixel_t) \
+template void FlowInterSlicer::FlowInterSimple<pixel_t>(uint8_t *, int, const uint8_t *, const uint8_t *, int, \
+  short *, short *, short *, short *, uint8_t *, uint8_t *, int, int, int, int, int); \
+template void FlowInterSlicer::FlowInter<pixel_t>(uint8_t *, int, const uint8_t *, const uint8_t *, int, \
+  short *, short *, short *, short *, uint8_t *, uint8_t *, int, int, int, int, int); \
+template void FlowInterSlicer::FlowInterExtra<pixel_t>(uint8_t *, int, const uint8_t *, const uint8_t *, int, \
+  short *, short *, short *, short *, uint8_t *, uint8_t *, int, int, int, int, int, short *, short *, short *, short *);
+
+MAKE_FN(uint8_t)
+MAKE_FN(uint16_t)
+MAKE_FN(float)
+#undef MAKE_FN
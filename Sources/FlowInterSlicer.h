@@ -0,0 +1,89 @@
+// Slice-parallel flow interpolation for MFlowInter and MFlowFps
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __MV_FLOWINTERSLICER__
+#define __MV_FLOWINTERSLICER__
+
+#include "MTSlicer.h"
+#include <stdint.h>
+
+// Same calls as FlowInterSimple / FlowInter / FlowInterExtra of MaskFun.h,
+// the rows of the plane are split between the avstp threads.
+// Meant to be instantiated on the stack in GetFrame.
+class FlowInterSlicer
+{
+public:
+  FlowInterSlicer(bool mt_flag, int cpuFlags);
+
+  template<typename pixel_t>
+  void FlowInterSimple(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
+    short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+    int VPitch, int width, int height, int time256, int nPel);
+
+  template<typename pixel_t>
+  void FlowInter(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
+    short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+    int VPitch, int width, int height, int time256, int nPel);
+
+  template<typename pixel_t>
+  void FlowInterExtra(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
+    short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+    int VPitch, int width, int height, int time256, int nPel,
+    short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF);
+
+private:
+  typedef MTSlicer <FlowInterSlicer> Slicer;
+
+  enum FlowMode { FLOW_SIMPLE, FLOW_INTER, FLOW_EXTRA };
+
+  template<typename pixel_t>
+  void run(FlowMode mode, uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
+    short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+    int VPitch, int width, int height, int time256, int nPel,
+    short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF);
+
+  template<typename pixel_t>
+  void flow_slice(Slicer::TaskData &td);
+
+  const bool _mt_flag;
+  const int _cpuFlags;
+
+  // parameters of the current call
+  FlowMode _mode;
+  uint8_t *_pdst;
+  int _dst_pitch;
+  const uint8_t *_prefB;
+  const uint8_t *_prefF;
+  int _ref_pitch;
+  short *_VXFullB;
+  short *_VXFullF;
+  short *_VYFullB;
+  short *_VYFullF;
+  uint8_t *_MaskB;
+  uint8_t *_MaskF;
+  short *_VXFullBB;
+  short *_VXFullFF;
+  short *_VYFullBB;
+  short *_VYFullFF;
+  int _VPitch;
+  int _width;
+  int _time256;
+  int _nPel;
+};
+
+#endif
@@ -31,7 +31,7 @@ GroupOfPlanes::GroupOfPlanes(
   int _nOverlapX, int _nOverlapY, int _nBlkX, int _nBlkY, int _xRatioUV, int _yRatioUV,
   int _divideExtra, int _pixelsize, int _bits_per_pixel,
   conc::ObjPool <DCTClass> *dct_pool_ptr,
-  bool mt_flag, int _chromaSADScale, int _optSearchOption, float _scaleCSADfine,
+  bool mt_flag, bool tile_flag, int _chromaSADScale, int _optSearchOption, float _scaleCSADfine,
   int _iUseSubShift, int _DMFlags,
   int _AreaMode, int _AMDiffSAD, int _AMstep, int _AMoffset, int _AMpel,
   IScriptEnvironment* env
@@ -49,6 +49,7 @@ GroupOfPlanes::GroupOfPlanes(
   , divideExtra(_divideExtra)
   , bits_per_pixel(_bits_per_pixel)
   , _mt_flag(mt_flag)
+  , _tile_flag(tile_flag)
   , chromaSADScale(_chromaSADScale)
   , optSearchOption(_optSearchOption)
   , scaleCSADfine(_scaleCSADfine)
@@ -60,6 +61,7 @@ GroupOfPlanes::GroupOfPlanes(
   , AMstep(_AMstep)
   , AMoffset(_AMoffset)
   , AMpel(_AMpel)
+  , _prof_ptr(0)
 {
   planes = new PlaneOfBlocks*[nLevelCount];
 
@@ -72,6 +74,9 @@ GroupOfPlanes::GroupOfPlanes(
   int				nWidth_B = (nBlkSizeX - nOverlapX) * nBlkX + nOverlapX;
   int				nHeight_B = (nBlkSizeY - nOverlapY) * nBlkY + nOverlapY;
 
+  // UseSubShift=2: only the finest level, the coarser ones have no sub-pel positions to shift
+  int				iUseSubShiftCurrent = iUseSubShift;
+
   for (int i = 0; i < nLevelCount; i++)
   {
     if (i == nLevelCount - 1)
@@ -82,8 +87,12 @@ GroupOfPlanes::GroupOfPlanes(
     nBlkY = ((nHeight_B >> i) - nOverlapY) / (nBlkSizeY - nOverlapY);
     planes[i] = new PlaneOfBlocks(nBlkX, nBlkY, nBlkSizeX, nBlkSizeY, nPelCurrent, i, nFlagsCurrent, nOverlapX, nOverlapY,
       xRatioUV, yRatioUV, pixelsize, bits_per_pixel, dct_pool_ptr,
-      mt_flag, chromaSADScale, optSearchOption, scaleCSADfine, iUseSubShift, DMFlags, AMDiffSAD, env);
+      mt_flag, tile_flag, chromaSADScale, optSearchOption, scaleCSADfine, iUseSubShiftCurrent, DMFlags, AMDiffSAD, env);
     nPelCurrent = 1;
+    if (iUseSubShift == 2)
+    {
+      iUseSubShiftCurrent = 0;
+    }
   }
 }
 
@@ -211,6 +220,7 @@ void	GroupOfPlanes::SearchMVs(
   DebugPrintf("SearchType %i", searchType);
   bool				tryManyLevel = (tryMany && nLevelCount > 1);
 
+  MVProfileScope	prof_coarsest(_prof_ptr, mvprof_search_stage(nLevelCount - 1));
 
   planes[nLevelCount - 1]->SearchMVs(
     pSrcGOF->GetFrame(nLevelCount - 1),
@@ -250,6 +260,8 @@ void	GroupOfPlanes::SearchMVs(
     MPM
   );
 
+  prof_coarsest.stop();
+
   out += planes[nLevelCount - 1]->GetArraySize(divideExtra);
   if (vecPrev)
   {
@@ -267,7 +279,7 @@ void	GroupOfPlanes::SearchMVs(
     int				nSearchParamLevel =
       (i == 0) ? nPelSearch : nSearchParam; // special case for finest level
 
-    PROFILE_START(MOTION_PROFILE_PREDICTION);
+    MVProfileScope	prof_pred(_prof_ptr, MVPROF_PREDICTION);
     if (global)
     {
       // get updated global MV (doubled)
@@ -294,7 +306,7 @@ void	GroupOfPlanes::SearchMVs(
     {
       slicer_glob.wait();
     }
-    PROFILE_STOP(MOTION_PROFILE_PREDICTION);
+    prof_pred.stop();
 
     fieldShiftCur = (i == 0) ? fieldShift : 0; // may be non zero for finest level only
 //		DebugPrintf("SearchMV level %i", i);
@@ -322,6 +334,8 @@ void	GroupOfPlanes::SearchMVs(
       PTlevel = PTpel;
     }
 
+    MVProfileScope	prof_level(_prof_ptr, mvprof_search_stage(i));
+
     planes[i]->SearchMVs(
       pSrcGOF->GetFrame(i),
       pRefGOF->GetFrame(i),
@@ -360,6 +374,7 @@ void	GroupOfPlanes::SearchMVs(
       MPM
     );
 
+    prof_level.stop();
 
     out += planes[i]->GetArraySize(divideExtra);
     if (vecPrev)
@@ -419,6 +434,7 @@ void	GroupOfPlanes::RecalculateMVs(
     pglobal = pzero;
   }
 
+  MVProfileScope	prof_pred(_prof_ptr, MVPROF_PREDICTION);
   PlaneOfBlocks::Slicer	slicer_glob(_mt_flag);
   if (_global)
   {
@@ -430,10 +446,12 @@ void	GroupOfPlanes::RecalculateMVs(
   {
     slicer_glob.wait();
   }
+  prof_pred.stop();
 
   // Search the motion vectors, for the low details interpolations first
   // Refining the search until we reach the highest detail interpolation.
 //	DebugPrintf("SearchMV level %i", nLevelCount-1);
+  MVProfileScope	prof_recalc(_prof_ptr, MVPROF_RECALCULATE);
   planes[0]->RecalculateMVs(
     mvClip,
     pSrcGOF->GetFrame(0),
@@ -468,6 +486,145 @@ void	GroupOfPlanes::RecalculateMVs(
 
 
 
+// Searches the vectors of a frame pair already searched in the opposite
+// direction (opposite: its vector array). The coarse levels are the inverted
+// opposite fields, without search. The finest level is searched like in
+// SearchMVs(), from the inverted opposite field instead of the interpolated
+// coarser level.
+void	GroupOfPlanes::SearchMVsDerived(
+  MVGroupOfFrames *pSrcGOF,
+  MVGroupOfFrames *pRefGOF,
+  const int *opposite,
+  SearchType searchType,
+  int    nPelSearch,
+  int    nLambda,
+  sad_t    lsad,
+  int    pnew,
+  int    plevel,
+  bool   global,
+  int    flags,
+  int *  out,
+  short* outfilebuf,
+  int    fieldShift,
+  int    pzero,
+  int    pglobal,
+  sad_t    badSAD,
+  int    badrange,
+  bool   meander,
+  int *  vecPrev,
+  int    optPredictorType,
+  int    PTpel,
+  int    AMflags,
+  int    AMavg,
+  int    AMpt,
+  SearchType    AMst,
+  int    AMsp,
+  int    TMAvg,
+  int    MDp,
+  int    ScanDir,
+  int    MPM
+)
+{
+  nFlags |= flags;
+
+  // write group's size
+  out[0] = GetArraySize();
+
+  // write validity : 1 in that case
+  out[1] = 1;
+
+  out += 2;
+  opposite += 2;
+  if (vecPrev)
+  {
+    vecPrev += 2;
+  }
+
+  VECTOR globalMV;
+  globalMV.x = zeroMV.x;
+  globalMV.y = zeroMV.y;
+  globalMV.sad = zeroMV.sad;
+
+  if (!global)
+  {
+    pglobal = pzero;
+  }
+
+  MVProfileScope	prof_pred(_prof_ptr, MVPROF_PREDICTION);
+  for (int i = nLevelCount - 1; i > 0; i--)
+  {
+    planes[i]->InvertPrediction(opposite, pSrcGOF->GetFrame(i));
+    out += planes[i]->WritePredictionToArray(out);
+    opposite += planes[i]->GetArraySize(divideExtra);
+    if (vecPrev)
+    {
+      vecPrev += planes[i]->GetArraySize(divideExtra);
+    }
+  }
+  planes[0]->InvertPrediction(opposite, pSrcGOF->GetFrame(0));
+
+  if (global && nLevelCount > 1)
+  {
+    PlaneOfBlocks::Slicer	slicer_glob(_mt_flag);
+    planes[1]->EstimateGlobalMVDoubled(&globalMV, slicer_glob);
+    slicer_glob.wait();
+  }
+  prof_pred.stop();
+
+  // Same finest level parameters as SearchMVs()
+  int AMlevel = AreaMode;
+  int PTlevel = optPredictorType;
+  if (nPel == 2 || nPel == 4)
+  {
+    AMlevel = AMpel;
+    PTlevel = PTpel;
+  }
+
+  int meanLumaChange = 0;
+
+  MVProfileScope	prof_level(_prof_ptr, mvprof_search_stage(0));
+
+  planes[0]->SearchMVs(
+    pSrcGOF->GetFrame(0),
+    pRefGOF->GetFrame(0),
+    searchType,
+    nPelSearch,
+    nLambda,
+    lsad,
+    pnew,
+    plevel,
+    flags,
+    out,
+    &globalMV,
+    outfilebuf,
+    fieldShift,
+    &meanLumaChange,
+    divideExtra,
+    pzero,
+    pglobal,
+    badSAD,
+    badrange,
+    meander,
+    vecPrev,
+    false,
+    PTlevel,
+    AMlevel,
+    AMstep,
+    AMoffset,
+    AMflags,
+    AMavg,
+    AMpt,
+    AMst,
+    AMsp,
+    TMAvg,
+    MDp,
+    (ScanDir == 1),
+    MPM
+  );
+}
+
+
+
 void GroupOfPlanes::WriteDefaultToArray(int *array)
 {
   // write group's size
@@ -21,6 +21,7 @@
 
 
 #include "PlaneOfBlocks.h"
+#include "profile.h"
 #include "avisynth.h"
 
 
@@ -42,6 +43,7 @@ class GroupOfPlanes
     int bits_per_pixel;
   int            divideExtra;
   bool           _mt_flag;
+  bool           _tile_flag;
   int            optSearchOption; // DTL test
   float          scaleCSADfine; //DTL test
   int            iUseSubShift; // DTL test
@@ -56,13 +58,14 @@ class GroupOfPlanes
                  _dct_pool_ptr;
   PlaneOfBlocks **
                  planes;
+  MVProfiler *   _prof_ptr; // Not owned, 0 if profiling is disabled
 
 public :
   GroupOfPlanes(
     int _nBlkSizeX, int _nBlkSizeY, int _nLevelCount, int _nPel, int _nFlags,
     int _nOverlapX, int _nOverlapY, int _nBlkX, int _nBlkY, int _xRatioUV, int _yRatioUV, int _divideExtra, int _pixelsize, int _bits_per_pixel, 
     conc::ObjPool <DCTClass> *dct_pool_ptr,
-    bool mt_flag, int _chromaSADScale, int _optSearchOption, float _scaleCSADfine, int _iUseSubShift, int DMFlags,
+    bool mt_flag, bool tile_flag, int _chromaSADScale, int _optSearchOption, float _scaleCSADfine, int _iUseSubShift, int DMFlags,
     int _AreaMode, int _AMDiffSAD, int _AMstep, int _AMoffset, int _AMpel,
     IScriptEnvironment *env);
   ~GroupOfPlanes ();
@@ -74,6 +77,14 @@ public :
     int badrange, bool meander, int *vecPrev, bool tryMany, int optPredictorType, int PTpel,
     int AMflags, int AMavg, int AMpt, SearchType AMst, int AMsp,
     int TMAvg, int MDp, int ScanDir, int MPM);
+  void           SearchMVsDerived (
+    MVGroupOfFrames *pSrcGOF, MVGroupOfFrames *pRefGOF, const int *opposite,
+    SearchType searchType, int _PelSearch, int _nLambda,
+    sad_t _lsad, int _pnew, int _plevel, bool _global, int flags, int *out,
+    short * outfilebuf, int fieldShift, int _pzero, int _pglobal, sad_t badSAD,
+    int badrange, bool meander, int *vecPrev, int optPredictorType, int PTpel,
+    int AMflags, int AMavg, int AMpt, SearchType AMst, int AMsp,
+    int TMAvg, int MDp, int ScanDir, int MPM);
   void           WriteDefaultToArray (int *array);
   int            GetArraySize ();
   void           ExtraDivide (int *out, int flags);
@@ -84,6 +95,7 @@ public :
     sad_t thSAD, int smooth, bool meander, int optPredictorType, int AreaMode, int AMstep, int AMoffset, float fAMthVSMang, int AMflags, int AMavg,
     bool _global, int pglobal, int pzero);
   PlaneOfBlocks* GetPlane(int iPlane) { return planes[iPlane]; };
+  void           set_profiler(MVProfiler *prof_ptr) { _prof_ptr = prof_ptr; };
 };
 
 #endif
@@ -50,6 +50,7 @@
 // Test & helpers filters
 #include "Padding.h"
 #include "MVFinest.h"
+#include "MLoadVectors.h"
 #include "MRestoreVect.h"
 #include "MScaleVect.h"
 #include "MStoreVect.h"
@@ -223,6 +224,11 @@ AVSValue __cdecl Create_MVAnalyse(AVSValue args, void* user_data, IScriptEnviron
     args[53].AsInt(-1), // mdp - MotionDistortion predictor, -1 - hierarchy predictor, 0 and higher - AMavg mode average of (some) predictors
     args[54].AsInt(1), // scandir - direction of search in the frame, 1 - lines scan top to bottom, 2 - lines bottom to top
     args[55].AsInt(0), // mpm - median predictor mode: 0 - median of 3, 1 - copy of MD predictor
+    args[56].AsString(""), // vectorfile - indexed vector file for MLoadVectors
+    args[57].AsBool(false), // batch - multi mode: search all the deltas of a source frame at once
+    args[58].AsBool(false), // derive - multi mode: forward vectors derived from the backward ones of the same frame pair
+    args[59].AsInt(0), // packed - vector data format: 0 - raw, 1 - packed (MVPackedVectors), 2 - packed finest level only
+    args[60].AsBool(false), // tiles - mt search over wavefront tiles instead of row slices
     env
   );
 }
@@ -295,6 +301,7 @@ AVSValue __cdecl Create_MVFlow(AVSValue args, void*, IScriptEnvironment* env)
     args[8].AsBool(true),
     args[9].AsBool(false), // planar
     args[10].IsClip() ? args[10].AsClip() : 0,
+    args[11].AsBool(true),  // mt
     env
   );
 }
@@ -324,6 +331,7 @@ AVSValue __cdecl Create_MVFlowInter(AVSValue args, void*, IScriptEnvironment* en
     args[8].AsInt(MV_DEFAULT_SCD2),
     args[9].AsBool(true),   // isse
     args[10].AsBool(false), // planar
+    args[12].AsBool(true),  // mt
     env);
 }
 
@@ -349,6 +357,7 @@ AVSValue __cdecl Create_MVFlowFps(AVSValue args, void*, IScriptEnvironment* env)
     args[11].AsBool(true),  // isse
     args[12].AsBool(false), // planar
     args[13].AsInt(0), // optDebug
+    args[14].AsBool(true),  // mt
     env
   );
 }
@@ -484,9 +493,13 @@ AVSValue __cdecl Create_MDegrainN(AVSValue args, void*, IScriptEnvironment* env)
   const float limit = args[7].AsFloatf(255.f); // change limit. 2.7.25-: use 255 as default for all bit depth v42:float
   const int thSAD2 = args[14].AsInt(thSAD);  // thSAD2
   const int thSADC2 = args[15].AsInt(thSAD2); // thSADC2
+  const bool prefetch = args[62].AsBool(false);
+
+  const int UseSubShift = args[27].AsInt(0);
 
   // Switch to MDegrain1/2/3/4/5/6 when possible (faster)
-  if (thSAD2 == thSAD && thSADC == thSADC2)
+  // MDegrain1..6 have no prefetch option and always read the refined planes
+  if (thSAD2 == thSAD && thSADC == thSADC2 && !prefetch && UseSubShift == 0)
   {
     if (tr <= MAX_DEGRAIN) // up to MDegrain5 160926, MDegrain6 170105
     {
@@ -589,6 +602,8 @@ AVSValue __cdecl Create_MDegrainN(AVSValue args, void*, IScriptEnvironment* env)
                        // fixme: out32
     args[60].AsInt(0), // LtComp - compesate for lighting changes 0 - default disabled, 1 - only DC comp mode
     args[61].AsInt(0), // NEW_DMFlags - update dissimilarity metric of input MVs  
+    prefetch, // prefetch - fetch the upstream frames of n+1 while processing n
+    args[63].AsBool(false), // TTH_DMcache - reuse the TTH frame pair dismetrics of the previous frames, faster, output differs
     env
   );
 }
@@ -658,6 +673,7 @@ AVSValue __cdecl Create_MVRecalculate(AVSValue args, void*, IScriptEnvironment*
     args[34].AsBool(true), // global (use global predictor or not
     pzero,
     pglobal,
+    args[37].AsInt(0), // packed - vector data format: 0 - raw, 1 - packed (MVPackedVectors), 2 - packed finest level only
     env
   );
 }
@@ -774,6 +790,14 @@ AVSValue __cdecl Create_MRestoreVect(AVSValue args, void*, IScriptEnvironment* e
   );
 }
 
+AVSValue __cdecl Create_MLoadVectors(AVSValue args, void*, IScriptEnvironment* env_ptr)
+{
+  return new MLoadVectors(
+    args[0].AsString(""), // vector file
+    env_ptr
+  );
+}
+
 AVSValue __cdecl Create_MScaleVect(AVSValue args, void*, IScriptEnvironment* env)
 {
   enum { CLIP, SCALE, SCALEV, MODE, FLIP, ADJUSTSUBPEL, BITS };
@@ -807,14 +831,14 @@ AvisynthPluginInit3(IScriptEnvironment* env, const AVS_Linkage* const vectors) {
   AVS_linkage = vectors;
 #endif
   env->AddFunction("MShow", "cc[scale]i[sil]i[tol]i[showsad]b[number]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVShow, 0);
-  env->AddFunction("MAnalyse", "c[blksize]i[blksizeV]i[levels]i[search]i[searchparam]i[pelsearch]i[isb]b[lambda]i[chroma]b[delta]i[truemotion]b[lsad]i[plevel]i[global]b[pnew]i[pzero]i[pglobal]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[badSAD]i[badrange]i[isse]b[meander]b[temporal]b[trymany]b[multi]b[mt]b[scaleCSAD]i[optsearchoption]i[optpredictortype]i[scaleCSADfine]f[accnum]i[UseSubShift]i[SuperCurrent]c[SearchDirMode]i[DMFlags]i[AreaMode]i[AMdiffSAD]i[AMstep]i[AMoffset]i[AMpel]i[PTpel]i[AMflags]i[AMavg]i[AMpt]i[AMst]i[AMsp]i[tmavg]i[mdp]i[scandir]i[mpm]i", Create_MVAnalyse, 0);
+  env->AddFunction("MAnalyse", "c[blksize]i[blksizeV]i[levels]i[search]i[searchparam]i[pelsearch]i[isb]b[lambda]i[chroma]b[delta]i[truemotion]b[lsad]i[plevel]i[global]b[pnew]i[pzero]i[pglobal]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[badSAD]i[badrange]i[isse]b[meander]b[temporal]b[trymany]b[multi]b[mt]b[scaleCSAD]i[optsearchoption]i[optpredictortype]i[scaleCSADfine]f[accnum]i[UseSubShift]i[SuperCurrent]c[SearchDirMode]i[DMFlags]i[AreaMode]i[AMdiffSAD]i[AMstep]i[AMoffset]i[AMpel]i[PTpel]i[AMflags]i[AMavg]i[AMpt]i[AMst]i[AMsp]i[tmavg]i[mdp]i[scandir]i[mpm]i[vectorfile]s[batch]b[derive]b[packed]i[tiles]b", Create_MVAnalyse, 0);
   env->AddFunction("MMask", "cc[ml]f[gamma]f[kind]i[time]f[Ysc]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVMask, 0);
   env->AddFunction("MCompensate", "ccc[scbehavior]b[recursion]f[thSAD]i[fields]b[time]f[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b[tr]i[center]b[cclip]c[thSAD2]i[showRNB]b", Create_MVCompensate, 0);
   env->AddFunction("MSCDetection", "cc[Ysc]i[thSCD1]i[thSCD2]i[isse]b", Create_MVSCDetection, 0);
   env->AddFunction("MDepan", "cc[mask]c[zoom]b[rot]b[pixaspect]f[error]f[info]b[log]s[wrong]f[zerow]f[range]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVDepan, 0);
-  env->AddFunction("MFlow", "ccc[time]f[mode]i[fields]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c", Create_MVFlow, 0);
-  env->AddFunction("MFlowInter", "cccc[time]f[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c", Create_MVFlowInter, 0);
-  env->AddFunction("MFlowFps", "cccc[num]i[den]i[mask]i[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[optDebug]i", Create_MVFlowFps, 0);
+  env->AddFunction("MFlow", "ccc[time]f[mode]i[fields]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c[mt]b", Create_MVFlow, 0);
+  env->AddFunction("MFlowInter", "cccc[time]f[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c[mt]b", Create_MVFlowInter, 0);
+  env->AddFunction("MFlowFps", "cccc[num]i[den]i[mask]i[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[optDebug]i[mt]b", Create_MVFlowFps, 0);
   env->AddFunction("MFlowBlur", "cccc[blur]f[prec]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVFlowBlur, 0);
   env->AddFunction("MDegrain1", "cccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b[out32]b", Create_MVDegrainX, (void *)1);
   env->AddFunction("MDegrain2", "cccccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b[out32]b", Create_MVDegrainX, (void *)2);
@@ -822,12 +846,13 @@ AvisynthPluginInit3(IScriptEnvironment* env, const AVS_Linkage* const vectors) {
   env->AddFunction("MDegrain4", "cccccccccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b[out32]b", Create_MVDegrainX, (void *)4);
   env->AddFunction("MDegrain5", "cccccccccccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b[out32]b", Create_MVDegrainX, (void *)5);
   env->AddFunction("MDegrain6", "cccccccccccccc[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b[out16]b[out32]b", Create_MVDegrainX, (void *)6);
-  env->AddFunction("MDegrainN", "ccci[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[thsad2]i[thsadc2]i[mt]b[out16]b[wpow]i[adjSADzeromv]f[adjSADcohmv]f[thCohMV]i[MVLPFCutoff]f[MVLPFSlope]f[MVLPFGauss]f[thMVLPFCorr]i[adjSADLPFedmv]f[UseSubShift]i[IntOvlp]i[mvmultirs]c[thFWBWmvpos]i[MPBthSub]i[MPBthAdd]i[MPBNumIt]i[MPB_SPCsub]f[MPB_SPCadd]f[MPB_PartBlend]b[MPBthIVS]i[showIVSmask]b[mvmultivs]c[MPB_DMFlags]i[MPBchroma]i[MPBtgtTR]i[MPB_MVlth]i[pmode]i[TTH_DMFlags]i[TTH_thUPD]i[TTH_BAS]i[TTH_chroma]b[dnmask]c[thSADA_a]f[thSADA_b]f[MVMedF]i[MVMedF_em]i[MVMedF_cm]i[MVF_fm]i[MGR]i[MGR_sr]i[MGR_st]i[MGR_pm]i[LtComp]i[NEW_DMFlags]i", Create_MDegrainN, 0);
-  env->AddFunction("MRecalculate", "cc[thsad]i[smooth]i[blksize]i[blksizeV]i[search]i[searchparam]i[lambda]i[chroma]b[truemotion]b[pnew]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[isse]b[meander]b[tr]i[mt]b[scaleCSAD]i[optsearchoption]i[optpredictortype]i[DMFlags]i[AreaMode]i[AMdiffSAD]i[AMstep]i[AMoffset]i[SuperCurrent]c[AMthVSMang]f[AMflags]i[AMavg]i[global]b[pzero]i[pglobal]i", Create_MVRecalculate, 0);
+  env->AddFunction("MDegrainN", "ccci[thSAD]i[thSADC]i[plane]i[limit]f[limitC]f[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[thsad2]i[thsadc2]i[mt]b[out16]b[wpow]i[adjSADzeromv]f[adjSADcohmv]f[thCohMV]i[MVLPFCutoff]f[MVLPFSlope]f[MVLPFGauss]f[thMVLPFCorr]i[adjSADLPFedmv]f[UseSubShift]i[IntOvlp]i[mvmultirs]c[thFWBWmvpos]i[MPBthSub]i[MPBthAdd]i[MPBNumIt]i[MPB_SPCsub]f[MPB_SPCadd]f[MPB_PartBlend]b[MPBthIVS]i[showIVSmask]b[mvmultivs]c[MPB_DMFlags]i[MPBchroma]i[MPBtgtTR]i[MPB_MVlth]i[pmode]i[TTH_DMFlags]i[TTH_thUPD]i[TTH_BAS]i[TTH_chroma]b[dnmask]c[thSADA_a]f[thSADA_b]f[MVMedF]i[MVMedF_em]i[MVMedF_cm]i[MVF_fm]i[MGR]i[MGR_sr]i[MGR_st]i[MGR_pm]i[LtComp]i[NEW_DMFlags]i[prefetch]b[TTH_DMcache]b", Create_MDegrainN, 0);
+  env->AddFunction("MRecalculate", "cc[thsad]i[smooth]i[blksize]i[blksizeV]i[search]i[searchparam]i[lambda]i[chroma]b[truemotion]b[pnew]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[isse]b[meander]b[tr]i[mt]b[scaleCSAD]i[optsearchoption]i[optpredictortype]i[DMFlags]i[AreaMode]i[AMdiffSAD]i[AMstep]i[AMoffset]i[SuperCurrent]c[AMthVSMang]f[AMflags]i[AMavg]i[global]b[pzero]i[pglobal]i[packed]i", Create_MVRecalculate, 0);
   env->AddFunction("MBlockFps", "cccc[num]i[den]i[mode]i[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b", Create_MVBlockFps, 0);
   env->AddFunction("MSuper", "c[hpad]i[vpad]i[pel]i[levels]i[chroma]b[sharp]i[rfilter]i[pelclip]c[isse]b[planar]b[mt]b[pelrefine]b", Create_MVSuper, 0);
   env->AddFunction("MStoreVect", "c+[vccs]s", Create_MStoreVect, 0);
   env->AddFunction("MRestoreVect", "c[index]i", Create_MRestoreVect, 0);
+  env->AddFunction("MLoadVectors", "s", Create_MLoadVectors, 0);
   env->AddFunction("MScaleVect", "c[scale]f[scaleV]f[mode]i[flip]b[adjustSubPel]b[bits]i", Create_MScaleVect, 0);
   //	env->AddFunction("MVFinest",     "c[isse]b", Create_MVFinest, 0);
   env->AddFunction("MAverage", "c+[mode]i", Create_MAverage, 0);
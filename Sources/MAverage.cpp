@@ -14,6 +14,7 @@
 /*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
 
 #include	"MAverage.h"
+#include	"MVSceneStats.h"
 #include	<cassert>
 #include  <algorithm>
 
@@ -67,6 +68,10 @@ MAverage::MAverage(std::vector <::PClip> clip_arr, int _mode, IScriptEnvironment
     {
       env->ThrowError("MAverage: invalid vector stream.");
     }
+    if ((mad.GetFlags() & MOTION_PACKED_VECTORS) != 0)
+    {
+      env->ThrowError("MAverage: packed vector clips are not supported.");
+    }
 
     // copy pointer to class for the first MV clip and init analysis data 
     if (clip_cnt == 0)
@@ -106,6 +111,10 @@ MAverage::MAverage(std::vector <::PClip> clip_arr, int _mode, IScriptEnvironment
   // Copy and fix header
   int headerSize = *pData;
   memcpy(pDst, pData, headerSize);
+  // averaged SADs, the scene stats of the first clip do not describe them
+  MVSceneStats* stats_ptr = MVSceneStats::from_frame(reinterpret_cast<unsigned char*>(pDst));
+  if (stats_ptr != 0)
+    stats_ptr->invalidate();
 
   const MVAnalysisData& hdr_src =
     *reinterpret_cast <const MVAnalysisData*> (pData + 1);
@@ -5,8 +5,10 @@
 #include	"def.h"
 #include	"MDegrainN.h"
 #include  "MVDegrain3.h"
+#include  "MDegrainN_avx2.h"
 #include  "MVFrame.h"
 #include  "MVPlane.h"
+#include  "MVSceneStats.h"
 #include  "MVFilter.h"
 #include  "profile.h"
 #include  "SuperParams64Bits.h"
@@ -60,8 +62,19 @@ MV_FORCEINLINE float fDiffAngleVect(int x1, int y1, int x2, int y2)
   return fResult;
 
 }
-
-// out16_type: 
+
+// x, y and sad planes of nPos positions, one after the other
+static MV_SOA MakeMVsSoA(int* pBase, int nPos, int iPitch)
+{
+  MV_SOA mvs;
+  mvs.x = pBase;
+  mvs.y = pBase + nPos * iPitch;
+  mvs.sad = pBase + nPos * iPitch * 2;
+  mvs.pos_pitch = iPitch;
+  return mvs;
+}
+
+// out16_type: 
 //   0: native 8 or 16
 //   1: 8bit in, lsb
 //   2: 8bit in, native16 out
@@ -770,6 +783,55 @@ func_degrain[make_tuple(x, y, DEGRAIN_TYPE_16BIT, USE_SSE41)] = DegrainN_16_sse4
   return result;
 }
 
+MDegrainN::DegrainNOverlapsYUVFunction* MDegrainN::get_degrainN_overlaps_yuv_function(int BlockX, int BlockY, int nLogxRatioUV, int nLogyRatioUV, int _bits_per_pixel, bool _lsb_flag, bool _out16_flag, arch_t arch)
+{
+  // short (8 bit) and int (10-16 bit) overlap buffers only, AVX2 only.
+  // Otherwise the separate degrain and overlaps functions are used.
+  if (_lsb_flag || _out16_flag || arch < USE_AVX2)
+    return nullptr;
+
+  const int DEGRAIN_TYPE_8BIT = 1;
+  const int DEGRAIN_TYPE_10to14BIT = 8;
+  const int DEGRAIN_TYPE_16BIT = 16;
+  // BlkSizeX, BlkSizeY, nLogxRatioUV, nLogyRatioUV, degrain_type
+  std::map<std::tuple<int, int, int, int, int>, DegrainNOverlapsYUVFunction*> func_degrain;
+  using std::make_tuple;
+
+  int type_to_search;
+  if (_bits_per_pixel == 8)
+    type_to_search = DEGRAIN_TYPE_8BIT;
+  else if (_bits_per_pixel <= 14)
+    type_to_search = DEGRAIN_TYPE_10to14BIT;
+  else if (_bits_per_pixel == 16)
+    type_to_search = DEGRAIN_TYPE_16BIT;
+  else
+    return nullptr;
+
+#define MAKE_FN_SS(x, y, xs, ys) \
+func_degrain[make_tuple(x, y, xs, ys, DEGRAIN_TYPE_8BIT)] = DegrainN_Overlaps_YUV_avx2<x, y, xs, ys, uint8_t, true>; \
+func_degrain[make_tuple(x, y, xs, ys, DEGRAIN_TYPE_10to14BIT)] = DegrainN_Overlaps_YUV_avx2<x, y, xs, ys, uint16_t, true>; \
+func_degrain[make_tuple(x, y, xs, ys, DEGRAIN_TYPE_16BIT)] = DegrainN_Overlaps_YUV_avx2<x, y, xs, ys, uint16_t, false>;
+  // 4:2:0, 4:2:2, 4:4:4
+#define MAKE_FN(x, y) \
+MAKE_FN_SS(x, y, 1, 1) \
+MAKE_FN_SS(x, y, 1, 0) \
+MAKE_FN_SS(x, y, 0, 0)
+  MAKE_FN(64, 64)
+  MAKE_FN(64, 32)
+  MAKE_FN(48, 48)
+  MAKE_FN(32, 32)
+  MAKE_FN(32, 16)
+  MAKE_FN(24, 24)
+  MAKE_FN(16, 16)
+  MAKE_FN(16, 8)
+  MAKE_FN(12, 12)
+  MAKE_FN(8, 8)
+#undef MAKE_FN
+#undef MAKE_FN_SS
+
+  return func_degrain[make_tuple(BlockX, BlockY, nLogxRatioUV, nLogyRatioUV, type_to_search)];
+}
+
 
 
 MDegrainN::MDegrainN(
@@ -784,8 +846,8 @@ MDegrainN::MDegrainN(
   int _pmode, int _TTH_DMFlags, int _TTH_thUPD, int _TTH_BAS, bool _TTH_chroma, PClip _dnmask,
   float _thSADA_a, float _thSADA_b, int _MVMedF, int _MVMedF_em, int _MVMedF_cm, int _MVF_fm,
   int _MGR, int _MGR_sr, int _MGR_st, int _MGR_pm,
-  int _LtComp, int _NEW_DMFlags,
-  IScriptEnvironment* env_ptr
+  int _LtComp, int _NEW_DMFlags, bool prefetch_flag, bool _TTH_DMcache,
+  IScriptEnvironment* env_ptr
 )
   : GenericVideoFilter(child)
   , MVFilter(mvmulti, "MDegrainN", env_ptr, 1, 0)
@@ -815,6 +877,7 @@ MDegrainN::MDegrainN(
   , _overschroma_lsb_ptr(0)
   , _degrainluma_ptr(0)
   , _degrainchroma_ptr(0)
+  , _degrainoverlaps_yuv_ptr(0)
   , _dst_short()
   , _dst_short_pitch()
   , _dst_int()
@@ -863,6 +926,7 @@ MDegrainN::MDegrainN(
   , TTH_thUPD(_TTH_thUPD)
   , TTH_BAS(_TTH_BAS)
   , TTH_chroma(_TTH_chroma)
+  , TTH_DMcache(_TTH_DMcache)
   , dnmask(_dnmask)
   , thSADA_a(_thSADA_a)
   , thSADA_b(_thSADA_b)
@@ -877,10 +941,19 @@ MDegrainN::MDegrainN(
   , iLtComp(_LtComp)
   , iNEW_DMFlags(_NEW_DMFlags)
   , veryBigSAD(3 * nBlkSizeX * nBlkSizeY * (pixelsize == 4 ? 1 : (1 << bits_per_pixel))) // * 256, pixelsize==2 -> 65536. Float:1
+  , _prefetch_flag(false)
+  , _prefetch_last_n(-1)
+  , _prefetch_fs()
+  , _prefetch_completion_ptr(0)
 {
   has_at_least_v8 = true;
   try { env_ptr->CheckVersion(8); }
   catch (const AvisynthError&) { has_at_least_v8 = false; }
+
+  // The jobs run on the AVS+ thread pool (IScriptEnvironment2, any v8
+  // interface is AVS+), which needs a worker thread besides the calling one.
+  _prefetch_flag = prefetch_flag && has_at_least_v8
+    && env_ptr->GetEnvProperty(AEP_THREADPOOL_THREADS) > 1;
 
   if (trad > MAX_TEMP_RAD)
   {
@@ -1106,7 +1179,8 @@ MDegrainN::MDegrainN(
       yRatioUV_super,
       pixelsize_super,
       bits_per_pixel_super,
-      mt_flag
+      mt_flag,
+      bPelRefine
     ));
 
     // Computes the SAD thresholds for this source frame, a cosine-shaped
@@ -1289,6 +1363,10 @@ MDegrainN::MDegrainN(
   if (!_degrainchroma_ptr)
     env_ptr->ThrowError("MDegrainN : no valid _degrainchroma_ptr function for %dx%d, pixelsize=%d, lsb_flag=%d", nBlkSizeX, nBlkSizeY, pixelsize_super, (int)lsb_flag);
 
+  // MPB, TTH and MGR read back the degrained blocks
+  if ((nOverlapX > 0 || nOverlapY > 0) && pmode == PM_BLEND && MPBNumIt == 0 && TTH_thUPD == 0 && iMGR == 0)
+    _degrainoverlaps_yuv_ptr = get_degrainN_overlaps_yuv_function(nBlkSizeX, nBlkSizeY, nLogxRatioUV_super, nLogyRatioUV_super, bits_per_pixel_super, lsb_flag, out16_flag, arch);
+
   if ((_cpuFlags & CPUF_SSE2) != 0)
   {
     if(out16_flag)
@@ -1409,6 +1487,24 @@ MDegrainN::MDegrainN(
 
   }
 
+  // SoA planes of the whole block rows temporal filtering:
+  // input row, median-like pass output row, then the filtered rows of the frame
+  MVLPF_SoA = get_mvlpf_soa_function(arch);
+  MVMedF_SoA = get_mvmedf_soa_function(iMVMedF_cm, arch);
+  MVAvg = get_mvavg_function(arch);
+  pMVsSoA_a = 0;
+  pMVsSoAFiltered = 0;
+  iMVsSoAPitch = (nBlkX + MVSOA_ALIGN - 1) & ~(MVSOA_ALIGN - 1);
+  if (bMVsAddProc)
+  {
+    const size_t stRowSize = (size_t)3 * (_trad * 2 + 1) * iMVsSoAPitch; // x, y and sad planes
+    pMVsSoA_a = (int*)_aligned_malloc(stRowSize * (2 + nBlkY) * sizeof(int), 64);
+    memset(pMVsSoA_a, 0, stRowSize * (2 + nBlkY) * sizeof(int)); // padding blocks are not written later
+    MVsSoAIn = MakeMVsSoA(pMVsSoA_a, _trad * 2 + 1, iMVsSoAPitch);
+    MVsSoATmp = MakeMVsSoA(pMVsSoA_a + stRowSize, _trad * 2 + 1, iMVsSoAPitch);
+    pMVsSoAFiltered = pMVsSoA_a + stRowSize * 2;
+  }
+
   // allocate interpolated overlap MVs arrays
   for (int k = 0; k < _trad * 2; ++k)
   {
@@ -1458,6 +1554,8 @@ MDegrainN::MDegrainN(
   // allocate MEL IIR filter memory storage
   if (TTH_thUPD > 0) // TTH in some mode enabled
   {
+    // one tile per block, rows of the tile width (see MEL_LC): the blocks never share
+    // memory, so the slices can update their block rows of the recursion in parallel
     SIZE_T stSizeToAlloc = nBlkSizeX * nBlkSizeY * pixelsize * nBlkCount;
     SIZE_T stSizeToAllocSum = nBlkCount * sizeof(int);
 
@@ -1471,9 +1569,9 @@ MDegrainN::MDegrainN(
     pMELmemUV2Sum = (int*)VirtualAlloc(0, stSizeToAllocSum, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE); // 4KByte page aligned address
 
 #else
-    pMELmemY = new uint8_t[stSizeToAlloc];
-    pMELmemUV1 = new uint8_t[stSizeToAlloc];
-    pMELmemUV2 = new uint8_t[stSizeToAlloc];
+    pMELmemY = new uint8_t[stSizeToAlloc](); // zeroed like VirtualAlloc, results must not depend on the heap
+    pMELmemUV1 = new uint8_t[stSizeToAlloc]();
+    pMELmemUV2 = new uint8_t[stSizeToAlloc]();
 
     pMELmemYSum = new int[stSizeToAllocSum];
     pMELmemUV1Sum = new int[stSizeToAllocSum];
@@ -1500,7 +1598,7 @@ MDegrainN::MDegrainN(
       BA_UV1arr[i] = new BlockArea(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV, TTH_BAS, pixelsize, nPel, arch, TTH_DMFlags);
       BA_UV2arr[i] = new BlockArea(nBlkSizeX / xRatioUV, nBlkSizeY / yRatioUV, TTH_BAS, pixelsize, nPel, arch, TTH_DMFlags);
 
-      DM_cache_arr[i] = new DM_cache(((_trad * 2 + 1) * (_trad * 2 + 1)) / 2);
+      DM_cache_arr[i] = (TTH_DMcache) ? new DM_cache(((_trad * 2 + 1) * (_trad * 2 + 1)) / 2) : 0;
     }
 
   }
@@ -1552,12 +1650,15 @@ MDegrainN::MDegrainN(
   }
   else
     dn_mm = DN_MM_NONE;
+
+  _prof_uptr = MVProfiler::create("MDegrainN");
 }
 
 
-MDegrainN::~MDegrainN()
-{
-  // Nothing
+MDegrainN::~MDegrainN()
+{
+  prefetch_wait();
+
   for (int k = 0; k < _trad * 2; ++k)
   {
 #ifdef _WIN32
@@ -1572,11 +1673,16 @@ MDegrainN::~MDegrainN()
     delete pMVsIntOvlpPlanesArrays[k];
     delete pMPBTempBlocks;
     delete pMPBTempBlocksUV1;
-    delete pMPBTempBlocksUV2;
+    delete pMPBTempBlocksUV2;
 #endif
   }
 
-  if (pmode == PM_MEL)
+  if (pMVsSoA_a != 0)
+  {
+    _aligned_free(pMVsSoA_a);
+  }
+
+  if (TTH_thUPD > 0)
   {
 #ifdef _WIN32
     VirtualFree((LPVOID)pMELmemY, 0, MEM_FREE);
@@ -1588,13 +1694,13 @@ MDegrainN::~MDegrainN()
     VirtualFree((LPVOID)pMELmemUV2Sum, 0, MEM_FREE);
 
 #else
-    delete pMELmemY;
-    delete pMELmemUV1;
-    delete pMELmemUV2;
+    delete[] pMELmemY;
+    delete[] pMELmemUV1;
+    delete[] pMELmemUV2;
 
-    delete pMELmemYSum;
-    delete pMELmemUV1Sum;
-    delete pMELmemUV2Sum;
+    delete[] pMELmemYSum;
+    delete[] pMELmemUV1Sum;
+    delete[] pMELmemUV2Sum;
 
 #endif
 
@@ -1606,6 +1712,10 @@ MDegrainN::~MDegrainN()
 
       delete DM_cache_arr[i];
     }
+    delete[] BA_Yarr;
+    delete[] BA_UV1arr;
+    delete[] BA_UV2arr;
+    delete[] DM_cache_arr;
   }
 
   if (iLtComp > 0)
@@ -1629,6 +1739,8 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
 
 ::PVideoFrame __stdcall MDegrainN::GetFrame(int n, ::IScriptEnvironment* env_ptr)
 {
+  MVProfileScope prof_frame(_prof_uptr.get(), MVPROF_GETFRAME);
+
   _covered_width = nBlkX * (nBlkSizeX - nOverlapX) + nOverlapX;
   _covered_height = nBlkY * (nBlkSizeY - nOverlapY) + nOverlapY;
 
@@ -1639,18 +1751,30 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
   int nDstPitchYUY2;
   int nSrcPitchYUY2;
 
-  iFrameNumRequested = n;// save to local var to use in DM cache
+  iFrameNumRequested = n;// save to local var to use in DM cache
 
-  for (int k2 = 0; k2 < _trad * 2; ++k2)
-  {
-    // reorder ror regular frames order in v2.0.9.2
-    const int k = reorder_ref(k2);
-
-    // v2.0.9.2 - it seems we do not need in vectors clip anymore when we
-    // finished copying them to fakeblockdatas
-    MVClip &mv_clip = *(_mv_clip_arr[k]._clip_sptr);
-    ::PVideoFrame mv = mv_clip.GetFrame(n, env_ptr);
-    mv_clip.Update(mv, env_ptr);
+  // Takes the frames fetched in advance if any
+  FrameSet fs;
+  prefetch_wait();
+  if (_prefetch_fs._n == n)
+  {
+    std::swap(fs, _prefetch_fs);
+  }
+  else
+  {
+    fetch_frames(fs, n, false, env_ptr);
+  }
+  _prefetch_fs = FrameSet();
+
+  for (int k2 = 0; k2 < _trad * 2; ++k2)
+  {
+    // reorder ror regular frames order in v2.0.9.2
+    const int k = reorder_ref(k2);
+
+    // v2.0.9.2 - it seems we do not need in vectors clip anymore when we
+    // finished copying them to fakeblockdatas
+    MVClip &mv_clip = *(_mv_clip_arr[k]._clip_sptr);
+    mv_clip.Update(fs._mv_arr[k], env_ptr);
     _usable_flag_arr[k] = mv_clip.IsUsable();
 
     if (mv_clip.GetTrad() != _trad) env_ptr->ThrowError("MDegrainN : nTrad in mvmulti %d not equal to MDegrain(tr=%d), possibly wrong tr params in MAnalyse and MDegrain", mv_clip.GetTrad(), _trad);
@@ -1658,26 +1782,24 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
     if (mvmultirs != 0) // get and update reverse search MVs
     {
       MVClip& mv_clip_rs = *(_mv_clip_arr[k]._cliprs_sptr);
-      ::PVideoFrame mv_rs = mv_clip_rs.GetFrame(n, env_ptr);
-      mv_clip_rs.Update(mv_rs, env_ptr);
+      mv_clip_rs.Update(fs._mvrs_arr[k], env_ptr);
     }
 
     if (mvmultivs != 0) // get and update IVS check MVs
     {
       MVClip& mv_clip_vs = *(_mv_clip_arr[k]._clipvs_sptr);
-      ::PVideoFrame mv_vs = mv_clip_vs.GetFrame(n, env_ptr);
-      mv_clip_vs.Update(mv_vs, env_ptr);
+      mv_clip_vs.Update(fs._mvvs_arr[k], env_ptr);
     }
   }
 
   if (dn_mm != DN_MM_NONE)
   {
-    src_dnmask = dnmask->GetFrame(n, env_ptr);
+    src_dnmask = fs._dnmask;
     dnmask_pitch = YPITCH(src_dnmask);
     pDNMask = (BYTE*)YRPLAN(src_dnmask);
   }
 
-  PVideoFrame src = child->GetFrame(n, env_ptr);
+  PVideoFrame src = fs._src;
   PVideoFrame dst = has_at_least_v8 ? env_ptr->NewVideoFrameP(vi, &src) : env_ptr->NewVideoFrame(vi); // frame property support
    
   if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2)
@@ -1765,7 +1887,28 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
     // reorder ror regular frames order in v2.0.9.2
     const int k = reorder_ref(k2);
     MVClip &mv_clip = *(_mv_clip_arr[k]._clip_sptr);
-    mv_clip.use_ref_frame(ref[k], _usable_flag_arr[k], _super, n, env_ptr);
+    if (fs._ref_arr.empty() || !fs._ref_arr[k])
+    {
+      mv_clip.use_ref_frame(ref[k], _usable_flag_arr[k], _super, n, env_ptr);
+    }
+    else
+    {
+      int ref_index;
+      mv_clip.use_ref_frame(ref_index, _usable_flag_arr[k], _super, n, env_ptr);
+      if (_usable_flag_arr[k])
+      {
+        ref[k] = fs._ref_arr[k];
+      }
+    }
+  }
+
+  // All the upstream requests for frame n are done. Those of the next frame
+  // can be issued while n is processed.
+  const bool seq_flag = (n == _prefetch_last_n + 1);
+  _prefetch_last_n = n;
+  if (_prefetch_flag && seq_flag && n + 1 < vi.num_frames)
+  {
+    prefetch_start(n + 1, env_ptr);
   }
 
   if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2)
@@ -1801,6 +1944,8 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
     }
   }
 
+  MVProfileScope prof_load(_prof_uptr.get(), MVPROF_SUPER_LOAD);
+
   memset(_planes_ptr, 0, _trad * 2 * sizeof(_planes_ptr[0]));
 
   for (int k2 = 0; k2 < _trad * 2; ++k2)
@@ -1835,6 +1980,8 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
     }
   }
 
+  prof_load.stop();
+
   // process reverse search MVs data to update SAD of std search to mark too bad MVs
   if (mvmultirs)
     ProcessRSMVdata();
@@ -1867,7 +2014,11 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
     {
 //      pMVsPlanesArrays[k] = _mv_clip_arr[k]._clip_sptr->GetpMVsArray(0);
 //      pMVsWorkPlanesArrays[k] = (VECTOR*)pMVsPlanesArrays[k];
-      pMVsWorkPlanesArrays[k] = (VECTOR*)_mv_clip_arr[k]._clip_sptr->GetpMVsArray(0);
+      // the vectors are read in place from the vector frame, MGR writes the refined ones back
+      if (iMGR > 0)
+        pMVsWorkPlanesArrays[k] = _mv_clip_arr[k]._clip_sptr->GetpMVsArrayWritable(0);
+      else
+        pMVsWorkPlanesArrays[k] = (VECTOR*)_mv_clip_arr[k]._clip_sptr->GetpMVsArray(0);
 
       if (mvmultivs != 0)
         pMVsPlanesArraysVS[k] = _mv_clip_arr[k]._clipvs_sptr->GetpMVsArray(0);
@@ -1885,14 +2036,22 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
 
     // it is currently faster to call once because of interconnectin of Y+UV via chroma blocks SADs,
   // will be faster with per-block processing may be only in the combined Y+UV colour data processing (possibly).
-  if (bMVsAddProc && !bYUVProc) // if interpolate overlap - may be it is better (and definitely faster) to make with input non-overlapped MVs ?
-  {
-    FilterMVs();
+  // The temporal filtering itself is made once for whole block rows, the SAD re-check
+  // of the filtered MVs is made here or per block in the YUV processing.
+  if (bMVsAddProc) // if interpolate overlap - may be it is better (and definitely faster) to make with input non-overlapped MVs ?
+  {
+    MVProfileScope prof_filter(_prof_uptr.get(), MVPROF_MV_FILTER);
+    FilterMVsSoA();
+    if (!bYUVProc)
+      FilterMVs();
   }
   // TEST with use_block_yuv
 
 
-  PROFILE_START(MOTION_PROFILE_COMPENSATION);
+  MVProfileScope prof_blend(
+    _prof_uptr.get(),
+    (nOverlapX > 0 || nOverlapY > 0) ? MVPROF_OVERLAP_BLEND : MVPROF_DEGRAIN_BLEND
+  );
 
   //-------------------------------------------------------------------------
   // LUMA plane Y
@@ -1944,7 +2103,7 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
           _mm_empty(); // (we may use double-float somewhere) Fizick
 #endif
 
-          PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
+          prof_blend.stop();
 
           if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !_planar_flag)
           {
@@ -1954,6 +2113,7 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
               _dst_ptr_arr[1], _dst_ptr_arr[2], _dst_pitch_arr[1], _cpuFlags);
           }
 
+          prefetch_wait();
           return (dst); // here is end of YUV single pass proc and GetFrame additional return
 
         }
@@ -2034,7 +2194,7 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
         _mm_empty(); // (we may use double-float somewhere) Fizick
 #endif
 
-        PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
+        prof_blend.stop();
 
         if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !_planar_flag)
         {
@@ -2044,6 +2204,7 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
             _dst_ptr_arr[1], _dst_ptr_arr[2], _dst_pitch_arr[1], _cpuFlags);
         }
 
+        prefetch_wait();
         return (dst); // here is end of YUV single pass proc and GetFrame additional return
 
       }
@@ -2093,7 +2254,7 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
   _mm_empty(); // (we may use double-float somewhere) Fizick
 #endif
 
-  PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
+  prof_blend.stop();
 
   if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !_planar_flag)
   {
@@ -2103,11 +2264,114 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
       _dst_ptr_arr[1], _dst_ptr_arr[2], _dst_pitch_arr[1], _cpuFlags);
   }
 
+  prefetch_wait();
   return (dst);
 }
 
 
 
+// Gets all the upstream frames required to process frame n. When refs_flag
+// is set, the reference super frames are fetched too. The vectors are not
+// decoded yet: a ref is skipped only when the scene change statistics in
+// the header of its vector frame already decide it.
+void MDegrainN::fetch_frames(FrameSet &fs, int n, bool refs_flag, ::IScriptEnvironment *env_ptr)
+{
+  const int nbr_refs = _trad * 2;
+  fs._mv_arr.assign(nbr_refs, ::PVideoFrame());
+  fs._mvrs_arr.assign((mvmultirs != 0) ? nbr_refs : 0, ::PVideoFrame());
+  fs._mvvs_arr.assign((mvmultivs != 0) ? nbr_refs : 0, ::PVideoFrame());
+  fs._ref_arr.assign(refs_flag ? nbr_refs : 0, ::PVideoFrame());
+
+  for (int k2 = 0; k2 < nbr_refs; ++k2)
+  {
+    const int k = reorder_ref(k2);
+    MvClipInfo &c_info = _mv_clip_arr[k];
+    fs._mv_arr[k] = c_info._clip_sptr->GetFrame(n, env_ptr);
+    if (mvmultirs != 0)
+    {
+      fs._mvrs_arr[k] = c_info._cliprs_sptr->GetFrame(n, env_ptr);
+    }
+    if (mvmultivs != 0)
+    {
+      fs._mvvs_arr[k] = c_info._clipvs_sptr->GetFrame(n, env_ptr);
+    }
+  }
+
+  if (dn_mm != DN_MM_NONE)
+  {
+    fs._dnmask = dnmask->GetFrame(n, env_ptr);
+  }
+
+  fs._src = child->GetFrame(n, env_ptr);
+
+  if (refs_flag)
+  {
+    for (int k2 = 0; k2 < nbr_refs; ++k2)
+    {
+      const int k = reorder_ref(k2);
+      MVClip &mv_clip = *(_mv_clip_arr[k]._clip_sptr);
+      const MVSceneStats *stats_ptr = MVSceneStats::from_frame(fs._mv_arr[k]->GetReadPtr());
+      bool usable_flag = !(stats_ptr != 0 && stats_ptr->is_valid(mv_clip.GetBlkCount())
+        && stats_ptr->is_scene_change(mv_clip.GetThSCD1(), mv_clip.GetThSCD2()) == 1);
+      mv_clip.use_ref_frame(fs._ref_arr[k], usable_flag, _super, n, env_ptr);
+    }
+  }
+
+  fs._n = n;
+}
+
+
+
+void MDegrainN::prefetch_start(int n, ::IScriptEnvironment *env_ptr)
+{
+  assert(_prefetch_completion_ptr == 0);
+
+  _prefetch_fs._n = n;
+
+  // The environment of a thread must not be shared with another one: the
+  // job gets the one of the pool worker it runs on.
+  ::IScriptEnvironment2 *env2_ptr = static_cast <::IScriptEnvironment2 *> (env_ptr);
+  _prefetch_completion_ptr = env2_ptr->NewCompletion(1);
+  env2_ptr->ParallelJob(&prefetch_job, this, _prefetch_completion_ptr);
+}
+
+
+
+void MDegrainN::prefetch_wait()
+{
+  if (_prefetch_completion_ptr != 0)
+  {
+    _prefetch_completion_ptr->Wait();
+    _prefetch_completion_ptr->Destroy();
+    _prefetch_completion_ptr = 0;
+  }
+}
+
+
+
+AVSValue MDegrainN::prefetch_job(::IScriptEnvironment2 *env_ptr, void *data_ptr)
+{
+  MDegrainN &obj = *reinterpret_cast <MDegrainN *> (data_ptr);
+  FrameSet &fs = obj._prefetch_fs;
+  const int n = fs._n;
+  fs._n = -1;
+
+  try
+  {
+    obj.fetch_frames(fs, n, true, env_ptr);
+  }
+  catch (...)
+  {
+    // Discarded, the error will show up again when the frame is fetched
+    // synchronously.
+    fs = FrameSet();
+  }
+
+  return AVSValue();
+}
+
+
+
 // Fn...F1 B1...Bn
 int MDegrainN::reorder_ref(int index) const
 {
@@ -2271,6 +2535,7 @@ void	MDegrainN::process_chroma(int plane_mask)
         realLimit = _nlimitc * (1 << (bits_per_pixel_output - 8));
       else
         realLimit = (float)_nlimitc / 255.0f;
+      MVProfileScope prof_limit(_prof_uptr.get(), MVPROF_NLIMIT);
       LimitFunction(_dst_ptr_arr[P], _dst_pitch_arr[P],
         _src_ptr_arr[P], _src_pitch_arr[P],
         nWidth >> nLogxRatioUV_super, nHeight >> nLogyRatioUV_super,
@@ -3088,6 +3353,30 @@ void	MDegrainN::process_luma_and_chroma_overlap_slice(int y_beg, int y_end)
 
       PrefetchMVs(i);
 
+      if (_degrainoverlaps_yuv_ptr != nullptr) // single call per block, no temporary blocks
+      {
+        if (pixelsize_super == 1)
+        {
+          DegrainOverlapsBlock_LC(
+            pDstShort + xx, pDstShortUV1 + xx_uv, pDstShortUV2 + xx_uv, _dst_short_pitch,
+            winOver, winOverUV,
+            pSrcCur, pSrcCurUV1, pSrcCurUV2,
+            i, bx, by, xx, xx_uv);
+        }
+        else
+        {
+          DegrainOverlapsBlock_LC(
+            (uint16_t*)(pDstInt + xx), (uint16_t*)(pDstIntUV1 + xx_uv), (uint16_t*)(pDstIntUV2 + xx_uv), _dst_int_pitch,
+            winOver, winOverUV,
+            pSrcCur, pSrcCurUV1, pSrcCurUV2,
+            i, bx, by, xx, xx_uv);
+        }
+
+        xx += (nBlkSizeX - nOverlapX) * iBlkScanDir;
+        xx_uv += ((nBlkSizeX - nOverlapX) >> nLogxRatioUV_super) * iBlkScanDir;
+        continue;
+      }
+
       if (pmode == PM_BLEND)
       {
 
@@ -4316,61 +4605,111 @@ float MDegrainN::fSinc(float x)
   else return 1.0f;
 }
 
-void MDegrainN::FilterMVs(void) 
+// Temporal filtering of the MVs of all the blocks, a whole row of blocks at once in
+// structure of arrays form. The SAD re-check and the choice between the filtered and
+// the original MVs stay per block in FilterBlkMVs.
+void MDegrainN::FilterMVsSoA(void)
 {
+  const int nPos = _trad * 2 + 1;
+  const bool bLPF = (fMVLPFCutoff < 1.0f || fMVLPFGauss > 0.0f);
+
+  // same initial minimum of the row sums as MVMedF_xy and MVMedF_vl
+  const int iMaxMVlength = std::max(nWidth, nHeight) * 2 * nPel; // hope it is enough ?
+  const int iMaxSumDM = (iMVMedF_cm == 1) ? (_trad * 2 + 1) * iMaxMVlength * (_trad * 2 + 1) * iMaxMVlength : (_trad * 2 + 1) * iMaxMVlength;
+
   for (int by = 0; by < nBlkY; by++)
   {
-    for (int bx = 0; bx < nBlkX; bx++)
+    // convert +1, -1, +2, -2, +3, -3 ... to
+    // -3, -2, -1, 0, +1, +2, +3 timed sequence
+    for (int pos = 0; pos < nPos; pos++)
     {
-      int i = by * nBlkX + bx;
-      FilterBlkMVs(i, bx, by);
-    } // bx
-  } // by
+      int* px = MVsSoAIn.x + pos * iMVsSoAPitch;
+      int* py = MVsSoAIn.y + pos * iMVsSoAPitch;
+      sad_t* psad = MVsSoAIn.sad + pos * iMVsSoAPitch;
 
-}
+      if (pos == _trad) // zero trad - source block itself
+      {
+        for (int bx = 0; bx < nBlkX; bx++)
+        {
+          px[bx] = 0;
+          py[bx] = 0;
+          psad[bx] = 0;
+        }
+        continue;
+      }
 
-// single block processing FilterMVs to allow to use cached subshifted block
-MV_FORCEINLINE void MDegrainN::FilterBlkMVs(int i, int bx, int by)
-{
-  VECTOR filteredp2fvectors[(MAX_TEMP_RAD * 2) + 1];
-  VECTOR filteredp2fvectors2[(MAX_TEMP_RAD * 2) + 1];
+      const int idx = (pos < _trad) ? (_trad - pos - 1) * 2 + 1 : (pos - _trad - 1) * 2;
+      const VECTOR* pMVs = pMVsWorkPlanesArrays[idx] + by * nBlkX;
+      for (int bx = 0; bx < nBlkX; bx++)
+      {
+        px[bx] = pMVs[bx].x;
+        py[bx] = pMVs[bx].y;
+        psad[bx] = pMVs[bx].sad;
+      }
+    }
 
-  VECTOR p2fvectors[(MAX_TEMP_RAD * 2) + 1];
-  // convert +1, -1, +2, -2, +3, -3 ... to
-// -3, -2, -1, 0, +1, +2, +3 timed sequence
-  for (int k = 0; k < _trad; ++k)
-  {
-    p2fvectors[k] = pMVsWorkPlanesArrays[(_trad - k - 1) * 2 + 1][i];
-  }
+    const MV_SOA filtered = GetFilteredMVsSoARow(by);
 
-  p2fvectors[_trad].x = 0; // zero trad - source block itself
-  p2fvectors[_trad].y = 0;
-  p2fvectors[_trad].sad = 0;
+    if (iMVMedF > 0) // Median-like temporal filtering enabled
+    {
+      const MV_SOA& medf_out = bLPF ? MVsSoATmp : filtered; // dual or single pass filtering
 
-  for (int k = 1; k < _trad + 1; ++k)
-  {
-    p2fvectors[k + _trad] = pMVsWorkPlanesArrays[(k - 1) * 2][i];
-  }
+      if (MVMedF_SoA != 0)
+      {
+        MVMedF_SoA(MVsSoAIn, medf_out, nPos, iMVMedF, iMaxSumDM, iMVMedF_em == 1, veryBigSAD, nBlkX);
+      }
+      else // no SoA version of the mode, per block
+      {
+        VECTOR p2fvectors[(MAX_TEMP_RAD * 2) + 1];
+        VECTOR filteredp2fvectors[(MAX_TEMP_RAD * 2) + 1];
 
-  if (iMVMedF > 0) // Median-like temporal filtering enabled
-  {
-    if (fMVLPFCutoff < 1.0f || fMVLPFGauss > 0.0f) // dual pass filtering
+        for (int bx = 0; bx < nBlkX; bx++)
+        {
+          for (int pos = 0; pos < nPos; pos++)
+          {
+            p2fvectors[pos] = GetSoAVECTOR(MVsSoAIn, pos, bx);
+          }
+
+          ProcessMVMedF(&p2fvectors[0], &filteredp2fvectors[0]);
+
+          for (int pos = 0; pos < nPos; pos++)
+          {
+            SetSoAVECTOR(medf_out, pos, bx, filteredp2fvectors[pos]);
+          }
+        }
+      }
+    }
+
+    if (bLPF)
     {
-      ProcessMVMedF(&p2fvectors[0], &filteredp2fvectors2[0]);
+      MVLPF_SoA((iMVMedF > 0) ? MVsSoATmp : MVsSoAIn, filtered, nPos, fMVLPFKernel, nBlkX);
     }
-    else // single pass filtering
-      ProcessMVMedF(&p2fvectors[0], &filteredp2fvectors[0]);
   }
+}
+
+MV_FORCEINLINE MV_SOA MDegrainN::GetFilteredMVsSoARow(int by)
+{
+  return MakeMVsSoA(pMVsSoAFiltered + by * 3 * (_trad * 2 + 1) * iMVsSoAPitch, _trad * 2 + 1, iMVsSoAPitch);
+}
 
-  if (fMVLPFCutoff < 1.0f || fMVLPFGauss > 0.0f)
+void MDegrainN::FilterMVs(void) 
+{
+  for (int by = 0; by < nBlkY; by++)
   {
-    if (iMVMedF > 0) // Median-like temporal filtering enabled
+    for (int bx = 0; bx < nBlkX; bx++)
     {
-      ProcessMVLPF(&filteredp2fvectors2[0], &filteredp2fvectors[0]);
-    }
-    else // single pass filtering
-      ProcessMVLPF(&p2fvectors[0], &filteredp2fvectors[0]);
-  }
+      int i = by * nBlkX + bx;
+      FilterBlkMVs(i, bx, by);
+    } // bx
+  } // by
+
+}
+
+// single block processing FilterMVs to allow to use cached subshifted block
+// The temporal filtered MVs are taken from FilterMVsSoA.
+MV_FORCEINLINE void MDegrainN::FilterBlkMVs(int i, int bx, int by)
+{
+  const MV_SOA filtered = GetFilteredMVsSoARow(by);
 
   // final copy output
   VECTOR vLPFed, vOrig;
@@ -4379,7 +4718,7 @@ MV_FORCEINLINE void MDegrainN::FilterBlkMVs(int i, int bx, int by)
   {
     // recheck SAD:
 
-    vLPFed = filteredp2fvectors[k];
+    vLPFed = GetSoAVECTOR(filtered, k, bx);
     int idx_mvto = (_trad - k - 1) * 2 + 1;
 
     if (vLPFed.sad != veryBigSAD)
@@ -4416,7 +4755,7 @@ MV_FORCEINLINE void MDegrainN::FilterBlkMVs(int i, int bx, int by)
   for (int k = 1; k < _trad + 1; ++k)
   {
     // recheck SAD
-    vLPFed = filteredp2fvectors[k + _trad];
+    vLPFed = GetSoAVECTOR(filtered, k + _trad, bx);
     int idx_mvto = (k - 1) * 2;
 
     if (vLPFed.sad != veryBigSAD)
@@ -4452,29 +4791,6 @@ MV_FORCEINLINE void MDegrainN::FilterBlkMVs(int i, int bx, int by)
   }
 }
 
-MV_FORCEINLINE void MDegrainN::ProcessMVLPF(VECTOR* pVin, VECTOR* pVout)
-{
-  // perform lpf of all good vectors in tr-scope
-  for (int pos = 0; pos < (_trad * 2 + 1); pos++)
-  {
-    float fSumX = 0.0f;
-    float fSumY = 0.0f;
-    for (int kpos = 0; kpos < MVLPFKERNELSIZE; kpos++)
-    {
-      int src_pos = pos + kpos - MVLPFKERNELSIZE / 2;
-      if (src_pos < 0) src_pos = 0;
-      if (src_pos > _trad * 2) src_pos = (_trad * 2); // total valid samples in vector of VECTORs is _trad*2+1
-      fSumX += pVin[src_pos].x * fMVLPFKernel[kpos];
-      fSumY += pVin[src_pos].y * fMVLPFKernel[kpos];
-    }
-
-    pVout[pos].x = (int)(fSumX);
-    pVout[pos].y = (int)(fSumY);
-    pVout[pos].sad = pVin[pos].sad;
-  }
-
-}
-
 MV_FORCEINLINE void MDegrainN::ProcessMVMedF(VECTOR* pVin, VECTOR* pVout)
 {
   VECTOR MedF_vect[(MAX_TEMP_RAD * 2) + 1];
@@ -5073,6 +5389,8 @@ MV_FORCEINLINE void MDegrainN::post_overlap_luma_plane(void)
 
 MV_FORCEINLINE void MDegrainN::nlimit_luma(void)
 {
+  MVProfileScope prof_limit(_prof_uptr.get(), MVPROF_NLIMIT);
+
   // limit is 0-255 relative, for any bit depth
   float realLimit;
   if (pixelsize_output <= 2)
@@ -5088,6 +5406,8 @@ MV_FORCEINLINE void MDegrainN::nlimit_luma(void)
 
 MV_FORCEINLINE void MDegrainN::nlimit_chroma(int P)
 {
+  MVProfileScope prof_limit(_prof_uptr.get(), MVPROF_NLIMIT);
+
     // limit is 0-255 relative, for any bit depth
   float realLimit;
   if (pixelsize_output <= 2)
@@ -5164,6 +5484,13 @@ void MDegrainN::InterpolateOverlap_4x(VECTOR* pInterpolatedMVs, const VECTOR* pI
 
   for (int by = 1; by < nBlkY - 1; by += 2) // output blkY
   {
+    if (iInterpolateOverlap != 1) // faster mode, average of x, y and SAD of whole rows
+    {
+      MVAvg(&pInterpolatedMVs[by * nBlkX], &pInterpolatedMVs[byInp * nBlkX], &pInterpolatedMVs[(byInp + 2) * nBlkX], nBlkX);
+      byInp += 2;
+      continue;
+    }
+
     for (int bx = 0; bx < nBlkX; bx++) // output blkX
     {
       i = by * nBlkX + bx;
@@ -5464,8 +5791,8 @@ MV_FORCEINLINE void MDegrainN::ProcessRSMVdata(void)
 
   for (int k = 0; k < _trad * 2; ++k)
   {
-    VECTOR* fwMVs = (VECTOR*)_mv_clip_arr[k]._clip_sptr->GetpMVsArray(0);
-    VECTOR* bwMVs = (VECTOR*)_mv_clip_arr[k]._cliprs_sptr->GetpMVsArray(0);
+    VECTOR* fwMVs = _mv_clip_arr[k]._clip_sptr->GetpMVsArrayWritable(0);
+    const VECTOR* bwMVs = _mv_clip_arr[k]._cliprs_sptr->GetpMVsArray(0);
  
     for (int by = 0; by < nInputBlkY; by++) // not interpolated overlap count
     {
@@ -5626,24 +5953,19 @@ MV_FORCEINLINE int MDegrainN::AlignBlockWeights(const BYTE* pRef[], int Pitch[],
       }
     }
 
-    if (!bChroma)
-//      sad_array_sub[0] = SAD(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (1)), iBlocksPitch);
-//      sad_t tmp_sad = SAD(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (1)), iBlocksPitch);
-      sad_array_sub[0] = DM_Luma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (1)), iBlocksPitch);
-    else
-//      sad_array_sub[0] = SADCHROMA(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (1)), iBlocksPitch);
-        sad_array_sub[0] = DM_Chroma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (1)), iBlocksPitch);
-    stAVG_sub_SAD += sad_array_sub[0];
-
-    // calc SAD of full blended vs refs
-    if (!bChroma)
-//      sad_array_add[0] = SAD(pMPBTempBlocks, iBlocksPitch, pCurr, iCurrPitch);
-        sad_array_add[0] = DM_Luma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pCurr, iCurrPitch);
-    else
-//      sad_array_add[0] = SADCHROMA(pMPBTempBlocks, iBlocksPitch, pCurr, iCurrPitch);
-        sad_array_add[0] = DM_Chroma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pCurr, iCurrPitch);
-    stAVG_add_SAD += sad_array_add[0];
+    // the full blended block is compared with all the subtracted blocks and
+    // all the refs in two batches, once the subtracted blocks are ready
+    const BYTE* pSubBlocks[MAX_TEMP_RAD * 2 + 1];
+    const BYTE* pAddBlocks[MAX_TEMP_RAD * 2 + 1];
+    int SubPitch[MAX_TEMP_RAD * 2 + 1];
+    int AddPitch[MAX_TEMP_RAD * 2 + 1];
+    int BlockIdx[MAX_TEMP_RAD * 2 + 1];
 
+    BlockIdx[iNumAVG] = 0;
+    pSubBlocks[iNumAVG] = pMPBTempBlocks + (iBlockSizeMem * (1));
+    SubPitch[iNumAVG] = iBlocksPitch;
+    pAddBlocks[iNumAVG] = pCurr;
+    AddPitch[iNumAVG] = iCurrPitch;
     iNumAVG++;
 
     // ref blocks
@@ -5689,29 +6011,31 @@ MV_FORCEINLINE int MDegrainN::AlignBlockWeights(const BYTE* pRef[], int Pitch[],
           }
 
         }
-        //calc SAD of full blended block vs subtracted
-        if (!bChroma)
-          //sad_array_sub[n] = SAD(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (n + 1)), iBlocksPitch);
-          sad_array_sub[n] = DM_Luma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (n + 1)), iBlocksPitch);
-        else
-//          sad_array_sub[n] = SADCHROMA(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (n + 1)), iBlocksPitch);
-          sad_array_sub[n] = DM_Chroma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (n + 1)), iBlocksPitch);
-        stAVG_sub_SAD += sad_array_sub[n];
-
-        // calc SAD of full blended vs refs
-        if (!bChroma)
-//          sad_array_add[n] = SAD(pMPBTempBlocks, iBlocksPitch, pRef[n - 1], Pitch[n - 1]);
-            sad_array_add[n] = DM_Luma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pRef[n - 1], Pitch[n - 1]);
-        else
-//          sad_array_add[n] = SADCHROMA(pMPBTempBlocks, iBlocksPitch, pRef[n - 1], Pitch[n - 1]);
-            sad_array_add[n] = DM_Chroma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pRef[n - 1], Pitch[n - 1]);
-        stAVG_add_SAD += sad_array_add[n];
-
+        BlockIdx[iNumAVG] = n;
+        pSubBlocks[iNumAVG] = pMPBTempBlocks + (iBlockSizeMem * (n + 1));
+        SubPitch[iNumAVG] = iBlocksPitch;
+        pAddBlocks[iNumAVG] = pRef[n - 1];
+        AddPitch[iNumAVG] = Pitch[n - 1];
         iNumAVG++;
       }
 
     }
 
+    //calc SAD of full blended block vs subtracted and vs refs
+    DisMetric* DM = bChroma ? DM_Chroma : DM_Luma;
+    int dm_sub[MAX_TEMP_RAD * 2 + 1];
+    int dm_add[MAX_TEMP_RAD * 2 + 1];
+    DM->GetDisMetricBatch(pMPBTempBlocks, iBlocksPitch, pSubBlocks, SubPitch, iNumAVG, dm_sub);
+    DM->GetDisMetricBatch(pMPBTempBlocks, iBlocksPitch, pAddBlocks, AddPitch, iNumAVG, dm_add);
+
+    for (int i = 0; i < iNumAVG; i++)
+    {
+      sad_array_sub[BlockIdx[i]] = dm_sub[i];
+      sad_array_add[BlockIdx[i]] = dm_add[i];
+      stAVG_sub_SAD += dm_sub[i];
+      stAVG_add_SAD += dm_add[i];
+    }
+
     // find average SAD
     stAVG_add_SAD /= iNumAVG;
     stAVG_sub_SAD /= iNumAVG;
@@ -5818,7 +6142,6 @@ MV_FORCEINLINE int MDegrainN::AlignBlockWeightsLC(const BYTE* pRef[], int Pitch[
     int iNumAVG = 0;
 
     sad_t sad_chroma;
-    sad_t luma_sad;
 
     // process current block too
     // subtracted
@@ -5887,36 +6210,27 @@ MV_FORCEINLINE int MDegrainN::AlignBlockWeightsLC(const BYTE* pRef[], int Pitch[
 
     }
 
-/*    luma_sad = SAD(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (1)), iBlocksPitch);
-    sad_chroma = ScaleSadChroma(SADCHROMA(pMPBTempBlocksUV1, iBlocksPitchUV, pMPBTempBlocksUV1 + (iBlockSizeMemUV * (1)), iBlocksPitchUV)
-          + SADCHROMA(pMPBTempBlocksUV2, iBlocksPitchUV, pMPBTempBlocksUV2 + (iBlockSizeMemUV * (1)), iBlocksPitchUV), chromaSADscale);
-*/
-    luma_sad = DM_Luma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (1)), iBlocksPitch);
-    if ((MPBchroma & 0x1) != 0)
-    {
-      sad_chroma = ScaleSadChroma(DM_Chroma->GetDisMetric(pMPBTempBlocksUV1, iBlocksPitchUV, pMPBTempBlocksUV1 + (iBlockSizeMemUV * (1)), iBlocksPitchUV)
-        + DM_Chroma->GetDisMetric(pMPBTempBlocksUV2, iBlocksPitchUV, pMPBTempBlocksUV2 + (iBlockSizeMemUV * (1)), iBlocksPitchUV), chromaSADscale);
-    }
-    else
-      sad_chroma = 0;
-    sad_array_sub[0] = luma_sad + sad_chroma;
-    stAVG_sub_SAD += sad_array_sub[0];
-
-    // calc SAD of full blended vs refs
-/*    luma_sad = SAD(pMPBTempBlocks, iBlocksPitch, pCurr, iCurrPitch);
-    sad_chroma = ScaleSadChroma(SADCHROMA(pMPBTempBlocksUV1, iBlocksPitchUV, pCurrUV1, iCurrPitchUV1)
-      + SADCHROMA(pMPBTempBlocksUV2, iBlocksPitchUV, pCurrUV2, iCurrPitchUV2), chromaSADscale);*/
-    luma_sad = DM_Luma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pCurr, iCurrPitch);
-    if ((MPBchroma & 0x1) != 0)
-    {
-      sad_chroma = ScaleSadChroma(DM_Chroma->GetDisMetric(pMPBTempBlocksUV1, iBlocksPitchUV, pCurrUV1, iCurrPitchUV1)
-        + DM_Chroma->GetDisMetric(pMPBTempBlocksUV2, iBlocksPitchUV, pCurrUV2, iCurrPitchUV2), chromaSADscale);
-    }
-    else
-      sad_chroma = 0;
-    sad_array_add[0] = luma_sad + sad_chroma;
-    stAVG_add_SAD += sad_array_add[0];
-
+    // the full blended block is compared with all the subtracted blocks and
+    // all the refs in batches, once the subtracted blocks are ready
+    const BYTE* pSubBlocks[3][MAX_TEMP_RAD * 2 + 1];
+    const BYTE* pAddBlocks[3][MAX_TEMP_RAD * 2 + 1];
+    int SubPitch[3][MAX_TEMP_RAD * 2 + 1];
+    int AddPitch[3][MAX_TEMP_RAD * 2 + 1];
+    int BlockIdx[MAX_TEMP_RAD * 2 + 1];
+
+    BlockIdx[iNumAVG] = 0;
+    pSubBlocks[0][iNumAVG] = pMPBTempBlocks + (iBlockSizeMem * (1));
+    pSubBlocks[1][iNumAVG] = pMPBTempBlocksUV1 + (iBlockSizeMemUV * (1));
+    pSubBlocks[2][iNumAVG] = pMPBTempBlocksUV2 + (iBlockSizeMemUV * (1));
+    SubPitch[0][iNumAVG] = iBlocksPitch;
+    SubPitch[1][iNumAVG] = iBlocksPitchUV;
+    SubPitch[2][iNumAVG] = iBlocksPitchUV;
+    pAddBlocks[0][iNumAVG] = pCurr;
+    pAddBlocks[1][iNumAVG] = pCurrUV1;
+    pAddBlocks[2][iNumAVG] = pCurrUV2;
+    AddPitch[0][iNumAVG] = iCurrPitch;
+    AddPitch[1][iNumAVG] = iCurrPitchUV1;
+    AddPitch[2][iNumAVG] = iCurrPitchUV2;
     iNumAVG++;
 
     // ref blocks
@@ -5987,41 +6301,49 @@ MV_FORCEINLINE int MDegrainN::AlignBlockWeightsLC(const BYTE* pRef[], int Pitch[
           }
         }
 
-        //calc SAD of full blended block vs subtracted
-/*        luma_sad = SAD(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (n + 1)), iBlocksPitch);
-        sad_chroma = ScaleSadChroma(SADCHROMA(pMPBTempBlocksUV1, iBlocksPitchUV, pMPBTempBlocksUV1 + (iBlockSizeMemUV * (n + 1)), iBlocksPitchUV)
-          + SADCHROMA(pMPBTempBlocksUV2, iBlocksPitchUV, pMPBTempBlocksUV2 + (iBlockSizeMemUV * (n + 1)), iBlocksPitchUV), chromaSADscale);*/
-        luma_sad = DM_Luma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pMPBTempBlocks + (iBlockSizeMem * (n + 1)), iBlocksPitch);
-        if ((MPBchroma & 0x1) != 0)
-        {
-          sad_chroma = ScaleSadChroma(DM_Chroma->GetDisMetric(pMPBTempBlocksUV1, iBlocksPitchUV, pMPBTempBlocksUV1 + (iBlockSizeMemUV * (n + 1)), iBlocksPitchUV)
-            + DM_Chroma->GetDisMetric(pMPBTempBlocksUV2, iBlocksPitchUV, pMPBTempBlocksUV2 + (iBlockSizeMemUV * (n + 1)), iBlocksPitchUV), chromaSADscale);
-        }
-        else
-          sad_chroma = 0;
-        sad_array_sub[n] = luma_sad + sad_chroma;
-        stAVG_sub_SAD += sad_array_sub[n];
-
-        // calc SAD of full blended vs refs
-/*        luma_sad = SAD(pMPBTempBlocks, iBlocksPitch, pRef[n - 1], Pitch[n - 1]);
-        sad_chroma = ScaleSadChroma(SADCHROMA(pMPBTempBlocksUV1, iBlocksPitchUV, pRefUV1[n - 1], PitchUV1[n - 1])
-          + SADCHROMA(pMPBTempBlocksUV2, iBlocksPitchUV, pRefUV2[n - 1], PitchUV2[n - 1]), chromaSADscale);*/
-        luma_sad = DM_Luma->GetDisMetric(pMPBTempBlocks, iBlocksPitch, pRef[n - 1], Pitch[n - 1]);
-        if ((MPBchroma & 0x1) != 0)
-        {
-          sad_chroma = ScaleSadChroma(DM_Chroma->GetDisMetric(pMPBTempBlocksUV1, iBlocksPitchUV, pRefUV1[n - 1], PitchUV1[n - 1])
-            + DM_Chroma->GetDisMetric(pMPBTempBlocksUV2, iBlocksPitchUV, pRefUV2[n - 1], PitchUV2[n - 1]), chromaSADscale);
-        }
-        else
-          sad_chroma = 0;
-        sad_array_add[n] = luma_sad + sad_chroma;
-        stAVG_add_SAD += sad_array_add[n];
-
+        BlockIdx[iNumAVG] = n;
+        pSubBlocks[0][iNumAVG] = pMPBTempBlocks + (iBlockSizeMem * (n + 1));
+        pSubBlocks[1][iNumAVG] = pMPBTempBlocksUV1 + (iBlockSizeMemUV * (n + 1));
+        pSubBlocks[2][iNumAVG] = pMPBTempBlocksUV2 + (iBlockSizeMemUV * (n + 1));
+        SubPitch[0][iNumAVG] = iBlocksPitch;
+        SubPitch[1][iNumAVG] = iBlocksPitchUV;
+        SubPitch[2][iNumAVG] = iBlocksPitchUV;
+        pAddBlocks[0][iNumAVG] = pRef[n - 1];
+        pAddBlocks[1][iNumAVG] = pRefUV1[n - 1];
+        pAddBlocks[2][iNumAVG] = pRefUV2[n - 1];
+        AddPitch[0][iNumAVG] = Pitch[n - 1];
+        AddPitch[1][iNumAVG] = PitchUV1[n - 1];
+        AddPitch[2][iNumAVG] = PitchUV2[n - 1];
         iNumAVG++;
       }
 
     }
 
+    //calc SAD of full blended block vs subtracted and vs refs
+    int dm_sub[3][MAX_TEMP_RAD * 2 + 1];
+    int dm_add[3][MAX_TEMP_RAD * 2 + 1];
+    DM_Luma->GetDisMetricBatch(pMPBTempBlocks, iBlocksPitch, pSubBlocks[0], SubPitch[0], iNumAVG, dm_sub[0]);
+    DM_Luma->GetDisMetricBatch(pMPBTempBlocks, iBlocksPitch, pAddBlocks[0], AddPitch[0], iNumAVG, dm_add[0]);
+    if ((MPBchroma & 0x1) != 0)
+    {
+      DM_Chroma->GetDisMetricBatch(pMPBTempBlocksUV1, iBlocksPitchUV, pSubBlocks[1], SubPitch[1], iNumAVG, dm_sub[1]);
+      DM_Chroma->GetDisMetricBatch(pMPBTempBlocksUV2, iBlocksPitchUV, pSubBlocks[2], SubPitch[2], iNumAVG, dm_sub[2]);
+      DM_Chroma->GetDisMetricBatch(pMPBTempBlocksUV1, iBlocksPitchUV, pAddBlocks[1], AddPitch[1], iNumAVG, dm_add[1]);
+      DM_Chroma->GetDisMetricBatch(pMPBTempBlocksUV2, iBlocksPitchUV, pAddBlocks[2], AddPitch[2], iNumAVG, dm_add[2]);
+    }
+
+    for (int i = 0; i < iNumAVG; i++)
+    {
+      const int n = BlockIdx[i];
+      sad_chroma = ((MPBchroma & 0x1) != 0) ? ScaleSadChroma(dm_sub[1][i] + dm_sub[2][i], chromaSADscale) : 0;
+      sad_array_sub[n] = dm_sub[0][i] + sad_chroma;
+      stAVG_sub_SAD += sad_array_sub[n];
+
+      sad_chroma = ((MPBchroma & 0x1) != 0) ? ScaleSadChroma(dm_add[1][i] + dm_add[2][i], chromaSADscale) : 0;
+      sad_array_add[n] = dm_add[0][i] + sad_chroma;
+      stAVG_add_SAD += sad_array_add[n];
+    }
+
     // find average SAD
     stAVG_add_SAD /= iNumAVG;
     stAVG_sub_SAD /= iNumAVG;
@@ -6550,6 +6872,8 @@ MV_FORCEINLINE void MDegrainN::MPB_SP(
   bool bChroma, int iBlkNum
 )
 {
+  MVProfileScope prof_mpb(_prof_uptr.get(), MVPROF_MPB);
+
   int adjWarr[1 + MAX_TEMP_RAD * 2]; 
   int startWarr[1 + MAX_TEMP_RAD * 2]; 
 
@@ -6749,6 +7073,8 @@ MV_FORCEINLINE void MDegrainN::MPB_LC(
   int iBlkNum
 )
 {
+  MVProfileScope prof_mpb(_prof_uptr.get(), MVPROF_MPB);
+
   // TEMP DEBUG !!!
 //  pRef[1] ++; // shift ptr second ref block 1 to the right !!!
 
@@ -7000,18 +7326,17 @@ MV_FORCEINLINE void MDegrainN::MEL_LC(
   const BYTE* pSrcCurUV2,
   int xx, int xx_uv, int ibx, int iby, int iBlkNum)
 {
+  MVProfileScope prof_mel(_prof_uptr.get(), MVPROF_MEL);
+
   BYTE* pYmem = pMELmemY + iBlkNum * nBlkSizeX * nBlkSizeY * pixelsize;
   BYTE* pUV1mem = pMELmemUV1 + iBlkNum * (nBlkSizeX >> nLogxRatioUV_super) * (nBlkSizeY >> nLogyRatioUV_super) * pixelsize;
   BYTE* pUV2mem = pMELmemUV2 + iBlkNum * (nBlkSizeX >> nLogxRatioUV_super)* (nBlkSizeY >> nLogyRatioUV_super) * pixelsize;
 
-  int Ymem_pitch = nBlkSizeY * pixelsize;
-  int UV1mem_pitch = (nBlkSizeY >> nLogyRatioUV_super)* pixelsize;
-  int UV2mem_pitch = (nBlkSizeY >> nLogyRatioUV_super)* pixelsize;
+  int Ymem_pitch = nBlkSizeX * pixelsize;
+  int UV1mem_pitch = (nBlkSizeX >> nLogxRatioUV_super)* pixelsize;
+  int UV2mem_pitch = (nBlkSizeX >> nLogxRatioUV_super)* pixelsize;
 
   DM_cache* dmc = DM_cache_arr[iBlkNum];
-#ifdef _DEBUG
-  iDM_cache_hits = 0;
-#endif
 
   const int rowsizeUV = nBlkSizeY >> nLogyRatioUV_super; // bad name. it's height really
   const int rowwidthUV = nBlkSizeX >> nLogxRatioUV_super; // bad name. it's width really
@@ -7028,7 +7353,9 @@ MV_FORCEINLINE void MDegrainN::MEL_LC(
 
   if (bMVsAddProc)
   {
+    MVProfileScope prof_filter(_prof_uptr.get(), MVPROF_MV_FILTER);
     FilterBlkMVs(iBlkNum, ibx, iby);
+    prof_filter.stop();
 
     for (int k = 0; k < _trad * 2; ++k)
     {
@@ -7092,129 +7419,94 @@ MV_FORCEINLINE void MDegrainN::MEL_LC(
     }
   }
 
-  for (int dmt_row = 0; dmt_row < (_trad * 2 + 1); dmt_row++)
-  {
-    for (int dmt_col = 0; dmt_col < (_trad * 2 + 1); dmt_col++)
-    {
-      if (dmt_row == dmt_col)
-      {
-        DM_table[dmt_row][dmt_col] = 0; // block with itself
-        continue;
-      }
-
-      // calc table triangle first (performance optimization)
-      if ( dmt_col > dmt_row)
-      {
-        continue;
-      }
-
-      // 0 is current src block ? 1,2,3,4,... -1, +1, -2, +2, blocks in total tr-pool ?
-      const BYTE* row_data_ptr;
-      const BYTE* row_data_ptrUV1;
-      const BYTE* row_data_ptrUV2;
-      int row_pitch;
-      int row_pitch_UV1;
-      int row_pitch_UV2;
+  // 0 is current src block, 1,2,3,4,... -1, +1, -2, +2, blocks in total tr-pool
+  const BYTE* dmt_data_ptr[3][MAX_TEMP_RAD * 2 + 1];
+  int dmt_pitch[3][MAX_TEMP_RAD * 2 + 1];
 
-      const BYTE* col_data_ptr;
-      const BYTE* col_data_ptrUV1;
-      const BYTE* col_data_ptrUV2;
-      int col_pitch;
-      int col_pitch_UV1;
-      int col_pitch_UV2;
+  dmt_data_ptr[0][0] = pSrcCur + (xx << pixelsize_super_shift);
+  dmt_pitch[0][0] = _src_pitch_arr[0];
+  dmt_data_ptr[1][0] = pSrcCurUV1 + (xx_uv << pixelsize_super_shift);
+  dmt_pitch[1][0] = _src_pitch_arr[1];
+  dmt_data_ptr[2][0] = pSrcCurUV2 + (xx_uv << pixelsize_super_shift);
+  dmt_pitch[2][0] = _src_pitch_arr[2];
 
+  for (int k = 0; k < _trad * 2; k++)
+  {
+    dmt_data_ptr[0][k + 1] = ref_data_ptr_arr[k];
+    dmt_pitch[0][k + 1] = pitch_arr[k];
+    dmt_data_ptr[1][k + 1] = ref_data_ptr_arrUV1[k];
+    dmt_pitch[1][k + 1] = pitch_arrUV1[k];
+    dmt_data_ptr[2][k + 1] = ref_data_ptr_arrUV2[k];
+    dmt_pitch[2][k + 1] = pitch_arrUV2[k];
+  }
 
-      if (dmt_row == 0) // src block
-      {
-        row_data_ptr = pSrcCur + (xx << pixelsize_super_shift);
-        row_pitch = _src_pitch_arr[0];
+  for (int dmt_row = 0; dmt_row < (_trad * 2 + 1); dmt_row++)
+  {
+    DM_table[dmt_row][dmt_row] = 0; // block with itself
 
-        row_data_ptrUV1 = pSrcCurUV1 + (xx_uv << pixelsize_super_shift);
-        row_pitch_UV1 = _src_pitch_arr[1];
+    // calc table triangle first (performance optimization):
+    // dismetrics of the row block with all the previous blocks in one batch
+    if (dmt_row == 0)
+    {
+      continue;
+    }
 
-        row_data_ptrUV2 = pSrcCurUV2 + (xx_uv << pixelsize_super_shift);
-        row_pitch_UV2 = _src_pitch_arr[2];
-      }
-      else // ref block
+    // DM-cached process: a frame pair DM comes from the blocks of a previous
+    // current frame (other MVs), so the output is not the same as without
+    // the cache, and depends on the frame request order.
+    if (TTH_DMcache)
+    {
+      for (int dmt_col = 0; dmt_col < dmt_row; dmt_col++)
       {
-        row_data_ptr = ref_data_ptr_arr[dmt_row - 1];
-        row_pitch = pitch_arr[dmt_row - 1];
+        // check cached DM:
+        int iFr0 = iFrameNumRequested + abs_frame_offset(dmt_row);
+        int iFr1 = iFrameNumRequested + abs_frame_offset(dmt_col);
 
-        row_data_ptrUV1 = ref_data_ptr_arrUV1[dmt_row - 1];
-        row_pitch_UV1 = pitch_arrUV1[dmt_row - 1];
+        int iDM;
 
-        row_data_ptrUV2 = ref_data_ptr_arrUV2[dmt_row - 1];
-        row_pitch_UV2 = pitch_arrUV2[dmt_row - 1];
-      }
-
-      if (dmt_col == 0) // src block
-      {
-        col_data_ptr = pSrcCur + (xx << pixelsize_super_shift);
-        col_pitch = _src_pitch_arr[0];
+        // DM-cached process
+        if (!dmc->Get(iFr0, iFr1, &iDM)) // frame pair DM not yet cached
+        {
+          // calculate relative dismetric of dmt_row with dmt_col blocks
+          int idm_chroma = 0;
+          if (TTH_chroma)
+          {
+            idm_chroma = ScaleSadChroma(DM_TTH_Chroma->GetDisMetric(dmt_data_ptr[1][dmt_row], dmt_pitch[1][dmt_row], dmt_data_ptr[1][dmt_col], dmt_pitch[1][dmt_col])
+              + DM_TTH_Chroma->GetDisMetric(dmt_data_ptr[2][dmt_row], dmt_pitch[2][dmt_row], dmt_data_ptr[2][dmt_col], dmt_pitch[2][dmt_col]), _mv_clip_arr[0]._clip_sptr->chromaSADScale);
+          }
+          int idm_luma = DM_TTH_Luma->GetDisMetric(dmt_data_ptr[0][dmt_row], dmt_pitch[0][dmt_row], dmt_data_ptr[0][dmt_col], dmt_pitch[0][dmt_col]);
+          iDM = idm_luma + idm_chroma;
 
-        col_data_ptrUV1 = pSrcCurUV1 + (xx_uv << pixelsize_super_shift);
-        col_pitch_UV1 = _src_pitch_arr[1];
+          // also push new value to cache
+          dmc->PushNew(iFr0, iFr1, iDM);
+        }
 
-        col_data_ptrUV2 = pSrcCurUV2 + (xx_uv << pixelsize_super_shift);
-        col_pitch_UV2 = _src_pitch_arr[2];
+        DM_table[dmt_row][dmt_col] = iDM;
       }
-      else // ref block
+    }
+    else
+    {
+      // no-DM cache
+      int idm_luma[MAX_TEMP_RAD * 2 + 1];
+      int idm_UV1[MAX_TEMP_RAD * 2 + 1];
+      int idm_UV2[MAX_TEMP_RAD * 2 + 1];
+      DM_TTH_Luma->GetDisMetricBatch(dmt_data_ptr[0][dmt_row], dmt_pitch[0][dmt_row], dmt_data_ptr[0], dmt_pitch[0], dmt_row, idm_luma);
+      if (TTH_chroma)
       {
-        col_data_ptr = ref_data_ptr_arr[dmt_col - 1];
-        col_pitch = pitch_arr[dmt_col - 1];
-
-        col_data_ptrUV1 = ref_data_ptr_arrUV1[dmt_col - 1];
-        col_pitch_UV1 = pitch_arrUV1[dmt_col - 1];
-
-        col_data_ptrUV2 = ref_data_ptr_arrUV2[dmt_col - 1];
-        col_pitch_UV2 = pitch_arrUV2[dmt_col - 1];
+        DM_TTH_Chroma->GetDisMetricBatch(dmt_data_ptr[1][dmt_row], dmt_pitch[1][dmt_row], dmt_data_ptr[1], dmt_pitch[1], dmt_row, idm_UV1);
+        DM_TTH_Chroma->GetDisMetricBatch(dmt_data_ptr[2][dmt_row], dmt_pitch[2][dmt_row], dmt_data_ptr[2], dmt_pitch[2], dmt_row, idm_UV2);
       }
 
-#if 0 // cache usage temporarily excluded from release - need cache fetching (management) method improuvement, esa search too slow
-      // check cached DM:
-      int iFr0 = iFrameNumRequested + abs_frame_offset(dmt_row);
-      int iFr1 = iFrameNumRequested + abs_frame_offset(dmt_col);
-
-      int iDM;
-
-      // DM-cached process
-      if (!dmc->Get(iFr0, iFr1, &iDM)) // frame pair DM not yet cached
+      for (int dmt_col = 0; dmt_col < dmt_row; dmt_col++)
       {
-        // calculate relative dismetric of dmt_row with dmt_col blocks
         int idm_chroma = 0;
         if (TTH_chroma)
         {
-          idm_chroma = ScaleSadChroma(DM_TTH_Chroma->GetDisMetric(row_data_ptrUV1, row_pitch_UV1, col_data_ptrUV1, col_pitch_UV1)
-            + DM_TTH_Chroma->GetDisMetric(row_data_ptrUV2, row_pitch_UV2, col_data_ptrUV2, col_pitch_UV2), _mv_clip_arr[0]._clip_sptr->chromaSADScale);
+          idm_chroma = ScaleSadChroma(idm_UV1[dmt_col] + idm_UV2[dmt_col], _mv_clip_arr[0]._clip_sptr->chromaSADScale);
         }
-        int idm_luma = DM_TTH_Luma->GetDisMetric(row_data_ptr, row_pitch, col_data_ptr, col_pitch);
-        iDM = idm_luma + idm_chroma;
 
-        // also push new value to cache
-        dmc->PushNew(iFr0, iFr1, iDM);
-      }
-      else
-      {
-#ifdef _DEBUG
-        iDM_cache_hits++;
-#endif
+        DM_table[dmt_row][dmt_col] = idm_luma[dmt_col] + idm_chroma;
       }
-
-        DM_table[dmt_row][dmt_col] = iDM;
-#endif
-
-//#if 0
-        // no-DM cache
-        int idm_chroma = 0;
-        if (TTH_chroma)
-        {
-          idm_chroma = ScaleSadChroma(DM_TTH_Chroma->GetDisMetric(row_data_ptrUV1, row_pitch_UV1, col_data_ptrUV1, col_pitch_UV1)
-            + DM_TTH_Chroma->GetDisMetric(row_data_ptrUV2, row_pitch_UV2, col_data_ptrUV2, col_pitch_UV2), _mv_clip_arr[0]._clip_sptr->chromaSADScale);
-        }
-        int idm_luma = DM_TTH_Luma->GetDisMetric(row_data_ptr, row_pitch, col_data_ptr, col_pitch);
-
-        DM_table[dmt_row][dmt_col] = idm_luma + idm_chroma;
-//#endif
     }
   }
 
@@ -7326,17 +7618,17 @@ MV_FORCEINLINE void MDegrainN::MEL_LC(
   {
     // luma
     BitBlt(pYmem, Ymem_pitch,
-      best_data_ptr, best_pitch, nBlkSizeX, nBlkSizeY);
+      best_data_ptr, best_pitch, nBlkSizeX * pixelsize, nBlkSizeY);
 
     // chroma1
     BitBlt(pUV1mem, UV1mem_pitch,
       best_data_ptrUV1, best_pitch_UV1,
-      rowwidthUV, rowsizeUV);
+      rowwidthUV * pixelsize, rowsizeUV);
 
     // chroma1
     BitBlt(pUV2mem, UV2mem_pitch,
       best_data_ptrUV2, best_pitch_UV2,
-      rowwidthUV, rowsizeUV);
+      rowwidthUV * pixelsize, rowsizeUV);
 
     // update sum memory with lowest sum
     pMELmemYSum[iby * nBlkX + ibx] = i_sum_minrow;
@@ -7468,39 +7760,20 @@ MV_FORCEINLINE void MDegrainN::CalcAutothSADs(void)
   }
 }
 
-MV_FORCEINLINE void MDegrainN::DegrainBlendBlock_LC(
-  BYTE* pDst, BYTE* pDstLsb, int iDstPitch,
-  const BYTE* pSrc,
-  BYTE* pDstUV1, BYTE* pDstLsbUV1, int iDstPitchUV1,
-  const BYTE* pSrcUV1,
-  BYTE* pDstUV2, BYTE* pDstLsbUV2, int iDstPitchUV2,
-  const BYTE* pSrcUV2,
+MV_FORCEINLINE int* MDegrainN::GetBlendRefs_LC(
+  const BYTE* ref_data_ptr_arr[], int pitch_arr[],
+  const BYTE* ref_data_ptr_arrUV1[], int pitch_arrUV1[],
+  const BYTE* ref_data_ptr_arrUV2[], int pitch_arrUV2[],
+  int weight_arr[], int weight_arrUV[],
+  const BYTE* pSrc, const BYTE* pSrcUV1, const BYTE* pSrcUV2,
   int iBlkNum, int ibx, int iby, int xx, int xx_uv
 )
 {
-  // ToDo: use BlockArea class later !
-  BYTE* pYmem = pMELmemY + iBlkNum * nBlkSizeX * nBlkSizeY * pixelsize;
-  BYTE* pUV1mem = pMELmemUV1 + iBlkNum * (nBlkSizeX >> nLogxRatioUV_super)* (nBlkSizeY >> nLogyRatioUV_super)* pixelsize;
-  BYTE* pUV2mem = pMELmemUV2 + iBlkNum * (nBlkSizeX >> nLogxRatioUV_super)* (nBlkSizeY >> nLogyRatioUV_super)* pixelsize;
-  int Ymem_pitch = nBlkSizeY * pixelsize;
-  int UV1mem_pitch = (nBlkSizeY >> nLogyRatioUV_super)* pixelsize;
-  int UV2mem_pitch = (nBlkSizeY >> nLogyRatioUV_super)* pixelsize;
-  const int rowwidthUV = nBlkSizeX >> nLogxRatioUV_super; // bad name. it's width really
-  const int rowsizeUV = nBlkSizeY >> nLogyRatioUV_super; // bad name. it's height really
-
-  const BYTE* ref_data_ptr_arr[MAX_TEMP_RAD * 2];
-  int pitch_arr[MAX_TEMP_RAD * 2];
-  int weight_arr[1 + MAX_TEMP_RAD * 2];
-  int weight_arrUV[1 + MAX_TEMP_RAD * 2];
-
-  const BYTE* ref_data_ptr_arrUV1[MAX_TEMP_RAD * 2]; // vs: const uint8_t *pointers[radius * 2]; // Moved by the degrain function.
-  const BYTE* ref_data_ptr_arrUV2[MAX_TEMP_RAD * 2]; // vs: const uint8_t *pointers[radius * 2]; // Moved by the degrain function. 
-  int pitch_arrUV1[MAX_TEMP_RAD * 2];
-  int pitch_arrUV2[MAX_TEMP_RAD * 2];
-
   if (bMVsAddProc)
   {
+    MVProfileScope prof_filter(_prof_uptr.get(), MVPROF_MV_FILTER);
     FilterBlkMVs(iBlkNum, ibx, iby);
+    prof_filter.stop();
 
     for (int k = 0; k < _trad * 2; ++k)
     {
@@ -7584,6 +7857,47 @@ MV_FORCEINLINE void MDegrainN::DegrainBlendBlock_LC(
   pChromaWA = &weight_arrUV[0];
   else
   pChromaWA = &weight_arr[0];
+
+  return pChromaWA;
+}
+
+MV_FORCEINLINE void MDegrainN::DegrainBlendBlock_LC(
+  BYTE* pDst, BYTE* pDstLsb, int iDstPitch,
+  const BYTE* pSrc,
+  BYTE* pDstUV1, BYTE* pDstLsbUV1, int iDstPitchUV1,
+  const BYTE* pSrcUV1,
+  BYTE* pDstUV2, BYTE* pDstLsbUV2, int iDstPitchUV2,
+  const BYTE* pSrcUV2,
+  int iBlkNum, int ibx, int iby, int xx, int xx_uv
+)
+{
+  // ToDo: use BlockArea class later !
+  BYTE* pYmem = pMELmemY + iBlkNum * nBlkSizeX * nBlkSizeY * pixelsize;
+  BYTE* pUV1mem = pMELmemUV1 + iBlkNum * (nBlkSizeX >> nLogxRatioUV_super)* (nBlkSizeY >> nLogyRatioUV_super)* pixelsize;
+  BYTE* pUV2mem = pMELmemUV2 + iBlkNum * (nBlkSizeX >> nLogxRatioUV_super)* (nBlkSizeY >> nLogyRatioUV_super)* pixelsize;
+  int Ymem_pitch = nBlkSizeX * pixelsize;
+  int UV1mem_pitch = (nBlkSizeX >> nLogxRatioUV_super)* pixelsize;
+  int UV2mem_pitch = (nBlkSizeX >> nLogxRatioUV_super)* pixelsize;
+  const int rowwidthUV = nBlkSizeX >> nLogxRatioUV_super; // bad name. it's width really
+  const int rowsizeUV = nBlkSizeY >> nLogyRatioUV_super; // bad name. it's height really
+
+  const BYTE* ref_data_ptr_arr[MAX_TEMP_RAD * 2];
+  int pitch_arr[MAX_TEMP_RAD * 2];
+  int weight_arr[1 + MAX_TEMP_RAD * 2];
+  int weight_arrUV[1 + MAX_TEMP_RAD * 2];
+
+  const BYTE* ref_data_ptr_arrUV1[MAX_TEMP_RAD * 2]; // vs: const uint8_t *pointers[radius * 2]; // Moved by the degrain function.
+  const BYTE* ref_data_ptr_arrUV2[MAX_TEMP_RAD * 2]; // vs: const uint8_t *pointers[radius * 2]; // Moved by the degrain function. 
+  int pitch_arrUV1[MAX_TEMP_RAD * 2];
+  int pitch_arrUV2[MAX_TEMP_RAD * 2];
+
+  int* pChromaWA = GetBlendRefs_LC(
+    ref_data_ptr_arr, pitch_arr,
+    ref_data_ptr_arrUV1, pitch_arrUV1,
+    ref_data_ptr_arrUV2, pitch_arrUV2,
+    weight_arr, weight_arrUV,
+    pSrc, pSrcUV1, pSrcUV2,
+    iBlkNum, ibx, iby, xx, xx_uv);
 
   // luma
   if (MPBNumIt == 0 || !isMVsStable(pMVsWorkPlanesArrays, iBlkNum, weight_arr))
@@ -7628,11 +7942,11 @@ MV_FORCEINLINE void MDegrainN::DegrainBlendBlock_LC(
       {
         //mem still good - output mem block
         // luma
-        BitBlt(pDst, iDstPitch, pYmem, Ymem_pitch, nBlkSizeX, nBlkSizeY);
+        BitBlt(pDst, iDstPitch, pYmem, Ymem_pitch, nBlkSizeX * pixelsize, nBlkSizeY);
         // chroma1
-        BitBlt(pDstUV1, iDstPitchUV1, pUV1mem, UV1mem_pitch, rowwidthUV, rowsizeUV);
+        BitBlt(pDstUV1, iDstPitchUV1, pUV1mem, UV1mem_pitch, rowwidthUV * pixelsize, rowsizeUV);
         // chroma2
-        BitBlt(pDstUV2, iDstPitchUV2, pUV2mem, UV2mem_pitch, rowwidthUV, rowsizeUV);
+        BitBlt(pDstUV2, iDstPitchUV2, pUV2mem, UV2mem_pitch, rowwidthUV * pixelsize, rowsizeUV);
 
   #ifdef _DEBUG
         iMEL_mem_hits++;
@@ -7641,11 +7955,11 @@ MV_FORCEINLINE void MDegrainN::DegrainBlendBlock_LC(
       else // mem no good - update mem
       {
         // luma
-        BitBlt(pYmem, Ymem_pitch, pDst, iDstPitch, nBlkSizeX, nBlkSizeY);
+        BitBlt(pYmem, Ymem_pitch, pDst, iDstPitch, nBlkSizeX * pixelsize, nBlkSizeY);
         // chroma1
-        BitBlt(pUV1mem, UV1mem_pitch, pDstUV1, iDstPitchUV1, rowwidthUV, rowsizeUV);
+        BitBlt(pUV1mem, UV1mem_pitch, pDstUV1, iDstPitchUV1, rowwidthUV * pixelsize, rowsizeUV);
         // chroma2
-        BitBlt(pUV2mem, UV2mem_pitch, pDstUV2, iDstPitchUV2, rowwidthUV, rowsizeUV);
+        BitBlt(pUV2mem, UV2mem_pitch, pDstUV2, iDstPitchUV2, rowwidthUV * pixelsize, rowsizeUV);
   #ifdef _DEBUG
         iMEL_mem_updates++;
   #endif
@@ -7696,6 +8010,43 @@ MV_FORCEINLINE void MDegrainN::DegrainBlendBlock_LC(
   }
 }
 
+// Degrain blend of the 3 planes added into the overlap buffers, no temporary blocks
+MV_FORCEINLINE void MDegrainN::DegrainOverlapsBlock_LC(
+  uint16_t* pDstOvr, uint16_t* pDstOvrUV1, uint16_t* pDstOvrUV2, int iDstOvrPitch,
+  short* winOver, short* winOverUV,
+  const BYTE* pSrc, const BYTE* pSrcUV1, const BYTE* pSrcUV2,
+  int iBlkNum, int ibx, int iby, int xx, int xx_uv
+)
+{
+  const BYTE* ref_data_ptr_arr[MAX_TEMP_RAD * 2];
+  int pitch_arr[MAX_TEMP_RAD * 2];
+  int weight_arr[1 + MAX_TEMP_RAD * 2];
+  int weight_arrUV[1 + MAX_TEMP_RAD * 2];
+
+  const BYTE* ref_data_ptr_arrUV1[MAX_TEMP_RAD * 2];
+  const BYTE* ref_data_ptr_arrUV2[MAX_TEMP_RAD * 2];
+  int pitch_arrUV1[MAX_TEMP_RAD * 2];
+  int pitch_arrUV2[MAX_TEMP_RAD * 2];
+
+  int* pChromaWA = GetBlendRefs_LC(
+    ref_data_ptr_arr, pitch_arr,
+    ref_data_ptr_arrUV1, pitch_arrUV1,
+    ref_data_ptr_arrUV2, pitch_arrUV2,
+    weight_arr, weight_arrUV,
+    pSrc, pSrcUV1, pSrcUV2,
+    iBlkNum, ibx, iby, xx, xx_uv);
+
+  _degrainoverlaps_yuv_ptr(
+    pDstOvr, pDstOvrUV1, pDstOvrUV2, iDstOvrPitch,
+    pSrc + (xx << pixelsize_super_shift), _src_pitch_arr[0],
+    pSrcUV1 + (xx_uv << pixelsize_super_shift), _src_pitch_arr[1],
+    pSrcUV2 + (xx_uv << pixelsize_super_shift), _src_pitch_arr[2],
+    ref_data_ptr_arr, pitch_arr, ref_data_ptr_arrUV1, pitch_arrUV1, ref_data_ptr_arrUV2, pitch_arrUV2,
+    weight_arr, pChromaWA, _trad,
+    winOver, winOverUV
+  );
+}
+
 // Multi-generation MVs refining, called after first normal blend using current working MVs
 MV_FORCEINLINE void MDegrainN::MGR_LC(
   BYTE* pDst, BYTE* pDstLsb, int iDstPitch,
@@ -7858,178 +8209,152 @@ MV_FORCEINLINE void MDegrainN::RefineMV(
 }
 
 void MDegrainN::ExpandingSearch(
-  BYTE* pDst, int iDstPitch,
-  BYTE* pDstUV1, int iDstPitchUV1,
+  BYTE* pDst, int iDstPitch,
+  BYTE* pDstUV1, int iDstPitchUV1,
   BYTE* pDstUV2, int iDstPitchUV2,
-  int bx_src, int by_src, // numbers of blocks
+  int bx_src, int by_src, // numbers of blocks
   int ref_idx,
   int r, int s, int mvx, int mvy, VECTOR* Refined) // diameter = 2*r + 1, step=s
 { // part of true exhaustive search (thin expanding square) around mvx, mvy
-  int i, j;
-  sad_t currSAD;
+  // The ring positions are checked in the same order as single CheckMV calls:
+  // top/bottom pairs without corners (v2.1), left/right pairs, then the corners.
+  // They are sent to GetSADBatch by chunks of MGR_BATCH.
+  const int MGR_BATCH = 32;
+  int dx_arr[MGR_BATCH];
+  int dy_arr[MGR_BATCH];
+  sad_t sad_arr[MGR_BATCH];
+
+  const int iNumSide = (s < 2 * r) ? (2 * r - s - 1) / s + 1 : 0;
+  const int iNumCand = 4 * iNumSide + 4;
 
   Refined->x = 0;
   Refined->y = 0;
   Refined->sad = veryBigSAD;
 
-  for (i = -r + s; i < r; i += s) // without corners! - v2.1
+  for (int c0 = 0; c0 < iNumCand; c0 += MGR_BATCH)
   {
-//    CheckMV<pixel_t>(workarea, mvx + i, mvy - r);
-//    CheckMV<pixel_t>(workarea, mvx + i, mvy + r);
-    currSAD = GetSAD(pDst, iDstPitch, pDstUV1, iDstPitchUV1, pDstUV2, iDstPitchUV2, bx_src, by_src, ref_idx, mvx + i, mvy - r);
-    if (currSAD < Refined->sad)
-    {
-      Refined->x = mvx + i;
-      Refined->y = mvx - r;
-      Refined->sad = currSAD;
-    }
+    const int n = (iNumCand - c0 < MGR_BATCH) ? iNumCand - c0 : MGR_BATCH;
 
-    currSAD = GetSAD(pDst, iDstPitch, pDstUV1, iDstPitchUV1, pDstUV2, iDstPitchUV2, bx_src, by_src, ref_idx, mvx + i, mvy + r);
-    if (currSAD < Refined->sad)
+    for (int c = 0; c < n; c++)
     {
-      Refined->x = mvx + i;
-      Refined->y = mvx + r;
-      Refined->sad = currSAD;
+      const int idx = c0 + c;
+      if (idx < 2 * iNumSide)
+      {
+        const int i = -r + s + (idx >> 1) * s;
+        dx_arr[c] = mvx + i;
+        dy_arr[c] = (idx & 1) ? mvy + r : mvy - r;
+      }
+      else if (idx < 4 * iNumSide)
+      {
+        const int j = -r + s + ((idx - 2 * iNumSide) >> 1) * s;
+        dx_arr[c] = (idx & 1) ? mvx + r : mvx - r;
+        dy_arr[c] = mvy + j;
+      }
+      else // then corners - they are more far from cenrer
+      {
+        const int corner = idx - 4 * iNumSide;
+        dx_arr[c] = (corner < 2) ? mvx - r : mvx + r;
+        dy_arr[c] = (corner & 1) ? mvy + r : mvy - r;
+      }
     }
-  }
 
-  for (j = -r + s; j < r; j += s)
-  {
-//    CheckMV<pixel_t>(workarea, mvx - r, mvy + j);
-//    CheckMV<pixel_t>(workarea, mvx + r, mvy + j);
-    currSAD = GetSAD(pDst, iDstPitch, pDstUV1, iDstPitchUV1, pDstUV2, iDstPitchUV2, bx_src, by_src, ref_idx, mvx - r, mvy + j);
-    if (currSAD < Refined->sad)
-    {
-      Refined->x = mvx - r;
-      Refined->y = mvx + j;
-      Refined->sad = currSAD;
-    }
+    GetSADBatch(pDst, iDstPitch, pDstUV1, iDstPitchUV1, pDstUV2, iDstPitchUV2, bx_src, by_src, ref_idx, dx_arr, dy_arr, n, sad_arr);
 
-    currSAD = GetSAD(pDst, iDstPitch, pDstUV1, iDstPitchUV1, pDstUV2, iDstPitchUV2, bx_src, by_src, ref_idx, mvx + r, mvy + j);
-    if (currSAD < Refined->sad)
+    for (int c = 0; c < n; c++)
     {
-      Refined->x = mvx + r;
-      Refined->y = mvx + j;
-      Refined->sad = currSAD;
+      if (sad_arr[c] < Refined->sad)
+      {
+        Refined->x = dx_arr[c];
+        Refined->y = dy_arr[c];
+        Refined->sad = sad_arr[c];
+      }
     }
   }
 
-  // then corners - they are more far from cenrer
-//  CheckMV<pixel_t>(workarea, mvx - r, mvy - r);
-  currSAD = GetSAD(pDst, iDstPitch, pDstUV1, iDstPitchUV1, pDstUV2, iDstPitchUV2, bx_src, by_src, ref_idx, mvx - r, mvy - r);
-  if (currSAD < Refined->sad)
-  {
-    Refined->x = mvx - r;
-    Refined->y = mvx - r;
-    Refined->sad = currSAD;
-  }
-//  CheckMV<pixel_t>(workarea, mvx - r, mvy + r);
-  currSAD = GetSAD(pDst, iDstPitch, pDstUV1, iDstPitchUV1, pDstUV2, iDstPitchUV2, bx_src, by_src, ref_idx, mvx - r, mvy + r);
-  if (currSAD < Refined->sad)
-  {
-    Refined->x = mvx - r;
-    Refined->y = mvx + r;
-    Refined->sad = currSAD;
-  }
-
-//  CheckMV<pixel_t>(workarea, mvx + r, mvy - r);
-  currSAD = GetSAD(pDst, iDstPitch, pDstUV1, iDstPitchUV1, pDstUV2, iDstPitchUV2, bx_src, by_src, ref_idx, mvx + r, mvy - r);
-  if (currSAD < Refined->sad)
-  {
-    Refined->x = mvx + r;
-    Refined->y = mvx - r;
-    Refined->sad = currSAD;
-  }
-
-//  CheckMV<pixel_t>(workarea, mvx + r, mvy + r);
-  currSAD = GetSAD(pDst, iDstPitch, pDstUV1, iDstPitchUV1, pDstUV2, iDstPitchUV2, bx_src, by_src, ref_idx, mvx + r, mvy + r);
-  if (currSAD < Refined->sad)
-  {
-    Refined->x = mvx + r;
-    Refined->y = mvx + r;
-    Refined->sad = currSAD;
-  }
-
 }
 
 MV_FORCEINLINE sad_t MDegrainN::GetSAD(
-  BYTE* pSrc, int iSrcPitch,
-  BYTE* pSrcUV1, int iSrcPitchUV1,
+  BYTE* pSrc, int iSrcPitch,
+  BYTE* pSrcUV1, int iSrcPitchUV1,
   BYTE* pSrcUV2, int iSrcPitchUV2,
-  int bx_src, int by_src, // numbers of blocks
+  int bx_src, int by_src, // numbers of blocks
   int ref_idx, int dx_ref, int dy_ref)
 {
   sad_t sad_out;
+  GetSADBatch(pSrc, iSrcPitch, pSrcUV1, iSrcPitchUV1, pSrcUV2, iSrcPitchUV2, bx_src, by_src, ref_idx, &dx_ref, &dy_ref, 1, &sad_out);
+  return sad_out;
+}
 
+// SADs of one source block against n positions of the same reference.
+// The source block and the ref planes stay in cache for all the positions.
+MV_FORCEINLINE void MDegrainN::GetSADBatch(
+  BYTE* pSrc, int iSrcPitch,
+  BYTE* pSrcUV1, int iSrcPitchUV1,
+  BYTE* pSrcUV2, int iSrcPitchUV2,
+  int bx_src, int by_src, // numbers of blocks
+  int ref_idx, const int* dx_ref, const int* dy_ref, int n, sad_t* pSAD)
+{
   if (!_usable_flag_arr[ref_idx]) // nothing to process
   {
-    return veryBigSAD;
+    for (int c = 0; c < n; c++)
+    {
+      pSAD[c] = veryBigSAD;
+    }
+    return;
   }
 
-  const int xx = bx_src * (nBlkSizeX - nOverlapX); // xx: indexing offset, - overlap ?
-  const int xx_uv = bx_src * ((nBlkSizeX - nOverlapX) >> nLogxRatioUV_super); // xx_uv: indexing offset
-
-  bool bChroma = (_nsupermodeyuv & UPLANE) && (_nsupermodeyuv & VPLANE); // chroma present in super clip ?
+  const bool bChroma = (_nsupermodeyuv & UPLANE) && (_nsupermodeyuv & VPLANE); // chroma present in super clip ?
 // scaleCSAD in the MVclip props
-  int chromaSADscale = _mv_clip_arr[0]._clip_sptr->chromaSADScale; // from 1st ?
+  const int chromaSADscale = _mv_clip_arr[0]._clip_sptr->chromaSADScale; // from 1st ?
 
-  const uint8_t* pRef;
-  int npitchRef;
+  for (int c = 0; c < n; c++)
+  {
+    const uint8_t* pRef;
+    int npitchRef;
 
-  int blx = bx_src * (nBlkSizeX - nOverlapX) * nPel + dx_ref;
-  int bly = by_src * (nBlkSizeY - nOverlapY) * nPel + dy_ref;
+    int blx = bx_src * (nBlkSizeX - nOverlapX) * nPel + dx_ref[c];
+    int bly = by_src * (nBlkSizeY - nOverlapY) * nPel + dy_ref[c];
 
-  ClipBlxBly
-
-    if (nPel != 1 && nUseSubShift != 0)
-    {
-      pRef = _planes_ptr[ref_idx][0]->GetPointerSubShift(blx, bly, npitchRef);
-    }
-    else
-    {
-      pRef = _planes_ptr[ref_idx][0]->GetPointer(blx, bly);
-      npitchRef = _planes_ptr[ref_idx][0]->GetPitch();
-    }
+    ClipBlxBly
 
-  sad_t sad_chroma = 0;
+      if (nPel != 1 && nUseSubShift != 0)
+      {
+        pRef = _planes_ptr[ref_idx][0]->GetPointerSubShift(blx, bly, npitchRef);
+      }
+      else
+      {
+        pRef = _planes_ptr[ref_idx][0]->GetPointer(blx, bly);
+        npitchRef = _planes_ptr[ref_idx][0]->GetPitch();
+      }
 
-  if (bChroma)
-  {
-    const uint8_t* pRefU;
-    const uint8_t* pRefV;
-    int npitchRefU, npitchRefV;
+    sad_t sad_out = SAD(pSrc, iSrcPitch, pRef, npitchRef);
 
-    if (/*nPel != 1 && */nUseSubShift != 0)
-    {
-      if (nLogxRatioUV_super == 1) blx++; // add bias for integer division for 4:2:x formats
-      if (nLogyRatioUV_super == 1) bly++; // add bias for integer division for 4:2:x formats
-      pRefU = _planes_ptr[ref_idx][1]->GetPointerSubShift(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super, npitchRefU);
-      pRefV = _planes_ptr[ref_idx][2]->GetPointerSubShift(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super, npitchRefV);
-      //      pRefU = _planes_ptr[ref_idx][1]->GetPointerSubShiftUV(blx, bly, npitchRefU, nLogxRatioUV_super, nLogyRatioUV_super);
-      //      pRefV = _planes_ptr[ref_idx][2]->GetPointerSubShiftUV(blx, bly, npitchRefV, nLogxRatioUV_super, nLogyRatioUV_super);
-    }
-    else
+    if (bChroma)
     {
+      const uint8_t* pRefU;
+      const uint8_t* pRefV;
+      int npitchRefU, npitchRefV;
+
       if (nLogxRatioUV_super == 1) blx++; // add bias for integer division for 4:2:x formats
       if (nLogyRatioUV_super == 1) bly++; // add bias for integer division for 4:2:x formats
-      pRefU = _planes_ptr[ref_idx][1]->GetPointer(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super);
-      npitchRefU = _planes_ptr[ref_idx][1]->GetPitch();
-      pRefV = _planes_ptr[ref_idx][2]->GetPointer(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super);
-      npitchRefV = _planes_ptr[ref_idx][2]->GetPitch();
-    }
-
-    sad_chroma = ScaleSadChroma(SADCHROMA(pSrcUV1, iSrcPitchUV1, pRefU, npitchRefU)
-      + SADCHROMA(pSrcUV1, iSrcPitchUV1, pRefV, npitchRefV), chromaSADscale);
 
-    sad_t luma_sad = SAD(pSrc, iSrcPitch, pRef, npitchRef);
+      if (/*nPel != 1 && */nUseSubShift != 0)
+      {
+        pRefU = _planes_ptr[ref_idx][1]->GetPointerSubShift(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super, npitchRefU);
+        pRefV = _planes_ptr[ref_idx][2]->GetPointerSubShift(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super, npitchRefV);
+      }
+      else
+      {
+        pRefU = _planes_ptr[ref_idx][1]->GetPointer(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super);
+        npitchRefU = _planes_ptr[ref_idx][1]->GetPitch();
+        pRefV = _planes_ptr[ref_idx][2]->GetPointer(blx >> nLogxRatioUV_super, bly >> nLogyRatioUV_super);
+        npitchRefV = _planes_ptr[ref_idx][2]->GetPitch();
+      }
 
-    sad_out = luma_sad + sad_chroma;
+      sad_out += ScaleSadChroma(SADCHROMA(pSrcUV1, iSrcPitchUV1, pRefU, npitchRefU)
+        + SADCHROMA(pSrcUV2, iSrcPitchUV2, pRefV, npitchRefV), chromaSADscale);
+    }
 
+    pSAD[c] = sad_out;
   }
-  else
-  {
-    sad_out = SAD(pSrc, iSrcPitch, pRef, npitchRef);
-  }
-
-  return sad_out;
 }
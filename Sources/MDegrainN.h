@@ -9,6 +9,7 @@
 #include "MVFilter.h"
 #include	"MVGroupOfFrames.h"
 #include "overlap.h"
+#include "profile.h"
 #include "SharedPtr.h"
 #include "yuy2planes.h"
 #include "def.h"
@@ -18,12 +19,12 @@
 #include "BlockArea.h"
 #include "dm_cache.h"
 #include "SADFunctions.h"
+#include "MVFilterSoA.h"
 
 #include	<memory>
 #include	<vector>
 
 #define CACHE_LINE_SIZE 64
-#define MVLPFKERNELSIZE 11 // 10+1 odd number, 10 - just some medium number relative to typical tr and allow to have some variance in slope
 
 enum PMode
 {
@@ -68,8 +69,8 @@ public:
     int _MPB_MVlth, int _pmode, int _TTH_DMFlags, int _TTH_thUPD, int _TTH_BAS, bool _TTH_chroma, ::PClip _dnmask,
     float _thSADA_a, float _thSADA_b, int _MVMedF, int _MVMedF_em, int _MVMedF_cm, int _MVF_fm,
     int _MGR, int _MGR_sr, int _MGR_st, int _MGR_pm,
-    int _LtComp, int _NEW_DMFlags,
-    ::IScriptEnvironment* env_ptr
+    int _LtComp, int _NEW_DMFlags, bool prefetch_flag, bool _TTH_DMcache,
+    ::IScriptEnvironment* env_ptr
   );
   ~MDegrainN();
 
@@ -77,16 +78,18 @@ public:
 
   int __stdcall SetCacheHints(int cachehints, int frame_range) override {
     //    return cachehints == CACHE_GET_MTMODE ? MT_MULTI_INSTANCE : 0;
-    // if any IIR-type processing enabled - set MT_SERIALIZED
-    return cachehints == CACHE_GET_MTMODE ? ((TTH_thUPD > 0 ) ? MT_SERIALIZED : MT_MULTI_INSTANCE) : 0;
+    // if any IIR-type processing enabled - set MT_SERIALIZED: the TTH memory of a frame is the
+    // result of the previously processed one, so the frames must come one at a time, and the
+    // output depends on their order. A frame-independent recursion is not implemented (yet).
+    // Each block has its own memory tile, so the block rows can still be sliced with mt=true.
+    if (cachehints == CACHE_GET_MTMODE)
+      return (TTH_thUPD > 0) ? MT_SERIALIZED : MT_MULTI_INSTANCE;
+    // prefetch only pays off when the frames are requested in order
+    if (cachehints == CACHE_GETCHILD_ACCESS_COST)
+      return _prefetch_flag ? CACHE_ACCESS_SEQ1 : CACHE_ACCESS_RAND;
+    return 0;
   }
 
-
-protected:
-
-private:
-  bool has_at_least_v8;
-
   typedef void (DenoiseNFunction)(
     BYTE *pDst, BYTE *pDstLsb, int nDstPitch,
     const BYTE *pSrc, int nSrcPitch,
@@ -96,7 +99,26 @@ private:
     int Wall[], int trad
     );
 
-  DenoiseNFunction* get_denoiseN_function(int BlockX, int BlockY, int _bits_per_pixel, bool _lsb_flag, bool _out16_flag, arch_t arch);
+  // static: also used by the standalone kernel benchmark (bench/mvtools_bench.cpp)
+  static DenoiseNFunction* get_denoiseN_function(int BlockX, int BlockY, int _bits_per_pixel, bool _lsb_flag, bool _out16_flag, arch_t arch);
+
+  // Y, U and V blocks of a block position degrained and added into the overlap buffers in a single call
+  typedef void (DegrainNOverlapsYUVFunction)(
+    uint16_t *pDst, uint16_t *pDstUV1, uint16_t *pDstUV2, int nDstPitch,
+    const BYTE *pSrc, int nSrcPitch, const BYTE *pSrcUV1, int nSrcPitchUV1, const BYTE *pSrcUV2, int nSrcPitchUV2,
+    const BYTE *pRef[], int Pitch[], const BYTE *pRefUV1[], int PitchUV1[], const BYTE *pRefUV2[], int PitchUV2[],
+    int Wall[], int WallUV[], int trad,
+    short *pWin, short *pWinUV
+    );
+
+  // nullptr if there is no fused version: the planes are degrained and overlapped one by one
+  static DegrainNOverlapsYUVFunction* get_degrainN_overlaps_yuv_function(int BlockX, int BlockY, int nLogxRatioUV, int nLogyRatioUV, int _bits_per_pixel, bool _lsb_flag, bool _out16_flag, arch_t arch);
+
+
+protected:
+
+private:
+  bool has_at_least_v8;
 
   class MvClipInfo
   {
@@ -114,6 +136,20 @@ private:
 
   typedef MTSlicer <MDegrainN> Slicer;
 
+  // Upstream frames needed to process an output frame. Indexes are the same
+  // as _mv_clip_arr.
+  class FrameSet
+  {
+  public:
+    int _n = -1;
+    std::vector <::PVideoFrame> _mv_arr;
+    std::vector <::PVideoFrame> _mvrs_arr;
+    std::vector <::PVideoFrame> _mvvs_arr;
+    std::vector <::PVideoFrame> _ref_arr; // Empty if not fetched in advance
+    ::PVideoFrame _src;
+    ::PVideoFrame _dnmask;
+  };
+
   class TmpBlock
   {
   public:
@@ -198,6 +234,7 @@ private:
   static MV_FORCEINLINE void
     norm_weights(int wref_arr[], int trad);
 
+  void FilterMVsSoA(void);
   void FilterMVs(void);
   MV_FORCEINLINE void FilterBlkMVs(int i, int bx, int by);
   MV_FORCEINLINE void PrefetchMVs(int i);
@@ -251,7 +288,6 @@ private:
   int iMVF_fm; // MVF_fm - MV filtering blocks fail mode: 0 - pass blocks with too bad filtered MVs SADs to blending, 1 - invalidate blocks with too bad filtered MVs SADs (skip from blending)
   bool bMVsAddProc; // bool indicate if additional processing of incoming MVs were performed and read must be from pFilteredMVsPlanesArrays (or even later in the future ?)
   float fMVLPFKernel[MVLPFKERNELSIZE];// 10+1 odd numbered
-  MV_FORCEINLINE void ProcessMVLPF(VECTOR* pVin, VECTOR* pVout);
   MV_FORCEINLINE void ProcessMVMedF(VECTOR* pVin, VECTOR* pVout);
 
   MV_FORCEINLINE void MVMedF_xy(VECTOR* pVin, VECTOR* pVout);
@@ -259,6 +295,17 @@ private:
   MV_FORCEINLINE void MVMedF_vad(VECTOR* pVin, VECTOR* pVout);
   MV_FORCEINLINE void MVMedF_mg(VECTOR* pVin, VECTOR* pVout);
   MV_FORCEINLINE void MVMedF_IQM(VECTOR* pVin, VECTOR* pVout);
+
+  // whole block rows temporal filtering by FilterMVsSoA, in structure of arrays form
+  MVLPFSoAFunction* MVLPF_SoA;
+  MVMedFSoAFunction* MVMedF_SoA; // 0 if iMVMedF_cm has no SoA version, per-block ProcessMVMedF used
+  MVAvgFunction* MVAvg; // for InterpolateOverlap_4x
+  int* pMVsSoA_a; // single aligned allocation of all the SoA planes
+  int iMVsSoAPitch; // ints per temporal position row
+  MV_SOA MVsSoAIn; // current row input
+  MV_SOA MVsSoATmp; // current row after the median-like pass of dual pass filtering
+  int* pMVsSoAFiltered; // filtered MVs of all the rows, read back by FilterBlkMVs
+  MV_FORCEINLINE MV_SOA GetFilteredMVsSoARow(int by);
   
 
   VECTOR* pFilteredMVsPlanesArrays[MAX_TEMP_RAD * 2];
@@ -278,6 +325,16 @@ private:
   int iLtComp; // 0 - disabled, 1 - DC compensation only mode
   uint8_t* pCompRefsBlksY;
 
+  // refs and normalized weights of a block for the single pass YUV proc, returns the chroma weights
+  MV_FORCEINLINE int* GetBlendRefs_LC(
+    const BYTE* ref_data_ptr_arr[], int pitch_arr[],
+    const BYTE* ref_data_ptr_arrUV1[], int pitch_arrUV1[],
+    const BYTE* ref_data_ptr_arrUV2[], int pitch_arrUV2[],
+    int weight_arr[], int weight_arrUV[],
+    const BYTE* pSrc, const BYTE* pSrcUV1, const BYTE* pSrcUV2,
+    int iBlkNum, int ibx, int iby, int xx, int xx_uv
+  );
+
   // Single iteration degrain blend (support both normal and overlap blending modes)
   MV_FORCEINLINE void DegrainBlendBlock_LC(
     BYTE* pDst, BYTE* pDstLsb, int iDstPitch,
@@ -289,6 +346,14 @@ private:
     int iBlkNum, int ibx, int iby, int xx, int xx_uv
   );
 
+  // Degrain blend added straight into the overlap buffers with _degrainoverlaps_yuv_ptr
+  MV_FORCEINLINE void DegrainOverlapsBlock_LC(
+    uint16_t* pDstOvr, uint16_t* pDstOvrUV1, uint16_t* pDstOvrUV2, int iDstOvrPitch,
+    short* winOver, short* winOverUV,
+    const BYTE* pSrc, const BYTE* pSrcUV1, const BYTE* pSrcUV2,
+    int iBlkNum, int ibx, int iby, int xx, int xx_uv
+  );
+
 
   // multi-pass blending luma and chroma planes
   MV_FORCEINLINE void MGR_LC(
@@ -339,6 +404,14 @@ private:
     int bx_src, int by_src,
     int ref_idx, int dx_ref, int dy_ref);
 
+  // n positions dx_ref[], dy_ref[] of the same ref in one call
+  MV_FORCEINLINE void GetSADBatch(
+    BYTE* pSrc, int iSrcPitch,
+    BYTE* pSrcUV1, int iSrcPitchUV1,
+    BYTE* pSrcUV2, int iSrcPitchUV2,
+    int bx_src, int by_src,
+    int ref_idx, const int* dx_ref, const int* dy_ref, int n, sad_t* pSAD);
+
   DisMetric* DM_Luma;
   DisMetric* DM_Chroma;
 
@@ -414,12 +487,28 @@ private:
   int TTH_thUPD;
   int TTH_BAS;
   bool TTH_chroma;
+  bool TTH_DMcache; // frame pair dismetrics reused from the previous frames, see MEL_LC
   BlockArea** BA_Yarr;
   BlockArea** BA_UV1arr;
   BlockArea** BA_UV2arr;
 
   DM_cache** DM_cache_arr;
   int iFrameNumRequested;
+
+  // Pipelined fetch: while frame n is processed, a job on the AVS+ thread
+  // pool gets the upstream frames of n + 1 with the environment of its own
+  // worker thread. Only enabled for sequential requests, and waited for
+  // before GetFrame returns so the upstream filters are never called
+  // concurrently by this instance.
+  void fetch_frames(FrameSet &fs, int n, bool refs_flag, ::IScriptEnvironment *env_ptr);
+  void prefetch_start(int n, ::IScriptEnvironment *env_ptr);
+  void prefetch_wait();
+  static AVSValue prefetch_job(::IScriptEnvironment2 *env_ptr, void *data_ptr);
+
+  bool _prefetch_flag;
+  int _prefetch_last_n;
+  FrameSet _prefetch_fs;
+  ::IJobCompletion *_prefetch_completion_ptr;
   MV_FORCEINLINE int abs_frame_offset(int index);
 
   uint8_t* pMELmemY;
@@ -501,7 +590,6 @@ private:
   int iMEL_non_zero_blocks;
   int iMEL_mem_hits;
   int iMEL_mem_updates;
-  int iDM_cache_hits;
 #endif
 
   MV_FORCEINLINE void CopyBlock(uint8_t* pDst, int iDstPitch, uint8_t* pSrc, int iBlkWidth, int iBlkHeight);
@@ -530,6 +618,8 @@ private:
   std::unique_ptr <OverlapWindows> _overwins;
   std::unique_ptr <OverlapWindows> _overwins_uv;
 
+  std::unique_ptr <MVProfiler> _prof_uptr; // 0 if profiling is not enabled
+
   OverlapsFunction *_oversluma_ptr;
   OverlapsFunction *_overschroma_ptr;
   OverlapsFunction *_oversluma16_ptr;
@@ -540,6 +630,7 @@ private:
   OverlapsLsbFunction *_overschroma_lsb_ptr;
   DenoiseNFunction *_degrainluma_ptr;
   DenoiseNFunction *_degrainchroma_ptr;
+  DegrainNOverlapsYUVFunction *_degrainoverlaps_yuv_ptr; // nullptr if the single pass YUV overlap proc needs the degrained blocks
 
   LimitFunction_t *LimitFunction;
 
@@ -0,0 +1,258 @@
+// Make a motion compensate temporal denoiser
+// Copyright(c)2006 A.G.Balakhnin aka Fizick
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#if defined (__GNUC__) && ! defined (__INTEL_COMPILER) && ! defined(__INTEL_LLVM_COMPILER)
+#include <x86intrin.h>
+// x86intrin.h includes header files for whatever instruction
+// sets are specified on the compiler command line, such as: xopintrin.h, fma4intrin.h
+#else
+#include <immintrin.h> // MS version of immintrin.h covers AVX, AVX2 and FMA3
+#endif // __GNUC__
+
+#include "MVDegrain3.h"
+#include "MDegrainN_avx2.h"
+
+#include <stdint.h>
+#include <type_traits>
+#include "def.h"
+
+// Weights: Wall[0] source, Wall[k * 2 + 1] pRef[k * 2], Wall[k * 2 + 2] pRef[k * 2 + 1], sum 256.
+// 8 bit: 16 bit sums like DegrainN_sse2, 255 * 256 + 128 fits.
+// 10-16 bit: the refs are madd-ed in pairs like in DegrainN_16_sse41. Real 16 bit samples are made
+// signed first, the sum of the weights being 256 the offset is added back before the shift.
+
+// n = 4, 8 or 16 pixels as 16 bit samples
+template<typename pixel_t, bool lessThan16bits, int n>
+static MV_FORCEINLINE __m128i load_samples(const BYTE* p)
+{
+  __m128i v;
+  if constexpr (sizeof(pixel_t) == 1)
+  {
+    if constexpr (n == 8)
+      v = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)p));
+    else
+      v = _mm_cvtepu8_epi16(_mm_cvtsi32_si128(*(const int*)p));
+  }
+  else
+  {
+    if constexpr (n == 8)
+      v = _mm_loadu_si128((const __m128i*)p);
+    else
+      v = _mm_loadl_epi64((const __m128i*)p);
+  }
+  if constexpr (!lessThan16bits)
+    v = _mm_add_epi16(v, _mm_set1_epi16(-32768));
+  return v;
+}
+
+// 16 degrained 8 bit pixels as 16 bit
+static MV_FORCEINLINE __m256i degrain16_8bit(const BYTE* pSrc, const BYTE* pRef[], const int Wall[], int trad, int x)
+{
+  __m256i val = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(pSrc + x))), _mm256_set1_epi16(Wall[0])), _mm256_set1_epi16(128));
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m256i s1 = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(pRef[k * 2] + x))), _mm256_set1_epi16(Wall[k * 2 + 1]));
+    const __m256i s2 = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(pRef[k * 2 + 1] + x))), _mm256_set1_epi16(Wall[k * 2 + 2]));
+    val = _mm256_add_epi16(val, s1);
+    val = _mm256_add_epi16(val, s2);
+  }
+  return _mm256_srli_epi16(val, DEGRAIN_WEIGHT_BITS);
+}
+
+// 8 or 4 degrained 8 bit pixels as 16 bit
+template<int n>
+static MV_FORCEINLINE __m128i degrain8_8bit(const BYTE* pSrc, const BYTE* pRef[], const int Wall[], int trad, int x)
+{
+  __m128i val = _mm_add_epi16(_mm_mullo_epi16(load_samples<uint8_t, true, n>(pSrc + x), _mm_set1_epi16(Wall[0])), _mm_set1_epi16(128));
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m128i s1 = _mm_mullo_epi16(load_samples<uint8_t, true, n>(pRef[k * 2] + x), _mm_set1_epi16(Wall[k * 2 + 1]));
+    const __m128i s2 = _mm_mullo_epi16(load_samples<uint8_t, true, n>(pRef[k * 2 + 1] + x), _mm_set1_epi16(Wall[k * 2 + 2]));
+    val = _mm_add_epi16(val, s1);
+    val = _mm_add_epi16(val, s2);
+  }
+  return _mm_srli_epi16(val, DEGRAIN_WEIGHT_BITS);
+}
+
+template<bool lessThan16bits>
+static MV_FORCEINLINE int degrain_rounder()
+{
+  return (1 << (DEGRAIN_WEIGHT_BITS - 1)) + (lessThan16bits ? 0 : (32768 << DEGRAIN_WEIGHT_BITS));
+}
+
+// 8 degrained 10-16 bit pixels as 32 bit
+template<bool lessThan16bits>
+static MV_FORCEINLINE __m256i degrain8_16bit(const BYTE* pSrc, const BYTE* pRef[], const int Wall[], int trad, int offs)
+{
+  __m256i res = _mm256_madd_epi16(_mm256_cvtepu16_epi32(load_samples<uint16_t, lessThan16bits, 8>(pSrc + offs)), _mm256_set1_epi32(Wall[0]));
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m128i b = load_samples<uint16_t, lessThan16bits, 8>(pRef[k * 2] + offs);
+    const __m128i f = load_samples<uint16_t, lessThan16bits, 8>(pRef[k * 2 + 1] + offs);
+    const __m256i bf = _mm256_set_m128i(_mm_unpackhi_epi16(b, f), _mm_unpacklo_epi16(b, f));
+    res = _mm256_add_epi32(res, _mm256_madd_epi16(bf, _mm256_set1_epi32((Wall[k * 2 + 2] << 16) + Wall[k * 2 + 1])));
+  }
+  res = _mm256_add_epi32(res, _mm256_set1_epi32(degrain_rounder<lessThan16bits>()));
+  return _mm256_srai_epi32(res, DEGRAIN_WEIGHT_BITS);
+}
+
+// 4 degrained 10-16 bit pixels as 32 bit
+template<bool lessThan16bits>
+static MV_FORCEINLINE __m128i degrain4_16bit(const BYTE* pSrc, const BYTE* pRef[], const int Wall[], int trad, int offs)
+{
+  __m128i res = _mm_madd_epi16(_mm_cvtepu16_epi32(load_samples<uint16_t, lessThan16bits, 4>(pSrc + offs)), _mm_set1_epi32(Wall[0]));
+  for (int k = 0; k < trad; ++k)
+  {
+    const __m128i b = load_samples<uint16_t, lessThan16bits, 4>(pRef[k * 2] + offs);
+    const __m128i f = load_samples<uint16_t, lessThan16bits, 4>(pRef[k * 2 + 1] + offs);
+    res = _mm_add_epi32(res, _mm_madd_epi16(_mm_unpacklo_epi16(b, f), _mm_set1_epi32((Wall[k * 2 + 2] << 16) + Wall[k * 2 + 1])));
+  }
+  res = _mm_add_epi32(res, _mm_set1_epi32(degrain_rounder<lessThan16bits>()));
+  return _mm_srai_epi32(res, DEGRAIN_WEIGHT_BITS);
+}
+
+// Overlaps_C 8 bit: (val * win + 32) >> 6 == mulhrs(val << 7, win << 2), val <= 255, win <= 2048
+
+// Degrain and overlap of one plane block. Moves pRef like the DegrainN functions.
+template<typename pixel_t, bool lessThan16bits, int blockWidth, int blockHeight>
+static MV_FORCEINLINE void DegrainN_Overlaps_avx2(
+  uint16_t* pDst0, int nDstPitch,
+  const BYTE* pSrc, int nSrcPitch,
+  const BYTE* pRef[], int Pitch[],
+  int Wall[], int trad,
+  short* pWin)
+{
+  typedef typename std::conditional < sizeof(pixel_t) == 1, short, int>::type target_t;
+  target_t* pDst = reinterpret_cast<target_t*>(pDst0);
+
+  for (int h = 0; h < blockHeight; ++h)
+  {
+    int x = 0;
+    if constexpr (sizeof(pixel_t) == 1)
+    {
+      for (; x + 16 <= blockWidth; x += 16)
+      {
+        const __m256i val = degrain16_8bit(pSrc, pRef, Wall, trad, x);
+        const __m256i win = _mm256_loadu_si256((const __m256i*)(pWin + x));
+        const __m256i ovr = _mm256_mulhrs_epi16(_mm256_slli_epi16(val, 7), _mm256_slli_epi16(win, 2));
+        _mm256_storeu_si256((__m256i*)(pDst + x), _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(pDst + x)), ovr));
+      }
+      if constexpr ((blockWidth & 15) >= 8)
+      {
+        const __m128i val = degrain8_8bit<8>(pSrc, pRef, Wall, trad, x);
+        const __m128i win = _mm_loadu_si128((const __m128i*)(pWin + x));
+        const __m128i ovr = _mm_mulhrs_epi16(_mm_slli_epi16(val, 7), _mm_slli_epi16(win, 2));
+        _mm_storeu_si128((__m128i*)(pDst + x), _mm_add_epi16(_mm_loadu_si128((const __m128i*)(pDst + x)), ovr));
+        x += 8;
+      }
+      if constexpr ((blockWidth & 7) >= 4)
+      {
+        const __m128i val = degrain8_8bit<4>(pSrc, pRef, Wall, trad, x);
+        const __m128i win = _mm_loadl_epi64((const __m128i*)(pWin + x));
+        const __m128i ovr = _mm_mulhrs_epi16(_mm_slli_epi16(val, 7), _mm_slli_epi16(win, 2));
+        _mm_storel_epi64((__m128i*)(pDst + x), _mm_add_epi16(_mm_loadl_epi64((const __m128i*)(pDst + x)), ovr));
+        x += 4;
+      }
+    }
+    else
+    {
+      for (; x + 8 <= blockWidth; x += 8)
+      {
+        const __m256i val = degrain8_16bit<lessThan16bits>(pSrc, pRef, Wall, trad, x * sizeof(uint16_t));
+        const __m256i win = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(pWin + x)));
+        _mm256_storeu_si256((__m256i*)(pDst + x), _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(pDst + x)), _mm256_mullo_epi32(val, win)));
+      }
+      if constexpr ((blockWidth & 7) >= 4)
+      {
+        const __m128i val = degrain4_16bit<lessThan16bits>(pSrc, pRef, Wall, trad, x * sizeof(uint16_t));
+        const __m128i win = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(pWin + x)));
+        _mm_storeu_si128((__m128i*)(pDst + x), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(pDst + x)), _mm_mullo_epi32(val, win)));
+        x += 4;
+      }
+    }
+
+    for (; x < blockWidth; ++x)
+    {
+      int val = reinterpret_cast<const pixel_t*>(pSrc)[x] * Wall[0] + (1 << (DEGRAIN_WEIGHT_BITS - 1));
+      for (int k = 0; k < trad; ++k)
+      {
+        val += reinterpret_cast<const pixel_t*>(pRef[k * 2])[x] * Wall[k * 2 + 1]
+          + reinterpret_cast<const pixel_t*>(pRef[k * 2 + 1])[x] * Wall[k * 2 + 2];
+      }
+      const int pix = (pixel_t)(val >> DEGRAIN_WEIGHT_BITS);
+      if constexpr (sizeof(pixel_t) == 1)
+        pDst[x] = pDst[x] + ((pix * pWin[x] + (1 << 5)) >> 6);
+      else
+        pDst[x] = pDst[x] + pix * pWin[x];
+    }
+
+    pDst += nDstPitch;
+    pSrc += nSrcPitch;
+    pWin += blockWidth;
+    for (int k = 0; k < trad; ++k)
+    {
+      pRef[k * 2] += Pitch[k * 2];
+      pRef[k * 2 + 1] += Pitch[k * 2 + 1];
+    }
+  }
+}
+
+template<int blockWidth, int blockHeight, int nLogxRatioUV, int nLogyRatioUV, typename pixel_t, bool lessThan16bits>
+void DegrainN_Overlaps_YUV_avx2(
+  uint16_t* pDst, uint16_t* pDstUV1, uint16_t* pDstUV2, int nDstPitch,
+  const BYTE* pSrc, int nSrcPitch, const BYTE* pSrcUV1, int nSrcPitchUV1, const BYTE* pSrcUV2, int nSrcPitchUV2,
+  const BYTE* pRef[], int Pitch[], const BYTE* pRefUV1[], int PitchUV1[], const BYTE* pRefUV2[], int PitchUV2[],
+  int Wall[], int WallUV[], int trad,
+  short* pWin, short* pWinUV)
+{
+  constexpr int blockWidthUV = blockWidth >> nLogxRatioUV;
+  constexpr int blockHeightUV = blockHeight >> nLogyRatioUV;
+
+  DegrainN_Overlaps_avx2<pixel_t, lessThan16bits, blockWidth, blockHeight>(pDst, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad, pWin);
+  DegrainN_Overlaps_avx2<pixel_t, lessThan16bits, blockWidthUV, blockHeightUV>(pDstUV1, nDstPitch, pSrcUV1, nSrcPitchUV1, pRefUV1, PitchUV1, WallUV, trad, pWinUV);
+  DegrainN_Overlaps_avx2<pixel_t, lessThan16bits, blockWidthUV, blockHeightUV>(pDstUV2, nDstPitch, pSrcUV2, nSrcPitchUV2, pRefUV2, PitchUV2, WallUV, trad, pWinUV);
+
+  _mm256_zeroupper();
+}
+
+// instantiate
+#define MAKE_FN_SS(x, y, xs, ys) \
+template void DegrainN_Overlaps_YUV_avx2<x, y, xs, ys, uint8_t, true>(uint16_t*, uint16_t*, uint16_t*, int, const BYTE*, int, const BYTE*, int, const BYTE*, int, const BYTE* pRef[], int Pitch[], const BYTE* pRefUV1[], int PitchUV1[], const BYTE* pRefUV2[], int PitchUV2[], int Wall[], int WallUV[], int, short*, short*); \
+template void DegrainN_Overlaps_YUV_avx2<x, y, xs, ys, uint16_t, true>(uint16_t*, uint16_t*, uint16_t*, int, const BYTE*, int, const BYTE*, int, const BYTE*, int, const BYTE* pRef[], int Pitch[], const BYTE* pRefUV1[], int PitchUV1[], const BYTE* pRefUV2[], int PitchUV2[], int Wall[], int WallUV[], int, short*, short*); \
+template void DegrainN_Overlaps_YUV_avx2<x, y, xs, ys, uint16_t, false>(uint16_t*, uint16_t*, uint16_t*, int, const BYTE*, int, const BYTE*, int, const BYTE*, int, const BYTE* pRef[], int Pitch[], const BYTE* pRefUV1[], int PitchUV1[], const BYTE* pRefUV2[], int PitchUV2[], int Wall[], int WallUV[], int, short*, short*);
+
+// 4:2:0, 4:2:2, 4:4:4
+#define MAKE_FN(x, y) \
+MAKE_FN_SS(x, y, 1, 1) \
+MAKE_FN_SS(x, y, 1, 0) \
+MAKE_FN_SS(x, y, 0, 0)
+
+// the very same list of get_degrainN_overlaps_yuv_function
+MAKE_FN(64, 64)
+MAKE_FN(64, 32)
+MAKE_FN(48, 48)
+MAKE_FN(32, 32)
+MAKE_FN(32, 16)
+MAKE_FN(24, 24)
+MAKE_FN(16, 16)
+MAKE_FN(16, 8)
+MAKE_FN(12, 12)
+MAKE_FN(8, 8)
+#undef MAKE_FN
+#undef MAKE_FN_SS
@@ -0,0 +1,40 @@
+// Fused MDegrainN kernels: degrain of the Y, U and V blocks of a block position
+// added straight into the overlap accumulators
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __MDEGRAINN_AVX2__
+#define __MDEGRAINN_AVX2__
+
+#include "types.h"
+#include <stdint.h>
+
+// Same results as DegrainN_C followed by Overlaps_C for each plane, without the temporary blocks.
+// The ref pointers are moved, like in the DegrainN functions.
+// pixel_t uint8_t: pDst is the short overlap buffer, uint16_t: int buffer (pitch in elements).
+// The chroma blocks are blockWidth >> nLogxRatioUV x blockHeight >> nLogyRatioUV,
+// both chroma planes use WallUV and pWinUV.
+template<int blockWidth, int blockHeight, int nLogxRatioUV, int nLogyRatioUV, typename pixel_t, bool lessThan16bits>
+void DegrainN_Overlaps_YUV_avx2(
+  uint16_t* pDst, uint16_t* pDstUV1, uint16_t* pDstUV2, int nDstPitch,
+  const BYTE* pSrc, int nSrcPitch, const BYTE* pSrcUV1, int nSrcPitchUV1, const BYTE* pSrcUV2, int nSrcPitchUV2,
+  const BYTE* pRef[], int Pitch[], const BYTE* pRefUV1[], int PitchUV1[], const BYTE* pRefUV2[], int PitchUV2[],
+  int Wall[], int WallUV[], int trad,
+  short* pWin, short* pWinUV);
+
+#endif
@@ -0,0 +1,149 @@
+/*****************************************************************************
+
+        MLoadVectors.cpp
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+  #pragma warning (1 : 4130 4223 4705 4706)
+  #pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"ClipFnc.h"
+#include	"MLoadVectors.h"
+
+#include	<algorithm>
+#include	<string>
+
+#include	<cassert>
+#include	<cstring>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+MLoadVectors::MLoadVectors (const char *filename_0, ::IScriptEnvironment *env)
+:	vi ()
+,	_mad ()
+,	_reader ()
+{
+  assert (filename_0 != 0);
+
+  if (filename_0 [0] == '\0')
+  {
+    env->ThrowError ("MLoadVectors: a vector file name is required.");
+  }
+
+  std::string		err_msg;
+  if (! _reader.open (filename_0, err_msg))
+  {
+    env->ThrowError ("MLoadVectors: %s: %s.", filename_0, err_msg.c_str ());
+  }
+
+  const MVVectorStore::Header &	header = _reader.get_header ();
+  _mad = header.mad;
+
+  memset (&vi, 0, sizeof (vi));
+  vi.num_frames = header.nbr_frames;
+  vi.image_type = header.image_type;
+  vi.SetFPS (header.fps_num, header.fps_den);
+  ClipFnc::format_vector_clip (
+    vi, true, _mad.nBlkX, "rgb32", header.frame_size, "MLoadVectors", env
+  );
+
+  CHECK_COMPILE_TIME (SizeOfIntPtr, (sizeof (int) <= sizeof (void *)));
+#if !defined(MV_64BIT)
+  vi.nchannels = reinterpret_cast <uintptr_t> (&_mad);
+#else
+  // hack!
+  uintptr_t p = reinterpret_cast <uintptr_t> (&_mad);
+  vi.nchannels = 0x80000000L | (int)(p >> 32);
+  vi.sample_type = (int)(p & 0xffffffffUL);
+#endif
+}
+
+
+
+// Frames are copied straight from the file mapping, nothing is decoded.
+// The copy can't be avoided: a PVideoFrame can only be allocated by the
+// environment, it cannot wrap the mapped memory.
+::PVideoFrame __stdcall	MLoadVectors::GetFrame (int n, ::IScriptEnvironment *env_ptr)
+{
+  assert (env_ptr != 0);
+
+  n = std::max (std::min (n, vi.num_frames - 1), 0);
+
+  const uint8_t *	src_ptr = _reader.use_frame (n);
+  if (src_ptr == 0)
+  {
+    env_ptr->ThrowError (
+      "MLoadVectors: frame %d is missing in the vector file.", n
+    );
+  }
+
+  ::PVideoFrame	dst_ptr = env_ptr->NewVideoFrame (vi);
+  uint8_t *		dst_data_ptr = dst_ptr->GetWritePtr ();
+  const int		dst_pitch    = dst_ptr->GetPitch ();
+  const int		row_size     = dst_ptr->GetRowSize ();
+  int				remaining    = _reader.get_header ().frame_size;
+  assert (vi.height == 1 || dst_pitch == row_size);
+  while (remaining > 0)
+  {
+    const int		len = std::min (remaining, row_size);
+    memcpy (dst_data_ptr, src_ptr, len);
+    src_ptr      += len;
+    dst_data_ptr += dst_pitch;
+    remaining    -= len;
+  }
+
+  return (dst_ptr);
+}
+
+
+
+bool __stdcall	MLoadVectors::GetParity (int n)
+{
+  return (vi.IsFieldBased () ? (n & 1) != 0 : false);
+}
+
+
+
+void __stdcall	MLoadVectors::GetAudio (void * /*buf*/, int64_t /*start*/, int64_t /*count*/, ::IScriptEnvironment * /*env_ptr*/)
+{
+  // No audio, nchannels is hacked
+}
+
+
+
+const ::VideoInfo & __stdcall	MLoadVectors::GetVideoInfo ()
+{
+  return (vi);
+}
+
+
+
+int __stdcall	MLoadVectors::SetCacheHints (int cachehints, int /*frame_range*/)
+{
+  // The mapping is read-only
+  return (cachehints == CACHE_GET_MTMODE ? MT_NICE_FILTER : 0);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
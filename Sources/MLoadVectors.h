@@ -0,0 +1,94 @@
+/*****************************************************************************
+
+        MLoadVectors.h
+
+Source filter serving the vector clip stored by MAnalyse (vectorfile) in a
+vector file. The output is the same as the MAnalyse clip which wrote it and
+can be used wherever this clip was, without recomputing the motion search.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MLoadVectors_HEADER_INCLUDED)
+#define	MLoadVectors_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+  #pragma once
+  #pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"def.h"
+#include "MVAnalysisData.h"
+#include "MVVectorStore.h"
+
+#include "avisynth.h"
+
+
+
+class MLoadVectors
+:	public ::IClip
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+  explicit			MLoadVectors (const char *filename_0, ::IScriptEnvironment *env);
+  virtual			~MLoadVectors () {}
+
+  // IClip
+  ::PVideoFrame __stdcall
+            GetFrame (int n, ::IScriptEnvironment *env_ptr) override;
+  bool __stdcall	GetParity (int n) override;
+  void __stdcall	GetAudio (void *buf, int64_t start, int64_t count, ::IScriptEnvironment *env_ptr) override;
+  const ::VideoInfo & __stdcall
+            GetVideoInfo () override;
+  int __stdcall	SetCacheHints (int cachehints, int frame_range) override;
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+  ::VideoInfo		vi;
+  MVAnalysisData	_mad;
+  MVVectorStoreReader
+            _reader;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+            MLoadVectors ();
+            MLoadVectors (const MLoadVectors &other);
+  MLoadVectors &	operator = (const MLoadVectors &other);
+  bool				operator == (const MLoadVectors &other) const;
+  bool				operator != (const MLoadVectors &other) const;
+
+};	// class MLoadVectors
+
+
+
+//#include	"MLoadVectors.hpp"
+
+
+
+#endif	// MLoadVectors_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -6,6 +6,7 @@
 
 #include "MScaleVect.h"
 #include "VECTOR.h"
+#include "MVSceneStats.h"
 #include <cmath>
 
 // Constructor - Copy motion vector information. Scale if required for use on different sized frame
@@ -27,6 +28,8 @@ MScaleVect::MScaleVect( PClip Child, double ScaleX, double ScaleY, ScaleMode Mod
 #endif
   if (mVectorsInfo.nMagicKey != MVAnalysisData::MOTION_MAGIC_KEY || mVectorsInfo.nVersion != MVAnalysisData::VERSION) 
     Env->ThrowError("MScaleVect: Clip does not contain motion vectors");
+  if ((mVectorsInfo.nFlags & MOTION_PACKED_VECTORS) != 0)
+    Env->ThrowError("MScaleVect: packed vector clips are not supported");
 #if !defined(MV_64BIT)
   vi.nchannels = reinterpret_cast <uintptr_t> (&mVectorsInfo);
 #else
@@ -168,6 +171,10 @@ PVideoFrame __stdcall MScaleVect::GetFrame( int FrameNum, IScriptEnvironment* En
   // Copy and fix header
   int headerSize = *pData;
   memcpy(pDst, pData, headerSize);
+  // SADs are rescaled below, drop the stored scene stats
+  MVSceneStats* stats_ptr = MVSceneStats::from_frame(reinterpret_cast<unsigned char*>(pDst));
+  if (stats_ptr != 0)
+    stats_ptr->invalidate();
 
   const MVAnalysisData &	hdr_src =
     *reinterpret_cast <const MVAnalysisData *> (pData + 1);
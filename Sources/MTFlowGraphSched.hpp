@@ -56,7 +56,8 @@ public:
 Name: constructor
 Input parameters:
 	- mt_flag: set it to false to disable multi-threading. If set to true, the
-		actual number of threads used will depend on the AVSTP settings.
+		actual number of threads used will depend on the AVSTP settings, or on
+		the built-in thread pool settings when avstp.dll is not available.
 Throws: an exception if AvstpWrapper cannot be accessed or constructed.
 ==============================================================================
 */
@@ -69,7 +70,7 @@ MTFlowGraphSched <T, GR, GD, MAXT>::MTFlowGraphSched (bool mt_flag)
 ,	_dep_graph_ptr (0)
 ,	_task_data_arr ()
 ,	_in_cnt_arr ()
-,	_mt_flag ()
+,	_mt_flag (mt_flag)
 {
 	// Nothing
 }
@@ -152,11 +153,10 @@ void	MTFlowGraphSched <T, GR, GD, MAXT>::start (const GR &dep_graph, GD &glob_da
 	_dep_graph_ptr = &dep_graph;
 
 	const int		last_node_index = _dep_graph_ptr->get_last_node ();
-	memset (	// Not very clean but should work correctly.
-		&_in_cnt_arr [0],
-		0,
-		sizeof (_in_cnt_arr [0]) * (last_node_index + 1)
-	);
+	for (int index = 0; index <= last_node_index; ++index)
+	{
+		_in_cnt_arr [index] = 0;
+	}
 
 	// Enqueues the root task
 	TaskData &		root = _task_data_arr [0];
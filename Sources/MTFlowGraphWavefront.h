@@ -0,0 +1,122 @@
+/*****************************************************************************
+
+        MTFlowGraphWavefront.h
+
+Dependency graph for MTFlowGraphSched, describing a wavefront over a grid of
+tiles. Tile (tx, ty) has index ty * nbr_tx + tx and depends on:
+- its left neighbour (tx - 1, ty),
+- its upper-right neighbour (tx + 1, ty - 1), or the upper one (tx, ty - 1)
+	on the last column.
+Transitively, all the tiles located above, above-left and left are complete
+when a tile starts, and no tile located below-right can have started yet.
+This matches the causal neighbourhood of a top-to-bottom, left-to-right scan.
+
+The graph is computed on the fly, its size is constant whatever the number
+of tiles.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTFlowGraphWavefront_HEADER_INCLUDED)
+#define	MTFlowGraphWavefront_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+class MTFlowGraphWavefront
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	typedef	MTFlowGraphWavefront	ThisType;
+
+	class Iterator
+	{
+	public:
+		inline 			Iterator (const ThisType &fg, int node);
+		inline void		next ();
+		inline bool		cont () const;
+		inline int		get_index () const;
+	private:
+		inline void		skip_invalid ();
+		const ThisType &
+							_fg;
+		int				_tx;
+		int				_ty;
+		int				_pos;
+	};
+
+	inline			MTFlowGraphWavefront ();
+	virtual			~MTFlowGraphWavefront () {}
+
+	inline void		set_grid (int nbr_tx, int nbr_ty);
+	inline int		get_nbr_tx () const;
+	inline int		get_nbr_ty () const;
+
+	inline int		get_last_node () const;
+	inline int		get_nbr_in (int task_index) const;
+	inline Iterator
+						get_out_node_it (int task_index) const;
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	int				_nbr_tx;
+	int				_nbr_ty;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						MTFlowGraphWavefront (const MTFlowGraphWavefront &other) = delete;
+						MTFlowGraphWavefront (MTFlowGraphWavefront &&other)      = delete;
+	MTFlowGraphWavefront &
+						operator = (const MTFlowGraphWavefront &other)        = delete;
+	MTFlowGraphWavefront &
+						operator = (MTFlowGraphWavefront &&other)             = delete;
+	bool				operator == (const MTFlowGraphWavefront &other) const = delete;
+	bool				operator != (const MTFlowGraphWavefront &other) const = delete;
+
+};	// class MTFlowGraphWavefront
+
+
+
+#include	"MTFlowGraphWavefront.hpp"
+
+
+
+#endif	// MTFlowGraphWavefront_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
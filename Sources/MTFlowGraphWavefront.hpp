@@ -0,0 +1,223 @@
+/*****************************************************************************
+
+        MTFlowGraphWavefront.hpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTFlowGraphWavefront_CODEHEADER_INCLUDED)
+#define	MTFlowGraphWavefront_CODEHEADER_INCLUDED
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*
+==============================================================================
+Name: ctor
+Description:
+	Creates a graph with a single tile, the root.
+Throws: Nothing
+==============================================================================
+*/
+
+MTFlowGraphWavefront::MTFlowGraphWavefront ()
+:	_nbr_tx (1)
+,	_nbr_ty (1)
+{
+	// Nothing
+}
+
+
+
+/*
+==============================================================================
+Name: set_grid
+Description:
+	Sets the grid size. The root task (index 0) is the top-left tile.
+Input parameters:
+	- nbr_tx: Number of tile columns, > 0.
+	- nbr_ty: Number of tile rows, > 0.
+Throws: Nothing
+==============================================================================
+*/
+
+void	MTFlowGraphWavefront::set_grid (int nbr_tx, int nbr_ty)
+{
+	assert (nbr_tx > 0);
+	assert (nbr_ty > 0);
+
+	_nbr_tx = nbr_tx;
+	_nbr_ty = nbr_ty;
+}
+
+
+
+int	MTFlowGraphWavefront::get_nbr_tx () const
+{
+	return (_nbr_tx);
+}
+
+
+
+int	MTFlowGraphWavefront::get_nbr_ty () const
+{
+	return (_nbr_ty);
+}
+
+
+
+int	MTFlowGraphWavefront::get_last_node () const
+{
+	return (_nbr_tx * _nbr_ty - 1);
+}
+
+
+
+/*
+==============================================================================
+Name: get_nbr_in
+Description:
+	Gives the number of dependencies of a tile: one for the left neighbour and
+	one for the upper row, when they exist.
+Input parameters:
+	- task_index: Index of the desired tile, >= 0.
+Returns: The number of direct preceding tasks, range [0 ; 2].
+Throws: Nothing
+==============================================================================
+*/
+
+int	MTFlowGraphWavefront::get_nbr_in (int task_index) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= get_last_node ());
+
+	const int		tx = task_index % _nbr_tx;
+	const int		ty = task_index / _nbr_tx;
+
+	return ((tx > 0 ? 1 : 0) + (ty > 0 ? 1 : 0));
+}
+
+
+
+/*
+==============================================================================
+Name: get_out_node_it
+Description:
+	Returns an iterator on the tiles depending on the provided one: the right
+	neighbour and the lower-left neighbour (or the lower one on the last
+	column).
+Input parameters:
+	- task_index: index of the tile.
+Returns:
+	The iterator, pointing on the first element (or terminated if the tile
+	has no dependent tile).
+Throws: Nothing.
+==============================================================================
+*/
+
+MTFlowGraphWavefront::Iterator	MTFlowGraphWavefront::get_out_node_it (int task_index) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= get_last_node ());
+
+	return (Iterator (*this, task_index));
+}
+
+
+
+MTFlowGraphWavefront::Iterator::Iterator (const ThisType &fg, int node)
+:	_fg (fg)
+,	_tx (node % fg._nbr_tx)
+,	_ty (node / fg._nbr_tx)
+,	_pos (0)
+{
+	skip_invalid ();
+}
+
+
+
+void	MTFlowGraphWavefront::Iterator::next ()
+{
+	assert (cont ());
+
+	++ _pos;
+	skip_invalid ();
+}
+
+
+
+bool	MTFlowGraphWavefront::Iterator::cont () const
+{
+	return (_pos < 3);
+}
+
+
+
+int	MTFlowGraphWavefront::Iterator::get_index () const
+{
+	assert (cont ());
+
+	const int		nbr_tx = _fg._nbr_tx;
+	switch (_pos)
+	{
+	case 0:	// Right
+		return (_ty * nbr_tx + _tx + 1);
+	case 1:	// Lower-left
+		return ((_ty + 1) * nbr_tx + _tx - 1);
+	default:	// Lower, from the last column
+		return ((_ty + 1) * nbr_tx + _tx);
+	}
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+void	MTFlowGraphWavefront::Iterator::skip_invalid ()
+{
+	const int		nbr_tx = _fg._nbr_tx;
+	const bool		last_row = (_ty + 1 >= _fg._nbr_ty);
+	for ( ; _pos < 3; ++ _pos)
+	{
+		const bool		ok_flag =
+			  (_pos == 0) ? (_tx + 1 < nbr_tx)
+			: (_pos == 1) ? (! last_row && _tx > 0)
+			:               (! last_row && _tx == nbr_tx - 1);
+		if (ok_flag)
+		{
+			break;
+		}
+	}
+}
+
+
+
+#endif	// MTFlowGraphWavefront_CODEHEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
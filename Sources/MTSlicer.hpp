@@ -57,7 +57,8 @@ public:
 Name: constructor
 Input parameters:
 	- mt_flag: set it to false to disable multi-threading. If set to true, the
-		actual number of threads used will depend on the AVSTP settings.
+		actual number of threads used will depend on the AVSTP settings, or on
+		the built-in thread pool settings when avstp.dll is not available.
 Throws: an exception if AvstpWrapper cannot be accessed or constructed.
 ==============================================================================
 */
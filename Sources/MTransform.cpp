@@ -14,6 +14,7 @@
 /*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
 
 #include	"MTransform.h"
+#include	"MVSceneStats.h"
 #include	<cassert>
 #include  <algorithm>
 
@@ -53,6 +54,10 @@ MTransform::MTransform(PClip clip, int _mode, IScriptEnvironment *env)
   {
     env->ThrowError("MTransform: invalid vector stream.");
   }
+  if ((mad.GetFlags() & MOTION_PACKED_VECTORS) != 0)
+  {
+    env->ThrowError("MTransform: packed vector clips are not supported.");
+  }
 
   // copy pointer to class for the first MV clip and init analysis data 
     mVectorsInfo = mad;
@@ -117,6 +122,10 @@ MTransform::MTransform(PClip clip, int _mode, IScriptEnvironment *env)
   // Copy and fix header
   int headerSize = *pData;
   memcpy(pDst, pData, headerSize);
+  // the transformed vectors are checked again, the scene stats of the source do not apply
+  MVSceneStats* stats_ptr = MVSceneStats::from_frame(reinterpret_cast<unsigned char*>(pDst));
+  if (stats_ptr != 0)
+    stats_ptr->invalidate();
 
   const MVAnalysisData& hdr_src =
     *reinterpret_cast <const MVAnalysisData*> (pData + 1);
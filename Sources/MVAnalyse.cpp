@@ -28,6 +28,8 @@
 #include "DCTINT.h"
 #include "MVAnalyse.h"
 #include "MVGroupOfFrames.h"
+#include "MVPackedVectors.h"
+#include "MVSceneStats.h"
 #include "MVSuper.h"
 #include "profile.h"
 #include "SuperParams64Bits.h"
@@ -53,8 +55,8 @@ MVAnalyse::MVAnalyse(
   int _iSearchDirMode, int _DMFlags,
   int _AreaMode, int _AMDiffSAD, int _AMstep, int _AMoffset, int _AMpel, int _PTpel,
   int _AMflags, int _AMavg, int _AMpt, int _AMst, int _AMsp,
-  int _TMavg, int _MDp, int _ScanDir, int _MPM,
-  IScriptEnvironment* env
+  int _TMavg, int _MDp, int _ScanDir, int _MPM, const char* _vectorfilename,
+  bool batch_flag, bool derive_flag, int packed_mode, bool tile_flag, IScriptEnvironment* env
 )
   : ::GenericVideoFilter(_child)
   , _srd_arr(1)
@@ -62,6 +64,9 @@ MVAnalyse::MVAnalyse(
   , _multi_flag(multi_flag)
   , _temporal_flag(temporal_flag)
   , _mt_flag(mt_flag)
+  , _batch_flag(batch_flag && multi_flag)
+  , _derive_flag(derive_flag && multi_flag && _iSearchDirMode == 0 && _optSearchOption != 5 && _optSearchOption != 6)
+  , _packed_mode(packed_mode)
   , _dct_factory_ptr()
   , _dct_pool()
   , _delta_max(0)
@@ -86,6 +91,12 @@ MVAnalyse::MVAnalyse(
   , iMDp(_MDp)
   , iScanDir(_ScanDir)
   , iMPM(_MPM)
+  , _batch_nsrc(-1)
+  , _batch_arr()
+  , _bwd_nsrc_arr()
+  , _bwd_arr()
+  , _src_gof_n(-1)
+  , _src_gof_frame()
 {
   has_at_least_v8 = true;
   try { env->CheckVersion(8); }
@@ -212,14 +223,16 @@ MVAnalyse::MVAnalyse(
 
   const bool bPelRefine = (nSuperParam & 1); // LSB of free param member
 
-  if (!bPelRefine && (optSearchOption == 6) && (iUseSubShift == 0) && (nSuperPel > 1))
+  // No refined planes in the super clip (MSuper pelrefine=false): the sub-pel
+  // candidates of the finest level are interpolated on demand. Only the
+  // searches reading the blocks through GetDM() can do it, the multi-block
+  // ones (optSearchOption 3 and 4) read the planes directly.
+  if (!bPelRefine && (optSearchOption != 5) && (iUseSubShift == 0) && (nSuperPel > 1))
   {
-    env->ThrowError("MAnalyse: optSearchOption=6 require UseSubShift=1 if no refined planes in super clip");
-  }
-
-  if ( !bPelRefine && (optSearchOption != 5) && (iUseSubShift == 0) && (nSuperPel > 1))
-  {
-    env->ThrowError("MAnalyse: super clip do not have refined planes for pel > 1 and not compatible set of options used");
+    if (optSearchOption <= 1 || optSearchOption == 6)
+      iUseSubShift = 2;
+    else
+      env->ThrowError("MAnalyse: super clip do not have refined planes for pel > 1 and not compatible set of options used");
   }
 
   analysisData.nWidth = vi.width - nSuperHPad * 2;
@@ -296,12 +309,12 @@ MVAnalyse::MVAnalyse(
     pSrcGOF = new MVGroupOfFrames(
       nSuperLevels, analysisData.nWidth, analysisData.nHeight,
       nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV,
-      _cpuFlags, analysisData.xRatioUV, analysisData.yRatioUV, pixelsize, bits_per_pixel, mt_flag
+      _cpuFlags, analysisData.xRatioUV, analysisData.yRatioUV, pixelsize, bits_per_pixel, mt_flag, bPelRefine
     );
     pRefGOF = new MVGroupOfFrames(
       nSuperLevels, analysisData.nWidth, analysisData.nHeight,
       nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV,
-      _cpuFlags, analysisData.xRatioUV, analysisData.yRatioUV, pixelsize, bits_per_pixel, mt_flag
+      _cpuFlags, analysisData.xRatioUV, analysisData.yRatioUV, pixelsize, bits_per_pixel, mt_flag, bPelRefine
     );
   }
 /*  else - need to find why system going unstable in init pel=1 with pel=4 processing
@@ -390,8 +403,8 @@ MVAnalyse::MVAnalyse(
 
   divideExtra = _divide;
 
-  // include itself, but usually equal to 256 :-)
-  headerSize = std::max(int(4 + sizeof(analysisData)), 256);
+  // include itself and the scene stats
+  headerSize = std::max(MVSceneStats::get_header_size(), 256);
 
   analysisData.nOverlapX = _overlapx;
   analysisData.nOverlapY = _overlapy;
@@ -554,8 +567,18 @@ MVAnalyse::MVAnalyse(
   nPelSearch = (_pelSearch <= 0) ? analysisData.nPel : _pelSearch;
 
 
+  if (_packed_mode < 0 || _packed_mode > 2)
+  {
+    env->ThrowError("MAnalyse: packed must be 0, 1 or 2");
+  }
+  if (_packed_mode == 2 && _derive_flag)
+  {
+    env->ThrowError("MAnalyse: packed=2 drops the coarse levels needed by derive");
+  }
+
   analysisData.nFlags = 0;
   analysisData.nFlags |= (_isse) ? MOTION_USE_ISSE : 0;
+  analysisData.nFlags |= (_packed_mode != 0) ? MOTION_PACKED_VECTORS : 0;
   analysisData.nFlags |= (analysisData.isBackward) ? MOTION_IS_BACKWARD : 0;
   analysisData.nFlags |= (chroma) ? MOTION_USE_CHROMA_MOTION : 0;
 
@@ -588,6 +611,7 @@ MVAnalyse::MVAnalyse(
     analysisData.bits_per_pixel,
     (_dct_factory_ptr.get() != 0) ? &_dct_pool : 0,
     _mt_flag,
+    tile_flag,
     analysisData.chromaSADScale,
     optSearchOption,
     scaleCSADfine,
@@ -601,6 +625,9 @@ MVAnalyse::MVAnalyse(
     env
   ));
 
+  _prof_uptr = MVProfiler::create("MAnalyse");
+  _vectorfields_aptr->set_profiler(_prof_uptr.get());
+
   analysisData.nMagicKey = MVAnalysisData::MOTION_MAGIC_KEY;
   analysisData.nHPadding = nSuperHPad; // v2.0
   analysisData.nVPadding = nSuperVPad;
@@ -632,7 +659,16 @@ MVAnalyse::MVAnalyse(
 
   // Defines the format of the output vector clip
   // count of 32 bit integers: 2_size_validity+(foreachblock(1_validity+blockCount*3))
-  const int		width_bytes = headerSize + _vectorfields_aptr->GetArraySize() * 4;
+  int				width_bytes = headerSize + _vectorfields_aptr->GetArraySize() * 4;
+  if (_packed_mode != 0)
+  {
+    // the level sizes are taken from the default vectors
+    std::vector <int>	def_arr(_vectorfields_aptr->GetArraySize());
+    _vectorfields_aptr->WriteDefaultToArray(&def_arr[0]);
+    width_bytes = headerSize + MVPackedVectors::get_packed_size(
+      &def_arr[0], analysisData.nLvCount + ((divideExtra) ? 1 : 0), _packed_mode == 2
+    ) * 4;
+  }
   ClipFnc::format_vector_clip(
     vi, true, nBlkX, "rgb32", width_bytes, "MAnalyse", env
   );
@@ -692,6 +728,12 @@ MVAnalyse::MVAnalyse(
 
     vi.num_frames *= _delta_max * 2;
     vi.MulDivFPS(_delta_max * 2, 1);
+
+    if (_derive_flag)
+    {
+      _bwd_nsrc_arr.assign((_delta_max + 1) * _delta_max, -1);
+      _bwd_arr.resize((_delta_max + 1) * _delta_max);
+    }
   }
 
   // we'll transmit to the processing filters a handle
@@ -718,6 +760,27 @@ MVAnalyse::MVAnalyse(
 #endif
   }
 
+  // Indexed vector file, served later by MLoadVectors
+  if (lstrlen(_vectorfilename) > 0)
+  {
+    MVVectorStore::Header header;
+    memset(&header, 0, sizeof(header));
+    header.nbr_frames = vi.num_frames;
+    header.nbr_deltas = (_multi_flag) ? _delta_max * 2 : 1;
+    header.frame_size = width_bytes;
+    header.image_type = vi.image_type;
+    header.fps_num = vi.fps_numerator;
+    header.fps_den = vi.fps_denominator;
+    header.mad = (divideExtra) ? _srd_arr[0]._analysis_data_divided : _srd_arr[0]._analysis_data;
+
+    _vstore_uptr.reset(new MVVectorStoreWriter);
+    std::string err_msg;
+    if (!_vstore_uptr->create(_vectorfilename, header, err_msg))
+    {
+      env->ThrowError("MAnalyse: vector file %s: %s.", _vectorfilename, err_msg.c_str());
+    }
+  }
+
 }
 
 
@@ -748,6 +811,39 @@ MVAnalyse::~MVAnalyse()
 PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 {
   _RPT2(0, "MAnalyze GetFrame, frame=%d id=%d\n", n, _instance_id);
+
+  if (!_batch_flag)
+  {
+    return compute_frame(n, env);
+  }
+
+  // Batched multi mode: the consumers (MDegrainN...) request all the deltas
+  // of a source frame in a row. They are searched at once, the source super
+  // frame is fetched and loaded in pSrcGOF only for the first one.
+  const int		ndiv = _delta_max * 2;
+  const int		nsrc = n / ndiv;
+  const int		srd_index = n % ndiv;
+
+  if (_batch_nsrc != nsrc)
+  {
+    _batch_nsrc = -1;
+    _batch_arr.resize(ndiv);
+    for (int k = 0; k < ndiv; ++k)
+    {
+      _batch_arr[k] = compute_frame(nsrc * ndiv + k, env);
+    }
+    _batch_nsrc = nsrc;
+  }
+
+  return _batch_arr[srd_index];
+}
+
+
+
+::PVideoFrame	MVAnalyse::compute_frame(int n, ::IScriptEnvironment* env)
+{
+  MVProfileScope prof_frame(_prof_uptr.get(), MVPROF_GETFRAME);
+
   const int		ndiv = (_multi_flag) ? _delta_max * 2 : 1;
   const int		nsrc = n / ndiv;
   const int		srd_index = n % ndiv;
@@ -803,6 +899,15 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
   }
   pDst += headerSize;
 
+  // packed output: the vectors are searched in the raw layout first
+  unsigned char * const	pDstData = pDst;
+  std::vector <int>	raw_arr;
+  if (_packed_mode != 0)
+  {
+    raw_arr.resize(_vectorfields_aptr->GetArraySize());
+    pDst = reinterpret_cast <unsigned char *> (&raw_arr[0]);
+  }
+
   if (nsrc < minframe || nsrc >= maxframe)
   {
     // fill all vectors with invalid data
@@ -814,22 +919,43 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 //		DebugPrintf ("MVAnalyse: Get src frame %d",nsrc);
     _RPT3(0, "MAnalyze GetFrame, frame_nsrc=%d nref=%d id=%d\n", nsrc, nref, _instance_id);
 
-//    PVideoFrame	src = child->GetFrame(nsrc, env); // v2.0
-    PVideoFrame	src;
+    // The result clip is a special MV clip. It does not need to inherit the frame props of source
 
-    if (child_cur == 0)
-      src = child->GetFrame(nsrc, env); // v2.0
-    else
-      src = child_cur->GetFrame(nsrc, env); // v2.7.46 - load different source super clip frame as current for search
-
-                                            // if(has_at_least_v8) env->copyFrameProps(src, dst); // frame property support
-    // The result clip is a special MV clip. It does not need to inherit the frame props of source
+    // Derived forward vectors: the backward vectors of the same frame pair
+    // (searched from nref) are needed first. They are searched again when
+    // they are not cached any more, so the result does not depend on the
+    // frame request order.
+    ::PVideoFrame	opp_frame;
+    if (_derive_flag && !srd._analysis_data.isBackward)
+    {
+      const int		delta_index = srd_index / 2;
+      const int		slot = (nref % (_delta_max + 1)) * _delta_max + delta_index;
+      if (_bwd_nsrc_arr[slot] != nref)
+      {
+        compute_frame(nref * ndiv + delta_index * 2, env);
+      }
+      opp_frame = _bwd_arr[slot];
+    }
 
     ::PVideoFrame	ref = child->GetFrame(nref, env); // v2.0
 
     if (iSearchDirMode == 0 || iSearchDirMode == 2) // standard current to ref search or first standard search of 2 searches
-    {
-      load_src_frame(*pSrcGOF, src, srd._analysis_data);
+    {
+      // Batch mode, successive deltas of the same source frame: pSrcGOF is
+      // already set
+      if (!_batch_flag || _src_gof_n != nsrc)
+      {
+        _src_gof_n = -1;
+        ::PVideoFrame	src = (child_cur == 0)
+          ? child->GetFrame(nsrc, env) // v2.0
+          : child_cur->GetFrame(nsrc, env); // v2.7.46 - load different source super clip frame as current for search
+        load_src_frame(*pSrcGOF, src, srd._analysis_data);
+        if (_batch_flag)
+        {
+          _src_gof_frame = src;
+          _src_gof_n = nsrc;
+        }
+      }
 
       //		DebugPrintf ("MVAnalyse: Get ref frame %d", nref);
       //		DebugPrintf ("MVAnalyse frame %i backward=%i", nsrc, srd._analysis_data.isBackward);
@@ -838,8 +964,11 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
     }
     else if (iSearchDirMode == 1) // reverse search from ref to current
     {
-      load_src_frame(*pSrcGOF, ref, srd._analysis_data);
+      ::PVideoFrame	src = (child_cur == 0) ? child->GetFrame(nsrc, env) : child_cur->GetFrame(nsrc, env);
+      load_src_frame(*pSrcGOF, ref, srd._analysis_data);
       load_src_frame(*pRefGOF, src, srd._analysis_data);
+      _src_gof_n = -1;
+      _src_gof_frame = 0;
     }
     else // error !
     {
@@ -1493,14 +1622,37 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 
     if (((optSearchOption != 5) /*|| (srd._analysis_data.nPel != 1) || (srd._analysis_data.nPel != 2)*/) /* && (optSearchOption != 6)*/ ) // optSearchOption=6 is now for onCPU SAD with DX12ME
     {
-      _vectorfields_aptr->SearchMVs(
-        pSrcGOF, pRefGOF,
-        searchType, nSearchParam, nPelSearch, nLambda, lsad, pnew, plevel,
-        global, srd._analysis_data.nFlags, reinterpret_cast<int*>(pDst),
-        outfilebuf, fieldShift, pzero, pglobal, badSAD, badrange,
-        meander, pVecPrevOrNull, tryMany, optPredictorType, iPTpel, iAMflags, iAMavg, iAMpt, AMsearchType, iAMsp,
-        iTMAvg, iMDp, iScanDir, iMPM
-      );
+      if (opp_frame)
+      {
+        const int *		pOpp = reinterpret_cast<const int*>(opp_frame->GetReadPtr() + headerSize);
+        std::vector <int>	opp_raw_arr;
+        if (_packed_mode != 0)
+        {
+          opp_raw_arr.resize(_vectorfields_aptr->GetArraySize());
+          MVPackedVectors::unpack(&opp_raw_arr[0], pOpp);
+          pOpp = &opp_raw_arr[0];
+        }
+        _vectorfields_aptr->SearchMVsDerived(
+          pSrcGOF, pRefGOF,
+          pOpp,
+          searchType, nPelSearch, nLambda, lsad, pnew, plevel,
+          global, srd._analysis_data.nFlags, reinterpret_cast<int*>(pDst),
+          outfilebuf, fieldShift, pzero, pglobal, badSAD, badrange,
+          meander, pVecPrevOrNull, optPredictorType, iPTpel, iAMflags, iAMavg, iAMpt, AMsearchType, iAMsp,
+          iTMAvg, iMDp, iScanDir, iMPM
+        );
+      }
+      else
+      {
+        _vectorfields_aptr->SearchMVs(
+          pSrcGOF, pRefGOF,
+          searchType, nSearchParam, nPelSearch, nLambda, lsad, pnew, plevel,
+          global, srd._analysis_data.nFlags, reinterpret_cast<int*>(pDst),
+          outfilebuf, fieldShift, pzero, pglobal, badSAD, badrange,
+          meander, pVecPrevOrNull, tryMany, optPredictorType, iPTpel, iAMflags, iAMavg, iAMpt, AMsearchType, iAMsp,
+          iTMAvg, iMDp, iScanDir, iMPM
+        );
+      }
     }
 
     // compare shader SAD with MAnalyse SAD
@@ -1561,7 +1713,6 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
       );
     }
 
-//		PROFILE_CUMULATE ();
     if (outfile != NULL)
     {
       fwrite(
@@ -1574,6 +1725,22 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
     }
   }
 
+  {
+    const MVAnalysisData &	ana_data =
+      (divideExtra) ? srd._analysis_data_divided : srd._analysis_data;
+    MVSceneStats::from_frame(pDstData - headerSize)->compute(
+      reinterpret_cast <const int *> (pDst),
+      ana_data.nLvCount, ana_data.nBlkX * ana_data.nBlkY
+    );
+    if (_packed_mode != 0)
+    {
+      MVPackedVectors::pack(
+        reinterpret_cast <int *> (pDstData), &raw_arr[0],
+        ana_data.nLvCount, _packed_mode == 2
+      );
+    }
+  }
+
   if (_temporal_flag)
   {
     // store previous vectors for use as predictor in next frame
@@ -1585,6 +1752,21 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
     srd._vec_prev_frame = nsrc;
   }
 
+  if (_vstore_uptr)
+  {
+    if (!_vstore_uptr->write_frame(n, dst->GetReadPtr(), dst->GetPitch(), dst->GetRowSize()))
+    {
+      env->ThrowError("MAnalyse: frame %d can not be written to the vector file!", n);
+    }
+  }
+
+  if (_derive_flag && srd._analysis_data.isBackward)
+  {
+    const int		slot = (nsrc % (_delta_max + 1)) * _delta_max + srd_index / 2;
+    _bwd_nsrc_arr[slot] = nsrc;
+    _bwd_arr[slot] = dst;
+  }
+
   _RPT3(0, "MAnalyze GetFrame END, frame_nsrc=%d nref=%d id=%d\n", nsrc, nref, _instance_id);
   return dst;
 }
@@ -1593,7 +1775,8 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 
 void	MVAnalyse::load_src_frame(MVGroupOfFrames &gof, ::PVideoFrame &src, const MVAnalysisData &ana_data)
 {
-  PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
+  MVProfileScope prof_load(_prof_uptr.get(), MVPROF_SUPER_LOAD);
+
   const unsigned char *	pSrcY;
   const unsigned char *	pSrcU;
   const unsigned char *	pSrcV;
@@ -1617,7 +1800,6 @@ void	MVAnalyse::load_src_frame(MVGroupOfFrames &gof, ::PVideoFrame &src, const M
     nSrcPitchY = src->GetPitch(PLANAR_Y);
     nSrcPitchUV = src->GetPitch(PLANAR_U);
   }
-  PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
 
   gof.Update(
     nModeYUV,
@@ -24,6 +24,8 @@
 #include "DCTFactory.h"
 #include "GroupOfPlanes.h"
 #include "MVAnalysisData.h"
+#include "MVVectorStore.h"
+#include "profile.h"
 #include "yuy2planes.h"
 
 #include "avisynth.h"
@@ -78,6 +80,9 @@ protected:
 
   SrcRefArray _srd_arr;
 
+  /*! \brief Stage profiler, 0 if not enabled. Shared with _vectorfields_aptr */
+  std::unique_ptr<MVProfiler> _prof_uptr;
+
   /*! \brief Frames of blocks for which motion vectors will be computed */
   std::unique_ptr<GroupOfPlanes> _vectorfields_aptr; // Temporary data, structure initialised once.
 
@@ -111,6 +116,9 @@ protected:
   const bool _multi_flag;
   const bool _temporal_flag;
   const bool _mt_flag;
+  const bool _batch_flag; // multi mode: all the deltas of a source frame are searched in one call
+  const bool _derive_flag; // multi mode: forward vectors derived from the backward ones of the same frame pair
+  const int _packed_mode; // 0: raw vector data, 1: MVPackedVectors, 2: MVPackedVectors, finest level only
   // 'opt' beginning until live during tests
   int optSearchOption; // DTL test
   int optPredictorType; // DTL test
@@ -127,6 +135,8 @@ protected:
   FILE *outfile;
   short * outfilebuf;
 
+  std::unique_ptr<MVVectorStoreWriter> _vstore_uptr; // vectorfile, 0 if not used
+
   //	YUY2Planes * SrcPlanes;
   //	YUY2Planes * RefPlanes;
 
@@ -158,6 +168,21 @@ protected:
   int iMDp;
   int iScanDir;
   int iMPM;
+
+  // Batched multi mode: vector frames of the last searched source frame,
+  // indexed like _srd_arr.
+  int _batch_nsrc;
+  std::vector<::PVideoFrame> _batch_arr;
+
+  // Derived forward vectors: backward vector frames of the last source
+  // frames, slot (nsrc % (_delta_max + 1)) * _delta_max + delta_index.
+  std::vector<int> _bwd_nsrc_arr;
+  std::vector<::PVideoFrame> _bwd_arr;
+
+  // Batch mode: super frame currently loaded as source in pSrcGOF, -1 if
+  // none. Kept referenced as long as pSrcGOF points to its data.
+  int _src_gof_n;
+  ::PVideoFrame _src_gof_frame;
 
 public:
 
@@ -173,20 +198,23 @@ public:
     int _iSearchDirMode, int _DMFlags,
     int _AreaMode, int _AMDiffSAD, int _AMstep, int _AMoffset, int _AMpel,
     int _PTpel, int _AMflags, int _AMavg, int _AMpt, int _AMst, int _AMsp,
-    int _TMavg, int _MDp, int _ScanDir, int _MPM,
-    IScriptEnvironment* env);
+    int _TMavg, int _MDp, int _ScanDir, int _MPM, const char* _vectorfilename,
+    bool batch_flag, bool derive_flag, int packed_mode, bool tile_flag, IScriptEnvironment* env);
   ~MVAnalyse();
 
   ::PVideoFrame __stdcall	GetFrame(int n, ::IScriptEnvironment* env) override;
 
   int __stdcall SetCacheHints(int cachehints, int frame_range) override {
-    return cachehints == CACHE_GET_MTMODE ? (_temporal_flag || lstrlen(outfilename)>0 ? MT_SERIALIZED : MT_MULTI_INSTANCE) : 0;
+    return cachehints == CACHE_GET_MTMODE ? (_temporal_flag || lstrlen(outfilename)>0 || _vstore_uptr || _batch_flag || _derive_flag ? MT_SERIALIZED : MT_MULTI_INSTANCE) : 0;
     // adaptive!
-    // temporal = true or using output file is not MT-friendly
+    // temporal = true or using output or vector file is not MT-friendly
+    // batch or derive = true: the frames cached by an instance would miss
+    // the requests sent to the other ones, and be searched again
   }
 
 private:
 
+  ::PVideoFrame compute_frame(int n, ::IScriptEnvironment* env);
   void load_src_frame(MVGroupOfFrames &gof, ::PVideoFrame &src, const MVAnalysisData &ana_data);
 
   PClip child_cur;
@@ -252,6 +252,8 @@ MVBlockFps::MVBlockFps(
       DstShortV = (uint16_t *)_aligned_malloc(dstShortPitchUV*nHeight * DestBufElementSize, tmpDstAlign);
     }
   }
+
+  _prof_uptr = MVProfiler::create("MBlockFps");
 }
 
 MVBlockFps::~MVBlockFps()
@@ -569,6 +571,13 @@ void MVBlockFps::ResultBlock(BYTE *pDst8, int dst_pitch, const BYTE * pMCB8, int
 
 PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 {
+  MVProfileScope prof_frame(_prof_uptr.get(), MVPROF_GETFRAME);
+  MVProfileScope prof_convert(_prof_uptr.get(), MVPROF_PLANAR_CONVERT, false);
+  MVProfileScope prof_comp(_prof_uptr.get(), MVPROF_COMPENSATION, false);
+  MVProfileScope prof_mask(_prof_uptr.get(), MVPROF_MASK, false);
+  MVProfileScope prof_resize(_prof_uptr.get(), MVPROF_RESIZE, false);
+  MVProfileScope prof_flow(_prof_uptr.get(), MVPROF_FLOW_INTER, false);
+
   int nWidth_B = nBlkX*(nBlkSizeX - nOverlapX) + nOverlapX;
   int nHeight_B = nBlkY*(nBlkSizeY - nOverlapY) + nOverlapY;
   int nHeightUV = nHeight / yRatioUVs[1];
@@ -633,7 +642,7 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
   if (mvClipB.IsUsable() && mvClipF.IsUsable())
   {
 
-    PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
+    prof_convert.start();
 
     if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2)
     {
@@ -690,7 +699,7 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
         nDstPitches[p] = dst->GetPitch(plane);
       }
     }
-    PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
+    prof_convert.stop();
 
     BYTE *pDstSave[3];
     pDstSave[0] = pDst[0];
@@ -715,14 +724,14 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
     MemZoneSet(MaskFullYB, 0, nWidthP, nHeightP, 0, 0, nPitchY); // put zeros
     MemZoneSet(MaskFullYF, 0, nWidthP, nHeightP, 0, 0, nPitchY);
 
-    PROFILE_START(MOTION_PROFILE_COMPENSATION);
+    prof_comp.start();
     int blocks = mvClipB.GetBlkCount();
 
     // int maxoffset = nPitchY*(nHeightP-nBlkSizeY)-nBlkSizeX; not used
 
     if (mode >= 3 && mode <= 8) {
 
-      PROFILE_START(MOTION_PROFILE_MASK);
+      prof_mask.start();
       if (mode <= 5)
         MakeVectorOcclusionMaskTime(mvClipF, nBlkX, nBlkY, ml, 1.0, nPel, smallMaskF, nBlkXP, time256, nBlkSizeX - nOverlapX, nBlkSizeY - nOverlapY);
       else // 6 to 8  // PF 161115 bits_per_pixel scale through dSADNormFactor
@@ -731,16 +740,16 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 
       CheckAndPadMaskSmall(smallMaskF, nBlkXP, nBlkYP, nBlkX, nBlkY);
 
-      PROFILE_STOP(MOTION_PROFILE_MASK);
+      prof_mask.stop();
 
-      PROFILE_START(MOTION_PROFILE_RESIZE);
+      prof_resize.start();
       // upsize (bilinear interpolate) vector masks to fullframe size
       upsizer->SimpleResizeDo_uint8(MaskFullYF, nWidthP, nHeightP, nPitchY, smallMaskF, nBlkXP, nBlkXP);
       if (!isGrey)
         upsizerUV->SimpleResizeDo_uint8(MaskFullUVF, nWidthPUV, nHeightPUV, nPitchUV, smallMaskF, nBlkXP, nBlkXP);
       // now we have forward fullframe blured occlusion mask in maskF arrays
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
-      PROFILE_START(MOTION_PROFILE_MASK);
+      prof_resize.stop();
+      prof_mask.start();
       if (mode <= 5)
         MakeVectorOcclusionMaskTime(mvClipB, nBlkX, nBlkY, ml, 1.0, nPel, smallMaskB, nBlkXP, (256 - time256), nBlkSizeX - nOverlapX, nBlkSizeY - nOverlapY);
       else // 6 to 8  // PF 161115 bits_per_pixel scale through dSADNormFactor
@@ -749,13 +758,13 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 
       CheckAndPadMaskSmall(smallMaskB, nBlkXP, nBlkYP, nBlkX, nBlkY);
 
-      PROFILE_STOP(MOTION_PROFILE_MASK);
-      PROFILE_START(MOTION_PROFILE_RESIZE);
+      prof_mask.stop();
+      prof_resize.start();
       // upsize (bilinear interpolate) vector masks to fullframe size
       upsizer->SimpleResizeDo_uint8(MaskFullYB, nWidthP, nHeightP, nPitchY, smallMaskB, nBlkXP, nBlkXP);
       if (!isGrey)
         upsizerUV->SimpleResizeDo_uint8(MaskFullUVB, nWidthPUV, nHeightPUV, nPitchUV, smallMaskB, nBlkXP, nBlkXP);
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
+      prof_resize.stop();
     }
     if (mode == 4 || mode == 5 || mode == 7 || mode == 8)
     {
@@ -1191,15 +1200,15 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
         }
       }
     }
-    PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
+    prof_comp.stop();
 
-    PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
+    prof_convert.start();
     if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
     {
       YUY2FromPlanes(pDstYUY2, nDstPitchYUY2, nWidth, nHeight,
         pDstSave[0], nDstPitches[0], pDstSave[1], pDstSave[2], nDstPitches[1], cpuFlags);
     }
-    PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
+    prof_convert.stop();
 
     return dst;
   }
@@ -1212,7 +1221,7 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
     if (blend) //let's blend src with ref frames like ConvertFPS
     {
       PVideoFrame ref = child->GetFrame(nright, env);
-      PROFILE_START(MOTION_PROFILE_FLOWINTER);
+      prof_flow.start();
       if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2)
       {
         pSrc[0] = src->GetReadPtr(); // we can blend YUY2
@@ -1266,7 +1275,7 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
           }
         }
       }
-      PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
+      prof_flow.stop();
 
       return dst;
     }
@@ -4,10 +4,13 @@
 #include "CopyCode.h"
 #include "MVClip.h"
 #include "MVFilter.h"
+#include "profile.h"
 #include "SimpleResize.h"
 #include "yuy2planes.h"
 #include "overlap.h"
 
+#include <memory>
+
 class MVGroupOfFrames;
 
 /*! \brief Filter that change fps by blocks moving
@@ -35,6 +38,8 @@ private:
 
   int64_t fa, fb;
 
+  std::unique_ptr <MVProfiler> _prof_uptr; // 0 if profiling is not enabled
+
   int nSuperModeYUV;
 
   BYTE *MaskFullYB; // shifted (projected) images planes
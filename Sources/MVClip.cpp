@@ -18,6 +18,8 @@
 // http://www.gnu.org/copyleft/gpl.html .
 
 #include "MVClip.h"
+#include "MVPackedVectors.h"
+#include "MVSceneStats.h"
 
 #include <cassert>
 #include <algorithm>
@@ -212,12 +214,31 @@ void MVClip::Update (PVideoFrame &fn, IScriptEnvironment *env)
   {
     env->ThrowError("MVTools: incompatible version of vector stream");
   }
+  const bool		packed_flag =
+    (reinterpret_cast <const MVAnalysisData *> (pMv + 1)->GetFlags () & MOTION_PACKED_VECTORS) != 0;
 
   // 17.05.22 filling from motion vector clip
   const int		hs_i32 = header_size / sizeof(int);
   pMv       += hs_i32;									// go to data - v1.8.1
   data_size -= hs_i32;
-  const bool		ok_flag = FakeGroupOfPlanes::Update(pMv, data_size);	// fixed a bug with lost frames
+  if (packed_flag)
+  {
+    const int		raw_size = MVPackedVectors::get_raw_size (pMv, data_size);
+    if (raw_size < 0)
+    {
+      env->ThrowError("MVTools: vector clip is too small (corrupted?)");
+    }
+    if (int (_unpack_arr.size ()) < raw_size)
+    {
+      _unpack_arr.resize (raw_size);
+    }
+    MVPackedVectors::unpack (&_unpack_arr [0], pMv);
+    pMv       = &_unpack_arr [0];
+    data_size = raw_size;
+  }
+  _vector_frame = fn;
+  const MVSceneStats *	stats_ptr = MVSceneStats::from_frame (fn->GetReadPtr ());
+  const bool		ok_flag = FakeGroupOfPlanes::Update(pMv, data_size, stats_ptr);	// fixed a bug with lost frames
   if (! ok_flag)
   {
     env->ThrowError("MVTools: vector clip is too small (corrupted?)");
@@ -25,6 +25,8 @@
 #include "FakePlaneOfBlocks.h"
 #include "MVAnalysisData.h"
 
+#include <vector>
+
 
 
 class MVClip
@@ -52,6 +54,8 @@ class MVClip
   int				_group_len;
   int				_group_ofs;
   bool				_frame_update_flag;
+  ::PVideoFrame	_vector_frame;	// keeps the vectors read in place (bMVsArrayOnly) and the scene stats
+  std::vector <int>	_unpack_arr;	// raw vector data of a packed vector frame (MOTION_PACKED_VECTORS)
 
 public :
   MVClip(const PClip &vectors, sad_t nSCD1, int nSCD2, IScriptEnvironment *env, int group_len, int group_ofs, bool bMVsArrayOnly = false);
@@ -82,6 +86,8 @@ public :
    bool IsSceneChange() const { return FakeGroupOfPlanes::IsSceneChange(nSCD1, nSCD2); }
 
    const VECTOR* GetpMVsArray(int nLevel) const { return GetPlane(nLevel).GetpMVsArray(); }
+   // private copy of the vectors of the current frame, to modify them
+   VECTOR* GetpMVsArrayWritable(int nLevel) { return GetPlane(nLevel).GetpMVsArrayWritable(); }
 };
 
 
@@ -253,6 +253,7 @@ MVCompensate::MVCompensate(
     }
   }
 
+  _prof_uptr = MVProfiler::create("MCompensate");
 }
 
 MVCompensate::~MVCompensate()
@@ -288,6 +289,8 @@ MVCompensate::~MVCompensate()
 
 PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
 {
+  MVProfileScope prof_frame(_prof_uptr.get(), MVPROF_GETFRAME);
+
   int nsrc;
   int nvec;
   int vindex;
@@ -436,7 +439,7 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
     */
     fieldShift = ClipFnc::compute_fieldshift(child, fields, nPel, nsrc, nref);
 
-    PROFILE_START(MOTION_PROFILE_COMPENSATION);
+    MVProfileScope prof_comp(_prof_uptr.get(), MVPROF_COMPENSATION);
 
     Slicer         slicer(_mt_flag); // prepare internal avstp multithreading
 
@@ -537,7 +540,7 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
         // BitBlt(pDst[1] + (nHeight_B>>nLogyRatioUV)*nDstPitches[1], nDstPitches[1], pSrcMapped[1] + nHPadding + ((nHeight_B + nVPadding)>>nLogyRatioUV) * pPitchesMapped[1], pPitchesMapped[1], nWidth>>nLogxRatioUV, (nHeight-nHeight_B)>>nLogyRatioUV, isse_flag);
     }
 
-    PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
+    prof_comp.stop();
 
     // if we're in in-loop recursive mode, we copy the frame
     if (recursion > 0)
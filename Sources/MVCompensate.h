@@ -7,11 +7,13 @@
 #include "MVClip.h"
 #include "MVFilter.h"
 #include "overlap.h"
+#include "profile.h"
 #include "SharedPtr.h"
 #include "yuy2planes.h"
 #include "info.h"
 #include "SADFunctions.h"
 
+#include	<memory>
 #include	<vector>
 
 
@@ -109,6 +111,9 @@ private:
 
   bool           _RNB; // 2.7.46 - residual noise bitrate calculate and display
 
+  std::unique_ptr <MVProfiler>
+                 _prof_uptr; // 0 if profiling is not enabled
+
   // Processing variables
   MVClip *       _mv_clip_ptr;  // Vector clip used to process this frame
   sad_t            _thsad;
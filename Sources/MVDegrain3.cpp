@@ -385,6 +385,10 @@ MVDegrainX::MVDegrainX(
   int nSuperPel = params.nPel;
   nSuperModeYUV = params.nModeYUV;
   int nSuperLevels = params.nLevels;
+  if (!(params.param & 1) && nSuperPel > 1)
+  {
+    env_ptr->ThrowError("MDegrain%d: super clip do not have refined planes for pel > 1, use MDegrainN with UseSubShift=1", level);
+  }
   for (int i = 0; i < level; i++) {
     pRefBGOF[i] = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUV_super, yRatioUV_super, pixelsize_super, bits_per_pixel_super, _mt_flag);
     pRefFGOF[i] = new MVGroupOfFrames(nSuperLevels, nWidth, nHeight, nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV, cpuFlags, xRatioUV_super, yRatioUV_super, pixelsize_super, bits_per_pixel_super, _mt_flag);
@@ -545,6 +549,12 @@ MVDegrainX::MVDegrainX(
     else if (vi.IsYV24())
       vi.pixel_type = VideoInfo::CS_YUV444P16;
   }
+
+  static const char * const prof_name_arr[MAX_DEGRAIN] =
+  {
+    "MDegrain1", "MDegrain2", "MDegrain3", "MDegrain4", "MDegrain5", "MDegrain6"
+  };
+  _prof_uptr = MVProfiler::create(prof_name_arr[level - 1]);
 }
 
 
@@ -586,6 +596,8 @@ static void plane_copy_8_to_16_c(uint8_t *dstp, int dstpitch, const uint8_t *src
 
 PVideoFrame __stdcall MVDegrainX::GetFrame(int n, IScriptEnvironment* env)
 {
+  MVProfileScope prof_frame(_prof_uptr.get(), MVPROF_GETFRAME);
+
   int nWidth_B = nBlkX*(nBlkSizeX - nOverlapX) + nOverlapX;
   int nHeight_B = nBlkY*(nBlkSizeY - nOverlapY) + nOverlapY;
 
@@ -765,6 +777,8 @@ PVideoFrame __stdcall MVDegrainX::GetFrame(int n, IScriptEnvironment* env)
   MVPlane *pPlanesB[3][MAX_DEGRAIN] = { 0 };
   MVPlane *pPlanesF[3][MAX_DEGRAIN] = { 0 };
 
+  MVProfileScope prof_load(_prof_uptr.get(), MVPROF_SUPER_LOAD);
+
   for (int j = level - 1; j >= 0; j--)
   {
     if (isUsableF[j])
@@ -793,7 +807,13 @@ PVideoFrame __stdcall MVDegrainX::GetFrame(int n, IScriptEnvironment* env)
     }
   }
 
-  PROFILE_START(MOTION_PROFILE_COMPENSATION);
+  prof_load.stop();
+
+  MVProfileScope prof_blend(
+    _prof_uptr.get(),
+    (nOverlapX > 0 || nOverlapY > 0) ? MVPROF_OVERLAP_BLEND : MVPROF_DEGRAIN_BLEND
+  );
+
   pDstCur[0] = pDst[0];
   pDstCur[1] = pDst[1];
   pDstCur[2] = pDst[2];
@@ -1130,6 +1150,7 @@ PVideoFrame __stdcall MVDegrainX::GetFrame(int n, IScriptEnvironment* env)
       else
         realLimit = nLimit / 255.0f;
 
+      MVProfileScope prof_limit(_prof_uptr.get(), MVPROF_NLIMIT);
       LimitFunction(pDst[0], nDstPitches[0], pSrc[0], nSrcPitches[0], nWidth, nHeight, realLimit);
     }
   }
@@ -1163,7 +1184,7 @@ PVideoFrame __stdcall MVDegrainX::GetFrame(int n, IScriptEnvironment* env)
   _mm_empty();	// (we may use double-float somewhere) Fizick
 #endif
 
-  PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
+  prof_blend.stop();
 
   if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
   {
@@ -1509,6 +1530,7 @@ void MVDegrainX::process_chroma(int plane_mask, BYTE *pDst, BYTE *pDstCur, int n
         realLimit = nLimitC * (1 << (bits_per_pixel_output - 8));
       else
         realLimit = nLimitC * (1 << (bits_per_pixel_output - 8));
+      MVProfileScope prof_limit(_prof_uptr.get(), MVPROF_NLIMIT);
       LimitFunction(pDst, nDstPitch, pSrc, nSrcPitch, nWidth >> nLogxRatioUV_super, nHeight >> nLogyRatioUV_super, realLimit);
     }
   }
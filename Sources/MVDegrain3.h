@@ -5,8 +5,10 @@
 #include "MVClip.h"
 #include "MVFilter.h"
 #include "overlap.h"
+#include "profile.h"
 #include "yuy2planes.h"
 #include <stdint.h>
+#include <memory>
 #include "def.h"
 #include	<emmintrin.h>
 #include	<smmintrin.h> // SSE4.1
@@ -101,6 +103,8 @@ private:
   const int level;
   int framenumber;
 
+  std::unique_ptr <MVProfiler> _prof_uptr; // 0 if profiling is not enabled
+
 public:
   MVDegrainX(PClip _child, PClip _super, 
     PClip _mvbw, PClip _mvfw, PClip _mvbw2, PClip _mvfw2, PClip _mvbw3, PClip _mvfw3, PClip _mvbw4, PClip _mvfw4, PClip _mvbw5, PClip _mvfw5, PClip _mvbw6, PClip _mvfw6,
@@ -0,0 +1,337 @@
+// Temporal filtering of motion vectors stored as structure of arrays
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "MVFilterSoA.h"
+#include "MVFilterSoA_avx2.h"
+#include <algorithm>
+#include <cstdlib>
+
+// Same results as the former per-block MDegrainN::ProcessMVLPF and the MDegrainN::MVMedF_* functions
+
+static void MVLPF_SoA_C(const MV_SOA& in, const MV_SOA& out, int nPos, const float* pKernel, int nBlocks)
+{
+  for (int pos = 0; pos < nPos; pos++)
+  {
+    for (int bx = 0; bx < nBlocks; bx++)
+    {
+      float fSumX = 0.0f;
+      float fSumY = 0.0f;
+      for (int kpos = 0; kpos < MVLPFKERNELSIZE; kpos++)
+      {
+        int src_pos = pos + kpos - MVLPFKERNELSIZE / 2;
+        if (src_pos < 0) src_pos = 0;
+        if (src_pos > nPos - 1) src_pos = nPos - 1;
+        fSumX += in.x[src_pos * in.pos_pitch + bx] * pKernel[kpos];
+        fSumY += in.y[src_pos * in.pos_pitch + bx] * pKernel[kpos];
+      }
+
+      out.x[pos * out.pos_pitch + bx] = (int)(fSumX);
+      out.y[pos * out.pos_pitch + bx] = (int)(fSumY);
+      out.sad[pos * out.pos_pitch + bx] = in.sad[pos * in.pos_pitch + bx];
+    }
+  }
+}
+
+// The windows of two consecutive positions share 2 * iRad samples: the median-like
+// filters keep per-sample statistics of the current window and update them with the
+// leaving and entering samples only, O(iWnd) per position instead of O(iWnd^2).
+// The integer sums wrap the same way as when summed again for each window.
+
+// positions without a full window
+static void MVMedF_SoA_Edges_C(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks)
+{
+  for (int pos = 0; pos < nPos; pos++)
+  {
+    if (pos >= iRad && pos < nPos - iRad)
+      continue;
+
+    for (int bx = 0; bx < nBlocks; bx++)
+    {
+      VECTOR v = GetSoAVECTOR(in, pos, bx);
+      if (bInvalidateEdges) v.sad = veryBigSAD;
+      SetSoAVECTOR(out, pos, bx, v);
+    }
+  }
+}
+
+static void MVMedF_xy_SoA_C(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks)
+{
+  const int iWnd = iRad * 2 + 1;
+  const int pitch = in.pos_pitch;
+
+  MVMedF_SoA_Edges_C(in, out, nPos, iRad, bInvalidateEdges, veryBigSAD, nBlocks);
+
+  // sums of the distances of each sample to all the samples of the current window
+  int sum_row_x[MAX_MVSOA_POS];
+  int sum_row_y[MAX_MVSOA_POS];
+
+  for (int bx = 0; bx < nBlocks; bx++)
+  {
+    const int* px = in.x + bx;
+    const int* py = in.y + bx;
+
+    for (int pos = iRad; pos < nPos - iRad; pos++)
+    {
+      const int first = pos - iRad;
+      const int last = pos + iRad;
+
+      if (pos == iRad) // first window
+      {
+        for (int dmt_row = 0; dmt_row < iWnd; dmt_row++)
+        {
+          sum_row_x[dmt_row] = 0;
+          sum_row_y[dmt_row] = 0;
+          for (int dmt_col = 0; dmt_col < iWnd; dmt_col++)
+          {
+            sum_row_x[dmt_row] += std::abs(px[dmt_row * pitch] - px[dmt_col * pitch]);
+            sum_row_y[dmt_row] += std::abs(py[dmt_row * pitch] - py[dmt_col * pitch]);
+          }
+        }
+      }
+      else // first - 1 leaves, last enters
+      {
+        const int x_old = px[(first - 1) * pitch];
+        const int y_old = py[(first - 1) * pitch];
+        const int x_new = px[last * pitch];
+        const int y_new = py[last * pitch];
+
+        sum_row_x[last] = 0;
+        sum_row_y[last] = 0;
+        for (int p = first; p < last; p++)
+        {
+          const int dx_new = std::abs(px[p * pitch] - x_new);
+          const int dy_new = std::abs(py[p * pitch] - y_new);
+          sum_row_x[p] += dx_new - std::abs(px[p * pitch] - x_old);
+          sum_row_y[p] += dy_new - std::abs(py[p * pitch] - y_old);
+          sum_row_x[last] += dx_new;
+          sum_row_y[last] += dy_new;
+        }
+      }
+
+      int sum_minrow_x = iMaxSum;
+      int sum_minrow_y = iMaxSum;
+      int i_idx_minrow_x = first;
+      int i_idx_minrow_y = first;
+
+      for (int p = first; p <= last; p++)
+      {
+        if (sum_row_x[p] < sum_minrow_x)
+        {
+          sum_minrow_x = sum_row_x[p];
+          i_idx_minrow_x = p;
+        }
+
+        if (sum_row_y[p] < sum_minrow_y)
+        {
+          sum_minrow_y = sum_row_y[p];
+          i_idx_minrow_y = p;
+        }
+      }
+
+      out.x[pos * out.pos_pitch + bx] = px[i_idx_minrow_x * pitch];
+      out.y[pos * out.pos_pitch + bx] = py[i_idx_minrow_y * pitch];
+      out.sad[pos * out.pos_pitch + bx] = in.sad[pos * pitch + bx]; // central
+    }
+  }
+}
+
+static void MVMedF_vl_SoA_C(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks)
+{
+  const int iWnd = iRad * 2 + 1;
+  const int pitch = in.pos_pitch;
+
+  MVMedF_SoA_Edges_C(in, out, nPos, iRad, bInvalidateEdges, veryBigSAD, nBlocks);
+
+  // sums of the squared difference vector lengths of each sample to all the samples of the current window
+  int sum_row[MAX_MVSOA_POS];
+
+  for (int bx = 0; bx < nBlocks; bx++)
+  {
+    const int* px = in.x + bx;
+    const int* py = in.y + bx;
+
+    for (int pos = iRad; pos < nPos - iRad; pos++)
+    {
+      const int first = pos - iRad;
+      const int last = pos + iRad;
+
+      if (pos == iRad) // first window
+      {
+        for (int dmt_row = 0; dmt_row < iWnd; dmt_row++)
+        {
+          sum_row[dmt_row] = 0;
+          for (int dmt_col = 0; dmt_col < iWnd; dmt_col++)
+          {
+            const int dx = px[dmt_row * pitch] - px[dmt_col * pitch];
+            const int dy = py[dmt_row * pitch] - py[dmt_col * pitch];
+            sum_row[dmt_row] += dx * dx + dy * dy;
+          }
+        }
+      }
+      else // first - 1 leaves, last enters
+      {
+        const int x_old = px[(first - 1) * pitch];
+        const int y_old = py[(first - 1) * pitch];
+        const int x_new = px[last * pitch];
+        const int y_new = py[last * pitch];
+
+        sum_row[last] = 0;
+        for (int p = first; p < last; p++)
+        {
+          const int dx_new = px[p * pitch] - x_new;
+          const int dy_new = py[p * pitch] - y_new;
+          const int dx_old = px[p * pitch] - x_old;
+          const int dy_old = py[p * pitch] - y_old;
+          const int d_new = dx_new * dx_new + dy_new * dy_new;
+          sum_row[p] += d_new - (dx_old * dx_old + dy_old * dy_old);
+          sum_row[last] += d_new;
+        }
+      }
+
+      int sum_minrow = iMaxSum;
+      int i_idx_minrow = first;
+
+      for (int p = first; p <= last; p++)
+      {
+        if (sum_row[p] < sum_minrow)
+        {
+          sum_minrow = sum_row[p];
+          i_idx_minrow = p;
+        }
+      }
+
+      SetSoAVECTOR(out, pos, bx, GetSoAVECTOR(in, i_idx_minrow, bx));
+    }
+  }
+}
+
+// replace v_old by v_new in the sorted v[n]
+static MV_FORCEINLINE void ReplaceSorted(int* v, int n, int v_old, int v_new)
+{
+  int i = (int)(std::lower_bound(v, v + n, v_old) - v);
+  while (i > 0 && v[i - 1] > v_new)
+  {
+    v[i] = v[i - 1];
+    i--;
+  }
+  while (i < n - 1 && v[i + 1] < v_new)
+  {
+    v[i] = v[i + 1];
+    i++;
+  }
+  v[i] = v_new;
+}
+
+static void MVMedF_IQM_SoA_C(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks)
+{
+  const int iWnd = iRad * 2 + 1;
+  const int pitch = in.pos_pitch;
+  const int qStart = (iWnd + 1) / 4;
+  const int qEnd = iWnd - ((iWnd + 1) / 4);
+  const int iBias = (qEnd - qStart) / 2;
+
+  MVMedF_SoA_Edges_C(in, out, nPos, iRad, bInvalidateEdges, veryBigSAD, nBlocks);
+
+  // sorted samples of the current window
+  int vX[MAX_MVSOA_POS];
+  int vY[MAX_MVSOA_POS];
+
+  for (int bx = 0; bx < nBlocks; bx++)
+  {
+    const int* px = in.x + bx;
+    const int* py = in.y + bx;
+
+    for (int pos = iRad; pos < nPos - iRad; pos++)
+    {
+      if (pos == iRad) // first window
+      {
+        for (int i = 0; i < iWnd; i++)
+        {
+          vX[i] = px[i * pitch];
+          vY[i] = py[i * pitch];
+        }
+
+        std::sort(vX, vX + iWnd);
+        std::sort(vY, vY + iWnd);
+      }
+      else // pos - iRad - 1 leaves, pos + iRad enters
+      {
+        ReplaceSorted(vX, iWnd, px[(pos - iRad - 1) * pitch], px[(pos + iRad) * pitch]);
+        ReplaceSorted(vY, iWnd, py[(pos - iRad - 1) * pitch], py[(pos + iRad) * pitch]);
+      }
+
+      if (iWnd < 4) // 3 possible ?
+      {
+        out.x[pos * out.pos_pitch + bx] = vX[1];
+        out.y[pos * out.pos_pitch + bx] = vY[1];
+      }
+      else
+      {
+        int iXmean = 0;
+        int iYmean = 0;
+        for (int i = qStart; i < qEnd; i++)
+        {
+          iXmean += vX[i];
+          iYmean += vY[i];
+        }
+
+        out.x[pos * out.pos_pitch + bx] = (iXmean + iBias) / (qEnd - qStart);
+        out.y[pos * out.pos_pitch + bx] = (iYmean + iBias) / (qEnd - qStart);
+      }
+
+      out.sad[pos * out.pos_pitch + bx] = 0;
+    }
+  }
+}
+
+static void MVAvg_C(VECTOR* pDst, const VECTOR* pSrc1, const VECTOR* pSrc2, int nBlocks)
+{
+  for (int bx = 0; bx < nBlocks; bx++)
+  {
+    pDst[bx].x = (pSrc1[bx].x + pSrc2[bx].x) / 2;
+    pDst[bx].y = (pSrc1[bx].y + pSrc2[bx].y) / 2;
+    pDst[bx].sad = (pSrc1[bx].sad + pSrc2[bx].sad) / 2;
+  }
+}
+
+MVLPFSoAFunction* get_mvlpf_soa_function(arch_t arch)
+{
+  if (arch >= USE_AVX2)
+    return MVLPF_SoA_avx2;
+  return MVLPF_SoA_C;
+}
+
+MVMedFSoAFunction* get_mvmedf_soa_function(int cm, arch_t arch)
+{
+  const bool bAVX2 = arch >= USE_AVX2;
+  switch (cm)
+  {
+  case 0: return bAVX2 ? MVMedF_xy_SoA_avx2 : MVMedF_xy_SoA_C;
+  case 1: return bAVX2 ? MVMedF_vl_SoA_avx2 : MVMedF_vl_SoA_C;
+  case 4: return bAVX2 ? MVMedF_IQM_SoA_avx2 : MVMedF_IQM_SoA_C;
+  default: return nullptr;
+  }
+}
+
+MVAvgFunction* get_mvavg_function(arch_t arch)
+{
+  if (arch >= USE_AVX2)
+    return MVAvg_avx2;
+  return MVAvg_C;
+}
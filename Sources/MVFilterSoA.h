@@ -0,0 +1,81 @@
+// Temporal filtering of motion vectors stored as structure of arrays
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __MV_FILTER_SOA__
+#define __MV_FILTER_SOA__
+
+#include "def.h"
+#include "types.h"
+#include "VECTOR.h"
+#include <stdint.h>
+
+#define MVLPFKERNELSIZE 11 // 10+1 odd number, 10 - just some medium number relative to typical tr and allow to have some variance in slope
+
+// MVs of a row of blocks at nPos temporal positions, as separate x, y and sad planes.
+// Position p of block bx is at [p * pos_pitch + bx]. The planes are 64-byte aligned
+// and pos_pitch is a multiple of MVSOA_ALIGN ints, so the SIMD versions process
+// whole block rows and may touch the padding blocks up to the next MVSOA_ALIGN.
+#define MVSOA_ALIGN 16
+#define MAX_MVSOA_POS (128 * 2 + 1) // 2 * MDegrainN::MAX_TEMP_RAD + 1
+
+struct MV_SOA
+{
+  int* x;
+  int* y;
+  sad_t* sad;
+  int pos_pitch;
+};
+
+MV_FORCEINLINE VECTOR GetSoAVECTOR(const MV_SOA& mvs, int pos, int bx)
+{
+  VECTOR v;
+  v.x = mvs.x[pos * mvs.pos_pitch + bx];
+  v.y = mvs.y[pos * mvs.pos_pitch + bx];
+  v.sad = mvs.sad[pos * mvs.pos_pitch + bx];
+  return v;
+}
+
+MV_FORCEINLINE void SetSoAVECTOR(const MV_SOA& mvs, int pos, int bx, const VECTOR& v)
+{
+  mvs.x[pos * mvs.pos_pitch + bx] = v.x;
+  mvs.y[pos * mvs.pos_pitch + bx] = v.y;
+  mvs.sad[pos * mvs.pos_pitch + bx] = v.sad;
+}
+
+// Lowpass of x and y with the MVLPFKERNELSIZE kernel, edge positions repeated. sad is copied.
+typedef void (MVLPFSoAFunction)(const MV_SOA& in, const MV_SOA& out, int nPos, const float* pKernel, int nBlocks);
+
+// Median-like filter over the 2 * iRad + 1 positions window.
+// The nPos - 2 * iRad positions without a full window are copied, with an
+// invalidated sad (veryBigSAD) if bInvalidateEdges.
+// iMaxSum: initial minimum of the row sums of the distance-based modes.
+typedef void (MVMedFSoAFunction)(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks);
+
+// Average of two rows of VECTORs, per component, rounded towards 0.
+typedef void (MVAvgFunction)(VECTOR* pDst, const VECTOR* pSrc1, const VECTOR* pSrc2, int nBlocks);
+
+MVLPFSoAFunction* get_mvlpf_soa_function(arch_t arch);
+
+// iMVMedF_cm modes: 0 - separated x,y, 1 - vector length, 4 - IQM.
+// nullptr for the other modes: they have no SoA version.
+MVMedFSoAFunction* get_mvmedf_soa_function(int cm, arch_t arch);
+
+MVAvgFunction* get_mvavg_function(arch_t arch);
+
+#endif
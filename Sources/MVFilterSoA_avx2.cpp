@@ -0,0 +1,390 @@
+#if defined (__GNUC__) && ! defined (__INTEL_COMPILER)
+#include <x86intrin.h>
+// x86intrin.h includes header files for whatever instruction
+// sets are specified on the compiler command line, such as: xopintrin.h, fma4intrin.h
+#else
+#include <immintrin.h> // MS version of immintrin.h covers AVX, AVX2 and FMA3
+#endif // __GNUC__
+
+#include "MVFilterSoA_avx2.h"
+
+#include <stdint.h>
+#include "def.h"
+
+// All the functions give the same results as the C versions of MVFilterSoA.cpp:
+// the float sums are evaluated in the same order, the integer sums wrap the same way.
+
+// positions without a full window
+static void MVMedF_SoA_Edges_avx2(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks)
+{
+  const __m256i big = _mm256_set1_epi32(veryBigSAD);
+  for (int pos = 0; pos < nPos; pos++)
+  {
+    if (pos >= iRad && pos < nPos - iRad)
+      continue;
+
+    for (int bx = 0; bx < nBlocks; bx += 8)
+    {
+      const __m256i x = _mm256_loadu_si256((const __m256i*)(in.x + pos * in.pos_pitch + bx));
+      const __m256i y = _mm256_loadu_si256((const __m256i*)(in.y + pos * in.pos_pitch + bx));
+      const __m256i sad = bInvalidateEdges ? big : _mm256_loadu_si256((const __m256i*)(in.sad + pos * in.pos_pitch + bx));
+      _mm256_storeu_si256((__m256i*)(out.x + pos * out.pos_pitch + bx), x);
+      _mm256_storeu_si256((__m256i*)(out.y + pos * out.pos_pitch + bx), y);
+      _mm256_storeu_si256((__m256i*)(out.sad + pos * out.pos_pitch + bx), sad);
+    }
+  }
+}
+
+void MVLPF_SoA_avx2(const MV_SOA& in, const MV_SOA& out, int nPos, const float* pKernel, int nBlocks)
+{
+  __m256 kernel[MVLPFKERNELSIZE];
+  for (int kpos = 0; kpos < MVLPFKERNELSIZE; kpos++)
+  {
+    kernel[kpos] = _mm256_set1_ps(pKernel[kpos]);
+  }
+
+  for (int pos = 0; pos < nPos; pos++)
+  {
+    int src_offset[MVLPFKERNELSIZE];
+    for (int kpos = 0; kpos < MVLPFKERNELSIZE; kpos++)
+    {
+      int src_pos = pos + kpos - MVLPFKERNELSIZE / 2;
+      if (src_pos < 0) src_pos = 0;
+      if (src_pos > nPos - 1) src_pos = nPos - 1;
+      src_offset[kpos] = src_pos * in.pos_pitch;
+    }
+
+    for (int bx = 0; bx < nBlocks; bx += 8)
+    {
+      __m256 sum_x = _mm256_setzero_ps();
+      __m256 sum_y = _mm256_setzero_ps();
+      for (int kpos = 0; kpos < MVLPFKERNELSIZE; kpos++)
+      {
+        const __m256 x = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(in.x + src_offset[kpos] + bx)));
+        const __m256 y = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(in.y + src_offset[kpos] + bx)));
+        sum_x = _mm256_add_ps(sum_x, _mm256_mul_ps(x, kernel[kpos]));
+        sum_y = _mm256_add_ps(sum_y, _mm256_mul_ps(y, kernel[kpos]));
+      }
+
+      _mm256_storeu_si256((__m256i*)(out.x + pos * out.pos_pitch + bx), _mm256_cvttps_epi32(sum_x));
+      _mm256_storeu_si256((__m256i*)(out.y + pos * out.pos_pitch + bx), _mm256_cvttps_epi32(sum_y));
+      _mm256_storeu_si256((__m256i*)(out.sad + pos * out.pos_pitch + bx),
+        _mm256_loadu_si256((const __m256i*)(in.sad + pos * in.pos_pitch + bx)));
+    }
+  }
+  _mm256_zeroupper();
+}
+
+// Median-like filters: incremental window statistics, see MVFilterSoA.cpp.
+// The statistics of 8 blocks are kept per sample position of the current window.
+
+void MVMedF_xy_SoA_avx2(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks)
+{
+  const int iWnd = iRad * 2 + 1;
+  const int pitch = in.pos_pitch;
+
+  MVMedF_SoA_Edges_avx2(in, out, nPos, iRad, bInvalidateEdges, veryBigSAD, nBlocks);
+
+  __m256i sum_row_x[MAX_MVSOA_POS];
+  __m256i sum_row_y[MAX_MVSOA_POS];
+
+  for (int bx = 0; bx < nBlocks; bx += 8)
+  {
+    const int* px = in.x + bx;
+    const int* py = in.y + bx;
+
+    for (int pos = iRad; pos < nPos - iRad; pos++)
+    {
+      const int first = pos - iRad;
+      const int last = pos + iRad;
+
+      if (pos == iRad) // first window
+      {
+        for (int dmt_row = 0; dmt_row < iWnd; dmt_row++)
+        {
+          const __m256i row_x = _mm256_loadu_si256((const __m256i*)(px + dmt_row * pitch));
+          const __m256i row_y = _mm256_loadu_si256((const __m256i*)(py + dmt_row * pitch));
+          __m256i sum_x = _mm256_setzero_si256();
+          __m256i sum_y = _mm256_setzero_si256();
+          for (int dmt_col = 0; dmt_col < iWnd; dmt_col++)
+          {
+            sum_x = _mm256_add_epi32(sum_x, _mm256_abs_epi32(_mm256_sub_epi32(row_x, _mm256_loadu_si256((const __m256i*)(px + dmt_col * pitch)))));
+            sum_y = _mm256_add_epi32(sum_y, _mm256_abs_epi32(_mm256_sub_epi32(row_y, _mm256_loadu_si256((const __m256i*)(py + dmt_col * pitch)))));
+          }
+          sum_row_x[dmt_row] = sum_x;
+          sum_row_y[dmt_row] = sum_y;
+        }
+      }
+      else // first - 1 leaves, last enters
+      {
+        const __m256i x_old = _mm256_loadu_si256((const __m256i*)(px + (first - 1) * pitch));
+        const __m256i y_old = _mm256_loadu_si256((const __m256i*)(py + (first - 1) * pitch));
+        const __m256i x_new = _mm256_loadu_si256((const __m256i*)(px + last * pitch));
+        const __m256i y_new = _mm256_loadu_si256((const __m256i*)(py + last * pitch));
+        __m256i sum_x_new = _mm256_setzero_si256();
+        __m256i sum_y_new = _mm256_setzero_si256();
+
+        for (int p = first; p < last; p++)
+        {
+          const __m256i x = _mm256_loadu_si256((const __m256i*)(px + p * pitch));
+          const __m256i y = _mm256_loadu_si256((const __m256i*)(py + p * pitch));
+          const __m256i dx_new = _mm256_abs_epi32(_mm256_sub_epi32(x, x_new));
+          const __m256i dy_new = _mm256_abs_epi32(_mm256_sub_epi32(y, y_new));
+          sum_row_x[p] = _mm256_sub_epi32(_mm256_add_epi32(sum_row_x[p], dx_new), _mm256_abs_epi32(_mm256_sub_epi32(x, x_old)));
+          sum_row_y[p] = _mm256_sub_epi32(_mm256_add_epi32(sum_row_y[p], dy_new), _mm256_abs_epi32(_mm256_sub_epi32(y, y_old)));
+          sum_x_new = _mm256_add_epi32(sum_x_new, dx_new);
+          sum_y_new = _mm256_add_epi32(sum_y_new, dy_new);
+        }
+        sum_row_x[last] = sum_x_new;
+        sum_row_y[last] = sum_y_new;
+      }
+
+      // the first sample is taken if no row sum is lower than iMaxSum
+      __m256i sum_min_x = _mm256_set1_epi32(iMaxSum);
+      __m256i sum_min_y = sum_min_x;
+      __m256i sel_x = _mm256_loadu_si256((const __m256i*)(px + first * pitch));
+      __m256i sel_y = _mm256_loadu_si256((const __m256i*)(py + first * pitch));
+
+      for (int p = first; p <= last; p++)
+      {
+        const __m256i lower_x = _mm256_cmpgt_epi32(sum_min_x, sum_row_x[p]);
+        const __m256i lower_y = _mm256_cmpgt_epi32(sum_min_y, sum_row_y[p]);
+        sum_min_x = _mm256_min_epi32(sum_min_x, sum_row_x[p]);
+        sum_min_y = _mm256_min_epi32(sum_min_y, sum_row_y[p]);
+        sel_x = _mm256_blendv_epi8(sel_x, _mm256_loadu_si256((const __m256i*)(px + p * pitch)), lower_x);
+        sel_y = _mm256_blendv_epi8(sel_y, _mm256_loadu_si256((const __m256i*)(py + p * pitch)), lower_y);
+      }
+
+      _mm256_storeu_si256((__m256i*)(out.x + pos * out.pos_pitch + bx), sel_x);
+      _mm256_storeu_si256((__m256i*)(out.y + pos * out.pos_pitch + bx), sel_y);
+      _mm256_storeu_si256((__m256i*)(out.sad + pos * out.pos_pitch + bx),
+        _mm256_loadu_si256((const __m256i*)(in.sad + pos * pitch + bx))); // central
+    }
+  }
+  _mm256_zeroupper();
+}
+
+static MV_FORCEINLINE __m256i sq_len_epi32(__m256i dx, __m256i dy)
+{
+  return _mm256_add_epi32(_mm256_mullo_epi32(dx, dx), _mm256_mullo_epi32(dy, dy));
+}
+
+void MVMedF_vl_SoA_avx2(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks)
+{
+  const int iWnd = iRad * 2 + 1;
+  const int pitch = in.pos_pitch;
+
+  MVMedF_SoA_Edges_avx2(in, out, nPos, iRad, bInvalidateEdges, veryBigSAD, nBlocks);
+
+  __m256i sum_row[MAX_MVSOA_POS];
+
+  for (int bx = 0; bx < nBlocks; bx += 8)
+  {
+    const int* px = in.x + bx;
+    const int* py = in.y + bx;
+    const sad_t* psad = in.sad + bx;
+
+    for (int pos = iRad; pos < nPos - iRad; pos++)
+    {
+      const int first = pos - iRad;
+      const int last = pos + iRad;
+
+      if (pos == iRad) // first window
+      {
+        for (int dmt_row = 0; dmt_row < iWnd; dmt_row++)
+        {
+          const __m256i row_x = _mm256_loadu_si256((const __m256i*)(px + dmt_row * pitch));
+          const __m256i row_y = _mm256_loadu_si256((const __m256i*)(py + dmt_row * pitch));
+          __m256i sum = _mm256_setzero_si256();
+          for (int dmt_col = 0; dmt_col < iWnd; dmt_col++)
+          {
+            const __m256i dx = _mm256_sub_epi32(row_x, _mm256_loadu_si256((const __m256i*)(px + dmt_col * pitch)));
+            const __m256i dy = _mm256_sub_epi32(row_y, _mm256_loadu_si256((const __m256i*)(py + dmt_col * pitch)));
+            sum = _mm256_add_epi32(sum, sq_len_epi32(dx, dy));
+          }
+          sum_row[dmt_row] = sum;
+        }
+      }
+      else // first - 1 leaves, last enters
+      {
+        const __m256i x_old = _mm256_loadu_si256((const __m256i*)(px + (first - 1) * pitch));
+        const __m256i y_old = _mm256_loadu_si256((const __m256i*)(py + (first - 1) * pitch));
+        const __m256i x_new = _mm256_loadu_si256((const __m256i*)(px + last * pitch));
+        const __m256i y_new = _mm256_loadu_si256((const __m256i*)(py + last * pitch));
+        __m256i sum_new = _mm256_setzero_si256();
+
+        for (int p = first; p < last; p++)
+        {
+          const __m256i x = _mm256_loadu_si256((const __m256i*)(px + p * pitch));
+          const __m256i y = _mm256_loadu_si256((const __m256i*)(py + p * pitch));
+          const __m256i d_new = sq_len_epi32(_mm256_sub_epi32(x, x_new), _mm256_sub_epi32(y, y_new));
+          const __m256i d_old = sq_len_epi32(_mm256_sub_epi32(x, x_old), _mm256_sub_epi32(y, y_old));
+          sum_row[p] = _mm256_sub_epi32(_mm256_add_epi32(sum_row[p], d_new), d_old);
+          sum_new = _mm256_add_epi32(sum_new, d_new);
+        }
+        sum_row[last] = sum_new;
+      }
+
+      __m256i sum_min = _mm256_set1_epi32(iMaxSum);
+      __m256i sel_x = _mm256_loadu_si256((const __m256i*)(px + first * pitch));
+      __m256i sel_y = _mm256_loadu_si256((const __m256i*)(py + first * pitch));
+      __m256i sel_sad = _mm256_loadu_si256((const __m256i*)(psad + first * pitch));
+
+      for (int p = first; p <= last; p++)
+      {
+        const __m256i lower = _mm256_cmpgt_epi32(sum_min, sum_row[p]);
+        sum_min = _mm256_min_epi32(sum_min, sum_row[p]);
+        sel_x = _mm256_blendv_epi8(sel_x, _mm256_loadu_si256((const __m256i*)(px + p * pitch)), lower);
+        sel_y = _mm256_blendv_epi8(sel_y, _mm256_loadu_si256((const __m256i*)(py + p * pitch)), lower);
+        sel_sad = _mm256_blendv_epi8(sel_sad, _mm256_loadu_si256((const __m256i*)(psad + p * pitch)), lower);
+      }
+
+      _mm256_storeu_si256((__m256i*)(out.x + pos * out.pos_pitch + bx), sel_x);
+      _mm256_storeu_si256((__m256i*)(out.y + pos * out.pos_pitch + bx), sel_y);
+      _mm256_storeu_si256((__m256i*)(out.sad + pos * out.pos_pitch + bx), sel_sad);
+    }
+  }
+  _mm256_zeroupper();
+}
+
+// truncated (a + bias) / n in 32-bit lanes, exact through double
+static MV_FORCEINLINE __m256i div_epi32(__m256i a, __m256d n)
+{
+  const __m128i lo = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(a)), n));
+  const __m128i hi = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(a, 1)), n));
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+// odd-even transposition sort of n vectors, each lane sorted on its own
+static MV_FORCEINLINE void sort_lanes(__m256i* v, int n)
+{
+  for (int pass = 0; pass < n; pass++)
+  {
+    for (int i = pass & 1; i + 1 < n; i += 2)
+    {
+      const __m256i lo = _mm256_min_epi32(v[i], v[i + 1]);
+      v[i + 1] = _mm256_max_epi32(v[i], v[i + 1]);
+      v[i] = lo;
+    }
+  }
+}
+
+// replace v_old by v_new in the lanes sorted v[n]: the first v_old of each lane
+// is overwritten, then one bubble pass up and one down move v_new to its place
+static MV_FORCEINLINE void replace_sorted_lanes(__m256i* v, int n, __m256i v_old, __m256i v_new)
+{
+  __m256i done = _mm256_setzero_si256();
+  for (int i = 0; i < n; i++)
+  {
+    const __m256i hit = _mm256_andnot_si256(done, _mm256_cmpeq_epi32(v[i], v_old));
+    v[i] = _mm256_blendv_epi8(v[i], v_new, hit);
+    done = _mm256_or_si256(done, hit);
+  }
+
+  for (int i = 0; i + 1 < n; i++)
+  {
+    const __m256i lo = _mm256_min_epi32(v[i], v[i + 1]);
+    v[i + 1] = _mm256_max_epi32(v[i], v[i + 1]);
+    v[i] = lo;
+  }
+
+  for (int i = n - 2; i >= 0; i--)
+  {
+    const __m256i lo = _mm256_min_epi32(v[i], v[i + 1]);
+    v[i + 1] = _mm256_max_epi32(v[i], v[i + 1]);
+    v[i] = lo;
+  }
+}
+
+void MVMedF_IQM_SoA_avx2(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks)
+{
+  const int iWnd = iRad * 2 + 1;
+  const int pitch = in.pos_pitch;
+  const int qStart = (iWnd + 1) / 4;
+  const int qEnd = iWnd - ((iWnd + 1) / 4);
+  const __m256i bias = _mm256_set1_epi32((qEnd - qStart) / 2);
+  const __m256d count = _mm256_set1_pd((double)(qEnd - qStart));
+
+  MVMedF_SoA_Edges_avx2(in, out, nPos, iRad, bInvalidateEdges, veryBigSAD, nBlocks);
+
+  // sorted samples of the current window
+  __m256i vX[MAX_MVSOA_POS];
+  __m256i vY[MAX_MVSOA_POS];
+
+  for (int bx = 0; bx < nBlocks; bx += 8)
+  {
+    const int* px = in.x + bx;
+    const int* py = in.y + bx;
+
+    for (int pos = iRad; pos < nPos - iRad; pos++)
+    {
+      if (pos == iRad) // first window
+      {
+        for (int i = 0; i < iWnd; i++)
+        {
+          vX[i] = _mm256_loadu_si256((const __m256i*)(px + i * pitch));
+          vY[i] = _mm256_loadu_si256((const __m256i*)(py + i * pitch));
+        }
+
+        sort_lanes(vX, iWnd);
+        sort_lanes(vY, iWnd);
+      }
+      else // pos - iRad - 1 leaves, pos + iRad enters
+      {
+        replace_sorted_lanes(vX, iWnd,
+          _mm256_loadu_si256((const __m256i*)(px + (pos - iRad - 1) * pitch)), _mm256_loadu_si256((const __m256i*)(px + (pos + iRad) * pitch)));
+        replace_sorted_lanes(vY, iWnd,
+          _mm256_loadu_si256((const __m256i*)(py + (pos - iRad - 1) * pitch)), _mm256_loadu_si256((const __m256i*)(py + (pos + iRad) * pitch)));
+      }
+
+      __m256i res_x, res_y;
+      if (iWnd < 4) // 3 possible ?
+      {
+        res_x = vX[1];
+        res_y = vY[1];
+      }
+      else
+      {
+        __m256i sum_x = _mm256_setzero_si256();
+        __m256i sum_y = _mm256_setzero_si256();
+        for (int i = qStart; i < qEnd; i++)
+        {
+          sum_x = _mm256_add_epi32(sum_x, vX[i]);
+          sum_y = _mm256_add_epi32(sum_y, vY[i]);
+        }
+        res_x = div_epi32(_mm256_add_epi32(sum_x, bias), count);
+        res_y = div_epi32(_mm256_add_epi32(sum_y, bias), count);
+      }
+
+      _mm256_storeu_si256((__m256i*)(out.x + pos * out.pos_pitch + bx), res_x);
+      _mm256_storeu_si256((__m256i*)(out.y + pos * out.pos_pitch + bx), res_y);
+      _mm256_storeu_si256((__m256i*)(out.sad + pos * out.pos_pitch + bx), _mm256_setzero_si256());
+    }
+  }
+  _mm256_zeroupper();
+}
+
+void MVAvg_avx2(VECTOR* pDst, const VECTOR* pSrc1, const VECTOR* pSrc2, int nBlocks)
+{
+  static_assert(sizeof(VECTOR) == 3 * sizeof(int), "VECTOR must be x, y, sad ints");
+
+  // x, y and sad are all averaged the same way: process the rows as plain ints
+  int* pd = reinterpret_cast<int*>(pDst);
+  const int* p1 = reinterpret_cast<const int*>(pSrc1);
+  const int* p2 = reinterpret_cast<const int*>(pSrc2);
+  const int n = nBlocks * 3;
+
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    const __m256i sum = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(p1 + i)), _mm256_loadu_si256((const __m256i*)(p2 + i)));
+    // sum / 2 rounded towards 0
+    const __m256i avg = _mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_srli_epi32(sum, 31)), 1);
+    _mm256_storeu_si256((__m256i*)(pd + i), avg);
+  }
+  for (; i < n; i++)
+  {
+    pd[i] = (p1[i] + p2[i]) / 2;
+  }
+  _mm256_zeroupper();
+}
@@ -0,0 +1,35 @@
+// AVX2 temporal filtering of motion vectors stored as structure of arrays,
+// 8 blocks of a row per vector
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __MV_FILTER_SOA_AVX2__
+#define __MV_FILTER_SOA_AVX2__
+
+#include "MVFilterSoA.h"
+
+void MVLPF_SoA_avx2(const MV_SOA& in, const MV_SOA& out, int nPos, const float* pKernel, int nBlocks);
+
+void MVMedF_xy_SoA_avx2(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks);
+void MVMedF_vl_SoA_avx2(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks);
+void MVMedF_IQM_SoA_avx2(const MV_SOA& in, const MV_SOA& out, int nPos, int iRad, int iMaxSum, bool bInvalidateEdges, sad_t veryBigSAD, int nBlocks);
+
+// AoS VECTOR rows, any nBlocks
+void MVAvg_avx2(VECTOR* pDst, const VECTOR* pSrc1, const VECTOR* pSrc2, int nBlocks);
+
+#endif
@@ -24,7 +24,6 @@
 #include "MVFrame.h"
 #include "MVGroupOfFrames.h"
 #include "MVPlane.h"
-#include "profile.h"
 #include "SuperParams64Bits.h"
 
 
@@ -117,8 +116,6 @@ PVideoFrame __stdcall MVFinest::GetFrame(int n, IScriptEnvironment* env)
   }
   else	// nPel > 1
   {
-    PROFILE_START(MOTION_PROFILE_2X);
-
     if ( (vi.pixel_type & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
     {
       // planar data packed to interleaved format (same as interleved2planar by kassandro) - v2.0.0.5
@@ -196,8 +193,6 @@ PVideoFrame __stdcall MVFinest::GetFrame(int n, IScriptEnvironment* env)
         }
       }
     }
-
-    PROFILE_STOP(MOTION_PROFILE_2X);
   }
 
   return dst;
@@ -20,13 +20,14 @@
 #include	"ClipFnc.h"
 #include "CopyCode.h"
 #include "MaskFun.h"
+#include "MaskFun_avx2.h"
 #include "MVFinest.h"
 #include "MVFlow.h"
 #include "SuperParams64Bits.h"
 #include "commonfunctions.h"
 
 MVFlow::MVFlow(PClip _child, PClip super, PClip _mvec, int _time256, int _mode, bool _fields,
-  sad_t nSCD1, int nSCD2, bool _isse, bool _planar, PClip _timeclip, IScriptEnvironment* env) :
+  sad_t nSCD1, int nSCD2, bool _isse, bool _planar, PClip _timeclip, bool mt_flag, IScriptEnvironment* env) :
   GenericVideoFilter(_child),
   MVFilter(_mvec, "MFlow", env, 1, 0),
   mvClip(_mvec, nSCD1, nSCD2, env, 1, 0)
@@ -41,6 +42,7 @@ MVFlow::MVFlow(PClip _child, PClip super, PClip _mvec, int _time256, int _mode,
   cpuFlags = _isse ? env->GetCPUFlags() : 0;
   fields = _fields;
   planar = _planar;
+  _mt_flag = mt_flag;
 
   SuperParams64Bits params;
   memcpy(&params, &super->GetVideoInfo().num_audio_samples, 8);
@@ -222,17 +224,63 @@ void MVFlow::Shift_NPel(BYTE * pdst8, int dst_pitch, const BYTE *pref8, int ref_
 template<typename pixel_t>
 void MVFlow::Fetch(BYTE * pdst, int dst_pitch, const BYTE *pref, int ref_pitch, short *VXFull, int VXPitch, short *VYFull, int VYPitch, int width, int height, int time256)
 {
+  _fetch_dst = pdst;
+  _fetch_dst_pitch = dst_pitch;
+  _fetch_ref = pref;
+  _fetch_ref_pitch = ref_pitch;
+  _fetch_vx = VXFull;
+  _fetch_vx_pitch = VXPitch;
+  _fetch_vy = VYFull;
+  _fetch_vy_pitch = VYPitch;
+  _fetch_width = width;
+  _fetch_time256 = time256;
+
+  Slicer slicer(_mt_flag);
+  slicer.start(height, *this, &MVFlow::fetch_slice<pixel_t>, 8);
+  slicer.wait();
+}
+
+template<typename pixel_t>
+void MVFlow::fetch_slice(Slicer::TaskData &td)
+{
+  typedef void (MVFlow::*FetchPtr)(BYTE *, int, const BYTE *, int, short *, int, short *, int, int, int, int);
+  FetchPtr fetch_ptr;
+  FlowFetchFunction *fetch_avx2_ptr;
   if (nPel == 1)
   {
-    Fetch_NPel <pixel_t,/*T256P,*/ 0>(pdst, dst_pitch, pref, ref_pitch, VXFull, VXPitch, VYFull, VYPitch, width, height, time256);
+    fetch_ptr = &MVFlow::Fetch_NPel <pixel_t,/*T256P,*/ 0>;
+    fetch_avx2_ptr = FlowFetch_NPel_avx2 <pixel_t, 0>;
   }
   else if (nPel == 2)
   {
-    Fetch_NPel <pixel_t,/*T256P,*/ 1>(pdst, dst_pitch, pref, ref_pitch, VXFull, VXPitch, VYFull, VYPitch, width, height, time256);
+    fetch_ptr = &MVFlow::Fetch_NPel <pixel_t,/*T256P,*/ 1>;
+    fetch_avx2_ptr = FlowFetch_NPel_avx2 <pixel_t, 1>;
   }
   else if (nPel == 4)
   {
-    Fetch_NPel <pixel_t,/*T256P, */2>(pdst, dst_pitch, pref, ref_pitch, VXFull, VXPitch, VYFull, VYPitch, width, height, time256);
+    fetch_ptr = &MVFlow::Fetch_NPel <pixel_t,/*T256P, */2>;
+    fetch_avx2_ptr = FlowFetch_NPel_avx2 <pixel_t, 2>;
+  }
+  else
+    return;
+
+  const int y = td._y_beg;
+  const int height = td._y_end - td._y_beg;
+  BYTE *pdst = _fetch_dst + y * _fetch_dst_pitch;
+  const BYTE *pref = _fetch_ref + y * _fetch_ref_pitch * nPel; // nPel times higher
+  short *VXFull = _fetch_vx + y * _fetch_vx_pitch;
+  short *VYFull = _fetch_vy + y * _fetch_vy_pitch;
+
+  // AVX2 on the mod8 part of the rows, C for the remaining columns
+  const int width8 = ((cpuFlags & CPUF_AVX2) != 0) ? (_fetch_width & ~7) : 0;
+  if (width8 > 0)
+  {
+    fetch_avx2_ptr(pdst, _fetch_dst_pitch, pref, _fetch_ref_pitch, VXFull, _fetch_vx_pitch, VYFull, _fetch_vy_pitch, width8, height, _fetch_time256);
+  }
+  if (width8 < _fetch_width)
+  {
+    (this->*fetch_ptr)(pdst + width8 * sizeof(pixel_t), _fetch_dst_pitch, pref + width8 * nPel * sizeof(pixel_t), _fetch_ref_pitch,
+      VXFull + width8, _fetch_vx_pitch, VYFull + width8, _fetch_vy_pitch, _fetch_width - width8, height, _fetch_time256);
   }
 }
 
@@ -3,6 +3,7 @@
 
 #include "MVClip.h"
 #include "MVFilter.h"
+#include "MTSlicer.h"
 #include "SimpleResize.h"
 #include "Time256ProviderCst.h"
 #include "Time256ProviderPlane.h"
@@ -28,6 +29,7 @@ private:
   //bool isse;
   int cpuFlags;
   bool planar;
+  bool _mt_flag;
 
   PClip finest; // v2.0
 // 	PClip	timeclip; P.F. commented out (2.6.0.5?), could not resolve with 2.5.11.22 intended changes
@@ -74,6 +76,22 @@ private:
   void Fetch(BYTE * pdst8, int dst_pitch, const BYTE *pref8, int ref_pitch, short *VXFull, int VXPitch, short *VYFull, int VYPitch, int width, int height, int time256);
   template <typename pixel_t, int NPELL2>
   void Fetch_NPel(BYTE * pdst8, int dst_pitch, const BYTE *pref8, int ref_pitch, short *VXFull, int VXPitch, short *VYFull, int VYPitch, int width, int height, int time256);
+
+  typedef	MTSlicer <MVFlow>	Slicer;
+  template<typename pixel_t>
+  void fetch_slice(Slicer::TaskData &td);
+
+  // parameters of the current Fetch call, rows are sliced
+  BYTE *_fetch_dst;
+  int _fetch_dst_pitch;
+  const BYTE *_fetch_ref;
+  int _fetch_ref_pitch;
+  short *_fetch_vx;
+  int _fetch_vx_pitch;
+  short *_fetch_vy;
+  int _fetch_vy_pitch;
+  int _fetch_width;
+  int _fetch_time256;
 /*
   template <class T256P> does not fit to 2.5.11.22 logic
   void Shift(BYTE * pdst, int dst_pitch, const BYTE *pref, int ref_pitch,  short *VXFull, int VXPitch,  short *VYFull, int VYPitch, int width, int height, T256P &t256_provider);
@@ -104,7 +122,7 @@ private:
 
 public:
   MVFlow(PClip _child, PClip _super, PClip _vectors, int _time256, int _mode, bool _fields,
-    sad_t nSCD1, int nSCD2, bool isse, bool _planar, PClip _timeclip, IScriptEnvironment* env);
+    sad_t nSCD1, int nSCD2, bool isse, bool _planar, PClip _timeclip, bool mt_flag, IScriptEnvironment* env);
   ~MVFlow();
   PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
 
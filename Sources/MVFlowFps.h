@@ -3,9 +3,11 @@
 
 #include "MVClip.h"
 #include "MVFilter.h"
+#include "profile.h"
 #include "SimpleResize.h"
 #include "yuy2planes.h"
 #include <atomic>
+#include <memory>
 
 class MVFlowFps
   : public GenericVideoFilter
@@ -25,6 +27,7 @@ private:
   //bool isse;
   int cpuFlags;
   bool planar;
+  bool _mt_flag;
   bool blend;
 
   PClip finest; // v2.0
@@ -33,11 +36,17 @@ private:
   std::atomic<bool> reentrancy_check;
   int optDebug;
 
+  // The full-res fields depend only on the source pair, so they are kept across the
+  // output frames interpolated between the same two frames. No lock: MT_MULTI_INSTANCE
+  // and reentrancy_check guarantee a single GetFrame at a time per instance.
   int nleftLast;
   int nrightLast;
+  int nleftExtraLast; // pair of the BB and FF fields (maskmode=2)
 
   int64_t fa, fb;
 
+  std::unique_ptr <MVProfiler> _prof_uptr; // 0 if profiling is not enabled
+
   // fullframe vector mask
   short *VXFullYB; //backward
   short *VXFullUVB;
@@ -80,6 +89,12 @@ private:
   BYTE *MaskSmallF;
   BYTE *MaskFullYF;
   BYTE *MaskFullUVF;
+  // occlusion masks are time dependent, but often identical for neighbour times:
+  // small masks of the current MaskFull content, the upsize is skipped when unchanged
+  BYTE *MaskSmallBLast;
+  BYTE *MaskSmallFLast;
+  bool MaskFullBValid;
+  bool MaskFullFValid;
 
   BYTE *SADMaskSmallB;
   BYTE *SADMaskSmallF;
@@ -119,7 +134,7 @@ private:
 
 public:
   MVFlowFps(PClip _child, PClip _super, PClip _mvbw, PClip _mvfw, unsigned int _num, unsigned int _den, int _maskmode, double _ml,
-    bool _blend, sad_t nSCD1, int nSCD2, bool isse, bool _planar, int _optDebug, IScriptEnvironment* env);
+    bool _blend, sad_t nSCD1, int nSCD2, bool isse, bool _planar, int _optDebug, bool mt_flag, IScriptEnvironment* env);
   ~MVFlowFps();
   PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
 
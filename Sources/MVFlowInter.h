@@ -22,6 +22,7 @@ private:
   PClip finest;
   int cpuFlags;
   bool planar;
+  bool _mt_flag;
   bool blend;
 
   // fullframe vector mask, common for all planes
@@ -94,7 +95,7 @@ private:
 
 public:
   MVFlowInter(PClip _child, PClip _finest, PClip _mvbw, PClip _mvfw, int _time256, double _ml,
-    bool _blend, sad_t nSCD1, int nSCD2, bool isse, bool _planar, IScriptEnvironment* env);
+    bool _blend, sad_t nSCD1, int nSCD2, bool isse, bool _planar, bool mt_flag, IScriptEnvironment* env);
   ~MVFlowInter();
   PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
 
@@ -32,7 +32,7 @@
 
 
 MVGroupOfFrames::MVGroupOfFrames(int _nLevelCount, int _nWidth, int _nHeight, int _nPel, int _nHPad, int _nVPad, int nMode, int cpuFlags, 
-  int _xRatioUV, int _yRatioUV, int _pixelsize, int _bits_per_pixel, bool mt_flag)
+  int _xRatioUV, int _yRatioUV, int _pixelsize, int _bits_per_pixel, bool mt_flag, bool _pel_refine)
 :	nLevelCount (_nLevelCount)
 ,	pFrames (new MVFrame* [_nLevelCount])
 ,	nWidth (_nWidth)
@@ -44,6 +44,7 @@ MVGroupOfFrames::MVGroupOfFrames(int _nLevelCount, int _nWidth, int _nHeight, in
 ,	yRatioUV (_yRatioUV)
 , pixelsize(_pixelsize)
 , bits_per_pixel(_bits_per_pixel)
+, pel_refine(_pel_refine)
 {
 
    pFrames[0] = new MVFrame(nWidth, nHeight, nPel, nHPad, nVPad, nMode, cpuFlags, xRatioUV, yRatioUV, pixelsize, bits_per_pixel, mt_flag);
@@ -57,12 +58,14 @@ MVGroupOfFrames::MVGroupOfFrames(int _nLevelCount, int _nWidth, int _nHeight, in
 
 void MVGroupOfFrames::Update(int nMode, uint8_t * pSrcY, int pitchY, uint8_t * pSrcU, int pitchU, uint8_t *pSrcV, int pitchV) // v2.0
 {
+  // without refined planes, MSuper packs the levels as for pel=1
+  const int nPelStored = (pel_refine) ? nPel : 1;
   for ( int i = 0; i < nLevelCount; i++ )
   {
         // offsets are pixelsize-aware because pitch is in bytes
-    unsigned int offY = PlaneSuperOffset(false, nHeight, i, nPel, nVPad, pitchY, yRatioUV); // no need here xRatioUV and pixelsize
-    unsigned int offU = PlaneSuperOffset(true, nHeight/yRatioUV, i, nPel, nVPad/yRatioUV, pitchU, yRatioUV);
-    unsigned int offV = PlaneSuperOffset(true, nHeight/yRatioUV, i, nPel, nVPad/yRatioUV, pitchV, yRatioUV);
+    unsigned int offY = PlaneSuperOffset(false, nHeight, i, nPelStored, nVPad, pitchY, yRatioUV); // no need here xRatioUV and pixelsize
+    unsigned int offU = PlaneSuperOffset(true, nHeight/yRatioUV, i, nPelStored, nVPad/yRatioUV, pitchU, yRatioUV);
+    unsigned int offV = PlaneSuperOffset(true, nHeight/yRatioUV, i, nPelStored, nVPad/yRatioUV, pitchV, yRatioUV);
     pFrames[i]->Update (nMode, pSrcY+offY, pitchY, pSrcU+offU, pitchU, pSrcV+offV, pitchV);
   }
 }
@@ -43,10 +43,11 @@ class MVGroupOfFrames
    int yRatioUV;
    int pixelsize; // PF 160729
    int bits_per_pixel; // PF 160927
+   bool pel_refine; // false: the super clip holds no refined sub-pel planes, levels are packed as for pel=1
 
 public :
     // xRatioUV PF 160729
-   MVGroupOfFrames(int _nLevelCount, int nWidth, int nHeight, int nPel, int nHPad, int nVPad, int nMode, int cpuFlags, int xRatioUV, int yRatioUV, int _pixelsize, int _bits_per_pixel, bool mt_flag);
+   MVGroupOfFrames(int _nLevelCount, int nWidth, int nHeight, int nPel, int nHPad, int nVPad, int nMode, int cpuFlags, int xRatioUV, int yRatioUV, int _pixelsize, int _bits_per_pixel, bool mt_flag, bool _pel_refine = true);
    ~MVGroupOfFrames();
    void Update(int nModeYUV, uint8_t * pSrcY, int pitchY, uint8_t * pSrcU, int pitchU, uint8_t *pSrcV, int pitchV);
 
@@ -0,0 +1,200 @@
+// Compact format of the vector clip data, MAnalyse / MRecalculate packed=1 or 2
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "MVPackedVectors.h"
+#include <algorithm>
+#include <cstring>
+#include "emmintrin.h"
+
+// int32 words per block in the raw layout
+static const int	MVPackedVectors_nbr_int = int(sizeof(VECTOR) / sizeof(int));
+
+int MVPackedVectors::get_level_blk_count(const int *level, int nBlkCountPrev)
+{
+  // special length of the divided level, see GroupOfPlanes::ExtraDivide
+  if (level[0] == int(0xFFFFFFFF))
+    return nBlkCountPrev * 4;
+  return (level[0] - 1) / MVPackedVectors_nbr_int;
+}
+
+int MVPackedVectors::get_packed_size(const int *raw, int nLvCount, bool finest_only)
+{
+  const int nbr_stored = (finest_only) ? 1 : nLvCount;
+  int size = POS_BLK_COUNT + nLvCount;
+  const int *pA = raw + 2;
+  int nb = 0;
+  for (int i = nLvCount - 1; i >= 0; i--)
+  {
+    nb = get_level_blk_count(pA, nb);
+    if (i < nbr_stored)
+      size += (nb * 3 + 1) / 2;
+    pA += nb * MVPackedVectors_nbr_int + 1;
+  }
+  return size;
+}
+
+void MVPackedVectors::pack(int *dst, const int *raw, int nLvCount, bool finest_only)
+{
+  const int nbr_stored = (finest_only) ? 1 : nLvCount;
+
+  // block counts and SAD range of the stored levels
+  sad_t sad_max = 0;
+  const int *pA = raw + 2;
+  int nb = 0;
+  for (int i = nLvCount - 1; i >= 0; i--)
+  {
+    nb = get_level_blk_count(pA, nb);
+    dst[POS_BLK_COUNT + nLvCount - 1 - i] = nb;
+    if (i < nbr_stored)
+    {
+      const VECTOR *pV = reinterpret_cast<const VECTOR *>(pA + 1);
+      for (int j = 0; j < nb; j++)
+        sad_max = std::max(sad_max, pV[j].sad);
+    }
+    pA += nb * MVPackedVectors_nbr_int + 1;
+  }
+
+  int sad_shift = 0;
+  while ((sad_max >> sad_shift) > 0xFFFF)
+    sad_shift++;
+
+  dst[POS_VALIDITY] = raw[1];
+  dst[POS_SAD_SHIFT] = sad_shift;
+  dst[POS_NBR_LEVELS] = nLvCount;
+  dst[POS_NBR_STORED] = nbr_stored;
+
+  int16_t *pD = reinterpret_cast<int16_t *>(dst + POS_BLK_COUNT + nLvCount);
+  pA = raw + 2;
+  for (int i = nLvCount - 1; i >= 0; i--)
+  {
+    nb = dst[POS_BLK_COUNT + nLvCount - 1 - i];
+    if (i < nbr_stored)
+    {
+      const VECTOR *pV = reinterpret_cast<const VECTOR *>(pA + 1);
+      for (int j = 0; j < nb; j++)
+      {
+        pD[0] = int16_t(std::min(std::max(pV[j].x, -32768), 32767));
+        pD[1] = int16_t(std::min(std::max(pV[j].y, -32768), 32767));
+        pD[2] = int16_t(uint16_t(std::max(pV[j].sad, 0) >> sad_shift));
+        pD += 3;
+      }
+      if (nb & 1)
+        *pD++ = 0;
+    }
+    pA += nb * MVPackedVectors_nbr_int + 1;
+  }
+
+  dst[POS_SIZE] = int(reinterpret_cast<int *>(pD) - dst);
+}
+
+int MVPackedVectors::get_raw_size(const int *packed, int packed_size)
+{
+  if (packed_size < POS_BLK_COUNT || packed[POS_SIZE] > packed_size)
+    return -1;
+  const int nLvCount = packed[POS_NBR_LEVELS];
+  const int nbr_stored = packed[POS_NBR_STORED];
+  if (nbr_stored < 1 || nbr_stored > nLvCount || POS_BLK_COUNT + nLvCount > packed_size)
+    return -1;
+
+  int raw_size = 2;
+  int size = POS_BLK_COUNT + nLvCount;
+  for (int k = 0; k < nLvCount; k++)
+  {
+    const int nb = packed[POS_BLK_COUNT + k];
+    if (nb < 0)
+      return -1;
+    raw_size += nb * MVPackedVectors_nbr_int + 1;
+    if (k >= nLvCount - nbr_stored)
+      size += (nb * 3 + 1) / 2;
+  }
+
+  return (size == packed[POS_SIZE]) ? raw_size : -1;
+}
+
+void MVPackedVectors::unpack(int *raw, const int *packed)
+{
+  const int nLvCount = packed[POS_NBR_LEVELS];
+  const int nbr_stored = packed[POS_NBR_STORED];
+  const int sad_shift = packed[POS_SAD_SHIFT];
+
+  const int16_t *pS = reinterpret_cast<const int16_t *>(packed + POS_BLK_COUNT + nLvCount);
+  int *pA = raw + 2;
+  for (int k = 0; k < nLvCount; k++)
+  {
+    const int nb = packed[POS_BLK_COUNT + k];
+    pA[0] = nb * MVPackedVectors_nbr_int + 1;
+    VECTOR *pV = reinterpret_cast<VECTOR *>(pA + 1);
+    if (k >= nLvCount - nbr_stored)
+    {
+      unpack_level_sse2(pV, pS, nb, sad_shift);
+      pS += (nb * 3 + 1) & ~1;
+    }
+    else
+    {
+      memset(pV, 0, nb * sizeof(VECTOR));
+    }
+    pA += pA[0];
+  }
+
+  raw[0] = int(pA - raw);
+  raw[1] = packed[POS_VALIDITY];
+}
+
+// 4 blocks per loop: the 12 int16 are widened in order to 3 vectors of 4 int32,
+// x0 y0 s0 x1 | y1 s1 x2 y2 | s2 x3 y3 s3. The SADs are zero-extended and
+// shifted, the coordinates sign-extended.
+void MVPackedVectors::unpack_level_sse2(VECTOR *dst, const int16_t *src, int nBlkCount, int sad_shift)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i shift = _mm_cvtsi32_si128(sad_shift);
+  const __m128i mask0 = _mm_setr_epi32(0, 0, -1, 0);
+  const __m128i mask1 = _mm_setr_epi32(0, -1, 0, 0);
+  const __m128i mask2 = _mm_setr_epi32(-1, 0, 0, -1);
+
+  int *pD = reinterpret_cast<int *>(dst);
+  const int nBlkCount4 = nBlkCount & ~3;
+  for (int i = 0; i < nBlkCount4; i += 4)
+  {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + 8));
+
+    const __m128i s0 = _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16);
+    const __m128i s1 = _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16);
+    const __m128i s2 = _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16);
+    const __m128i u0 = _mm_sll_epi32(_mm_unpacklo_epi16(a, zero), shift);
+    const __m128i u1 = _mm_sll_epi32(_mm_unpackhi_epi16(a, zero), shift);
+    const __m128i u2 = _mm_sll_epi32(_mm_unpacklo_epi16(b, zero), shift);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pD), _mm_or_si128(_mm_andnot_si128(mask0, s0), _mm_and_si128(mask0, u0)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pD + 4), _mm_or_si128(_mm_andnot_si128(mask1, s1), _mm_and_si128(mask1, u1)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(pD + 8), _mm_or_si128(_mm_andnot_si128(mask2, s2), _mm_and_si128(mask2, u2)));
+
+    src += 12;
+    pD += 12;
+  }
+
+  for (int i = nBlkCount4; i < nBlkCount; i++)
+  {
+    pD[0] = src[0];
+    pD[1] = src[1];
+    pD[2] = int(uint16_t(src[2])) << sad_shift;
+    src += 3;
+    pD += 3;
+  }
+}
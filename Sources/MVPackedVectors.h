@@ -0,0 +1,63 @@
+// Compact format of the vector clip data, MAnalyse / MRecalculate packed=1 or 2
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef	__MV_PackedVectors__
+#define	__MV_PackedVectors__
+
+#include "types.h"
+#include "VECTOR.h"
+
+// The header of the frame is unchanged, MVAnalysisData::nFlags has
+// MOTION_PACKED_VECTORS. The data, in 32-bit words:
+// 0: size of the packed data, 1: validity, 2: SAD shift,
+// 3: level count, 4: stored level count (the finest ones),
+// 5: block count of each level, coarsest first,
+// then for each stored level, coarsest first: x, y, sad >> shift as
+// int16/int16/uint16 per block, padded to 32 bits.
+// The vectors are kept in sub-pel units, the SAD shift is the smallest one
+// for the largest SAD of the frame, so 8-bit SADs are usually exact.
+class MVPackedVectors
+{
+public:
+  enum
+  {
+    POS_SIZE = 0,
+    POS_VALIDITY,
+    POS_SAD_SHIFT,
+    POS_NBR_LEVELS,
+    POS_NBR_STORED,
+    POS_BLK_COUNT
+  };
+
+  // raw: the layout written by GroupOfPlanes (size, validity, then length and
+  // vectors of each level). Sizes are in 32-bit words.
+  static int get_packed_size(const int *raw, int nLvCount, bool finest_only);
+  static void pack(int *dst, const int *raw, int nLvCount, bool finest_only);
+
+  // -1 if packed_size is too small for the packed data
+  static int get_raw_size(const int *packed, int packed_size);
+  // Back to the raw layout. The levels which were not stored get zero vectors.
+  static void unpack(int *raw, const int *packed);
+
+private:
+  static int get_level_blk_count(const int *level, int nBlkCountPrev);
+  static void unpack_level_sse2(VECTOR *dst, const int16_t *src, int nBlkCount, int sad_shift);
+};
+
+#endif	// __MV_PackedVectors__
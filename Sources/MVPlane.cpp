@@ -67,6 +67,9 @@ MVPlane::MVPlane(int _nWidth, int _nHeight, int _nPel, int _nHPad, int _nVPad, i
   , _plan_refine()
   , _slicer_reduce(mt_flag)
   , _redp_ptr(0)
+  , _subshift_cache_ovf_arr()
+  , _subshift_mutex()
+  , _subshift_gen(0)
 {
   _isse = !!(cpuFlags & CPUF_SSE2);
   hasSSE41 = !!(cpuFlags & CPUF_SSE4_1);
@@ -114,12 +117,11 @@ MVPlane::MVPlane(int _nWidth, int _nHeight, int _nPel, int _nHPad, int _nVPad, i
   // Nothing
 
   // 2.7.46
-  // memory of processed block to return without double processing
-  iPrcdBlockX = 0;
-  iPrcdBlockY = 0;
-  iPrcdBlkPitch = 0;
-  puiPrcdBlkPtr = 0;
-  bPrcdBlkValid = false;
+  // per-thread caches of the sub-shifted blocks, created on first use
+  for (int slot = 0; slot < SUBSHIFT_MAX_THREADS; ++slot)
+  {
+    _subshift_cache_arr[slot].store(0, std::memory_order_relaxed);
+  }
 
   // 2.7.46
   // sub shift kernels init
@@ -136,25 +138,6 @@ MVPlane::MVPlane(int _nWidth, int _nHeight, int _nPel, int _nHPad, int _nVPad, i
   sKernelShWI6_110 = new short[SHIFTKERNELSIZE + 1] {1, -5, 20, 52, -5, 1, 16};
   sKernelShWI6_111 = new short[SHIFTKERNELSIZE + 1] {1, -5, 20, 52, -5, 1, 16}; // i
   */
-
-
-//  _sub_shift_ptr = SubShiftBlock_C<uint8_t>;
-#ifdef _WIN32
- // to prevent cache set overloading when accessing cached subshifted blocks - add random L2L3_CACHE_LINE_SIZE-bytes sized offset to different allocations
-  size_t random = rand();
-  random *= RAND_OFFSET_MAX;
-  random /= RAND_MAX;
-  random *= L2L3_CACHE_LINE_SIZE;
-
-  SIZE_T stSizeToAlloc = (pixelsize * (64*64))+ RAND_OFFSET_MAX * L2L3_CACHE_LINE_SIZE; // 64x64 - max block size ??
-
-  pShiftedBlockBuf_a = (uint8_t*)VirtualAlloc(0, stSizeToAlloc, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE); // 4KByte page aligned address
-  // Allocated with 4096 bytes granularity, most of these bytes is never used for host bus transfer
-  // and only point is to have enough address range to hit different cache sets to prevent cache set overload with large enough tr-value
-  pShiftedBlockBuf = (uint8_t*)(pShiftedBlockBuf_a + random);
-#else
-  pShiftedBlockBuf = new uint8_t[pixelsize * (64 * 64)]; // allocate in heap ?
-#endif
 }
 
 
@@ -164,11 +147,14 @@ MVPlane::~MVPlane()
   delete[] pPlane;
   pPlane = 0;
 
-#ifdef _WIN32
-  VirtualFree(pShiftedBlockBuf_a, 0, MEM_RELEASE);
-#else
-  delete[] pShiftedBlockBuf;
-#endif
+  for (int slot = 0; slot < SUBSHIFT_MAX_THREADS; ++slot)
+  {
+    delete _subshift_cache_arr[slot].load(std::memory_order_relaxed);
+  }
+  for (auto cache_ptr : _subshift_cache_ovf_arr)
+  {
+    delete cache_ptr;
+  }
   delete sKernelShWI6_01;
   delete sKernelShWI6_10;
   delete sKernelShWI6_11;
@@ -268,6 +254,7 @@ void MVPlane::Update(uint8_t* pSrc, int _nPitch) //v2.0
   }
 
   ResetState();
+  ++_subshift_gen;
 }
 
 
@@ -279,6 +266,7 @@ void MVPlane::ChangePlane(const uint8_t *pNewPlane, int nNewPitch)
     // noffsetPadding is pixelsize aware
     BitBlt(pPlane[0] + nOffsetPadding, nPitch, pNewPlane, nNewPitch, (nWidth << pixelsize_shift), nHeight);
     isFilled = true;
+    ++_subshift_gen;
   }
 }
 
@@ -296,6 +284,7 @@ void MVPlane::Pad()
     else
       Padding::PadReferenceFrame<float>(pPlane[0], nPitch, nHPadding, nVPadding, nWidth, nHeight);
     isPadded = true;
+    ++_subshift_gen;
   }
 }
 
@@ -595,11 +584,164 @@ void MVPlane::reduce_slice(SlicerReduce::TaskData &td)
   );
 }
 
+MVPlane::SubShiftCache::SubShiftCache(std::thread::id owner)
+  : _owner(owner)
+  , _gen(0)
+  , _clock(0)
+  , _blk_size(0)
+  , _buf_ptr(0)
+{
+  for (int way = 0; way < NBR_WAYS; ++way)
+  {
+    _x_arr[way] = 0;
+    _y_arr[way] = 0;
+    _tag_arr[way] = -1;
+    _last_use_arr[way] = 0;
+  }
+}
+
+
+
+MVPlane::SubShiftCache::~SubShiftCache()
+{
+  _aligned_free(_buf_ptr);
+}
+
+
+
+// Finds the cache of the calling thread, creates it on the first call.
+// Threads only read the slots, a slot is written once with a CAS.
+MVPlane::SubShiftCache& MVPlane::use_subshift_cache()
+{
+  const std::thread::id tid = std::this_thread::get_id();
+
+  for (int slot = 0; slot < SUBSHIFT_MAX_THREADS; ++slot)
+  {
+    SubShiftCache* cache_ptr = _subshift_cache_arr[slot].load(std::memory_order_acquire);
+    if (cache_ptr == 0)
+    {
+      SubShiftCache* new_ptr = new SubShiftCache(tid);
+      SubShiftCache* expected_ptr = 0;
+      if (_subshift_cache_arr[slot].compare_exchange_strong(expected_ptr, new_ptr, std::memory_order_acq_rel))
+      {
+        return *new_ptr;
+      }
+      // Another thread took this slot, keep searching
+      delete new_ptr;
+      cache_ptr = expected_ptr;
+    }
+    if (cache_ptr->_owner == tid)
+    {
+      return *cache_ptr;
+    }
+  }
+
+  std::lock_guard <std::mutex> lock(_subshift_mutex);
+  for (auto cache_ptr : _subshift_cache_ovf_arr)
+  {
+    if (cache_ptr->_owner == tid)
+    {
+      return *cache_ptr;
+    }
+  }
+  _subshift_cache_ovf_arr.push_back(new SubShiftCache(tid));
+
+  return *_subshift_cache_ovf_arr.back();
+}
+
+
+
+// nKeyX, nKeyY, nTag: identify the block in the cache
+// pSrc: top-left full-pel source pixel, i_dx, i_dy: sub-pel shift
+const uint8_t* MVPlane::sub_shift_block(const uint8_t* pSrc, int i_dx, int i_dy, int nKeyX, int nKeyY, int nTag, int& pDstPitch)
+{
+  SubShiftCache& cache = use_subshift_cache();
+
+  const int nShiftedBufPitch = (nBlkSizeX << pixelsize_shift);
+  pDstPitch = nShiftedBufPitch;
+
+  if (cache._gen != _subshift_gen)
+  {
+    for (int way = 0; way < SubShiftCache::NBR_WAYS; ++way)
+    {
+      cache._tag_arr[way] = -1;
+    }
+    const int blk_size = (nShiftedBufPitch * nBlkSizeY + 63) & ~63;
+    if (blk_size > cache._blk_size)
+    {
+      _aligned_free(cache._buf_ptr);
+      cache._buf_ptr = (uint8_t*)_aligned_malloc(blk_size * SubShiftCache::NBR_WAYS, 64);
+      cache._blk_size = blk_size;
+    }
+    cache._gen = _subshift_gen;
+  }
+
+  ++cache._clock;
+
+  // check if block already processed, otherwise replace the least recently used one
+  int way_lru = 0;
+  for (int way = 0; way < SubShiftCache::NBR_WAYS; ++way)
+  {
+    if (cache._x_arr[way] == nKeyX && cache._y_arr[way] == nKeyY && cache._tag_arr[way] == nTag)
+    {
+      cache._last_use_arr[way] = cache._clock;
+      return cache._buf_ptr + way * cache._blk_size;
+    }
+    if (cache._tag_arr[way] < 0
+    || (cache._tag_arr[way_lru] >= 0 && cache._last_use_arr[way] < cache._last_use_arr[way_lru]))
+    {
+      way_lru = way;
+    }
+  }
+
+  cache._x_arr[way_lru] = nKeyX;
+  cache._y_arr[way_lru] = nKeyY;
+  cache._tag_arr[way_lru] = nTag;
+  cache._last_use_arr[way_lru] = cache._clock;
+
+  uint8_t* pDst = cache._buf_ptr + way_lru * cache._blk_size;
+  unsigned char* pSrcUC = (unsigned char*)pSrc;
+
+  short* const psKrn_arr[4] = { 0, sKernelShWI6_01, sKernelShWI6_10, sKernelShWI6_11 };
+  short* psKrnH = psKrn_arr[i_dx];
+  short* psKrnV = psKrn_arr[i_dy];
+
+  if (hasAVX2)
+  {
+    if (nBlkSizeX == 8 && nBlkSizeY == 8 && pixelsize == 1)
+    {
+      SubShiftBlock8x8_KS6_i16_uint8_avx2(pSrcUC, pDst, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
+    }
+    else if (nBlkSizeX == 8 && nBlkSizeY == 8 && pixelsize == 2)
+    {
+      SubShiftBlock8x8_KS6_i16_uint16_avx2(pSrcUC, pDst, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
+    }
+    else if (nBlkSizeX == 4 && nBlkSizeY == 4 && pixelsize == 1)
+    {
+      SubShiftBlock4x4_KS6_i16_uint8_avx2(pSrcUC, pDst, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
+    }
+    /*    else if (nBlkSizeX == 4 && nBlkSizeY == 4 && pixelsize == 2) - still not debugged
+        {
+          SubShiftBlock4x4_KS6_i16_uint16_avx2(pSrcUC, pDst, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
+        }*/
+    else if (nBlkSizeX == 16 && nBlkSizeY == 16 && pixelsize == 1)
+    {
+      SubShiftBlock16x16_KS6_i16_uint8_avx2(pSrcUC, pDst, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
+    }
+    else
+      _sub_shift_ptr(pSrcUC, pDst, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nBlkSizeX, SHIFTKERNELSIZE);
+  }
+  else
+  {
+    _sub_shift_ptr(pSrcUC, pDst, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nBlkSizeX, SHIFTKERNELSIZE);
+  }
+
+  return pDst;
+}
+
 const uint8_t* MVPlane::GetPointerSubShiftUV(int nX, int nY, int& pDstPitch, int LogXrUV, int LogYrUV, bool bPadded)
 {
-  uint8_t* pSrc;
-  short* psKrnH = 0;
-  short* psKrnV = 0;
+  const uint8_t* pSrc;
 
   int NPELL2 = nPel >> 1;
 
@@ -624,8 +766,9 @@ const uint8_t* MVPlane::GetPointerSubShiftUV(int nX, int nY, int& pDstPitch, int
     nfullX >>= NPELL2;
     nfullY >>= NPELL2;
 
-    pSrc = (uint8_t*)GetAbsolutePointerPel <0>(nfullX, nfullY);
+    pSrc = GetAbsolutePointerPel <0>(nfullX, nfullY);
 
+    pDstPitch = nPitch;
     return pSrc;
   }
   else // chroma plane size < luma plane size
@@ -646,15 +789,6 @@ const uint8_t* MVPlane::GetPointerSubShiftUV(int nX, int nY, int& pDstPitch, int
     nfullY2 += nVPaddingPel;
   }
 
-  int nShiftedBufPitch = (nBlkSizeX << pixelsize_shift);
-
-  // check if block already processed
-  if ((iPrcdBlockX == nfullX2) && (iPrcdBlockY == nfullY2) && bPrcdBlkValid)
-  {
-    pDstPitch = iPrcdBlkPitch;
-    return puiPrcdBlkPtr;
-  }
-
   int iMASK = (1 << NPELL2) - 1;
   int iMASK2 = (1 << nPel) - 1;
 
@@ -667,17 +801,10 @@ const uint8_t* MVPlane::GetPointerSubShiftUV(int nX, int nY, int& pDstPitch, int
   nfullX >>= NPELL2;
   nfullY >>= NPELL2;
 
-  pSrc = (uint8_t*)GetAbsolutePointerPel <0>(nfullX, nfullY);
+  pSrc = GetAbsolutePointerPel <0>(nfullX, nfullY);
 
   if ((i_dx == 0 && i_dy == 0) && (LogXrUV == 0 && LogYrUV != 0))
   {
-    // remember last processed block params
-    iPrcdBlockX = nfullX2;
-    iPrcdBlockY = nfullY2;
-    puiPrcdBlkPtr = pSrc;
-    iPrcdBlkPitch = nPitch;
-    bPrcdBlkValid = true;
-
     pDstPitch = nPitch;
     return pSrc;
   }
@@ -686,13 +813,6 @@ const uint8_t* MVPlane::GetPointerSubShiftUV(int nX, int nY, int& pDstPitch, int
   {
     if (i_dx2 == 0 && i_dy2 == 0)
     {
-      // remember last processed block params
-      iPrcdBlockX = nfullX2;
-      iPrcdBlockY = nfullY2;
-      puiPrcdBlkPtr = pSrc;
-      iPrcdBlkPitch = nPitch;
-      bPrcdBlkValid = true;
-
       pDstPitch = nPitch;
       return pSrc;
     }
@@ -704,117 +824,33 @@ const uint8_t* MVPlane::GetPointerSubShiftUV(int nX, int nY, int& pDstPitch, int
       i_dx = i_dx2 << 1;
     else
       i_dx = i_dx2; // nPel = 2 and 4 (?)
-  }
 
-  switch (i_dx)
-  {
-  case 0:
-    psKrnH = 0;
-    break;
-  case 1:
-    psKrnH = (short*)sKernelShWI6_01;
-    break;
-  case 2:
-    psKrnH = (short*)sKernelShWI6_10;
-    break;
-  case 3:
-    psKrnH = (short*)sKernelShWI6_11;
-    break;
-  }
-
-  if (LogXrUV != 0)
-  {
     if (nPel == 1)
       i_dy = i_dy2 << 1;
     else
       i_dy = i_dy2; // nPel = 2 and 4 (?)
   }
 
-  switch (i_dy)
-  {
-  case 0:
-    psKrnV = 0;
-    break;
-  case 1:
-    psKrnV = (short*)sKernelShWI6_01;
-    break;
-  case 2:
-    psKrnV = (short*)sKernelShWI6_10;
-    break;
-  case 3:
-    psKrnV = (short*)sKernelShWI6_11;
-    break;
-  }
-
-  if (hasAVX2)
-  {
-    if (nBlkSizeX == 8 && nBlkSizeY == 8 && pixelsize == 1)
-    {
-      SubShiftBlock8x8_KS6_i16_uint8_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    }
-    else if (nBlkSizeX == 8 && nBlkSizeY == 8 && pixelsize == 2)
-    {
-      SubShiftBlock8x8_KS6_i16_uint16_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    }
-    else if (nBlkSizeX == 4 && nBlkSizeY == 4 && pixelsize == 1)
-    {
-      SubShiftBlock4x4_KS6_i16_uint8_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    }
-/*    else if (nBlkSizeX == 4 && nBlkSizeY == 4 && pixelsize == 2) - still not debugged
-    {
-      SubShiftBlock4x4_KS6_i16_uint16_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    }*/
-    else if (nBlkSizeX == 16 && nBlkSizeY == 16 && pixelsize == 1)
-    {
-      SubShiftBlock16x16_KS6_i16_uint8_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    }
-    else
-//   _sub_shift_ptr(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-     _sub_shift_ptr(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nBlkSizeX, SHIFTKERNELSIZE);
-  }
-  else
-  {
-//    _sub_shift_ptr(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    _sub_shift_ptr(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nBlkSizeX, SHIFTKERNELSIZE);
-  }
-
-  pDstPitch = nShiftedBufPitch;
-
-  // remember last processed block params
-  iPrcdBlockX = nfullX2;
-  iPrcdBlockY = nfullY2;
-  puiPrcdBlkPtr = pShiftedBlockBuf;
-  iPrcdBlkPitch = nShiftedBufPitch;
-  bPrcdBlkValid = true;
-
-  return pShiftedBlockBuf;
+  // no kernel for the other phases
+  if (i_dx > 3) i_dx = 0;
+  if (i_dy > 3) i_dy = 0;
 
+  // chroma subsampling is part of the cache key
+  return sub_shift_block(pSrc, i_dx, i_dy, nfullX2, nfullY2, 1 + LogXrUV + (LogYrUV << 1), pDstPitch);
 }
 
 void MVPlane::SetBlockSize(int iBlockSizeX, int iBlockSizeY)
 {
   nBlkSizeX = iBlockSizeX;
   nBlkSizeY = iBlockSizeY;
+  ++_subshift_gen;
 }
 
 const uint8_t* MVPlane::GetPointerSubShift(int nX, int nY, int& pDstPitch, bool bPadded)
 {
-  uint8_t* pSrc;
-  short* psKrnH = 0;
-  short* psKrnV = 0;
-
   int nfullX = nX;
   int nfullY = nY;
 
-  int nShiftedBufPitch = (nBlkSizeX << pixelsize_shift);
-
-  // check if block already processed
-  if ((iPrcdBlockX == nX) && (iPrcdBlockY == nY) && bPrcdBlkValid)
-  {
-    pDstPitch = iPrcdBlkPitch;
-    return puiPrcdBlkPtr;
-  }
-
   int NPELL2 = nPel >> 1;
 
   if (bPadded)
@@ -823,6 +859,9 @@ const uint8_t* MVPlane::GetPointerSubShift(int nX, int nY, int& pDstPitch, bool
     nfullY += nVPaddingPel;
   }
 
+  const int nKeyX = nfullX;
+  const int nKeyY = nfullY;
+
   int iMASK = (1 << NPELL2) - 1;
 
   int i_dx = (nfullX & iMASK);
@@ -831,94 +870,14 @@ const uint8_t* MVPlane::GetPointerSubShift(int nX, int nY, int& pDstPitch, bool
   nfullX >>= NPELL2;
   nfullY >>= NPELL2;
 
-  pSrc = (uint8_t*)GetAbsolutePointerPel <0>(nfullX, nfullY);
+  const uint8_t* pSrc = GetAbsolutePointerPel <0>(nfullX, nfullY);
 
+  // full-pel position, nothing to compute
   if (i_dx == 0 && i_dy == 0)
   {
-    // remember last processed block params
-    iPrcdBlockX = nX;
-    iPrcdBlockY = nY;
-    puiPrcdBlkPtr = pSrc;
-    iPrcdBlkPitch = nPitch;
-    bPrcdBlkValid = true;
-
     pDstPitch = nPitch;
     return pSrc;
   }
 
-  switch (i_dx)
-  {
-  case 0:
-    psKrnH = 0;
-    break;
-  case 1:
-    psKrnH = (short*)sKernelShWI6_01;
-    break;
-  case 2:
-    psKrnH = (short*)sKernelShWI6_10;
-    break;
-  case 3:
-    psKrnH = (short*)sKernelShWI6_11;
-    break;
-  }
-
-  switch (i_dy)
-  {
-  case 0:
-    psKrnV = 0;
-    break;
-  case 1:
-    psKrnV = (short*)sKernelShWI6_01;
-    break;
-  case 2:
-    psKrnV = (short*)sKernelShWI6_10;
-    break;
-  case 3:
-    psKrnV = (short*)sKernelShWI6_11;
-    break;
-  }
-
-  if (hasAVX2)
-  {
-    if (nBlkSizeX == 8 && nBlkSizeY == 8 && pixelsize == 1)
-    {
-      SubShiftBlock8x8_KS6_i16_uint8_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    }
-    else if (nBlkSizeX == 8 && nBlkSizeY == 8 && pixelsize == 2)
-    {
-      SubShiftBlock8x8_KS6_i16_uint16_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    }
-    else if (nBlkSizeX == 4 && nBlkSizeY == 4 && pixelsize == 1)
-    {
-      SubShiftBlock4x4_KS6_i16_uint8_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    }
-    /*    else if (nBlkSizeX == 4 && nBlkSizeY == 4 && pixelsize == 2) - still not debugged
-        {
-          SubShiftBlock4x4_KS6_i16_uint16_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-        }*/
-    else if (nBlkSizeX == 16 && nBlkSizeY == 16 && pixelsize == 1)
-    {
-      SubShiftBlock16x16_KS6_i16_uint8_avx2(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    }
-    else
-      //   _sub_shift_ptr(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-      _sub_shift_ptr(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nBlkSizeX, SHIFTKERNELSIZE);
-  }
-  else
-  {
-    //    _sub_shift_ptr(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nShiftedBufPitch, SHIFTKERNELSIZE);
-    _sub_shift_ptr(pSrc, pShiftedBlockBuf, nBlkSizeX, nBlkSizeY, psKrnH, psKrnV, nPitch, nBlkSizeX, SHIFTKERNELSIZE);
-  }
-
-  pDstPitch = nShiftedBufPitch;
-
-  // remember last processed block params
-  iPrcdBlockX = nX;
-  iPrcdBlockY = nY;
-  puiPrcdBlkPtr = pShiftedBlockBuf;
-  iPrcdBlkPitch = nShiftedBufPitch;
-  bPrcdBlkValid = true;
-
-  return pShiftedBlockBuf;
-
+  return sub_shift_block(pSrc, i_dx, i_dy, nKeyX, nKeyY, 0, pDstPitch);
 }
@@ -24,7 +24,11 @@
 #include	"MTSlicer.h"
 #include	"types.h"
 
+#include	<atomic>
 #include	<cstdio>
+#include	<mutex>
+#include	<thread>
+#include	<vector>
 #include <stdint.h>
 #include "def.h"
 
@@ -136,9 +140,6 @@ private:
    bool isRefined;
    bool isFilled;
 
-   uint8_t* pShiftedBlockBuf;
-   uint8_t* pShiftedBlockBuf_a;
-
    InterpFncPtr	_bilin_hor_ptr;
   InterpFncPtr	_bilin_ver_ptr;
   InterpFncPtr	_bilin_dia_ptr;
@@ -166,11 +167,45 @@ private:
   int nBlkSizeX;
   int nBlkSizeY;
 
-  int iPrcdBlockX;
-  int iPrcdBlockY;
-  uint8_t* puiPrcdBlkPtr;
-  int iPrcdBlkPitch;
-  bool bPrcdBlkValid;
+  // Sub-shifted blocks are computed in a small LRU owned by the calling
+  // thread, so concurrent slices neither share nor thrash a single buffer.
+  // A returned pointer stays valid until the same thread requests
+  // NBR_WAYS other sub-shifted blocks from this plane.
+  class SubShiftCache
+  {
+  public:
+    enum { NBR_WAYS = 4 };
+
+    explicit       SubShiftCache(std::thread::id owner);
+                   ~SubShiftCache();
+
+    const std::thread::id
+                   _owner;
+    uint32_t       _gen;      // plane generation the entries were computed for
+    uint32_t       _clock;
+    int            _blk_size; // bytes allocated per entry
+    uint8_t *      _buf_ptr;  // NBR_WAYS entries, 64-byte aligned
+    int            _x_arr[NBR_WAYS];
+    int            _y_arr[NBR_WAYS];
+    int            _tag_arr[NBR_WAYS]; // -1: empty
+    uint32_t       _last_use_arr[NBR_WAYS];
+
+  private:
+                   SubShiftCache(const SubShiftCache &other) = delete;
+    SubShiftCache& operator = (const SubShiftCache &other) = delete;
+  };
+
+  enum { SUBSHIFT_MAX_THREADS = 64 };
+
+  SubShiftCache& use_subshift_cache();
+  const uint8_t* sub_shift_block(const uint8_t* pSrc, int i_dx, int i_dy, int nKeyX, int nKeyY, int nTag, int& pDstPitch);
+
+  std::atomic <SubShiftCache *>
+            _subshift_cache_arr[SUBSHIFT_MAX_THREADS]; // lock-free lookup, one slot per thread
+  std::vector <SubShiftCache *>
+            _subshift_cache_ovf_arr; // more threads than slots, protected by _subshift_mutex
+  std::mutex _subshift_mutex;
+  uint32_t  _subshift_gen; // bumped when the plane content or the block size changes
 
   typedef void (*SubShiftFncPtr) (
     unsigned char* pSrc, unsigned char* pDst, int iBlockSizeX, int iBlockSizeY, short* sKernelH, short* sKernelV, int nSrcPitch, int nDstPitch, int iKS
@@ -27,7 +27,9 @@
 #include "DCTINT.h"
 #include "MVClip.h"
 #include "MVGroupOfFrames.h"
+#include "MVPackedVectors.h"
 #include "MVRecalculate.h"
+#include "MVSceneStats.h"
 #include "profile.h"
 #include "SuperParams64Bits.h"
 
@@ -44,7 +46,7 @@ MVRecalculate::MVRecalculate(
   int trad, bool mt_flag, int _chromaSADScale, int _optSearchOption, int _optPredictorType, int _DMFlags,
   int _AreaMode, int _AMDiffSAD, int _AMstep, int _AMoffset, 
   PClip _super_cur, float _fAMthVSMang, int _AMflags, int _AMavg,
-  bool _bglobal, int _pglobal, int _pzero,
+  bool _bglobal, int _pglobal, int _pzero, int packed_mode,
   IScriptEnvironment* env
 )
   : GenericVideoFilter(_super)
@@ -68,6 +70,7 @@ MVRecalculate::MVRecalculate(
   , bGlobal(_bglobal)
   , iPGlobal(_pglobal)
   , iPZero(_pzero)
+  , _packed_mode(packed_mode)
 {
   has_at_least_v8 = true;
   try { env->CheckVersion(8); }
@@ -263,8 +266,8 @@ MVRecalculate::MVRecalculate(
 
   divideExtra = _divide;
 
-  // include itself, but usually equal to 256 :-)
-  headerSize = std::max(int(4 + sizeof(analysisData)), 256);
+  // include itself and the scene stats
+  headerSize = std::max(MVSceneStats::get_header_size(), 256);
 
   analysisData.nOverlapX = _overlapx;
   analysisData.nOverlapY = _overlapy;
@@ -344,8 +347,14 @@ MVRecalculate::MVRecalculate(
     nSearchParam = (stp < 1) ? 1 : stp;
   }
 
+  if (_packed_mode < 0 || _packed_mode > 2)
+  {
+    env->ThrowError("MRecalculate: packed must be 0, 1 or 2");
+  }
+
   analysisData.nFlags = 0;
   analysisData.nFlags |= (_isse) ? MOTION_USE_ISSE : 0;
+  analysisData.nFlags |= (_packed_mode != 0) ? MOTION_PACKED_VECTORS : 0;
   analysisData.nFlags |= (analysisData.isBackward) ? MOTION_IS_BACKWARD : 0;
   analysisData.nFlags |= (chroma) ? MOTION_USE_CHROMA_MOTION : 0;
   analysisData.nFlags |= conv_cpuf_flags_to_cpu(env->GetCPUFlags());
@@ -367,6 +376,7 @@ MVRecalculate::MVRecalculate(
     analysisData.bits_per_pixel,
     (_dct_factory_ptr.get() != 0) ? &_dct_pool : 0,
     _mt_flag,
+    false, // tiles - RecalculateMVs keeps the row slices
     analysisData.chromaSADScale,
     _optSearchOption,
     1.0f, // scaleCSADfine default (no op)
@@ -380,6 +390,9 @@ MVRecalculate::MVRecalculate(
     env
   ));
 
+  _prof_uptr = MVProfiler::create("MRecalculate");
+  _vectorfields_aptr->set_profiler(_prof_uptr.get());
+
   analysisData.nMagicKey = MVAnalysisData::MOTION_MAGIC_KEY;
   analysisData.nHPadding = nSuperHPad;
   analysisData.nVPadding = nSuperVPad;
@@ -409,7 +422,15 @@ MVRecalculate::MVRecalculate(
   }
 
   // Defines the format of the output vector clip
-  const int		width_bytes = headerSize + _vectorfields_aptr->GetArraySize() * 4;
+  int				width_bytes = headerSize + _vectorfields_aptr->GetArraySize() * 4;
+  if (_packed_mode != 0)
+  {
+    std::vector <int>	def_arr(_vectorfields_aptr->GetArraySize());
+    _vectorfields_aptr->WriteDefaultToArray(&def_arr[0]);
+    width_bytes = headerSize + MVPackedVectors::get_packed_size(
+      &def_arr[0], analysisData.nLvCount + ((divideExtra) ? 1 : 0), _packed_mode == 2
+    ) * 4;
+  }
   ClipFnc::format_vector_clip(
     vi, true, nBlkX, "rgb32", width_bytes, "MRecalculate", env
   );
@@ -492,6 +513,8 @@ MVRecalculate::~MVRecalculate()
 
 PVideoFrame __stdcall MVRecalculate::GetFrame(int n, IScriptEnvironment* env)
 {
+  MVProfileScope prof_frame(_prof_uptr.get(), MVPROF_GETFRAME);
+
   const int		nsrc = n / _nbr_srd;
   const int		srd_index = n % _nbr_srd;
 
@@ -571,6 +594,15 @@ PVideoFrame __stdcall MVRecalculate::GetFrame(int n, IScriptEnvironment* env)
   }
   pDst += headerSize;
 
+  // packed output: the vectors are recalculated in the raw layout first
+  unsigned char * const	pDstData = pDst;
+  std::vector <int>	raw_arr;
+  if (_packed_mode != 0)
+  {
+    raw_arr.resize(_vectorfields_aptr->GetArraySize());
+    pDst = reinterpret_cast <unsigned char *> (&raw_arr[0]);
+  }
+
   if (!srd._clip_sptr->IsUsable() || nsrc < minframe || nsrc >= maxframe)
   {
     _vectorfields_aptr->WriteDefaultToArray(reinterpret_cast <int *> (pDst));
@@ -625,7 +657,6 @@ PVideoFrame __stdcall MVRecalculate::GetFrame(int n, IScriptEnvironment* env)
       );
     }
 
-    //		PROFILE_CUMULATE ();
     if (outfile != NULL)
     {
       fwrite(
@@ -638,6 +669,22 @@ PVideoFrame __stdcall MVRecalculate::GetFrame(int n, IScriptEnvironment* env)
     }
   }
 
+  {
+    const MVAnalysisData &	ana_data =
+      (divideExtra) ? srd._analysis_data_divided : srd._analysis_data;
+    MVSceneStats::from_frame(pDstData - headerSize)->compute(
+      reinterpret_cast <const int *> (pDst),
+      ana_data.nLvCount, ana_data.nBlkX * ana_data.nBlkY
+    );
+    if (_packed_mode != 0)
+    {
+      MVPackedVectors::pack(
+        reinterpret_cast <int *> (pDstData), &raw_arr[0],
+        ana_data.nLvCount, _packed_mode == 2
+      );
+    }
+  }
+
   return dst;
 }
 
@@ -645,7 +692,8 @@ PVideoFrame __stdcall MVRecalculate::GetFrame(int n, IScriptEnvironment* env)
 
 void	MVRecalculate::load_src_frame(MVGroupOfFrames &gof, ::PVideoFrame &src, const MVAnalysisData &ana_data)
 {
-  PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
+  MVProfileScope prof_load(_prof_uptr.get(), MVPROF_SUPER_LOAD);
+
   const unsigned char *	pSrcY;
   const unsigned char *	pSrcU;
   const unsigned char *	pSrcV;
@@ -669,7 +717,6 @@ void	MVRecalculate::load_src_frame(MVGroupOfFrames &gof, ::PVideoFrame &src, con
     nSrcPitchY = src->GetPitch(PLANAR_Y);
     nSrcPitchUV = src->GetPitch(PLANAR_U);
   }
-  PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
 
   gof.Update(
     nModeYUV,
@@ -29,6 +29,7 @@
 #include "DCTFactory.h"
 #include "GroupOfPlanes.h"
 #include "MVAnalysisData.h"
+#include "profile.h"
 #include "yuy2planes.h"
 #include	"SharedPtr.h"
 
@@ -57,6 +58,10 @@ protected:
 
   SrcRefArray    _srd_arr;
 
+  /*! \brief Stage profiler, 0 if not enabled. Shared with _vectorfields_aptr */
+  std::unique_ptr <MVProfiler>
+                 _prof_uptr;
+
   /*! \brief Frames of blocks for which motion vectors will be computed */
   std::unique_ptr <GroupOfPlanes>
                  _vectorfields_aptr;	// Temporary data, structure initialised once.
@@ -133,6 +138,8 @@ protected:
     int  iPGlobal;
     int  iPZero;
 
+    int  _packed_mode; // 0: raw vector data, 1: MVPackedVectors, 2: MVPackedVectors, finest level only
+
     PClip super_cur;
 
 public :
@@ -145,7 +152,7 @@ public :
     int trad, bool mt_flag, int _chromaSADScale, int _optSearchOption, int _optPredictorType, int _DMFlags,
     int _AreaMode, int _AMDiffSAD, int _AMstep, int _AMoffset, 
     PClip _super_cur, float _fAMthVSMang, int _AMflags, int _AMavg,
-    bool _bglobal, int _pzero, int _pglobal,
+    bool _bglobal, int _pzero, int _pglobal, int packed_mode,
     IScriptEnvironment* env
   );
   ~MVRecalculate();
@@ -0,0 +1,111 @@
+// Finest level SAD statistics of a vector frame, stored in the frame header
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "MVSceneStats.h"
+#include "MVAnalysisData.h"
+#include <algorithm>
+#include <cstring>
+
+// SADs 0..7: one bin each, then 4 bins per octave (2 mantissa bits)
+int MVSceneStats::get_bin(sad_t sad)
+{
+  if (sad < NBR_EXACT)
+    return std::max(sad, 0);
+
+  uint32_t v = uint32_t(sad);
+  int e = 0; // index of the highest bit
+  if (v >= (1u << 16)) { v >>= 16; e += 16; }
+  if (v >= (1u << 8)) { v >>= 8; e += 8; }
+  if (v >= (1u << 4)) { v >>= 4; e += 4; }
+  if (v >= (1u << 2)) { v >>= 2; e += 2; }
+  if (v >= (1u << 1)) { e += 1; }
+
+  const int m = (uint32_t(sad) >> (e - 2)) & 3;
+  return NBR_EXACT + (e - 3) * 4 + m;
+}
+
+int64_t MVSceneStats::get_bin_end(int bin)
+{
+  if (bin < NBR_EXACT)
+    return bin + 1;
+
+  const int next = bin + 1 - NBR_EXACT;
+  const int e = next / 4 + 3;
+  const int m = next % 4;
+  return int64_t(4 + m) << (e - 2);
+}
+
+void MVSceneStats::compute(const int *pData, int nLvCount, int nBlkCount_)
+{
+  // same walk as FakeGroupOfPlanes::Update, the finest level comes last
+  const int *pA = pData + 2;
+  for (int i = nLvCount - 1; i > 0; i--)
+  {
+    pA += pA[0];
+  }
+  const VECTOR *pMVs = reinterpret_cast<const VECTOR *>(pA + 1);
+
+  memset(aCount, 0, sizeof(aCount));
+  for (int i = 0; i < nBlkCount_; i++)
+  {
+    aCount[get_bin(pMVs[i].sad)]++;
+  }
+
+  nBlkCount = nBlkCount_;
+  nKey = KEY;
+}
+
+int MVSceneStats::is_scene_change(sad_t nTh1, int nTh2) const
+{
+  if (nTh1 < 0)
+    return (nBlkCount > nTh2) ? 1 : 0;
+
+  const int bin = get_bin(nTh1);
+  int above = 0;
+  for (int i = bin + 1; i < NBR_BINS; i++)
+  {
+    above += aCount[i];
+  }
+
+  if (above > nTh2)
+    return 1;
+  // the whole bin is <= nTh1
+  if (bin < NBR_EXACT || get_bin_end(bin) - 1 == nTh1 || above + aCount[bin] <= nTh2)
+    return 0;
+
+  return -1;
+}
+
+int MVSceneStats::get_header_size()
+{
+  return int(sizeof(int) + sizeof(MVAnalysisData) + sizeof(MVSceneStats));
+}
+
+const MVSceneStats *MVSceneStats::from_frame(const unsigned char *pFrame)
+{
+  const int header_size = *reinterpret_cast<const int *>(pFrame);
+  if (header_size < get_header_size())
+    return 0;
+  return reinterpret_cast<const MVSceneStats *>(pFrame + sizeof(int) + sizeof(MVAnalysisData));
+}
+
+MVSceneStats *MVSceneStats::from_frame(unsigned char *pFrame)
+{
+  return const_cast<MVSceneStats *>(from_frame(const_cast<const unsigned char *>(pFrame)));
+}
@@ -0,0 +1,67 @@
+// Finest level SAD statistics of a vector frame, stored in the frame header
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef	__MV_SceneStats__
+#define	__MV_SceneStats__
+
+#include "types.h"
+#include "VECTOR.h"
+
+#pragma pack (push, 16)
+
+// Written by MAnalyse and MRecalculate right after MVAnalysisData:
+// headersize, MVAnalysisData, MVSceneStats, padding up to headersize.
+// The consumers answer IsSceneChange from the histogram instead of counting the
+// blocks over thSCD1 each, the SADs are counted only when thSCD1 falls in a bin
+// which makes the answer ambiguous.
+class MVSceneStats
+{
+public:
+  enum
+  {
+    KEY      = 0x5343, // 'SC'
+    NBR_EXACT = 8,     // SADs 0..7 have their own bin
+    NBR_BINS = NBR_EXACT + (31 - 3) * 4 // then 4 bins per octave up to 2^31
+  };
+
+  int nKey; // KEY when the histogram matches the vectors of the frame
+  int nBlkCount; // finest level block count
+  int aCount[NBR_BINS]; // number of blocks per SAD bin
+
+  // pData: vector data after the header, as read by FakeGroupOfPlanes::Update
+  void compute(const int *pData, int nLvCount, int nBlkCount_);
+  void invalidate() { nKey = 0; }
+  bool is_valid(int nBlkCount_) const { return nKey == KEY && nBlkCount == nBlkCount_; }
+
+  // 1: more than nTh2 blocks with SAD > nTh1, 0: not, -1: undecided, count the SADs
+  int is_scene_change(sad_t nTh1, int nTh2) const;
+
+  // stats of a vector frame, 0 if the header has no room for them (older producers)
+  static const MVSceneStats *from_frame(const unsigned char *pFrame);
+  static MVSceneStats *from_frame(unsigned char *pFrame);
+  static int get_header_size();
+
+private:
+  static int get_bin(sad_t sad);
+  static int64_t get_bin_end(int bin); // first SAD of the next bin
+};
+
+#pragma pack (pop)
+
+#endif	// __MV_SceneStats__
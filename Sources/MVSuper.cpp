@@ -32,13 +32,6 @@
 
 #include <cmath>
 
-// move profile init here from MVCore.cpp (it is not quite correct for several mvsuper)
-#ifdef MOTION_PROFILE
-int ProfTimeTable[MOTION_PROFILE_COUNT];
-int ProfResults[MOTION_PROFILE_COUNT * 2];
-int64_t ProfCumulatedResults[MOTION_PROFILE_COUNT * 2];
-#endif
-
 
 MVSuper::MVSuper(
   PClip _child, int _hPad, int _vPad, int _pel, int _levels, bool _chroma,
@@ -186,7 +179,7 @@ MVSuper::MVSuper(
 
   pSrcGOF->set_interp(nModeYUV, rfilter, sharp);
 
-  PROFILE_INIT();
+  _prof_uptr = MVProfiler::create("MSuper");
 }
 
 MVSuper::~MVSuper()
@@ -201,8 +194,6 @@ MVSuper::~MVSuper()
     }
   }
   delete pSrcGOF;
-
-  PROFILE_SHOW();
 }
 
 PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
@@ -216,6 +207,8 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
   int nSrcPelPitch[3];
   
   int planecount;
+
+  MVProfileScope prof_frame(_prof_uptr.get(), MVPROF_GETFRAME);
   
     //DebugPrintf("MSuper: Get src frame %d clip %d",n,child);
 
@@ -226,7 +219,7 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
 
   PVideoFrame dst = has_at_least_v8 ? env->NewVideoFrameP(vi, &src) : env->NewVideoFrame(vi); // frame property support
 
-  PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
+  MVProfileScope prof_convert(_prof_uptr.get(), MVPROF_PLANAR_CONVERT);
   if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2)
   {
     if (!planar)
@@ -308,9 +301,9 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
   }
   */
 
-  PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
+  prof_convert.stop();
 
-  PROFILE_START(MOTION_PROFILE_INTERPOLATION);
+  MVProfileScope prof_reduce(_prof_uptr.get(), MVPROF_SUPER_REDUCE);
 
   pSrcGOF->Update(YUVPLANES, pDst[0], nDstPitch[0], pDst[1], nDstPitch[1], pDst[2], nDstPitch[2]);
   // constant name is Y U and V but for MVFrame this is good for RGB
@@ -324,6 +317,10 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
   pSrcGOF->Reduce(nModeYUV);
   pSrcGOF->Pad(nModeYUV);
 
+  prof_reduce.stop();
+
+  MVProfileScope prof_refine(_prof_uptr.get(), MVPROF_SUPER_REFINE);
+
   if (usePelClip)
   {
     MVFrame *srcFrames = pSrcGOF->GetFrame(0);
@@ -347,11 +344,10 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
     if (pel_refine) pSrcGOF->Refine(nModeYUV); // skip refined planes generation if using searching and degraining with internal runtime subsample shifting
   }
 
-  PROFILE_STOP(MOTION_PROFILE_INTERPOLATION);
+  prof_refine.stop();
 
 
   /*
-    PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
 
     if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
     {
@@ -360,10 +356,7 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
       YUY2FromPlanes(pDstYUY2, nDstPitchYUY2, nSuperWidth, nSuperHeight,
         pDstY, nDstPitchY, pDstU, pDstV, nDstPitchUV, isse);
     }
-    PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
   */
 
-  PROFILE_CUMULATE();
-
   return dst;
 }
@@ -24,8 +24,11 @@
 #include "commonfunctions.h"
 #include "yuy2planes.h"
 #include	"avisynth.h"
+#include "profile.h"
 #include "stdint.h"
 
+#include <memory>
+
 
 MV_FORCEINLINE int PlaneHeightLuma(int src_height, int level, int yRatioUV, int vpad)
 {
@@ -129,6 +132,9 @@ protected:
   bool           _mt_flag; // PF maybe 2.6.0.5
   bool           pel_refine; // 2.7.46 - default true, generate subpel buffers for pel > 1 or not (not needed for DX12_ME and internal sub shifting in MDegrainN)
 
+  std::unique_ptr <MVProfiler>
+                 _prof_uptr; // 0 if profiling is not enabled
+
 public:
 
   MVSuper(
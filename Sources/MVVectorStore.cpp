@@ -0,0 +1,517 @@
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "MVVectorStore.h"
+
+#ifdef _WIN32
+#define NOGDI
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include "windows.h"
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+
+
+static bool	MVVectorStore_seek(FILE *f_ptr, int64_t pos)
+{
+#ifdef _WIN32
+  return _fseeki64(f_ptr, pos, SEEK_SET) == 0;
+#else
+  return fseeko(f_ptr, off_t(pos), SEEK_SET) == 0;
+#endif
+}
+
+
+
+static int64_t	MVVectorStore_get_size(FILE *f_ptr)
+{
+#ifdef _WIN32
+  return (_fseeki64(f_ptr, 0, SEEK_END) == 0) ? _ftelli64(f_ptr) : -1;
+#else
+  return (fseeko(f_ptr, 0, SEEK_END) == 0) ? int64_t(ftello(f_ptr)) : -1;
+#endif
+}
+
+
+
+// Same clip format and analysis, so the records of one file are valid for
+// the other. The MVAnalysisData fields are compared one by one, the struct
+// has padding.
+static bool	MVVectorStore_is_same_stream(const MVVectorStore::Header &a, const MVVectorStore::Header &b)
+{
+  const MVAnalysisData & ma = a.mad;
+  const MVAnalysisData & mb = b.mad;
+  return (
+       a.magic == b.magic && a.version == b.version && a.header_size == b.header_size
+    && a.nbr_frames == b.nbr_frames && a.nbr_deltas == b.nbr_deltas
+    && a.frame_size == b.frame_size && a.image_type == b.image_type
+    && a.fps_num == b.fps_num && a.fps_den == b.fps_den
+    && a.table_pos == b.table_pos && a.data_pos == b.data_pos
+    && ma.nMagicKey == mb.nMagicKey && ma.nVersion == mb.nVersion
+    && ma.nBlkSizeX == mb.nBlkSizeX && ma.nBlkSizeY == mb.nBlkSizeY
+    && ma.nPel == mb.nPel && ma.nLvCount == mb.nLvCount
+    && ma.nDeltaFrame == mb.nDeltaFrame && ma.isBackward == mb.isBackward
+    && ma.nFlags == mb.nFlags && ma.nWidth == mb.nWidth && ma.nHeight == mb.nHeight
+    && ma.nOverlapX == mb.nOverlapX && ma.nOverlapY == mb.nOverlapY
+    && ma.nBlkX == mb.nBlkX && ma.nBlkY == mb.nBlkY && ma.pixelType == mb.pixelType
+    && ma.yRatioUV == mb.yRatioUV && ma.xRatioUV == mb.xRatioUV
+    && ma.chromaSADScale == mb.chromaSADScale
+    && ma.pixelsize == mb.pixelsize && ma.bits_per_pixel == mb.bits_per_pixel
+    && ma.nHPadding == mb.nHPadding && ma.nVPadding == mb.nVPadding
+    && ma.nTrad == mb.nTrad
+  );
+}
+
+
+
+// Drops everything after pos, including the data still buffered by stdio,
+// and moves the write position there.
+static bool	MVVectorStore_truncate(FILE *f_ptr, int64_t pos)
+{
+  fflush(f_ptr); // may fail again, the data is dropped anyway
+#ifdef _WIN32
+  const bool     ok_flag = _chsize_s(_fileno(f_ptr), pos) == 0;
+#else
+  const bool     ok_flag = ftruncate(fileno(f_ptr), off_t(pos)) == 0;
+#endif
+  clearerr(f_ptr);
+  return MVVectorStore_seek(f_ptr, pos) && ok_flag;
+}
+
+
+
+MVVectorStoreWriter::MVVectorStoreWriter()
+  : _mutex()
+  , _f_ptr(0)
+  , _header()
+  , _table()
+  , _end_pos(0)
+  , _rec_buf()
+{
+}
+
+
+
+MVVectorStoreWriter::~MVVectorStoreWriter()
+{
+  close();
+}
+
+
+
+bool	MVVectorStoreWriter::create(const char *filename_0, const MVVectorStore::Header &header, std::string &err_msg)
+{
+  assert(filename_0 != 0);
+  assert(header.nbr_frames > 0);
+  assert(header.frame_size > 0);
+
+  close();
+
+  _header             = header;
+  _header.magic       = MVVectorStore::MAGIC;
+  _header.version     = MVVectorStore::VERSION;
+  _header.header_size = int32_t(sizeof(_header));
+  _header.flags       = 0;
+  _header.table_pos   = MVVectorStore::align(sizeof(_header));
+  _header.data_pos    = MVVectorStore::align(
+    _header.table_pos + int64_t(sizeof(int64_t)) * _header.nbr_frames
+  );
+  _table.assign(_header.nbr_frames, 0);
+  _end_pos = _header.data_pos;
+
+  const int64_t rec_len = MVVectorStore::align(
+    sizeof(MVVectorStore::RecordHeader) + _header.frame_size
+  );
+  _rec_buf.assign(size_t(rec_len), 0);
+
+  _f_ptr = fopen(filename_0, "r+b");
+  if (_f_ptr != 0)
+  {
+    return resume(err_msg);
+  }
+
+  _f_ptr = fopen(filename_0, "wb");
+  if (_f_ptr == 0)
+  {
+    err_msg = "cannot create the file";
+    return false;
+  }
+
+  // Header with the complete flag cleared and an empty table. Both are
+  // rewritten by close().
+  std::vector <uint8_t> zero_buf(size_t(_header.data_pos), 0);
+  memcpy(&zero_buf[0], &_header, sizeof(_header));
+  if (fwrite(&zero_buf[0], zero_buf.size(), 1, _f_ptr) != 1
+    || fflush(_f_ptr) != 0)
+  {
+    fclose(_f_ptr);
+    _f_ptr = 0;
+    err_msg = "write error";
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// The table is rebuilt from the record headers, complete file or not, like
+// the reader does for an aborted render. A partial record at the end is
+// dropped. The complete flag is cleared until the next close().
+bool	MVVectorStoreWriter::resume(std::string &err_msg)
+{
+  assert(_f_ptr != 0);
+
+  MVVectorStore::Header old_header;
+  const int64_t  file_size = MVVectorStore_get_size(_f_ptr);
+  if (file_size < int64_t(sizeof(old_header))
+    || ! MVVectorStore_seek(_f_ptr, 0)
+    || fread(&old_header, sizeof(old_header), 1, _f_ptr) != 1
+    || old_header.magic != MVVectorStore::MAGIC)
+  {
+    err_msg = "the file exists and is not a vector file, it is not overwritten";
+  }
+  else if (! MVVectorStore_is_same_stream(old_header, _header))
+  {
+    err_msg = "the file exists and holds the vectors of another clip or analysis, it is not overwritten";
+  }
+  if (! err_msg.empty())
+  {
+    fclose(_f_ptr);
+    _f_ptr = 0;
+    return false;
+  }
+
+  const int64_t  rec_len = int64_t(_rec_buf.size());
+  for (int64_t pos = _header.data_pos; pos + rec_len <= file_size; pos += rec_len)
+  {
+    MVVectorStore::RecordHeader rec;
+    if (! MVVectorStore_seek(_f_ptr, pos)
+      || fread(&rec, sizeof(rec), 1, _f_ptr) != 1
+      || rec.size != _header.frame_size
+      || rec.frame < 0 || rec.frame >= _header.nbr_frames
+      || _table[rec.frame] != 0)
+    {
+      break;
+    }
+    _table[rec.frame] = pos;
+    _end_pos = pos + rec_len;
+  }
+
+  if (! MVVectorStore_truncate(_f_ptr, _end_pos)
+    || ! MVVectorStore_seek(_f_ptr, 0)
+    || fwrite(&_header, sizeof(_header), 1, _f_ptr) != 1
+    || ! MVVectorStore_seek(_f_ptr, _end_pos)
+    || fflush(_f_ptr) != 0)
+  {
+    fclose(_f_ptr);
+    _f_ptr = 0;
+    err_msg = "write error";
+    return false;
+  }
+
+  return true;
+}
+
+
+
+bool	MVVectorStoreWriter::write_frame(int n, const uint8_t *data_ptr, int pitch, int row_size)
+{
+  assert(data_ptr != 0);
+  assert(row_size > 0);
+
+  std::lock_guard <std::mutex> lock(_mutex);
+
+  if (_f_ptr == 0 || n < 0 || n >= _header.nbr_frames)
+  {
+    return false;
+  }
+  if (_table[n] != 0)
+  {
+    return true;
+  }
+
+  MVVectorStore::RecordHeader rec;
+  rec.frame = n;
+  rec.size  = _header.frame_size;
+  memcpy(&_rec_buf[0], &rec, sizeof(rec));
+
+  // Multi-line vector clips have pitch == row_size, but the frame may
+  // still be padded when it fits on a single line.
+  uint8_t *      dst_ptr = &_rec_buf[sizeof(rec)];
+  int            remaining = _header.frame_size;
+  while (remaining > 0)
+  {
+    const int      len = std::min(remaining, row_size);
+    memcpy(dst_ptr, data_ptr, len);
+    dst_ptr   += len;
+    data_ptr  += pitch;
+    remaining -= len;
+  }
+
+  // Flushed record by record, so _end_pos is always the end of the data
+  // actually written.
+  if (fwrite(&_rec_buf[0], _rec_buf.size(), 1, _f_ptr) != 1
+    || fflush(_f_ptr) != 0)
+  {
+    // A partial record would be taken for a valid one when the table is
+    // rebuilt: the file is cut back to the last complete record. If this
+    // fails too, the file cannot be trusted any more and is closed.
+    if (!MVVectorStore_truncate(_f_ptr, _end_pos))
+    {
+      fclose(_f_ptr);
+      _f_ptr = 0;
+    }
+    return false;
+  }
+  _table[n] = _end_pos;
+  _end_pos += int64_t(_rec_buf.size());
+
+  return true;
+}
+
+
+
+void	MVVectorStoreWriter::close()
+{
+  std::lock_guard <std::mutex> lock(_mutex);
+
+  if (_f_ptr == 0)
+  {
+    return;
+  }
+
+  _header.flags |= MVVectorStore::Flag_COMPLETE;
+  bool           ok_flag = MVVectorStore_seek(_f_ptr, _header.table_pos);
+  ok_flag = ok_flag && fwrite(&_table[0], sizeof(_table[0]) * _table.size(), 1, _f_ptr) == 1;
+  ok_flag = ok_flag && fflush(_f_ptr) == 0;
+  // Header last: the flag is set only if the table is entirely written
+  ok_flag = ok_flag && MVVectorStore_seek(_f_ptr, 0);
+  ok_flag = ok_flag && fwrite(&_header, sizeof(_header), 1, _f_ptr) == 1;
+  (void)ok_flag;
+
+  fclose(_f_ptr);
+  _f_ptr = 0;
+  _table.clear();
+  _rec_buf.clear();
+}
+
+
+
+MVVectorStoreReader::MVVectorStoreReader()
+  : _base_ptr(0)
+  , _file_size(0)
+  , _header_ptr(0)
+  , _table_ptr(0)
+  , _table_rebuilt()
+#ifdef _WIN32
+  , _file_hnd(INVALID_HANDLE_VALUE)
+  , _map_hnd(0)
+#endif
+{
+}
+
+
+
+MVVectorStoreReader::~MVVectorStoreReader()
+{
+  unmap();
+}
+
+
+
+bool	MVVectorStoreReader::open(const char *filename_0, std::string &err_msg)
+{
+  assert(filename_0 != 0);
+
+  unmap();
+
+#ifdef _WIN32
+  _file_hnd = ::CreateFileA(
+    filename_0, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, 0
+  );
+  if (_file_hnd == INVALID_HANDLE_VALUE)
+  {
+    err_msg = "cannot open the file";
+    return false;
+  }
+  LARGE_INTEGER  size;
+  if (! ::GetFileSizeEx(_file_hnd, &size) || size.QuadPart < int64_t(sizeof(MVVectorStore::Header)))
+  {
+    unmap();
+    err_msg = "file too small";
+    return false;
+  }
+  _file_size = size.QuadPart;
+  _map_hnd = ::CreateFileMappingA(_file_hnd, 0, PAGE_READONLY, 0, 0, 0);
+  if (_map_hnd != 0)
+  {
+    _base_ptr = static_cast <const uint8_t *> (
+      ::MapViewOfFile(_map_hnd, FILE_MAP_READ, 0, 0, 0)
+    );
+  }
+#else
+  const int      fd = ::open(filename_0, O_RDONLY);
+  if (fd < 0)
+  {
+    err_msg = "cannot open the file";
+    return false;
+  }
+  struct stat    st;
+  if (fstat(fd, &st) != 0 || int64_t(st.st_size) < int64_t(sizeof(MVVectorStore::Header)))
+  {
+    ::close(fd);
+    err_msg = "file too small";
+    return false;
+  }
+  _file_size = int64_t(st.st_size);
+  void *         map_ptr = mmap(0, size_t(_file_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map_ptr != MAP_FAILED)
+  {
+    _base_ptr = static_cast <const uint8_t *> (map_ptr);
+  }
+#endif
+  if (_base_ptr == 0)
+  {
+    unmap();
+    err_msg = "cannot map the file in memory";
+    return false;
+  }
+
+  _header_ptr = reinterpret_cast <const MVVectorStore::Header *> (_base_ptr);
+  const MVVectorStore::Header & h = *_header_ptr;
+  if (h.magic != MVVectorStore::MAGIC)
+  {
+    err_msg = "not a vector file";
+  }
+  else if (h.version != MVVectorStore::VERSION || h.header_size != int32_t(sizeof(h)))
+  {
+    err_msg = "unsupported version of the vector file";
+  }
+  else if (h.mad.GetMagicKey() != MVAnalysisData::MOTION_MAGIC_KEY
+    || h.mad.nVersion != MVAnalysisData::VERSION)
+  {
+    err_msg = "incompatible version of the vector stream";
+  }
+  else if (h.nbr_frames <= 0 || h.nbr_deltas <= 0 || h.frame_size <= 0
+    || h.table_pos < int64_t(sizeof(h))
+    || h.data_pos < h.table_pos + int64_t(sizeof(int64_t)) * h.nbr_frames
+    || h.data_pos > _file_size)
+  {
+    err_msg = "corrupted header";
+  }
+  if (! err_msg.empty())
+  {
+    unmap();
+    return false;
+  }
+
+  if ((h.flags & MVVectorStore::Flag_COMPLETE) != 0)
+  {
+    _table_ptr = reinterpret_cast <const int64_t *> (_base_ptr + h.table_pos);
+  }
+  else
+  {
+    // Aborted render: recovers the records written so far
+    _table_rebuilt.assign(h.nbr_frames, 0);
+    const int64_t  rec_len =
+      MVVectorStore::align(sizeof(MVVectorStore::RecordHeader) + h.frame_size);
+    for (int64_t pos = h.data_pos; pos + rec_len <= _file_size; pos += rec_len)
+    {
+      const MVVectorStore::RecordHeader & rec =
+        *reinterpret_cast <const MVVectorStore::RecordHeader *> (_base_ptr + pos);
+      if (rec.size != h.frame_size || rec.frame < 0 || rec.frame >= h.nbr_frames)
+      {
+        break;
+      }
+      _table_rebuilt[rec.frame] = pos;
+    }
+    _table_ptr = &_table_rebuilt[0];
+  }
+
+  return true;
+}
+
+
+
+const uint8_t*	MVVectorStoreReader::use_frame(int n) const
+{
+  assert(_base_ptr != 0);
+
+  if (n < 0 || n >= _header_ptr->nbr_frames)
+  {
+    return 0;
+  }
+  const int64_t  pos = _table_ptr[n];
+  if (pos < _header_ptr->data_pos
+    || pos + int64_t(sizeof(MVVectorStore::RecordHeader)) + _header_ptr->frame_size > _file_size)
+  {
+    return 0;
+  }
+  const MVVectorStore::RecordHeader & rec =
+    *reinterpret_cast <const MVVectorStore::RecordHeader *> (_base_ptr + pos);
+  if (rec.frame != n || rec.size != _header_ptr->frame_size)
+  {
+    return 0;
+  }
+
+  return _base_ptr + pos + sizeof(rec);
+}
+
+
+
+void	MVVectorStoreReader::unmap()
+{
+#ifdef _WIN32
+  if (_base_ptr != 0)
+  {
+    ::UnmapViewOfFile(_base_ptr);
+  }
+  if (_map_hnd != 0)
+  {
+    ::CloseHandle(_map_hnd);
+    _map_hnd = 0;
+  }
+  if (_file_hnd != INVALID_HANDLE_VALUE)
+  {
+    ::CloseHandle(_file_hnd);
+    _file_hnd = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (_base_ptr != 0)
+  {
+    munmap(const_cast <uint8_t *> (_base_ptr), size_t(_file_size));
+  }
+#endif
+  _base_ptr   = 0;
+  _file_size  = 0;
+  _header_ptr = 0;
+  _table_ptr  = 0;
+  _table_rebuilt.clear();
+}
@@ -0,0 +1,183 @@
+// Indexed motion vector store file, written by MAnalyse (vectorfile) and
+// read back through a memory mapping by MLoadVectors
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+
+#ifndef	__MV_MVVectorStore__
+#define	__MV_MVVectorStore__
+
+// File layout, native endianness, positions are in bytes from the file start:
+//   MVVectorStore::Header  clip format and the MVAnalysisData published by
+//                          the MAnalyse instance
+//   int64_t [nbr_frames]   offset table, one entry per vector clip frame,
+//                          0 if the frame is not stored. In multi mode, frame
+//                          n * nbr_deltas + k is the delta index k of source
+//                          frame n, like the MAnalyse output.
+//   records                appended in computing order, ALIGN-aligned:
+//                          RecordHeader, then the vector clip frame content
+//                          (header size, MVAnalysisData of the delta, vectors
+//                          of all the levels) as MAnalyse outputs it.
+// The table and the Flag_COMPLETE flag are written when the writer is closed.
+// For an incomplete file (render aborted), the reader rebuilds the table from
+// the record headers.
+// A writer opening an existing file for the same clip and analysis resumes
+// it: the stored records are kept and only the missing frames are appended.
+
+#include "MVAnalysisData.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+
+class MVVectorStore
+{
+public:
+
+  enum
+  {
+    MAGIC   = 0x5356564D, // 'MVVS'
+    VERSION = 1,
+    ALIGN   = 64
+  };
+
+  enum
+  {
+    Flag_COMPLETE = 1 << 0
+  };
+
+  class Header
+  {
+  public:
+    int32_t        magic;
+    int32_t        version;
+    int32_t        header_size;  // sizeof (Header), checks the struct layout
+    int32_t        flags;
+    int32_t        nbr_frames;   // vector clip frames
+    int32_t        nbr_deltas;   // vector clip frames per source frame
+    int32_t        frame_size;   // bytes of vector clip data per frame
+    int32_t        image_type;   // VideoInfo::image_type
+    uint32_t       fps_num;
+    uint32_t       fps_den;
+    int64_t        table_pos;
+    int64_t        data_pos;
+    MVAnalysisData mad;
+  };
+
+  class RecordHeader
+  {
+  public:
+    int32_t        frame;
+    int32_t        size;         // bytes, equal to Header::frame_size
+  };
+
+  static inline int64_t
+                 align(int64_t pos)
+  {
+    return (pos + (ALIGN - 1)) & ~int64_t(ALIGN - 1);
+  }
+};
+
+
+
+class MVVectorStoreWriter
+{
+public:
+
+                 MVVectorStoreWriter();
+                 ~MVVectorStoreWriter();
+
+  // header: fields other than magic, version, header_size, flags, table_pos
+  // and data_pos must be set. An existing file is resumed if its header
+  // matches, and left untouched otherwise.
+  // On failure, returns false and sets err_msg
+  bool           create(const char *filename_0, const MVVectorStore::Header &header, std::string &err_msg);
+
+  // Frame data is the vector clip frame content, frame_size bytes in rows of
+  // row_size bytes. Frames already stored are skipped. Thread-safe.
+  // Returns false on a write error, the file then ends with the previous
+  // complete record (or is closed if it cannot be cut back).
+  bool           write_frame(int n, const uint8_t *data_ptr, int pitch, int row_size);
+
+  void           close();
+
+private:
+
+  bool           resume(std::string &err_msg);
+
+  std::mutex     _mutex;
+  FILE *         _f_ptr;
+  MVVectorStore::Header
+                 _header;
+  std::vector <int64_t>
+                 _table;
+  int64_t        _end_pos;
+  std::vector <uint8_t>
+                 _rec_buf;     // a whole record, written at once
+
+                 MVVectorStoreWriter(const MVVectorStoreWriter &other) = delete;
+  MVVectorStoreWriter &
+                 operator = (const MVVectorStoreWriter &other) = delete;
+};
+
+
+
+class MVVectorStoreReader
+{
+public:
+
+                 MVVectorStoreReader();
+                 ~MVVectorStoreReader();
+
+  // On failure, returns false and sets err_msg
+  bool           open(const char *filename_0, std::string &err_msg);
+
+  const MVVectorStore::Header &
+                 get_header() const { return *_header_ptr; }
+
+  // Returns the mapped frame content, or 0 if the frame is not stored
+  const uint8_t* use_frame(int n) const;
+
+private:
+
+  void           unmap();
+
+  const uint8_t* _base_ptr;
+  int64_t        _file_size;
+  const MVVectorStore::Header *
+                 _header_ptr;
+  const int64_t* _table_ptr;    // in the mapping or in _table_rebuilt
+  std::vector <int64_t>
+                 _table_rebuilt;
+#ifdef _WIN32
+  void *         _file_hnd;
+  void *         _map_hnd;
+#endif
+
+                 MVVectorStoreReader(const MVVectorStoreReader &other) = delete;
+  MVVectorStoreReader &
+                 operator = (const MVVectorStoreReader &other) = delete;
+};
+
+
+
+#endif	// __MV_MVVectorStore__
@@ -20,6 +20,7 @@
 
 
 #include "MaskFun.h"
+#include "MaskFun_avx2.h"
 #include <emmintrin.h>
 #include <cassert>
 
@@ -787,36 +788,68 @@ template void Blend<uint8_t>(uint8_t * pdst8, const uint8_t * psrc8, const uint8
 template void Blend<uint16_t>(uint8_t * pdst8, const uint8_t * psrc8, const uint8_t * pref8, int height, int width, int dst_pitch, int src_pitch, int ref_pitch, int time256, int cpuFlags);
 template void Blend<float>(uint8_t * pdst8, const uint8_t * psrc8, const uint8_t * pref8, int height, int width, int dst_pitch, int src_pitch, int ref_pitch, int time256, int cpuFlags);
 
+static int flow_npel_log2(int nPel)
+{
+  return (nPel == 4) ? 2 : (nPel == 2) ? 1 : 0;
+}
+
+// The AVX2 versions process the mod8 part of the rows, the C versions the remaining columns.
 template<typename pixel_t>
-void FlowInter(
+static void FlowInter_dispatch(FlowInterFunction *func, FlowInterFunction *func_avx2,
   uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256, int nPel)
+  int VPitch, int width, int height, int time256, int nPel, int cpuFlags)
 {
-  if (nPel == 1)
+  const int width8 = ((cpuFlags & CPUF_AVX2) != 0) ? (width & ~7) : 0;
+  if (width8 > 0)
   {
-    FlowInter_NPel <pixel_t, 0>(
+    func_avx2(
       pdst, dst_pitch, prefB, prefF, ref_pitch,
       VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-      VPitch, width, height, time256
+      VPitch, width8, height, time256
       );
   }
-  else if (nPel == 2)
+  if (width8 < width)
   {
-    FlowInter_NPel <pixel_t, 1>(
-      pdst, dst_pitch, prefB, prefF, ref_pitch,
-      VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-      VPitch, width, height, time256
+    const int ref_offset = (width8 << flow_npel_log2(nPel)) * sizeof(pixel_t);
+    func(
+      pdst + width8 * sizeof(pixel_t), dst_pitch, prefB + ref_offset, prefF + ref_offset, ref_pitch,
+      VXFullB + width8, VXFullF + width8, VYFullB + width8, VYFullF + width8, MaskB + width8, MaskF + width8,
+      VPitch, width - width8, height, time256
       );
   }
+}
+
+template<typename pixel_t>
+void FlowInter(
+  uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256, int nPel, int cpuFlags)
+{
+  FlowInterFunction *func;
+  FlowInterFunction *func_avx2;
+  if (nPel == 1)
+  {
+    func = FlowInter_NPel <pixel_t, 0>;
+    func_avx2 = FlowInter_NPel_avx2 <pixel_t, 0>;
+  }
+  else if (nPel == 2)
+  {
+    func = FlowInter_NPel <pixel_t, 1>;
+    func_avx2 = FlowInter_NPel_avx2 <pixel_t, 1>;
+  }
   else if (nPel == 4)
   {
-    FlowInter_NPel <pixel_t, 2>(
-      pdst, dst_pitch, prefB, prefF, ref_pitch,
-      VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-      VPitch, width, height, time256
-      );
+    func = FlowInter_NPel <pixel_t, 2>;
+    func_avx2 = FlowInter_NPel_avx2 <pixel_t, 2>;
   }
+  else
+    return;
+
+  FlowInter_dispatch<pixel_t>(func, func_avx2,
+    pdst, dst_pitch, prefB, prefF, ref_pitch,
+    VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
+    VPitch, width, height, time256, nPel, cpuFlags);
 }
 
 template<typename pixel_t>
@@ -824,101 +857,115 @@ void FlowInterExtra(
   uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
   int VPitch, int width, int height, int time256, int nPel,
-  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF)
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF, int cpuFlags)
 {
+  FlowInterExtraFunction *func;
+  FlowInterExtraFunction *func_avx2;
   if (nPel == 1)
   {
-    FlowInterExtra_NPel <pixel_t, 0>(
-      pdst, dst_pitch, prefB, prefF, ref_pitch,
-      VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-      VPitch, width, height, time256,
-      VXFullBB, VXFullFF, VYFullBB, VYFullFF
-      );
+    func = FlowInterExtra_NPel <pixel_t, 0>;
+    func_avx2 = FlowInterExtra_NPel_avx2 <pixel_t, 0>;
   }
   else if (nPel == 2)
   {
-    FlowInterExtra_NPel <pixel_t, 1>(
-      pdst, dst_pitch, prefB, prefF, ref_pitch,
-      VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-      VPitch, width, height, time256,
-      VXFullBB, VXFullFF, VYFullBB, VYFullFF
-      );
+    func = FlowInterExtra_NPel <pixel_t, 1>;
+    func_avx2 = FlowInterExtra_NPel_avx2 <pixel_t, 1>;
   }
   else if (nPel == 4)
   {
-    FlowInterExtra_NPel <pixel_t, 2>(
+    func = FlowInterExtra_NPel <pixel_t, 2>;
+    func_avx2 = FlowInterExtra_NPel_avx2 <pixel_t, 2>;
+  }
+  else
+    return;
+
+  const int width8 = ((cpuFlags & CPUF_AVX2) != 0) ? (width & ~7) : 0;
+  if (width8 > 0)
+  {
+    func_avx2(
       pdst, dst_pitch, prefB, prefF, ref_pitch,
       VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-      VPitch, width, height, time256,
+      VPitch, width8, height, time256,
       VXFullBB, VXFullFF, VYFullBB, VYFullFF
       );
   }
+  if (width8 < width)
+  {
+    const int ref_offset = (width8 << flow_npel_log2(nPel)) * sizeof(pixel_t);
+    func(
+      pdst + width8 * sizeof(pixel_t), dst_pitch, prefB + ref_offset, prefF + ref_offset, ref_pitch,
+      VXFullB + width8, VXFullF + width8, VYFullB + width8, VYFullF + width8, MaskB + width8, MaskF + width8,
+      VPitch, width - width8, height, time256,
+      VXFullBB + width8, VXFullFF + width8, VYFullBB + width8, VYFullFF + width8
+      );
+  }
 }
 
 template<typename pixel_t>
 void FlowInterSimple(
   uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256, int nPel)
+  int VPitch, int width, int height, int time256, int nPel, int cpuFlags)
 {
+  FlowInterFunction *func;
+  FlowInterFunction *func_avx2;
   if (nPel == 1)
   {
-    FlowInterSimple_Pel1<pixel_t>(
-      pdst, dst_pitch, prefB, prefF, ref_pitch,
-      VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-      VPitch, width, height, time256
-      );
+    // the paired pel1 version starts the C part on an even column, mod8 keeps it
+    func = FlowInterSimple_Pel1<pixel_t>;
+    func_avx2 = FlowInterSimple_Pel1_avx2<pixel_t>;
   }
   else if (nPel == 2)
   {
-    FlowInterSimple_NPel <pixel_t, 1>(
-      pdst, dst_pitch, prefB, prefF, ref_pitch,
-      VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-      VPitch, width, height, time256
-      );
+    func = FlowInterSimple_NPel <pixel_t, 1>;
+    func_avx2 = FlowInterSimple_NPel_avx2 <pixel_t, 1>;
   }
   else if (nPel == 4)
   {
-    FlowInterSimple_NPel <pixel_t, 2>(
-      pdst, dst_pitch, prefB, prefF, ref_pitch,
-      VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-      VPitch, width, height, time256
-      );
+    func = FlowInterSimple_NPel <pixel_t, 2>;
+    func_avx2 = FlowInterSimple_NPel_avx2 <pixel_t, 2>;
   }
+  else
+    return;
+
+  FlowInter_dispatch<pixel_t>(func, func_avx2,
+    pdst, dst_pitch, prefB, prefF, ref_pitch,
+    VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
+    VPitch, width, height, time256, nPel, cpuFlags);
 }
 
 // instantiate
 template void FlowInterSimple<uint8_t>(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256, int nPel );
+  int VPitch, int width, int height, int time256, int nPel, int cpuFlags);
 template void FlowInterSimple<uint16_t>(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256, int nPel );
+  int VPitch, int width, int height, int time256, int nPel, int cpuFlags);
 template void FlowInterSimple<float>(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256, int nPel);
+  int VPitch, int width, int height, int time256, int nPel, int cpuFlags);
 
 template void FlowInter<uint8_t>(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256, int nPel );
+  int VPitch, int width, int height, int time256, int nPel, int cpuFlags);
 template void FlowInter<uint16_t>(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256, int nPel );
+  int VPitch, int width, int height, int time256, int nPel, int cpuFlags);
 template void FlowInter<float>(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256, int nPel);
+  int VPitch, int width, int height, int time256, int nPel, int cpuFlags);
 
 template void FlowInterExtra<uint8_t>(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
   int VPitch, int width, int height, int time256, int nPel,
-  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF);
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF, int cpuFlags);
 template void FlowInterExtra<uint16_t>(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
   int VPitch, int width, int height, int time256, int nPel,
-  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF);
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF, int cpuFlags);
 template void FlowInterExtra<float>(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
   int VPitch, int width, int height, int time256, int nPel,
-  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF);
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF, int cpuFlags);
 
 
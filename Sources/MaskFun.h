@@ -83,20 +83,20 @@ void Create_LUTV(int time256, short *LUTVB, short *LUTVF);
 template<typename pixel_t>
   void FlowInterSimple(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256 /*T256P &t256_provider*/, int nPel );
+  int VPitch, int width, int height, int time256 /*T256P &t256_provider*/, int nPel, int cpuFlags);
 
 //template <class T256P>
 template<typename pixel_t>
   void FlowInter(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-  int VPitch, int width, int height, int time256 /*T256P &t256_provider*/, int nPel );
+  int VPitch, int width, int height, int time256 /*T256P &t256_provider*/, int nPel, int cpuFlags);
 
 //template <class T256P>
 template<typename pixel_t>
   void FlowInterExtra(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
   int VPitch, int width, int height, int time256 /*T256P &t256_provider*/, int nPel,
-  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF);
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF, int cpuFlags);
 /* in 2 5.11.22 
 void FlowInterSimple(BYTE * pdst, int dst_pitch, const BYTE *prefB, const BYTE *prefF, int ref_pitch,
   short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, BYTE *MaskB, BYTE *MaskF,
@@ -0,0 +1,471 @@
+// Per-pixel flow interpolation kernels, AVX2
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#if defined (__GNUC__) && ! defined (__INTEL_COMPILER) && ! defined(__INTEL_LLVM_COMPILER)
+#include <x86intrin.h>
+// x86intrin.h includes header files for whatever instruction
+// sets are specified on the compiler command line, such as: xopintrin.h, fma4intrin.h
+#else
+#include <immintrin.h> // MS version of immintrin.h covers AVX, AVX2 and FMA3
+#endif // __GNUC__
+
+#include "MaskFun_avx2.h"
+
+#include "def.h"
+
+// The integer formulas are the ones of MaskFun.hpp on 32 bit lanes. For 16 bit pixels
+// some products need 32 unsigned bits (int64 in the C version), they are all
+// positive so a logical right shift gives the same result.
+
+static MV_FORCEINLINE __m256i load_vec8(const short *p)
+{
+  return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+static MV_FORCEINLINE __m256i load_mask8(const uint8_t *p)
+{
+  return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+}
+
+static MV_FORCEINLINE __m256 mask_to_float8(__m256i m)
+{
+  return _mm256_mul_ps(_mm256_cvtepi32_ps(m), _mm256_set1_ps(1.0f / 255.0f));
+}
+
+// (v * t) >> 8
+static MV_FORCEINLINE __m256i scale_vec8(__m256i v, __m256i t)
+{
+  return _mm256_srai_epi32(_mm256_mullo_epi32(v, t), 8);
+}
+
+// vy * pitch + vx + pos
+static MV_FORCEINLINE __m256i pixel_index8(__m256i vx, __m256i vy, __m256i pitch, __m256i pos)
+{
+  return _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(vy, pitch), vx), pos);
+}
+
+// int32 lanes for 8 and 16 bit, float lanes for float
+template<typename pixel_t>
+static MV_FORCEINLINE auto gather_pixels8(const pixel_t *p, __m256i idx)
+{
+  if constexpr (sizeof(pixel_t) == 1)
+    return _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int *>(p), idx, 1), _mm256_set1_epi32(0xFF));
+  else if constexpr (sizeof(pixel_t) == 2)
+    return _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int *>(p), idx, 2), _mm256_set1_epi32(0xFFFF));
+  else
+    return _mm256_i32gather_ps(p, idx, 4);
+}
+
+// int32 lanes, already in the pixel range
+template<typename pixel_t>
+static MV_FORCEINLINE void store_pixels8(pixel_t *p, __m256i v)
+{
+  const __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  if constexpr (sizeof(pixel_t) == 1)
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(w, w));
+  else
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), w);
+}
+
+// (x * (255 - m) + y * m + 255) >> 8
+static MV_FORCEINLINE __m256i mask_blend8(__m256i x, __m256i y, __m256i m)
+{
+  const __m256i c255 = _mm256_set1_epi32(255);
+  const __m256i sum = _mm256_add_epi32(_mm256_mullo_epi32(x, _mm256_sub_epi32(c255, m)), _mm256_mullo_epi32(y, m));
+  return _mm256_srli_epi32(_mm256_add_epi32(sum, c255), 8);
+}
+
+// (a * (256 - time256) + b * time256) >> 8
+static MV_FORCEINLINE __m256i time_blend8(__m256i a, __m256i b, __m256i t_inv, __m256i t)
+{
+  return _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(a, t_inv), _mm256_mullo_epi32(b, t)), 8);
+}
+
+template <typename pixel_t, int NPELL2>
+void FlowInter_NPel_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256)
+{
+  dst_pitch /= sizeof(pixel_t);
+  ref_pitch /= sizeof(pixel_t);
+  pixel_t *pdst = reinterpret_cast<pixel_t *>(pdst8);
+  const pixel_t *prefB = reinterpret_cast<const pixel_t *>(prefB8);
+  const pixel_t *prefF = reinterpret_cast<const pixel_t *>(prefF8);
+
+  const __m256i t = _mm256_set1_epi32(time256);
+  const __m256i t_inv = _mm256_set1_epi32(256 - time256);
+  const __m256i pitch = _mm256_set1_epi32(ref_pitch);
+  const __m256i lanes = _mm256_slli_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), NPELL2);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 time256_f = _mm256_set1_ps(time256 / 256.0f);
+  const __m256 time256_inv_f = _mm256_sub_ps(one, time256_f);
+
+  for (int h = 0; h < height; h++)
+  {
+    for (int w = 0; w < width; w += 8)
+    {
+      const __m256i pos = _mm256_add_epi32(lanes, _mm256_set1_epi32(w << NPELL2));
+      const __m256i idxF = pixel_index8(scale_vec8(load_vec8(VXFullF + w), t), scale_vec8(load_vec8(VYFullF + w), t), pitch, pos);
+      const __m256i idxB = pixel_index8(scale_vec8(load_vec8(VXFullB + w), t_inv), scale_vec8(load_vec8(VYFullB + w), t_inv), pitch, pos);
+      const auto dstF = gather_pixels8(prefF, idxF);
+      const auto dstF0 = gather_pixels8(prefF, pos); // zero
+      const auto dstB = gather_pixels8(prefB, idxB);
+      const auto dstB0 = gather_pixels8(prefB, pos); // zero
+      const __m256i mF = load_mask8(MaskF + w);
+      const __m256i mB = load_mask8(MaskB + w);
+
+      if constexpr (sizeof(pixel_t) == 4) {
+        const __m256 MaskF_f = mask_to_float8(mF);
+        const __m256 MaskB_f = mask_to_float8(mB);
+        const __m256 MaskF_inv_f = _mm256_sub_ps(one, MaskF_f);
+        const __m256 MaskB_inv_f = _mm256_sub_ps(one, MaskB_f);
+        const __m256 a = _mm256_add_ps(_mm256_mul_ps(dstF, MaskF_inv_f),
+          _mm256_mul_ps(MaskF_f, _mm256_add_ps(_mm256_mul_ps(dstB, MaskB_inv_f), _mm256_mul_ps(MaskB_f, dstF0))));
+        const __m256 b = _mm256_add_ps(_mm256_mul_ps(dstB, MaskB_inv_f),
+          _mm256_mul_ps(MaskB_f, _mm256_add_ps(_mm256_mul_ps(dstF, MaskF_inv_f), _mm256_mul_ps(MaskF_f, dstB0))));
+        _mm256_storeu_ps(pdst + w, _mm256_add_ps(_mm256_mul_ps(a, time256_inv_f), _mm256_mul_ps(b, time256_f)));
+      }
+      else {
+        // (dstF*(255 - MaskF) + ((MaskF * (dstB*(255 - MaskB) + MaskB*dstF0) + 255) >> 8) + 255) >> 8
+        const __m256i c255 = _mm256_set1_epi32(255);
+        const __m256i dstF_mF = _mm256_mullo_epi32(dstF, _mm256_sub_epi32(c255, mF));
+        const __m256i dstB_mB = _mm256_mullo_epi32(dstB, _mm256_sub_epi32(c255, mB));
+        const __m256i innerF = _mm256_add_epi32(dstB_mB, _mm256_mullo_epi32(mB, dstF0));
+        const __m256i innerB = _mm256_add_epi32(dstF_mF, _mm256_mullo_epi32(mF, dstB0));
+        const __m256i a = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(dstF_mF,
+          _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(mF, innerF), c255), 8)), c255), 8);
+        const __m256i b = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(dstB_mB,
+          _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(mB, innerB), c255), 8)), c255), 8);
+        store_pixels8(pdst + w, time_blend8(a, b, t_inv, t));
+      }
+    }
+    pdst += dst_pitch;
+    prefB += ref_pitch << NPELL2;
+    prefF += ref_pitch << NPELL2;
+    VXFullB += VPitch;
+    VYFullB += VPitch;
+    VXFullF += VPitch;
+    VYFullF += VPitch;
+    MaskB += VPitch;
+    MaskF += VPitch;
+  }
+  _mm256_zeroupper();
+}
+
+template <typename pixel_t, int NPELL2>
+void FlowInterExtra_NPel_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256,
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF)
+{
+  dst_pitch /= sizeof(pixel_t);
+  ref_pitch /= sizeof(pixel_t);
+  pixel_t *pdst = reinterpret_cast<pixel_t *>(pdst8);
+  const pixel_t *prefB = reinterpret_cast<const pixel_t *>(prefB8);
+  const pixel_t *prefF = reinterpret_cast<const pixel_t *>(prefF8);
+
+  const __m256i t = _mm256_set1_epi32(time256);
+  const __m256i t_inv = _mm256_set1_epi32(256 - time256);
+  const __m256i pitch = _mm256_set1_epi32(ref_pitch);
+  const __m256i lanes = _mm256_slli_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), NPELL2);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 time256_f = _mm256_set1_ps(time256 / 256.0f);
+  const __m256 time256_inv_f = _mm256_sub_ps(one, time256_f);
+
+  for (int h = 0; h < height; h++)
+  {
+    for (int w = 0; w < width; w += 8)
+    {
+      const __m256i pos = _mm256_add_epi32(lanes, _mm256_set1_epi32(w << NPELL2));
+      const __m256i idxF = pixel_index8(scale_vec8(load_vec8(VXFullF + w), t), scale_vec8(load_vec8(VYFullF + w), t), pitch, pos);
+      const __m256i idxFF = pixel_index8(scale_vec8(load_vec8(VXFullFF + w), t), scale_vec8(load_vec8(VYFullFF + w), t), pitch, pos);
+      const __m256i idxB = pixel_index8(scale_vec8(load_vec8(VXFullB + w), t_inv), scale_vec8(load_vec8(VYFullB + w), t_inv), pitch, pos);
+      const __m256i idxBB = pixel_index8(scale_vec8(load_vec8(VXFullBB + w), t_inv), scale_vec8(load_vec8(VYFullBB + w), t_inv), pitch, pos);
+      const auto dstF = gather_pixels8(prefF, idxF);
+      const auto dstFF = gather_pixels8(prefF, idxFF);
+      const auto dstB = gather_pixels8(prefB, idxB);
+      const auto dstBB = gather_pixels8(prefB, idxBB);
+      const __m256i mF = load_mask8(MaskF + w);
+      const __m256i mB = load_mask8(MaskB + w);
+
+      if constexpr (sizeof(pixel_t) == 4) {
+        // Median3r(minfb, x, maxfb)
+        const __m256 minfb = _mm256_min_ps(dstF, dstB);
+        const __m256 maxfb = _mm256_max_ps(dstF, dstB);
+        const __m256 medBB = _mm256_min_ps(_mm256_max_ps(dstBB, minfb), maxfb);
+        const __m256 medFF = _mm256_min_ps(_mm256_max_ps(dstFF, minfb), maxfb);
+        const __m256 MaskF_f = mask_to_float8(mF);
+        const __m256 MaskB_f = mask_to_float8(mB);
+        const __m256 a = _mm256_add_ps(_mm256_mul_ps(medBB, MaskF_f), _mm256_mul_ps(dstF, _mm256_sub_ps(one, MaskF_f)));
+        const __m256 b = _mm256_add_ps(_mm256_mul_ps(medFF, MaskB_f), _mm256_mul_ps(dstB, _mm256_sub_ps(one, MaskB_f)));
+        _mm256_storeu_ps(pdst + w, _mm256_add_ps(_mm256_mul_ps(a, time256_inv_f), _mm256_mul_ps(b, time256_f)));
+      }
+      else {
+        const __m256i minfb = _mm256_min_epi32(dstF, dstB);
+        const __m256i maxfb = _mm256_max_epi32(dstF, dstB);
+        const __m256i medBB = _mm256_min_epi32(_mm256_max_epi32(dstBB, minfb), maxfb);
+        const __m256i medFF = _mm256_min_epi32(_mm256_max_epi32(dstFF, minfb), maxfb);
+        const __m256i a = mask_blend8(dstF, medBB, mF);
+        const __m256i b = mask_blend8(dstB, medFF, mB);
+        store_pixels8(pdst + w, time_blend8(a, b, t_inv, t));
+      }
+    }
+    pdst += dst_pitch;
+    prefB += ref_pitch << NPELL2;
+    prefF += ref_pitch << NPELL2;
+    VXFullB += VPitch;
+    VYFullB += VPitch;
+    VXFullF += VPitch;
+    VYFullF += VPitch;
+    MaskB += VPitch;
+    MaskF += VPitch;
+    VXFullBB += VPitch;
+    VYFullBB += VPitch;
+    VXFullFF += VPitch;
+    VYFullFF += VPitch;
+  }
+  _mm256_zeroupper();
+}
+
+// time256 == 128: (((F + B) << 8) + (B - F)*(MaskF - MaskB)) >> 9
+template <typename pixel_t, typename V>
+static MV_FORCEINLINE void flow_inter_simple_128(pixel_t *p, V dstF, V dstB, __m256i mF, __m256i mB)
+{
+  if constexpr (sizeof(pixel_t) == 4) {
+    const __m256 diff_mask = _mm256_sub_ps(mask_to_float8(mF), mask_to_float8(mB));
+    const __m256 sum = _mm256_add_ps(_mm256_add_ps(dstF, dstB), _mm256_mul_ps(_mm256_sub_ps(dstB, dstF), diff_mask));
+    _mm256_storeu_ps(p, _mm256_mul_ps(sum, _mm256_set1_ps(0.5f)));
+  }
+  else {
+    const __m256i sum = _mm256_add_epi32(_mm256_slli_epi32(_mm256_add_epi32(dstF, dstB), 8),
+      _mm256_mullo_epi32(_mm256_sub_epi32(dstB, dstF), _mm256_sub_epi32(mF, mB)));
+    store_pixels8(p, _mm256_srai_epi32(sum, 9));
+  }
+}
+
+template <typename pixel_t, int NPELL2>
+void FlowInterSimple_NPel_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256)
+{
+  dst_pitch /= sizeof(pixel_t);
+  ref_pitch /= sizeof(pixel_t);
+  pixel_t *pdst = reinterpret_cast<pixel_t *>(pdst8);
+  const pixel_t *prefB = reinterpret_cast<const pixel_t *>(prefB8);
+  const pixel_t *prefF = reinterpret_cast<const pixel_t *>(prefF8);
+
+  const __m256i t = _mm256_set1_epi32(time256);
+  const __m256i t_inv = _mm256_set1_epi32(256 - time256);
+  const __m256i pitch = _mm256_set1_epi32(ref_pitch);
+  const __m256i lanes = _mm256_slli_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), NPELL2);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 time256_f = _mm256_set1_ps(time256 / 256.0f);
+  const __m256 time256_inv_f = _mm256_sub_ps(one, time256_f);
+
+  for (int h = 0; h < height; h++)
+  {
+    for (int w = 0; w < width; w += 8)
+    {
+      const __m256i pos = _mm256_add_epi32(lanes, _mm256_set1_epi32(w << NPELL2));
+      const __m256i mF = load_mask8(MaskF + w);
+      const __m256i mB = load_mask8(MaskB + w);
+
+      if (time256 == 128) // special case double fps - fastest
+      {
+        const __m256i idxF = pixel_index8(_mm256_srai_epi32(load_vec8(VXFullF + w), 1), _mm256_srai_epi32(load_vec8(VYFullF + w), 1), pitch, pos);
+        const __m256i idxB = pixel_index8(_mm256_srai_epi32(load_vec8(VXFullB + w), 1), _mm256_srai_epi32(load_vec8(VYFullB + w), 1), pitch, pos);
+        flow_inter_simple_128(pdst + w, gather_pixels8(prefF, idxF), gather_pixels8(prefB, idxB), mF, mB);
+        continue;
+      }
+
+      const __m256i idxF = pixel_index8(scale_vec8(load_vec8(VXFullF + w), t), scale_vec8(load_vec8(VYFullF + w), t), pitch, pos);
+      const __m256i idxB = pixel_index8(scale_vec8(load_vec8(VXFullB + w), t_inv), scale_vec8(load_vec8(VYFullB + w), t_inv), pitch, pos);
+      const auto dstF = gather_pixels8(prefF, idxF);
+      const auto dstB = gather_pixels8(prefB, idxB);
+
+      if constexpr (sizeof(pixel_t) == 4) {
+        const __m256 MaskF_f = mask_to_float8(mF);
+        const __m256 MaskB_f = mask_to_float8(mB);
+        const __m256 a = _mm256_add_ps(_mm256_mul_ps(dstF, _mm256_sub_ps(one, MaskF_f)), _mm256_mul_ps(dstB, MaskF_f));
+        const __m256 b = _mm256_add_ps(_mm256_mul_ps(dstB, _mm256_sub_ps(one, MaskB_f)), _mm256_mul_ps(dstF, MaskB_f));
+        _mm256_storeu_ps(pdst + w, _mm256_add_ps(_mm256_mul_ps(a, time256_inv_f), _mm256_mul_ps(b, time256_f)));
+      }
+      else {
+        store_pixels8(pdst + w, time_blend8(mask_blend8(dstF, dstB, mF), mask_blend8(dstB, dstF, mB), t_inv, t));
+      }
+    }
+    pdst += dst_pitch;
+    prefB += ref_pitch << NPELL2;
+    prefF += ref_pitch << NPELL2;
+    VXFullB += VPitch;
+    VYFullB += VPitch;
+    VXFullF += VPitch;
+    VYFullF += VPitch;
+    MaskB += VPitch;
+    MaskF += VPitch;
+  }
+  _mm256_zeroupper();
+}
+
+template <typename pixel_t>
+void FlowInterSimple_Pel1_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256)
+{
+  dst_pitch /= sizeof(pixel_t);
+  ref_pitch /= sizeof(pixel_t);
+  pixel_t *pdst = reinterpret_cast<pixel_t *>(pdst8);
+  const pixel_t *prefB = reinterpret_cast<const pixel_t *>(prefB8);
+  const pixel_t *prefF = reinterpret_cast<const pixel_t *>(prefF8);
+
+  const __m256i t = _mm256_set1_epi32(time256);
+  const __m256i t_inv = _mm256_set1_epi32(256 - time256);
+  const __m256i pitch = _mm256_set1_epi32(ref_pitch);
+  // addrF + 1 of the odd pixel is the even vector + w + 1
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 time256_f = _mm256_set1_ps(time256 / 256.0f);
+  const __m256 time256_inv_f = _mm256_sub_ps(one, time256_f);
+
+  // vectors of the even pixels, duplicated to the odd ones
+  auto load_vec8_paired = [](const short *p) {
+    return _mm256_shuffle_epi32(load_vec8(p), _MM_SHUFFLE(2, 2, 0, 0));
+  };
+
+  for (int h = 0; h < height; h++)
+  {
+    for (int w = 0; w < width; w += 8)
+    {
+      const __m256i pos = _mm256_add_epi32(lanes, _mm256_set1_epi32(w));
+      const __m256i mF = load_mask8(MaskF + w);
+      const __m256i mB = load_mask8(MaskB + w);
+      const __m256i vxF = _mm256_srai_epi32(load_vec8_paired(VXFullF + w), 1);
+      const __m256i vyF = _mm256_srai_epi32(load_vec8_paired(VYFullF + w), 1);
+      const auto dstF = gather_pixels8(prefF, pixel_index8(vxF, vyF, pitch, pos));
+
+      if (time256 == 128) // special case double fps - fastest
+      {
+        const __m256i vxB = _mm256_srai_epi32(load_vec8_paired(VXFullB + w), 1);
+        const __m256i vyB = _mm256_srai_epi32(load_vec8_paired(VYFullB + w), 1);
+        flow_inter_simple_128(pdst + w, dstF, gather_pixels8(prefB, pixel_index8(vxB, vyB, pitch, pos)), mF, mB);
+        continue;
+      }
+
+      // general case, the forward vectors are not scaled by time like in the C version
+      const __m256i vxB = scale_vec8(load_vec8_paired(VXFullB + w), t_inv);
+      const __m256i vyB = scale_vec8(load_vec8_paired(VYFullB + w), t_inv);
+      const auto dstB = gather_pixels8(prefB, pixel_index8(vxB, vyB, pitch, pos));
+
+      if constexpr (sizeof(pixel_t) == 4) {
+        const __m256 diff = _mm256_sub_ps(dstB, dstF);
+        const __m256 a = _mm256_add_ps(dstF, _mm256_mul_ps(diff, mask_to_float8(mF)));
+        const __m256 b = _mm256_sub_ps(dstB, _mm256_mul_ps(diff, mask_to_float8(mB)));
+        _mm256_storeu_ps(pdst + w, _mm256_add_ps(_mm256_mul_ps(a, time256_inv_f), _mm256_mul_ps(b, time256_f)));
+      }
+      else {
+        // (dstF*255 + (dstB - dstF)*MaskF + 255)*(256 - time256) + (dstB*255 - (dstB - dstF)*MaskB + 255)*time256) >> 16
+        const __m256i c255 = _mm256_set1_epi32(255);
+        const __m256i diff = _mm256_sub_epi32(dstB, dstF);
+        const __m256i a = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(dstF, c255), _mm256_mullo_epi32(diff, mF)), c255);
+        const __m256i b = _mm256_add_epi32(_mm256_sub_epi32(_mm256_mullo_epi32(dstB, c255), _mm256_mullo_epi32(diff, mB)), c255);
+        const __m256i sum = _mm256_add_epi32(_mm256_mullo_epi32(a, t_inv), _mm256_mullo_epi32(b, t));
+        store_pixels8(pdst + w, _mm256_srli_epi32(sum, 16));
+      }
+    }
+    pdst += dst_pitch;
+    prefB += ref_pitch;
+    prefF += ref_pitch;
+    VXFullB += VPitch;
+    VYFullB += VPitch;
+    VXFullF += VPitch;
+    VYFullF += VPitch;
+    MaskB += VPitch;
+    MaskF += VPitch;
+  }
+  _mm256_zeroupper();
+}
+
+template <typename pixel_t, int NPELL2>
+void FlowFetch_NPel_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *pref8, int ref_pitch,
+  short *VXFull, int VXPitch, short *VYFull, int VYPitch, int width, int height, int time256)
+{
+  dst_pitch /= sizeof(pixel_t);
+  ref_pitch /= sizeof(pixel_t);
+  pixel_t *pdst = reinterpret_cast<pixel_t *>(pdst8);
+  const pixel_t *pref = reinterpret_cast<const pixel_t *>(pref8);
+
+  const __m256i t = _mm256_set1_epi32(time256);
+  const __m256i round = _mm256_set1_epi32(128);
+  const __m256i pitch = _mm256_set1_epi32(ref_pitch);
+  const __m256i lanes = _mm256_slli_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), NPELL2);
+
+  for (int h = 0; h < height; h++)
+  {
+    for (int w = 0; w < width; w += 8)
+    {
+      // (VXFull * time256 + 128) >> 8
+      const __m256i vx = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(load_vec8(VXFull + w), t), round), 8);
+      const __m256i vy = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(load_vec8(VYFull + w), t), round), 8);
+      const __m256i pos = _mm256_add_epi32(lanes, _mm256_set1_epi32(w << NPELL2));
+      const auto src = gather_pixels8(pref, pixel_index8(vx, vy, pitch, pos));
+      if constexpr (sizeof(pixel_t) == 4)
+        _mm256_storeu_ps(pdst + w, src);
+      else
+        store_pixels8(pdst + w, src);
+    }
+    pref += ref_pitch << NPELL2;
+    pdst += dst_pitch;
+    VXFull += VXPitch;
+    VYFull += VYPitch;
+  }
+  _mm256_zeroupper();
+}
+
+// instantiate
+#define MAKE_FN(pixel_t, NPELL2) \
+template void FlowInter_NPel_avx2<pixel_t, NPELL2>(uint8_t *, int, const uint8_t *, const uint8_t *, int, \
+  short *, short *, short *, short *, uint8_t *, uint8_t *, int, int, int, int); \
+template void FlowInterExtra_NPel_avx2<pixel_t, NPELL2>(uint8_t *, int, const uint8_t *, const uint8_t *, int, \
+  short *, short *, short *, short *, uint8_t *, uint8_t *, int, int, int, int, short *, short *, short *, short *); \
+template void FlowInterSimple_NPel_avx2<pixel_t, NPELL2>(uint8_t *, int, const uint8_t *, const uint8_t *, int, \
+  short *, short *, short *, short *, uint8_t *, uint8_t *, int, int, int, int); \
+template void FlowFetch_NPel_avx2<pixel_t, NPELL2>(uint8_t *, int, const uint8_t *, int, \
+  short *, int, short *, int, int, int, int);
+
+MAKE_FN(uint8_t, 0)
+MAKE_FN(uint8_t, 1)
+MAKE_FN(uint8_t, 2)
+MAKE_FN(uint16_t, 0)
+MAKE_FN(uint16_t, 1)
+MAKE_FN(uint16_t, 2)
+MAKE_FN(float, 0)
+MAKE_FN(float, 1)
+MAKE_FN(float, 2)
+#undef MAKE_FN
+
+template void FlowInterSimple_Pel1_avx2<uint8_t>(uint8_t *, int, const uint8_t *, const uint8_t *, int,
+  short *, short *, short *, short *, uint8_t *, uint8_t *, int, int, int, int);
+template void FlowInterSimple_Pel1_avx2<uint16_t>(uint8_t *, int, const uint8_t *, const uint8_t *, int,
+  short *, short *, short *, short *, uint8_t *, uint8_t *, int, int, int, int);
+template void FlowInterSimple_Pel1_avx2<float>(uint8_t *, int, const uint8_t *, const uint8_t *, int,
+  short *, short *, short *, short *, uint8_t *, uint8_t *, int, int, int, int);
@@ -0,0 +1,77 @@
+// Per-pixel flow interpolation kernels, AVX2
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __MV_MASKFUN_AVX2__
+#define __MV_MASKFUN_AVX2__
+
+#include <stdint.h>
+
+// Same parameters as the C versions in MaskFun.hpp
+typedef void (FlowInterFunction)(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256);
+
+typedef void (FlowInterExtraFunction)(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256,
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF);
+
+typedef void (FlowFetchFunction)(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *pref8, int ref_pitch,
+  short *VXFull, int VXPitch, short *VYFull, int VYPitch, int width, int height, int time256);
+
+// Bit-exact with the C versions for 8 and 16 bit, float differs only by rounding.
+// width must be mod8, the caller processes the remaining columns in C.
+// The 8 and 16 bit reference pixels are gathered as 32 bit words: up to 3 bytes
+// after the addressed pixel are read. The reference planes are always followed by
+// the lower levels of the super frame, so these reads stay inside the frame.
+template <typename pixel_t, int NPELL2>
+void FlowInter_NPel_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256);
+
+template <typename pixel_t, int NPELL2>
+void FlowInterExtra_NPel_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256,
+  short *VXFullBB, short *VXFullFF, short *VYFullBB, short *VYFullFF);
+
+template <typename pixel_t, int NPELL2>
+void FlowInterSimple_NPel_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256);
+
+// keeps the paired approximation of the C version: odd pixels use the vectors of the even ones
+template <typename pixel_t>
+void FlowInterSimple_Pel1_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *prefB8, const uint8_t *prefF8, int ref_pitch,
+  short *VXFullB, short *VXFullF, short *VYFullB, short *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
+  int VPitch, int width, int height, int time256);
+
+// MFlow fetch mode
+template <typename pixel_t, int NPELL2>
+void FlowFetch_NPel_avx2(
+  uint8_t * pdst8, int dst_pitch, const uint8_t *pref8, int ref_pitch,
+  short *VXFull, int VXPitch, short *VYFull, int VYPitch, int width, int height, int time256);
+
+#endif
@@ -31,7 +31,6 @@
 #include "MVPlane.h"
 #include "PlaneOfBlocks.h"
 #include "Padding.h"
-#include "profile.h"
 
 #include <emmintrin.h> // SSE2
 #include <pmmintrin.h> // SSE3
@@ -54,7 +53,7 @@ static unsigned int SadDummy(const uint8_t *, int , const uint8_t *, int )
 PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSizeY, int _nPel, int _nLevel, int _nFlags, int _nOverlapX, int _nOverlapY,
   int _xRatioUV, int _yRatioUV, int _pixelsize, int _bits_per_pixel,
   conc::ObjPool <DCTClass> *dct_pool_ptr,
-  bool mt_flag, int _chromaSADscale, int _optSearchOption, float _scaleCSADfine, int _iUseSubShift, int _DMFlags,
+  bool mt_flag, bool tile_flag, int _chromaSADscale, int _optSearchOption, float _scaleCSADfine, int _iUseSubShift, int _DMFlags,
   int _AMDiffSAD,  IScriptEnvironment* env)
   : nBlkX(_nBlkX)
   , nBlkY(_nBlkY)
@@ -77,6 +76,7 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
   , pixelsize_shift(ilog2(pixelsize)) // 161201
   , bits_per_pixel(_bits_per_pixel) // PF
   , _mt_flag(mt_flag)
+  , _tile_flag(tile_flag)
   , chromaSADscale(_chromaSADscale)
   , optSearchOption(_optSearchOption)
   , scaleCSADfine(_scaleCSADfine)
@@ -107,6 +107,15 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
 {
   _workarea_pool.set_factory(_workarea_fact);
 
+  _tile_w = std::max(int(MIN_TILE_W), (nBlkX + MAX_TILE_COLS - 1) / MAX_TILE_COLS);
+  _tile_h = (nBlkY + MAX_TILE_ROWS - 1) / MAX_TILE_ROWS;
+  _tile_graph.set_grid(
+    (nBlkX + _tile_w - 1) / _tile_w,
+    (nBlkY + _tile_h - 1) / _tile_h
+  );
+  _tile_plane_sad_arr.resize(_tile_graph.get_last_node() + 1);
+  _tile_luma_change_arr.resize(_tile_graph.get_last_node() + 1);
+
   // half must be more than max vector length, which is (framewidth + Padding) * nPel
   freqArray[0].resize(8192 * _nPel * 2);
   freqArray[1].resize(8192 * _nPel * 2);
@@ -215,9 +224,10 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
     // block sizes and chroma remain the same
 
     // not implemented ones are nullptr
-    if ((nBlkSizeX == 8 || nBlkSizeX == 16) && (nBlkSizeY == 8 || nBlkSizeY == 16) && pixelsize == 1 && !chroma) {
+    // sub-shifted blocks are not stored in the sub-planes, so nPel > 1 needs UseSubShift=0
+    if (pixelsize <= 2 && !chroma && (nPel == 1 || iUseSubShift == 0)) {
       for (int iSearchParam = 0; iSearchParam <= MAX_SUPPORTED_EXH_SEARCHPARAM; iSearchParam++)
-        ExhaustiveSearchFunctions[iSearchParam] = get_ExhaustiveSearchFunction(nBlkSizeX, nBlkSizeY, iSearchParam, bits_per_pixel, arch);
+        ExhaustiveSearchFunctions[iSearchParam] = get_ExhaustiveSearchFunction(nBlkSizeX, nBlkSizeY, iSearchParam, bits_per_pixel, nPel, arch);
     }
   }
 
@@ -281,6 +291,17 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
     }
   }
 #endif
+
+  // Early termination of the luma SAD for large blocks: the rows are summed
+  // by chunks and a candidate is given up as soon as its partial cost reaches
+  // the best one. Plain SAD only, the chunks then add up to the full metric.
+  SADPART = nullptr;
+  nPartRows = nBlkSizeY;
+  if (_DMFlags == MEF_SAD && dctmode == 0 && pixelsize <= 2 && nBlkSizeX * nBlkSizeY >= 512)
+  {
+    nPartRows = nBlkSizeY / 4;
+    SADPART = get_sad_function(nBlkSizeX, nPartRows, bits_per_pixel, arch);
+  }
 }
 
 
@@ -447,38 +468,76 @@ void PlaneOfBlocks::SearchMVs(
   penaltyNew = _pnew; // penalty for new vector
   LSAD = _lsad;    // SAD limit for lambda using
 
-  Slicer			slicer(_mt_flag); // fixme: mt bug
-  if (bits_per_pixel == 8)
+  // MAnalyse tiles=true: wavefront over a fixed tile grid. The predictors
+  // of each block are fetched as in the single-threaded scan, instead of
+  // being cut at each horizontal slice boundary, except the left and
+  // up-right ones which stay inside the tile (the right neighbour tile is
+  // not searched yet).
+  // Not depending on the number of threads, so neither is the output.
+  const bool tile_flag =
+       _mt_flag && _tile_flag && bVScanDir
+    && (bits_per_pixel != 8 || optSearchOption < 2 || optSearchOption > 4)
+    && _tile_graph.get_last_node() > 0;
+
+  if (tile_flag)
   {
-    if (optSearchOption == 2)
+    // The smallest plane has no coarser level to fill its vectors: clear
+    // what the previous search left there, so the output does not depend
+    // on the order in which the frames are requested.
+    if (smallestPlane)
     {
-      slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_SO2<uint8_t>, 4);
+      for (int i = 0; i < nBlkCount; ++i)
+        vectors[i] = zeroMVfieldShifted;
     }
+
+    SchedulerTiles	sched(true);
+    if (bits_per_pixel == 8)
+      sched.start(_tile_graph, *this, &PlaneOfBlocks::search_mv_tile<uint8_t>);
     else
-    if (optSearchOption == 3)
+      sched.start(_tile_graph, *this, &PlaneOfBlocks::search_mv_tile<uint16_t>);
+    sched.wait();
+
+    for (int t = 0; t <= _tile_graph.get_last_node(); ++t)
     {
-      slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_SO3<uint8_t>, 4); // AVX2 multi-block
+      planeSAD += _tile_plane_sad_arr[t]; // for debug, plus fixme outer planeSAD is not used
+      sumLumaChange += _tile_luma_change_arr[t];
     }
-    else
-    if (optSearchOption == 4)
+  }
+  else
+  {
+    Slicer			slicer(_mt_flag); // fixme: mt bug
+    if (bits_per_pixel == 8)
     {
-      slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_SO4<uint8_t>, 4); // AVX512 multi-block
+      if (optSearchOption == 2)
+      {
+        slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_SO2<uint8_t>, 4);
+      }
+      else
+      if (optSearchOption == 3)
+      {
+        slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_SO3<uint8_t>, 4); // AVX2 multi-block
+      }
+      else
+      if (optSearchOption == 4)
+      {
+        slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_SO4<uint8_t>, 4); // AVX512 multi-block
+      }
+      else
+      {
+        if (bVScanDir)
+          slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice<uint8_t>, 4);
+        else
+          slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_rv<uint8_t>, 4);
+      }
     }
     else
-    {
       if (bVScanDir)
-        slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice<uint8_t>, 4);
+        slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice<uint16_t>, 4);
       else
-        slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_rv<uint8_t>, 4);
-    }
-  }
-  else
-    if (bVScanDir)
-      slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice<uint16_t>, 4);
-    else
-      slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_rv<uint16_t>, 4);
+        slicer.start(nBlkY, *this, &PlaneOfBlocks::search_mv_slice_rv<uint16_t>, 4);
 
-  slicer.wait();
+    slicer.wait();
+  }
 
   // -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
 
@@ -990,6 +1049,97 @@ int PlaneOfBlocks::WriteDefaultToArray(int *array, int divideMode)
 
 
 
+// Sets the predictors from the vectors of the same frame pair searched in the
+// opposite direction (array: this plane's part of the vector frame, header
+// included). Each opposite block votes for the block its vector points to,
+// the lowest SAD wins. Blocks without vote take the opposite of their
+// co-located vector.
+void PlaneOfBlocks::InvertPrediction(const int *array, MVFrame *_pSrcFrame)
+{
+  const int *    in = array + 1;
+
+  const int      nStepX = (nBlkSizeX - nOverlapX) * nPel;
+  const int      nStepY = (nBlkSizeY - nOverlapY) * nPel;
+  for (int i = 0; i < nBlkCount; i++)
+  {
+    vectors[i].x = 0;
+    vectors[i].y = 0;
+    vectors[i].sad = -1; // no vote yet
+  }
+
+  for (int by = 0; by < nBlkY; by++)
+  {
+    for (int bx = 0; bx < nBlkX; bx++)
+    {
+      const int *  blk = in + (by * nBlkX + bx) * N_PER_BLOCK;
+      const sad_t  sad = *reinterpret_cast<const sad_t *>(&blk[2]);
+      const int    tx_pos = bx * nStepX + blk[0] + nStepX / 2;
+      const int    ty_pos = by * nStepY + blk[1] + nStepY / 2;
+      if (tx_pos < 0 || ty_pos < 0)
+      {
+        continue;
+      }
+      const int    tx = tx_pos / nStepX;
+      const int    ty = ty_pos / nStepY;
+      if (tx >= nBlkX || ty >= nBlkY)
+      {
+        continue;
+      }
+      VECTOR &     v = vectors[ty * nBlkX + tx];
+      if (v.sad < 0 || sad < v.sad)
+      {
+        v.x = -blk[0];
+        v.y = -blk[1];
+        v.sad = sad;
+      }
+    }
+  }
+
+  // same search boundaries as search_mv_block(), without AreaMode offsets
+  const MVPlane *pPlane = _pSrcFrame->GetPlane(YPLANE);
+  const int      nHPaddingScaled = pPlane->GetHPadding() >> nLogScale;
+  const int      nVPaddingScaled = pPlane->GetVPadding() >> nLogScale;
+  for (int by = 0; by < nBlkY; by++)
+  {
+    const int    y = pPlane->GetVPadding() + (nBlkSizeY - nOverlapY) * by;
+    const int    nDyMax = nPel * (pPlane->GetExtendedHeight() - y - nBlkSizeY - pPlane->GetVPadding() + nVPaddingScaled);
+    const int    nDyMin = -nPel * (y - pPlane->GetVPadding() + nVPaddingScaled);
+    for (int bx = 0; bx < nBlkX; bx++)
+    {
+      const int  x = pPlane->GetHPadding() + (nBlkSizeX - nOverlapX) * bx;
+      const int  nDxMax = nPel * (pPlane->GetExtendedWidth() - x - nBlkSizeX - pPlane->GetHPadding() + nHPaddingScaled);
+      const int  nDxMin = -nPel * (x - pPlane->GetHPadding() + nHPaddingScaled);
+      const int  i = by * nBlkX + bx;
+      VECTOR &   v = vectors[i];
+      if (v.sad < 0)
+      {
+        v.x = -in[i * N_PER_BLOCK + 0];
+        v.y = -in[i * N_PER_BLOCK + 1];
+        v.sad = *reinterpret_cast<const sad_t *>(&in[i * N_PER_BLOCK + 2]);
+      }
+      v.x = std::max(nDxMin, std::min(v.x, nDxMax - 1));
+      v.y = std::max(nDyMin, std::min(v.y, nDyMax - 1));
+    }
+  }
+}
+
+
+
+// Writes the predictors as the plane's vectors, no search.
+int PlaneOfBlocks::WritePredictionToArray(int *array)
+{
+  WriteHeaderToArray(array);
+  for (int i = 0; i < nBlkCount; i++)
+  {
+    array[i * N_PER_BLOCK + 1] = vectors[i].x;
+    array[i * N_PER_BLOCK + 2] = vectors[i].y;
+    array[i * N_PER_BLOCK + 3] = *(uint32_t*)(&vectors[i].sad);
+  }
+  return GetArraySize(0);
+}
+
+
+
 int PlaneOfBlocks::GetArraySize(int divideMode)
 {
   int size = 0;
@@ -1011,7 +1161,7 @@ template<typename pixel_t>
 void PlaneOfBlocks::FetchPredictors(WorkingArea &workarea)
 {
   // Left (or right) predictor
-  if ((workarea.blkScanDir == 1 && workarea.blkx > 0) || (workarea.blkScanDir == -1 && workarea.blkx < nBlkX - 1))
+  if ((workarea.blkScanDir == 1 && workarea.blkx > workarea.blkx_beg) || (workarea.blkScanDir == -1 && workarea.blkx < workarea.blkx_end - 1))
   {
     workarea.predictors[1] = ClipMV(workarea, vectors[workarea.blkIdx - workarea.blkScanDir]);
   }
@@ -1054,7 +1204,7 @@ void PlaneOfBlocks::FetchPredictors(WorkingArea &workarea)
       workarea.predictors[3] = ClipMV(workarea, vectors[workarea.blkIdx + nBlkX + workarea.blkScanDir]);
     }
     // Up-right predictor
-    else if (!isTop && ((workarea.blkScanDir == 1 && workarea.blkx < nBlkX - 1) || (workarea.blkScanDir == -1 && workarea.blkx > 0)))
+    else if (!isTop && ((workarea.blkScanDir == 1 && workarea.blkx < workarea.blkx_end - 1) || (workarea.blkScanDir == -1 && workarea.blkx > workarea.blkx_beg)))
     {
       workarea.predictors[3] = ClipMV(workarea, vectors[workarea.blkIdx - nBlkX + workarea.blkScanDir]);
     }
@@ -1617,7 +1767,7 @@ MV_FORCEINLINE void PlaneOfBlocks::FetchPredictors_sse41(WorkingArea& workarea)
   // Gathering vectors first
 
   // Left (or right) predictor
-  if ((workarea.blkScanDir == 1 && workarea.blkx > 0) || (workarea.blkScanDir == -1 && workarea.blkx < nBlkX - 1))
+  if ((workarea.blkScanDir == 1 && workarea.blkx > workarea.blkx_beg) || (workarea.blkScanDir == -1 && workarea.blkx < workarea.blkx_end - 1))
   {
     v1 = vectors[workarea.blkIdx - workarea.blkScanDir];
   }
@@ -1700,7 +1850,7 @@ MV_FORCEINLINE void PlaneOfBlocks::FetchPredictors_sse41(WorkingArea& workarea)
       v3 = vectors[workarea.blkIdx + nBlkX + workarea.blkScanDir];
     }
     // Up-right predictor
-    else if (!isTop && ((workarea.blkScanDir == 1 && workarea.blkx < nBlkX - 1) || (workarea.blkScanDir == -1 && workarea.blkx > 0)))
+    else if (!isTop && ((workarea.blkScanDir == 1 && workarea.blkx < workarea.blkx_end - 1) || (workarea.blkScanDir == -1 && workarea.blkx > workarea.blkx_beg)))
     {
       v3 = vectors[workarea.blkIdx - nBlkX + workarea.blkScanDir];
     }
@@ -2245,9 +2395,10 @@ void PlaneOfBlocks::Refine(WorkingArea &workarea)
 
     // DTL TEST
     // one-pass Exa search by DTL
-    // only for 8 bit, nPel==1, nSearchParam == 1 and 2 and 4 && nBlkSizeX == 8 && nBlkSizeY == 8 && !chroma
-    // c or avx2. See function dispatcher
-    if (0 != optSearchOption && nPel == 1 && avx2) { // keep compatibility - new addition - only for pel=1 now !! other will cause buggy x,y,sad output, only avx2 and later
+    // nSearchParam 1 to 4, !chroma. 8x8 and 16x16 8 bit nPel==1 have dedicated versions,
+    // the others use the generic multi-candidate ones (see PlaneOfBlocks_exa.h)
+    // c or avx2. See function dispatcher, the table only holds the nPel-compatible ones
+    if (0 != optSearchOption && avx2) { // keep compatibility - new addition - only avx2 and later
       if (nSearchParam <= MAX_SUPPORTED_EXH_SEARCHPARAM) {
         // nSearchParam can change during the algorithm so we are choosing from prefilled function pointer table
         auto ExhaustiveSearchFunction = ExhaustiveSearchFunctions[nSearchParam];
@@ -2300,17 +2451,17 @@ void PlaneOfBlocks::Refine(WorkingArea &workarea)
   }
 }
 
-MV_FORCEINLINE bool PlaneOfBlocks::IsVectorChecked(uint64_t xy) // 2.7.46
+MV_FORCEINLINE bool PlaneOfBlocks::IsVectorChecked(WorkingArea &workarea, uint64_t xy) // 2.7.46
 {
   int i;
-  for (i = 0; i < iNumCheckedVectors; i++)
+  for (i = 0; i < workarea.iNumCheckedVectors; i++)
   {
-    if (checked_mv_vectors[i] == xy) return true;
+    if (workarea.checked_mv_vectors[i] == xy) return true;
   }
 
   // record it to checked
-  checked_mv_vectors[iNumCheckedVectors] = xy;
-  iNumCheckedVectors++;
+  workarea.checked_mv_vectors[workarea.iNumCheckedVectors] = xy;
+  workarea.iNumCheckedVectors++;
 
   return false;
 }
@@ -2337,7 +2488,7 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea& workarea)
       FetchPredictors<pixel_t>(workarea);
   }
 
-  iNumCheckedVectors = 0;
+  workarea.iNumCheckedVectors = 0;
 
   sad_t sad;
   sad_t cost;
@@ -2369,8 +2520,8 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea& workarea)
   workarea.bestMV.sad = sad;
   workarea.nMinCost = sad + ((penaltyZero * (safe_sad_t)sad) >> 8); // v.1.11.0.2
 
-  checked_mv_vectors[iNumCheckedVectors] = 0;
-  iNumCheckedVectors++;
+  workarea.checked_mv_vectors[workarea.iNumCheckedVectors] = 0;
+  workarea.iNumCheckedVectors++;
 
   VECTOR bestMVMany[MAX_PREDICTOR + 3];
   int nMinCostMany[MAX_PREDICTOR + 3];
@@ -2388,7 +2539,7 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea& workarea)
   // Global MV predictor  - added by Fizick
   workarea.globalMVPredictor = ClipMV(workarea, workarea.globalMVPredictor);
 
-  if (!IsVectorChecked((uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
+  if (!IsVectorChecked(workarea, (uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
   {
     sad = GetDM<pixel_t>(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y);
     cost = sad + ((pglobal * (safe_sad_t)sad) >> 8);
@@ -2414,7 +2565,7 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea& workarea)
       bestMVMany[1] = workarea.globalMVPredictor; 
     }
 
-  if (!IsVectorChecked((uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
+  if (!IsVectorChecked(workarea, (uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
   {
     sad = GetDM<pixel_t>(workarea, workarea.predictor.x, workarea.predictor.y);
     cost = sad;
@@ -2455,7 +2606,7 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea& workarea)
       workarea.nMinCost = verybigSAD + 1;
     }
 
-    if (!IsVectorChecked((uint64_t)workarea.predictors[i].x | ((uint64_t)workarea.predictors[i].y << 32)))
+    if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[i].x | ((uint64_t)workarea.predictors[i].y << 32)))
     {
       CheckMV0<pixel_t>(workarea, workarea.predictors[i].x, workarea.predictors[i].y);
 
@@ -2766,7 +2917,7 @@ void PlaneOfBlocks::PseudoEPZSearch_glob_med_pred(WorkingArea& workarea)
         FetchPredictors<pixel_t>(workarea);
     }
 
-    iNumCheckedVectors = 0;
+    workarea.iNumCheckedVectors = 0;
     
     sad_t sad;
     sad_t saduv;
@@ -2786,8 +2937,8 @@ void PlaneOfBlocks::PseudoEPZSearch_glob_med_pred(WorkingArea& workarea)
     workarea.bestMV.sad = sad;
     workarea.nMinCost = sad + ((penaltyZero * (safe_sad_t)sad) >> 8); // v.1.11.0.2
 
-    checked_mv_vectors[iNumCheckedVectors] = 0;
-    iNumCheckedVectors++;
+    workarea.checked_mv_vectors[workarea.iNumCheckedVectors] = 0;
+    workarea.iNumCheckedVectors++;
 
     if (tryMany)
     {
@@ -2800,7 +2951,7 @@ void PlaneOfBlocks::PseudoEPZSearch_glob_med_pred(WorkingArea& workarea)
    // Global MV predictor  - added by Fizick
     workarea.globalMVPredictor = ClipMV(workarea, workarea.globalMVPredictor);
 
-    if (!IsVectorChecked(workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
+    if (!IsVectorChecked(workarea, workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
     {
         sad = GetDM<pixel_t>(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y);
 
@@ -2826,7 +2977,7 @@ void PlaneOfBlocks::PseudoEPZSearch_glob_med_pred(WorkingArea& workarea)
     //	
     //	Then, the herarchy predictor :
     //	
-    if (!IsVectorChecked((uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
+    if (!IsVectorChecked(workarea, (uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
     {
         sad = GetDM<pixel_t>(workarea, workarea.predictor.x, workarea.predictor.y);
         cost = sad;
@@ -2851,7 +3002,7 @@ void PlaneOfBlocks::PseudoEPZSearch_glob_med_pred(WorkingArea& workarea)
     //	
     //	Then, the median predictor :
     //	
-    if (!IsVectorChecked((uint64_t)workarea.predictors[0].x | ((uint64_t)workarea.predictors[0].y << 32)))
+    if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[0].x | ((uint64_t)workarea.predictors[0].y << 32)))
     {
       sad = GetDM<pixel_t>(workarea, workarea.predictors[0].x, workarea.predictors[0].y);
       cost = sad;
@@ -2938,16 +3089,16 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2(WorkingArea& workarea)
   workarea.bestMV.sad = sad;
   workarea.nMinCost = sad + ((penaltyZero * (safe_sad_t)sad) >> 8); // v.1.11.0.2
 
-  iNumCheckedVectors = 0;
-  checked_mv_vectors[iNumCheckedVectors] = 0;
-  iNumCheckedVectors++;
+  workarea.iNumCheckedVectors = 0;
+  workarea.checked_mv_vectors[workarea.iNumCheckedVectors] = 0;
+  workarea.iNumCheckedVectors++;
 
-  /*    if (!IsVectorChecked(workarea.predictors[i].x | (workarea.predictors[i].y << 32)))
+  /*    if (!IsVectorChecked(workarea, workarea.predictors[i].x | (workarea.predictors[i].y << 32)))
       {
         CheckMV0<pixel_t>(workarea, workarea.predictors[i].x, workarea.predictors[i].y);
 
-        checked_mv_vectors[iNumCheckedVectors] = workarea.predictors[i].x | (workarea.predictors[i].y << 32);
-        iNumCheckedVectors++;
+        workarea.checked_mv_vectors[workarea.iNumCheckedVectors] = workarea.predictors[i].x | (workarea.predictors[i].y << 32);
+        workarea.iNumCheckedVectors++;
       }
       */
 
@@ -2955,7 +3106,7 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2(WorkingArea& workarea)
   // Global MV predictor  - added by Fizick
   workarea.globalMVPredictor = ClipMV_SO2(workarea, workarea.globalMVPredictor);
 
-  if (!IsVectorChecked((uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
+  if (!IsVectorChecked(workarea, (uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
   {
     sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y));
     cost = sad + ((pglobal * (safe_sad_t)sad) >> 8);
@@ -2973,7 +3124,7 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2(WorkingArea& workarea)
   //	if (   (( workarea.predictor.x != zeroMVfieldShifted.x ) || ( workarea.predictor.y != zeroMVfieldShifted.y ))
   //	    && (( workarea.predictor.x != workarea.globalMVPredictor.x ) || ( workarea.predictor.y != workarea.globalMVPredictor.y )))
   //	{
-  if (!IsVectorChecked((uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
+  if (!IsVectorChecked(workarea, (uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
   {
     sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.predictor.x, workarea.predictor.y));
     cost = sad;
@@ -3009,28 +3160,28 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2(WorkingArea& workarea)
   // vectors were clipped in FetchPredictors - no new IsVectorOK() check ?
   if ((iMask & 0x1) != 0)
   {
-    if (!IsVectorChecked((uint64_t)workarea.predictors[0].x | ((uint64_t)workarea.predictors[0].y << 32)))
+    if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[0].x | ((uint64_t)workarea.predictors[0].y << 32)))
     {
       CheckMV0_SO2<pixel_t>(workarea, workarea.predictors[0].x, workarea.predictors[0].y, _mm_extract_epi32(xmm0_cost, 0));
     }
   }
   if ((iMask & 0x10) != 0)
   {
-    if (!IsVectorChecked((uint64_t)workarea.predictors[1].x | ((uint64_t)workarea.predictors[1].y << 32)))
+    if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[1].x | ((uint64_t)workarea.predictors[1].y << 32)))
     {
       CheckMV0_SO2<pixel_t>(workarea, workarea.predictors[1].x, workarea.predictors[1].y, _mm_extract_epi32(xmm0_cost, 1));
     }
   }
   if ((iMask & 0x100) != 0)
   {
-    if (!IsVectorChecked((uint64_t)workarea.predictors[2].x | ((uint64_t)workarea.predictors[2].y << 32)))
+    if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[2].x | ((uint64_t)workarea.predictors[2].y << 32)))
     {
       CheckMV0_SO2<pixel_t>(workarea, workarea.predictors[2].x, workarea.predictors[2].y, _mm_extract_epi32(xmm0_cost, 2));
     }
   }
   if ((iMask & 0x1000) != 0)
   {
-    if (!IsVectorChecked((uint64_t)workarea.predictors[3].x | ((uint64_t)workarea.predictors[3].y << 32)))
+    if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[3].x | ((uint64_t)workarea.predictors[3].y << 32)))
     {
       CheckMV0_SO2<pixel_t>(workarea, workarea.predictors[3].x, workarea.predictors[3].y, _mm_extract_epi32(xmm0_cost, 3));
     }
@@ -3086,9 +3237,9 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2_glob_med_pred(WorkingArea& workarea)
   sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y));
   sad_t cost = sad + ((pglobal * (safe_sad_t)sad) >> 8);
 
-  iNumCheckedVectors = 0;
-  checked_mv_vectors[iNumCheckedVectors] = workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32);
-  iNumCheckedVectors++;
+  workarea.iNumCheckedVectors = 0;
+  workarea.checked_mv_vectors[workarea.iNumCheckedVectors] = workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32);
+  workarea.iNumCheckedVectors++;
   
   if (cost < workarea.nMinCost)
   {
@@ -3102,7 +3253,7 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2_glob_med_pred(WorkingArea& workarea)
   //	if (   (( workarea.predictor.x != zeroMVfieldShifted.x ) || ( workarea.predictor.y != zeroMVfieldShifted.y ))
   //	    && (( workarea.predictor.x != workarea.globalMVPredictor.x ) || ( workarea.predictor.y != workarea.globalMVPredictor.y )))
   //	{
-  if (!IsVectorChecked((uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
+  if (!IsVectorChecked(workarea, (uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
   {
     sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.predictor.x, workarea.predictor.y));
     cost = sad;
@@ -4896,7 +5047,7 @@ MV_FORCEINLINE void	PlaneOfBlocks::CheckMV0(WorkingArea &workarea, int vx, int v
     sad_t cost = workarea.MotionDistorsion<pixel_t>(vx, vy);
     if (cost >= workarea.nMinCost) return;
 
-    sad_t sad = GetDMLuma<pixel_t>(workarea, vx, vy);
+    sad_t sad = GetDMLumaBounded<pixel_t>(workarea, vx, vy, cost, 0);
     cost+=sad;
     if(cost>=workarea.nMinCost) return;
 
@@ -4978,7 +5129,7 @@ MV_FORCEINLINE void	PlaneOfBlocks::CheckMV(WorkingArea &workarea, int vx, int vy
 
     typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
 
-    sad_t sad = GetDMLuma<pixel_t>(workarea, vx, vy);
+    sad_t sad = GetDMLumaBounded<pixel_t>(workarea, vx, vy, cost, penaltyNew);
 
     cost += sad + ((penaltyNew*(safe_sad_t)sad) >> 8);
     if(cost>=workarea.nMinCost) return;
@@ -5033,7 +5184,7 @@ MV_FORCEINLINE void	PlaneOfBlocks::CheckMV2(WorkingArea &workarea, int vx, int v
 
     typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
 
-    sad_t sad = GetDMLuma<pixel_t>(workarea, vx, vy);
+    sad_t sad = GetDMLumaBounded<pixel_t>(workarea, vx, vy, cost, penaltyNew);
 
     cost += sad + ((penaltyNew*(safe_sad_t)sad) >> 8);
     if(cost>=workarea.nMinCost) return;
@@ -5085,7 +5236,7 @@ MV_FORCEINLINE void	PlaneOfBlocks::CheckMVdir(WorkingArea &workarea, int vx, int
 
     typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
 
-    sad_t sad = GetDMLuma<pixel_t>(workarea, vx, vy);
+    sad_t sad = GetDMLumaBounded<pixel_t>(workarea, vx, vy, cost, penaltyNew);
     cost += sad + ((penaltyNew*(safe_sad_t)sad) >> 8);
     if(cost>=workarea.nMinCost) return;
 
@@ -5209,6 +5360,172 @@ MV_FORCEINLINE bool	PlaneOfBlocks::IsInFrame(int i)
 
 
 
+// Searches the vector of the current block (workarea.blkx, blky, blkIdx, x[]
+// and y[] set) and writes it at the block position in the output row.
+template<typename pixel_t>
+MV_FORCEINLINE void PlaneOfBlocks::search_mv_block(WorkingArea &workarea, int *pBlkData, short *outfilebuf)
+{
+  // Resets the global predictor (it may have been clipped during the
+  // previous block scan)
+
+  // fixme: why recalc is resetting only outside, why, maybe recalc is not using that at all?
+  workarea.globalMVPredictor = _glob_mv_pred_def; // need to reset every time in AreaMode next searches (because am_shift added before clipping internally in the EPZ search)
+
+#if (ALIGN_SOURCEBLOCK > 1)
+  //store the pitch
+  const BYTE* pY = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
+  //create aligned copy
+  BLITLUMA(workarea.pSrc_temp[0], nSrcPitch[0], pY, nSrcPitch_plane[0]);
+  //set the to the aligned copy
+  workarea.pSrc[0] = workarea.pSrc_temp[0];
+  if (chroma)
+  {
+    workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
+    BLITCHROMA(workarea.pSrc_temp[1], nSrcPitch[1], workarea.pSrc[1], nSrcPitch_plane[1]);
+    workarea.pSrc[1] = workarea.pSrc_temp[1];
+    workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
+    BLITCHROMA(workarea.pSrc_temp[2], nSrcPitch[2], workarea.pSrc[2], nSrcPitch_plane[2]);
+    workarea.pSrc[2] = workarea.pSrc_temp[2];
+  }
+#else	// ALIGN_SOURCEBLOCK
+  workarea.pSrc[0] = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
+  if (chroma)
+  {
+    workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
+    workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
+  }
+#endif	// ALIGN_SOURCEBLOCK
+
+  // fixme note:
+  // MAnalyze mt-inconsistency reason #3
+  // this is _not_ internal mt friendly
+  // because workarea.nLambda is set to 0 differently:
+  // In vertically sliced multithreaded case it happens an _each_ top of the sliced block
+  // In non-mt: only for the most top blocks
+
+  if (workarea.blky == workarea.blky_beg)
+  {
+    workarea.nLambda = 0;
+  }
+  else
+  {
+    workarea.nLambda = _lambda_level;
+  }
+
+  // fixme:
+  // not exacly nice, but works
+  // different threads are writing, but the are the same always and come from parameters _pnew, _lsad
+  penaltyNew = _pnew; // penalty for new vector
+  LSAD = _lsad;    // SAD limit for lambda using
+  // may be they must be scaled by nPel ?
+
+  // decreased padding of coarse levels
+  int nHPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetHPadding() >> nLogScale;
+  int nVPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetVPadding() >> nLogScale;
+
+  /* additional AreaMode limits*/
+  int iAMmaxOffset = (iAreaMode * iAMstep) + iAMoffset;
+
+  /* computes search boundaries */
+  if (iUseSubShift == 0)
+  {
+    workarea.nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - workarea.x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled - iAMmaxOffset);
+    workarea.nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight() - workarea.y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled - iAMmaxOffset);
+    workarea.nDxMin = -nPel * (workarea.x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled - iAMmaxOffset);
+    workarea.nDyMin = -nPel * (workarea.y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled - iAMmaxOffset);
+  }
+  else
+  {
+    int iKS_sh_d2 = ((SHIFTKERNELSIZE / 2) + 2); // +2 is to prevent run out of buffer for UV planes
+    workarea.nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - workarea.x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled - iKS_sh_d2);
+    workarea.nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight() - workarea.y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled - iKS_sh_d2);
+    workarea.nDxMin = -nPel * (workarea.x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled - iKS_sh_d2);
+    workarea.nDyMin = -nPel * (workarea.y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled - iKS_sh_d2);
+  }
+
+  /* search the mv */
+  workarea.am_shift.x = 0; // set to zero always at startup and non-AreaMode search
+  workarea.am_shift.y = 0;
+
+  workarea.predictor = ClipMV(workarea, vectors[workarea.blkIdx]);
+  if (temporal)
+  {
+    workarea.predictors[4] = ClipMV(workarea, *reinterpret_cast<VECTOR*>(&_vecPrev[workarea.blkIdx * N_PER_BLOCK])); // temporal predictor
+  }
+  else
+  {
+    workarea.predictors[4] = ClipMV(workarea, zeroMV);
+  }
+
+//        if (optSearchOption == 5 || optSearchOption == 6) // only calc sad for x,y from DX12_ME
+  if (optSearchOption == 6) // only calc sad for x,y from DX12_ME, SO=5 is shader SAD now
+  {
+    workarea.bestMV = workarea.predictor; // clip outside - no need in MDegrain 
+    workarea.bestMV.sad = GetDM<pixel_t>(workarea, workarea.predictor.x, workarea.predictor.y);
+  }
+  else 
+  {
+    // Possible point of placement selection of 'predictors control'
+    if (_predictorType <= 0)
+      PseudoEPZSearch<pixel_t>(workarea); // all predictors (original)
+    else if (_predictorType == 1) // DTL: partial predictors
+      PseudoEPZSearch_glob_med_pred<pixel_t>(workarea);
+    else if (_predictorType == 2) // DTL: no predictiors
+      PseudoEPZSearch_no_pred<pixel_t>(workarea);
+    else // DTL: no refine (at level = 0 typically)
+      PseudoEPZSearch_no_refine<pixel_t>(workarea);
+
+    if (iAreaMode > 0 )
+    {
+      ProcessAreaMode<pixel_t>(workarea, false);
+    }
+
+  }
+
+  // workarea.bestMV = zeroMV; // debug
+
+  if (outfilebuf != NULL) // write vector to outfile
+  {
+    outfilebuf[workarea.blkx * 4 + 0] = workarea.bestMV.x;
+    outfilebuf[workarea.blkx * 4 + 1] = workarea.bestMV.y;
+    outfilebuf[workarea.blkx * 4 + 2] = (*(uint32_t*)(&workarea.bestMV.sad) & 0x0000ffff); // low word
+    outfilebuf[workarea.blkx * 4 + 3] = (*(uint32_t*)(&workarea.bestMV.sad) >> 16);     // high word, usually null
+  }
+
+  /* write the results */
+  pBlkData[workarea.blkx * N_PER_BLOCK + 0] = workarea.bestMV.x;
+  pBlkData[workarea.blkx * N_PER_BLOCK + 1] = workarea.bestMV.y;
+  pBlkData[workarea.blkx * N_PER_BLOCK + 2] = *(uint32_t*)(&workarea.bestMV.sad);
+
+
+
+  if (smallestPlane) // do we need it with DX12_ME ??? 
+  {
+    /*
+    int64_t i64_1 = 0;
+    int64_t i64_2 = 0;
+    int32_t i32 = 0;
+    unsigned int a1 = 200;
+    unsigned int a2 = 201;
+
+    i64_1 += a1 - a2; // 0x00000000 FFFFFFFF   !!!!!
+    i64_2 = i64_2 + a1 - a2; // 0xFFFFFFFF FFFFFFFF O.K.!
+    i32 += a1 - a2; // 0xFFFFFFFF
+    */
+
+    // int64_t += uint32_t - uint32_t is not ok, if diff would be negative
+    // LUMA diff can be negative! we should cast from uint32_t
+    // 64 bit cast or else: int64_t += uint32t - uint32_t results in int64_t += (uint32_t)(uint32t - uint32_t)
+    // which is baaaad 0x00000000 FFFFFFFF instead of 0xFFFFFFFF FFFFFFFF
+
+    // 161204 todo check: why is it not abs(lumadiff)?
+    typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
+    workarea.sumLumaChange += (safe_sad_t)LUMA(GetRefBlock(workarea, 0, 0), nRefPitch[0]) - (safe_sad_t)LUMA(workarea.pSrc[0], nSrcPitch[0]);
+  }
+}
+
+
+
 template<typename pixel_t>
 void	PlaneOfBlocks::search_mv_slice(Slicer::TaskData &td)
 {
@@ -5221,6 +5538,8 @@ void	PlaneOfBlocks::search_mv_slice(Slicer::TaskData &td)
 
   workarea.blky_beg = td._y_beg;
   workarea.blky_end = td._y_end;
+  workarea.blkx_beg = 0;
+  workarea.blkx_end = nBlkX;
 
   workarea.DCT = 0;
 #ifdef ALLOW_DCT
@@ -5290,166 +5609,8 @@ void	PlaneOfBlocks::search_mv_slice(Slicer::TaskData &td)
         workarea.blkIdx = workarea.blky * nBlkX + workarea.blkx;
         workarea.iter = 0;
         //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-        PROFILE_START(MOTION_PROFILE_ME);
-
-        // Resets the global predictor (it may have been clipped during the
-        // previous block scan)
-
-        // fixme: why recalc is resetting only outside, why, maybe recalc is not using that at all?
-        workarea.globalMVPredictor = _glob_mv_pred_def; // need to reset every time in AreaMode next searches (because am_shift added before clipping internally in the EPZ search)
 
-#if (ALIGN_SOURCEBLOCK > 1)
-        //store the pitch
-        const BYTE* pY = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
-        //create aligned copy
-        BLITLUMA(workarea.pSrc_temp[0], nSrcPitch[0], pY, nSrcPitch_plane[0]);
-        //set the to the aligned copy
-        workarea.pSrc[0] = workarea.pSrc_temp[0];
-        if (chroma)
-        {
-          workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
-          BLITCHROMA(workarea.pSrc_temp[1], nSrcPitch[1], workarea.pSrc[1], nSrcPitch_plane[1]);
-          workarea.pSrc[1] = workarea.pSrc_temp[1];
-          workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
-          BLITCHROMA(workarea.pSrc_temp[2], nSrcPitch[2], workarea.pSrc[2], nSrcPitch_plane[2]);
-          workarea.pSrc[2] = workarea.pSrc_temp[2];
-        }
-#else	// ALIGN_SOURCEBLOCK
-        workarea.pSrc[0] = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
-        if (chroma)
-        {
-          workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
-          workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
-        }
-#endif	// ALIGN_SOURCEBLOCK
-
-        // fixme note:
-        // MAnalyze mt-inconsistency reason #3
-        // this is _not_ internal mt friendly
-        // because workarea.nLambda is set to 0 differently:
-        // In vertically sliced multithreaded case it happens an _each_ top of the sliced block
-        // In non-mt: only for the most top blocks
-
-        if (workarea.blky == workarea.blky_beg)
-        {
-          workarea.nLambda = 0;
-        }
-        else
-        {
-          workarea.nLambda = _lambda_level;
-        }
-
-        // fixme:
-        // not exacly nice, but works
-        // different threads are writing, but the are the same always and come from parameters _pnew, _lsad
-        penaltyNew = _pnew; // penalty for new vector
-        LSAD = _lsad;    // SAD limit for lambda using
-        // may be they must be scaled by nPel ?
-
-        // decreased padding of coarse levels
-        int nHPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetHPadding() >> nLogScale;
-        int nVPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetVPadding() >> nLogScale;
-
-        /* additional AreaMode limits*/
-        int iAMmaxOffset = (iAreaMode * iAMstep) + iAMoffset;
-
-        /* computes search boundaries */
-        if (iUseSubShift == 0)
-        {
-          workarea.nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - workarea.x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled - iAMmaxOffset);
-          workarea.nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight() - workarea.y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled - iAMmaxOffset);
-          workarea.nDxMin = -nPel * (workarea.x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled - iAMmaxOffset);
-          workarea.nDyMin = -nPel * (workarea.y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled - iAMmaxOffset);
-        }
-        else
-        {
-          int iKS_sh_d2 = ((SHIFTKERNELSIZE / 2) + 2); // +2 is to prevent run out of buffer for UV planes
-          workarea.nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - workarea.x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled - iKS_sh_d2);
-          workarea.nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight() - workarea.y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled - iKS_sh_d2);
-          workarea.nDxMin = -nPel * (workarea.x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled - iKS_sh_d2);
-          workarea.nDyMin = -nPel * (workarea.y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled - iKS_sh_d2);
-        }
-
-        /* search the mv */
-        workarea.am_shift.x = 0; // set to zero always at startup and non-AreaMode search
-        workarea.am_shift.y = 0;
-
-        workarea.predictor = ClipMV(workarea, vectors[workarea.blkIdx]);
-        if (temporal)
-        {
-          workarea.predictors[4] = ClipMV(workarea, *reinterpret_cast<VECTOR*>(&_vecPrev[workarea.blkIdx * N_PER_BLOCK])); // temporal predictor
-        }
-        else
-        {
-          workarea.predictors[4] = ClipMV(workarea, zeroMV);
-        }
-
-//        if (optSearchOption == 5 || optSearchOption == 6) // only calc sad for x,y from DX12_ME
-        if (optSearchOption == 6) // only calc sad for x,y from DX12_ME, SO=5 is shader SAD now
-        {
-          workarea.bestMV = workarea.predictor; // clip outside - no need in MDegrain 
-          workarea.bestMV.sad = GetDM<pixel_t>(workarea, workarea.predictor.x, workarea.predictor.y);
-        }
-        else 
-        {
-          // Possible point of placement selection of 'predictors control'
-          if (_predictorType <= 0)
-            PseudoEPZSearch<pixel_t>(workarea); // all predictors (original)
-          else if (_predictorType == 1) // DTL: partial predictors
-            PseudoEPZSearch_glob_med_pred<pixel_t>(workarea);
-          else if (_predictorType == 2) // DTL: no predictiors
-            PseudoEPZSearch_no_pred<pixel_t>(workarea);
-          else // DTL: no refine (at level = 0 typically)
-            PseudoEPZSearch_no_refine<pixel_t>(workarea);
-
-          if (iAreaMode > 0 )
-          {
-            ProcessAreaMode<pixel_t>(workarea, false);
-          }
-
-        }
-
-        // workarea.bestMV = zeroMV; // debug
-
-        if (outfilebuf != NULL) // write vector to outfile
-        {
-          outfilebuf[workarea.blkx * 4 + 0] = workarea.bestMV.x;
-          outfilebuf[workarea.blkx * 4 + 1] = workarea.bestMV.y;
-          outfilebuf[workarea.blkx * 4 + 2] = (*(uint32_t*)(&workarea.bestMV.sad) & 0x0000ffff); // low word
-          outfilebuf[workarea.blkx * 4 + 3] = (*(uint32_t*)(&workarea.bestMV.sad) >> 16);     // high word, usually null
-        }
-
-        /* write the results */
-        pBlkData[workarea.blkx * N_PER_BLOCK + 0] = workarea.bestMV.x;
-        pBlkData[workarea.blkx * N_PER_BLOCK + 1] = workarea.bestMV.y;
-        pBlkData[workarea.blkx * N_PER_BLOCK + 2] = *(uint32_t*)(&workarea.bestMV.sad);
-
-        PROFILE_STOP(MOTION_PROFILE_ME);
-
-
-        if (smallestPlane) // do we need it with DX12_ME ??? 
-        {
-          /*
-          int64_t i64_1 = 0;
-          int64_t i64_2 = 0;
-          int32_t i32 = 0;
-          unsigned int a1 = 200;
-          unsigned int a2 = 201;
-
-          i64_1 += a1 - a2; // 0x00000000 FFFFFFFF   !!!!!
-          i64_2 = i64_2 + a1 - a2; // 0xFFFFFFFF FFFFFFFF O.K.!
-          i32 += a1 - a2; // 0xFFFFFFFF
-          */
-
-          // int64_t += uint32_t - uint32_t is not ok, if diff would be negative
-          // LUMA diff can be negative! we should cast from uint32_t
-          // 64 bit cast or else: int64_t += uint32t - uint32_t results in int64_t += (uint32_t)(uint32t - uint32_t)
-          // which is baaaad 0x00000000 FFFFFFFF instead of 0xFFFFFFFF FFFFFFFF
-
-          // 161204 todo check: why is it not abs(lumadiff)?
-          typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
-          workarea.sumLumaChange += (safe_sad_t)LUMA(GetRefBlock(workarea, 0, 0), nRefPitch[0]) - (safe_sad_t)LUMA(workarea.pSrc[0], nSrcPitch[0]);
-        }
+        search_mv_block<pixel_t>(workarea, pBlkData, outfilebuf);
 
         /* increment indexes & pointers */
         if (iblkx < nBlkX - 1)
@@ -5519,6 +5680,140 @@ void	PlaneOfBlocks::search_mv_slice(Slicer::TaskData &td)
 } // search_mv_slice
 
 
+// Processes one tile of the wavefront search. Tiles located above and on the
+// left are complete and the ones below-right are not started yet, so the
+// spatial predictors are the same as in a whole-frame scan. On the tile
+// borders, the right and lower neighbours still hold the predictors
+// interpolated from the coarser level.
+// With meander, the scan direction alternates inside the tile width.
+template<typename pixel_t>
+void	PlaneOfBlocks::search_mv_tile(SchedulerTiles::TaskData &td)
+{
+  assert(&td != 0);
+
+  const int		nbr_tx = _tile_graph.get_nbr_tx();
+  const int		tx = td._task_index % nbr_tx;
+  const int		ty = td._task_index / nbr_tx;
+  const int		bx_beg = tx * _tile_w;
+  const int		bx_end = std::min(bx_beg + _tile_w, nBlkX);
+  const int		by_beg = ty * _tile_h;
+  const int		by_end = std::min(by_beg + _tile_h, nBlkY);
+
+  WorkingArea &	workarea = *(_workarea_pool.take_obj());
+  assert(&workarea != 0);
+
+  // Whole plane: top and bottom predictors are only cut at the frame borders.
+  // Left and right ones are cut at the tile borders: the right neighbour tile
+  // is not searched yet.
+  workarea.blky_beg = 0;
+  workarea.blky_end = nBlkY;
+  workarea.blkx_beg = bx_beg;
+  workarea.blkx_end = bx_end;
+
+  workarea.DCT = 0;
+#ifdef ALLOW_DCT
+  if (_dct_pool_ptr != 0)
+  {
+    workarea.DCT = _dct_pool_ptr->take_obj();
+  }
+#endif	// ALLOW_DCT
+
+  workarea.planeSAD = 0; // for debug, plus fixme outer planeSAD is not used
+  workarea.sumLumaChange = 0;
+
+  const int nBlkSizeX_Ovr[3] = { (nBlkSizeX - nOverlapX), (nBlkSizeX - nOverlapX) >> nLogxRatioUV, (nBlkSizeX - nOverlapX) >> nLogxRatioUV };
+  const int nBlkSizeY_Ovr[3] = { (nBlkSizeY - nOverlapY), (nBlkSizeY - nOverlapY) >> nLogyRatioUV, (nBlkSizeY - nOverlapY) >> nLogyRatioUV };
+
+  int x0[3] = { pSrcFrame->GetPlane(YPLANE)->GetHPadding(), 0, 0 };
+  int y0[3] = { pSrcFrame->GetPlane(YPLANE)->GetVPadding(), 0, 0 };
+  if (chroma)
+  {
+    x0[1] = pSrcFrame->GetPlane(UPLANE)->GetHPadding();
+    x0[2] = pSrcFrame->GetPlane(VPLANE)->GetHPadding();
+  }
+  if (pSrcFrame->GetMode() & UPLANE)
+  {
+    y0[1] = pSrcFrame->GetPlane(UPLANE)->GetVPadding();
+  }
+  if (pSrcFrame->GetMode() & VPLANE)
+  {
+    y0[2] = pSrcFrame->GetPlane(VPLANE)->GetVPadding();
+  }
+
+  for (workarea.blky = by_beg; workarea.blky < by_end; workarea.blky++)
+  {
+    int *pBlkData = _out + 1 + workarea.blky * nBlkX * N_PER_BLOCK;
+    short *outfilebuf = _outfilebuf;
+    if (outfilebuf != NULL)
+    {
+      outfilebuf += workarea.blky * nBlkX * 4;// 4 short word per block
+    }
+
+    for (int p = 0; p < 3; ++p)
+    {
+      workarea.y[p] = y0[p] + workarea.blky * nBlkSizeY_Ovr[p];
+    }
+
+    workarea.blkScanDir = (workarea.blky % 2 == 0 || !_meander_flag) ? 1 : -1;
+    const int blkxStart = (workarea.blkScanDir == 1) ? bx_beg : bx_end - 1;
+
+    for (int iblkx = 0; iblkx < bx_end - bx_beg; iblkx++)
+    {
+      workarea.blkx = blkxStart + iblkx * workarea.blkScanDir;
+      workarea.blkIdx = workarea.blky * nBlkX + workarea.blkx;
+
+      if (_predictorType != 4)
+      {
+        workarea.iter = 0;
+        for (int p = 0; p < 3; ++p)
+        {
+          workarea.x[p] = x0[p] + workarea.blkx * nBlkSizeX_Ovr[p];
+        }
+
+        search_mv_block<pixel_t>(workarea, pBlkData, outfilebuf);
+      }
+      else
+      {
+        workarea.bestMV = vectors[workarea.blkIdx];
+
+        if (outfilebuf != NULL) // write vector to outfile
+        {
+          outfilebuf[workarea.blkx * 4 + 0] = workarea.bestMV.x;
+          outfilebuf[workarea.blkx * 4 + 1] = workarea.bestMV.y;
+          outfilebuf[workarea.blkx * 4 + 2] = (*(uint32_t*)(&workarea.bestMV.sad) & 0x0000ffff); // low word
+          outfilebuf[workarea.blkx * 4 + 3] = (*(uint32_t*)(&workarea.bestMV.sad) >> 16);     // high word, usually null
+        }
+
+        pBlkData[workarea.blkx * N_PER_BLOCK + 0] = workarea.bestMV.x;
+        pBlkData[workarea.blkx * N_PER_BLOCK + 1] = workarea.bestMV.y;
+        pBlkData[workarea.blkx * N_PER_BLOCK + 2] = *(uint32_t*)(&workarea.bestMV.sad);
+      }
+    }	// for iblkx
+  }	// for workarea.blky
+
+  // Own slot of the tile, summed by SearchMVs() once all the tiles are done
+  _tile_plane_sad_arr[td._task_index] = workarea.planeSAD;
+  _tile_luma_change_arr[td._task_index] = workarea.sumLumaChange;
+
+  if (isse)
+  {
+#ifndef _M_X64
+    _mm_empty();
+#endif
+  }
+
+#ifdef ALLOW_DCT
+  if (_dct_pool_ptr != 0)
+  {
+    _dct_pool_ptr->return_obj(*(workarea.DCT));
+    workarea.DCT = 0;
+  }
+#endif
+
+  _workarea_pool.return_obj(workarea);
+} // search_mv_tile
+
+
 template<typename pixel_t>
 void	PlaneOfBlocks::search_mv_slice_rv(Slicer::TaskData& td)
 {
@@ -5533,6 +5828,8 @@ void	PlaneOfBlocks::search_mv_slice_rv(Slicer::TaskData& td)
 //  workarea.blky_end = td._y_end;
   workarea.blky_beg = td._y_end - 1; // y_end is last row index (exclusive - so -1)
   workarea.blky_end = td._y_beg;
+  workarea.blkx_beg = 0;
+  workarea.blkx_end = nBlkX;
 
 
   workarea.DCT = 0;
@@ -5605,7 +5902,6 @@ void	PlaneOfBlocks::search_mv_slice_rv(Slicer::TaskData& td)
         workarea.blkIdx = workarea.blky * nBlkX + workarea.blkx;
         workarea.iter = 0;
         //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-        PROFILE_START(MOTION_PROFILE_ME);
 
         // Resets the global predictor (it may have been clipped during the
         // previous block scan)
@@ -5739,7 +6035,6 @@ void	PlaneOfBlocks::search_mv_slice_rv(Slicer::TaskData& td)
         pBlkData[workarea.blkx * N_PER_BLOCK + 1] = workarea.bestMV.y;
         pBlkData[workarea.blkx * N_PER_BLOCK + 2] = *(uint32_t*)(&workarea.bestMV.sad);
 
-        PROFILE_STOP(MOTION_PROFILE_ME);
 
 
         if (smallestPlane) // do we need it with DX12_ME ??? 
@@ -6258,6 +6553,8 @@ void	PlaneOfBlocks::search_mv_slice_SO2(Slicer::TaskData& td)
 
   workarea.blky_beg = td._y_beg;
   workarea.blky_end = td._y_end;
+  workarea.blkx_beg = 0;
+  workarea.blkx_end = nBlkX;
 
   workarea.DCT = 0;
 
@@ -6360,7 +6657,6 @@ void	PlaneOfBlocks::search_mv_slice_SO2(Slicer::TaskData& td)
         workarea.blkIdx = workarea.blky * nBlkX + workarea.blkx;
         workarea.iter = 0;
         //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-        PROFILE_START(MOTION_PROFILE_ME);
 
         // Resets the global predictor (it may have been clipped during the
         // previous block scan)
@@ -6464,7 +6760,6 @@ void	PlaneOfBlocks::search_mv_slice_SO2(Slicer::TaskData& td)
         pBlkData[workarea.blkx * N_PER_BLOCK + 1] = workarea.bestMV.y;
         pBlkData[workarea.blkx * N_PER_BLOCK + 2] = *(uint32_t*)(&workarea.bestMV.sad);
 
-        PROFILE_STOP(MOTION_PROFILE_ME);
 
         if (smallestPlane)
         {
@@ -6562,6 +6857,8 @@ void	PlaneOfBlocks::search_mv_slice_SO3(Slicer::TaskData& td) // multi-blocks se
 
   workarea.blky_beg = td._y_beg;
   workarea.blky_end = td._y_end;
+  workarea.blkx_beg = 0;
+  workarea.blkx_end = nBlkX;
 
   workarea.DCT = 0;
 
@@ -6638,7 +6935,6 @@ void	PlaneOfBlocks::search_mv_slice_SO3(Slicer::TaskData& td) // multi-blocks se
         workarea.blkIdx = workarea.blky * nBlkX + workarea.blkx;
         workarea.iter = 0;
         //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-        PROFILE_START(MOTION_PROFILE_ME);
 
         // Resets the global predictor (it may have been clipped during the
         // previous block scan)
@@ -6736,7 +7032,6 @@ void	PlaneOfBlocks::search_mv_slice_SO3(Slicer::TaskData& td) // multi-blocks se
         pBlkData[workarea.blkx * N_PER_BLOCK + 1] = workarea.bestMV.y;
         pBlkData[workarea.blkx * N_PER_BLOCK + 2] = *(uint32_t*)(&workarea.bestMV.sad);
         */
-        PROFILE_STOP(MOTION_PROFILE_ME);
 
         if (smallestPlane)
         {
@@ -6809,7 +7104,6 @@ void	PlaneOfBlocks::search_mv_slice_SO3(Slicer::TaskData& td) // multi-blocks se
        
 
         //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-        PROFILE_START(MOTION_PROFILE_ME);
 
         // Resets the global predictor (it may have been clipped during the
         // previous block scan)
@@ -6906,7 +7200,6 @@ void	PlaneOfBlocks::search_mv_slice_SO3(Slicer::TaskData& td) // multi-blocks se
         */
         // 4 results written internally in Exa_search_4Blks()
 
-        PROFILE_STOP(MOTION_PROFILE_ME);
 
         if (smallestPlane)
         {
@@ -6978,6 +7271,8 @@ void	PlaneOfBlocks::search_mv_slice_SO4(Slicer::TaskData& td) // multi-blocks se
 
   workarea.blky_beg = td._y_beg;
   workarea.blky_end = td._y_end;
+  workarea.blkx_beg = 0;
+  workarea.blkx_end = nBlkX;
 
   workarea.DCT = 0;
 
@@ -7054,7 +7349,6 @@ void	PlaneOfBlocks::search_mv_slice_SO4(Slicer::TaskData& td) // multi-blocks se
         workarea.blkIdx = workarea.blky * nBlkX + workarea.blkx;
         workarea.iter = 0;
         //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-        PROFILE_START(MOTION_PROFILE_ME);
 
         // Resets the global predictor (it may have been clipped during the
         // previous block scan)
@@ -7152,7 +7446,6 @@ void	PlaneOfBlocks::search_mv_slice_SO4(Slicer::TaskData& td) // multi-blocks se
                   pBlkData[workarea.blkx * N_PER_BLOCK + 1] = workarea.bestMV.y;
                   pBlkData[workarea.blkx * N_PER_BLOCK + 2] = *(uint32_t*)(&workarea.bestMV.sad);
                   */
-        PROFILE_STOP(MOTION_PROFILE_ME);
 
         if (smallestPlane)
         {
@@ -7204,7 +7497,6 @@ void	PlaneOfBlocks::search_mv_slice_SO4(Slicer::TaskData& td) // multi-blocks se
         workarea.blkIdx = workarea.blky * nBlkX + workarea.blkx;
         workarea.iter = 0;
         //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-        PROFILE_START(MOTION_PROFILE_ME);
 
         // Resets the global predictor (it may have been clipped during the
         // previous block scan)
@@ -7301,7 +7593,6 @@ void	PlaneOfBlocks::search_mv_slice_SO4(Slicer::TaskData& td) // multi-blocks se
         */
         // 4 results written internally in Exa_search_4Blks()
 
-        PROFILE_STOP(MOTION_PROFILE_ME);
 
         if (smallestPlane)
         {
@@ -7371,6 +7662,8 @@ void	PlaneOfBlocks::recalculate_mv_slice(Slicer::TaskData &td)
 
   workarea.blky_beg = td._y_beg;
   workarea.blky_end = td._y_end;
+  workarea.blkx_beg = 0;
+  workarea.blkx_end = nBlkX;
 
   workarea.DCT = 0;
 #ifdef ALLOW_DCT
@@ -7457,7 +7750,6 @@ void	PlaneOfBlocks::recalculate_mv_slice(Slicer::TaskData &td)
       workarea.blkx = blkxStart + iblkx*workarea.blkScanDir;
       workarea.blkIdx = workarea.blky*nBlkX + workarea.blkx;
       //		DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-      PROFILE_START(MOTION_PROFILE_ME);
 
 #if (ALIGN_SOURCEBLOCK > 1)
       //store the pitch
@@ -7635,7 +7927,6 @@ void	PlaneOfBlocks::recalculate_mv_slice(Slicer::TaskData &td)
       pBlkData[workarea.blkx*N_PER_BLOCK + 2] = workarea.bestMV.sad;
 
 
-      PROFILE_STOP(MOTION_PROFILE_ME);
 
       if (smallestPlane)
       {
@@ -7863,7 +8154,7 @@ PlaneOfBlocks::WorkingArea *PlaneOfBlocks::WorkingAreaFactory::do_create()
 }
 
 
-PlaneOfBlocks::ExhaustiveSearchFunction_t PlaneOfBlocks::get_ExhaustiveSearchFunction(int BlockX, int BlockY, int SearchParam, int _bits_per_pixel, arch_t arch)
+PlaneOfBlocks::ExhaustiveSearchFunction_t PlaneOfBlocks::get_ExhaustiveSearchFunction(int BlockX, int BlockY, int SearchParam, int _bits_per_pixel, int _nPel, arch_t arch)
 {
 
   // BlkSizeX, BlkSizeY, bits_per_pixel, arch_t
@@ -7890,7 +8181,7 @@ PlaneOfBlocks::ExhaustiveSearchFunction_t PlaneOfBlocks::get_ExhaustiveSearchFun
   ExhaustiveSearchFunction_t result = nullptr;
   arch_t archlist[] = { USE_AVX512, USE_AVX2, USE_AVX, USE_SSE41, USE_SSE2, NO_SIMD };
   int index = 0;
-  while (result == nullptr) {
+  while (result == nullptr && _nPel == 1) { // the ones above read full-pel positions only
     arch_t current_arch_try = archlist[index++];
     if (current_arch_try > arch) continue;
     result = func_fn[std::make_tuple(BlockX, BlockY, SearchParam, _bits_per_pixel, current_arch_try)];
@@ -7900,6 +8191,16 @@ PlaneOfBlocks::ExhaustiveSearchFunction_t PlaneOfBlocks::get_ExhaustiveSearchFun
     }
   }
 
+  // Generic multi-candidate versions for the other block sizes, bit depths and nPel
+  if (result == nullptr && SearchParam > 0 && _bits_per_pixel <= 16)
+  {
+    const int pixelsize_ = (_bits_per_pixel + 7) >> 3;
+    if (arch >= USE_AVX512)
+      result = get_ExhaustiveSearchFunction_mc_avx512(BlockX, BlockY, SearchParam, pixelsize_);
+    if (result == nullptr && arch >= USE_AVX2)
+      result = get_ExhaustiveSearchFunction_mc_avx2(BlockX, BlockY, SearchParam, pixelsize_);
+  }
+
   return result;
 }
 
@@ -8248,14 +8549,14 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2_8x8_avx2(WorkingArea& workarea) // +
   workarea.bestMV.sad = sad;
   workarea.nMinCost = sad + ((penaltyZero * (safe_sad_t)sad) >> 8); // v.1.11.0.2
 
-  iNumCheckedVectors = 0;
-  checked_mv_vectors[iNumCheckedVectors] = 0;
-  iNumCheckedVectors++;
+  workarea.iNumCheckedVectors = 0;
+  workarea.checked_mv_vectors[workarea.iNumCheckedVectors] = 0;
+  workarea.iNumCheckedVectors++;
 
   // Global MV predictor  - added by Fizick
   workarea.globalMVPredictor = ClipMV_SO2(workarea, workarea.globalMVPredictor);
 
-  if (!IsVectorChecked((uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
+  if (!IsVectorChecked(workarea, (uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
   {
     //    sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y));
     pucRef = (uint8_t*)GetRefBlock(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y);
@@ -8278,7 +8579,7 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2_8x8_avx2(WorkingArea& workarea) // +
   //	if (   (( workarea.predictor.x != zeroMVfieldShifted.x ) || ( workarea.predictor.y != zeroMVfieldShifted.y ))
   //	    && (( workarea.predictor.x != workarea.globalMVPredictor.x ) || ( workarea.predictor.y != workarea.globalMVPredictor.y )))
   //	{
-  if (!IsVectorChecked((uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
+  if (!IsVectorChecked(workarea, (uint64_t)workarea.predictor.x | ((uint64_t)workarea.predictor.y << 32)))
   {
     //    sad = LumaSAD<pixel_t>(workarea, GetRefBlock(workarea, workarea.predictor.x, workarea.predictor.y));
     pucRef = (uint8_t*)GetRefBlock(workarea, workarea.predictor.x, workarea.predictor.y);
@@ -8317,7 +8618,7 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2_8x8_avx2(WorkingArea& workarea) // +
     // vectors were clipped in FetchPredictors - no new IsVectorOK() check ?
     if ((iMask & 0x1) != 0)
     {
-      if (!IsVectorChecked((uint64_t)workarea.predictors[0].x | ((uint64_t)workarea.predictors[0].y << 32)))
+      if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[0].x | ((uint64_t)workarea.predictors[0].y << 32)))
       {
         //      CheckMV0_SO2<pixel_t>(workarea, workarea.predictors[0].x, workarea.predictors[0].y, _mm_extract_epi32(xmm0_cost, 0));
         cost = _mm_extract_epi32(xmm0_cost, 0);
@@ -8339,7 +8640,7 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2_8x8_avx2(WorkingArea& workarea) // +
     }
     if ((iMask & 0x10) != 0)
     {
-      if (!IsVectorChecked((uint64_t)workarea.predictors[1].x | ((uint64_t)workarea.predictors[1].y << 32)))
+      if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[1].x | ((uint64_t)workarea.predictors[1].y << 32)))
       {
         //      CheckMV0_SO2<pixel_t>(workarea, workarea.predictors[1].x, workarea.predictors[1].y, _mm_extract_epi32(xmm0_cost, 1));
         cost = _mm_extract_epi32(xmm0_cost, 1);
@@ -8362,7 +8663,7 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2_8x8_avx2(WorkingArea& workarea) // +
     }
     if ((iMask & 0x100) != 0)
     {
-      if (!IsVectorChecked((uint64_t)workarea.predictors[2].x | ((uint64_t)workarea.predictors[2].y << 32)))
+      if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[2].x | ((uint64_t)workarea.predictors[2].y << 32)))
       {
         //      CheckMV0_SO2<pixel_t>(workarea, workarea.predictors[2].x, workarea.predictors[2].y, _mm_extract_epi32(xmm0_cost, 2));
         cost = _mm_extract_epi32(xmm0_cost, 2);
@@ -8385,7 +8686,7 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO2_8x8_avx2(WorkingArea& workarea) // +
     }
     if ((iMask & 0x1000) != 0)
     {
-      if (!IsVectorChecked((uint64_t)workarea.predictors[3].x | ((uint64_t)workarea.predictors[3].y << 32)))
+      if (!IsVectorChecked(workarea, (uint64_t)workarea.predictors[3].x | ((uint64_t)workarea.predictors[3].y << 32)))
       {
         //      CheckMV0_SO2<pixel_t>(workarea, workarea.predictors[3].x, workarea.predictors[3].y, _mm_extract_epi32(xmm0_cost, 3));
         cost = _mm_extract_epi32(xmm0_cost, 3);
@@ -8687,12 +8988,12 @@ void PlaneOfBlocks::PseudoEPZSearch_optSO3_glob_pred_avx2(WorkingArea& workarea,
   workarea.bestMV_multi[3].sad = sad;
   workarea.nMinCost_multi[3] = sad + ((penaltyZero * (safe_sad_t)sad) >> 8); // v.1.11.0.2*/
 
-  iNumCheckedVectors = 0;
-  checked_mv_vectors[iNumCheckedVectors] = 0;
-  iNumCheckedVectors++;
+  workarea.iNumCheckedVectors = 0;
+  workarea.checked_mv_vectors[workarea.iNumCheckedVectors] = 0;
+  workarea.iNumCheckedVectors++;
 
   workarea.globalMVPredictor = ClipMV_SO2(workarea, workarea.globalMVPredictor);
-  if (!IsVectorChecked((uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
+  if (!IsVectorChecked(workarea, (uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
   {
     pucRef = (uint8_t*)GetRefBlock(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y);
 
@@ -9060,12 +9361,12 @@ zmm17_r1_b0815 = _mm512_adds_epi16(zmm17_r1_b0815, zmm25_r5_b0815);
   workarea.bestMV_multi[15].sad = sad;
   workarea.nMinCost_multi[15] = sad + ((penaltyZero * (safe_sad_t)sad) >> 8); // v.1.11.0.2*/
 
-  iNumCheckedVectors = 0;
-  checked_mv_vectors[iNumCheckedVectors] = 0;
-  iNumCheckedVectors++;
+  workarea.iNumCheckedVectors = 0;
+  workarea.checked_mv_vectors[workarea.iNumCheckedVectors] = 0;
+  workarea.iNumCheckedVectors++;
 
   workarea.globalMVPredictor = ClipMV_SO2(workarea, workarea.globalMVPredictor);
-  if (!IsVectorChecked((uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
+  if (!IsVectorChecked(workarea, (uint64_t)workarea.globalMVPredictor.x | ((uint64_t)workarea.globalMVPredictor.y << 32)))
   {
     pucRef = (uint8_t*)GetRefBlock(workarea, workarea.globalMVPredictor.x, workarea.globalMVPredictor.y);
 
@@ -9647,6 +9948,43 @@ MV_FORCEINLINE sad_t PlaneOfBlocks::GetDMLuma(WorkingArea& workarea, int vx, int
   return sad;
 }
 
+// Same as GetDMLuma, but stops once cost + sad + penalty reaches nMinCost.
+// The returned sad is then partial, and already too high to be selected.
+template<typename pixel_t>
+MV_FORCEINLINE sad_t PlaneOfBlocks::GetDMLumaBounded(WorkingArea& workarea, int vx, int vy, sad_t cost, int penalty)
+{
+  if (SADPART == nullptr)
+  {
+    return GetDMLuma<pixel_t>(workarea, vx, vy);
+  }
+
+  typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
+
+  const unsigned char* pRef;
+  int iRefPitchY;
+  if (iUseSubShift == 0)
+  {
+    pRef = GetRefBlock(workarea, vx, vy);
+    iRefPitchY = nRefPitch[0];
+  }
+  else
+  {
+    pRef = GetRefBlockSubShifted(workarea, vx, vy, iRefPitchY);
+  }
+  const unsigned char* pSrc = workarea.pSrc[0];
+
+  sad_t sad = SADPART(pSrc, nSrcPitch[0], pRef, iRefPitchY);
+  for (int y = nPartRows; y < nBlkSizeY; y += nPartRows)
+  {
+    if (cost + sad + ((penalty*(safe_sad_t)sad) >> 8) >= workarea.nMinCost) break;
+    pSrc += nSrcPitch[0] * nPartRows;
+    pRef += iRefPitchY * nPartRows;
+    sad += SADPART(pSrc, nSrcPitch[0], pRef, iRefPitchY);
+  }
+
+  return sad;
+}
+
 MV_FORCEINLINE VECTOR PlaneOfBlocks::GetMDpredictor(WorkingArea& workarea)
 {
   VECTOR vPredictors[MAX_PREDICTOR];
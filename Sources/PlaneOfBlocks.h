@@ -28,6 +28,8 @@
 
 #include "conc/ObjPool.h"
 #include "CopyCode.h"
+#include "MTFlowGraphSched.h"
+#include "MTFlowGraphWavefront.h"
 #include "MTSlicer.h"
 #include	"MVInterface.h"	// Required for ALIGN_SOURCEBLOCK
 #include "SADFunctions.h"
@@ -110,10 +112,14 @@ public:
 
   typedef	MTSlicer <PlaneOfBlocks>	Slicer;
 
+  // Wavefront tiles for the multithreaded search, see search_mv_tile()
+  enum { MAX_TILE_COLS = 32, MAX_TILE_ROWS = 32, MIN_TILE_W = 4 };
+  typedef	MTFlowGraphSched <PlaneOfBlocks, MTFlowGraphWavefront, PlaneOfBlocks, MAX_TILE_COLS * MAX_TILE_ROWS>	SchedulerTiles;
+
   PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSizeY, int _nPel, int _nLevel, int _nFlags, int _nOverlapX, int _nOverlapY,
     int _xRatioUV, int _yRatioUV, int _pixelsize, int _bits_per_pixel,
     conc::ObjPool <DCTClass>* dct_pool_ptr,
-    bool mt_flag, int _chromaSADscale, int _optSearchOption, float _scaleCSADfine, int _iUseSubShift, int _DMFlags,
+    bool mt_flag, bool tile_flag, int _chromaSADscale, int _optSearchOption, float _scaleCSADfine, int _iUseSubShift, int _DMFlags,
     int _AMDiffSAD,
   IScriptEnvironment* env);
 
@@ -143,6 +149,8 @@ public:
   void WriteHeaderToArray(int *array);
   int WriteDefaultToArray(int *array, int divideExtra);
   int GetArraySize(int divideExtra);
+  void InvertPrediction(const int *array, MVFrame *_pSrcFrame); // predictors from the opposite direction field
+  int WritePredictionToArray(int *array);
   // not used void FitReferenceIntoArray(MVFrame *_pRefFrame, int *array);
   void EstimateGlobalMVDoubled(VECTOR *globalMVec, Slicer &slicer); // Fizick
   MV_FORCEINLINE int GetnBlkX() { return nBlkX; }
@@ -185,6 +193,7 @@ private:
   const int      pixelsize_shift; // log of pixelsize (0,1,2) for shift instead of mul or div
   const int      bits_per_pixel;
   const bool     _mt_flag;         // Allows multithreading
+  const bool     _tile_flag;       // Multithreaded search over wavefront tiles instead of row slices
   const int      chromaSADscale;   // PF experimental 2.7.18.22 allow e.g. YV24 chroma to have the same magnitude as for YV12
   int            effective_chromaSADscale;   // PF experimental 2.7.18.22 allow e.g. YV24 chroma to have the same magnitude as for YV12
   const int      optSearchOption; // DTL test != 0: allow new performance optimizations
@@ -198,6 +207,8 @@ private:
   COPYFunction * BLITCHROMA;
   SADFunction *  SADCHROMA;
   SADFunction *  SATD;              /* SATD function, (similar to SAD), used as replacement to dct */
+  SADFunction *  SADPART;          /* SAD of the nPartRows first rows of a block, nullptr when early termination is off */
+  int            nPartRows;        /* rows per SADPART chunk */
 
   // DTL test
   DisMetric* DM_Luma;
@@ -207,7 +218,7 @@ private:
   class WorkingArea; // forward
   using ExhaustiveSearchFunction_t = void(PlaneOfBlocks::*)(WorkingArea& workarea, int mvx, int mvy);
 
-  ExhaustiveSearchFunction_t get_ExhaustiveSearchFunction(int BlockX, int BlockY, int SearchParam, int bits_per_pixel, arch_t arch);
+  ExhaustiveSearchFunction_t get_ExhaustiveSearchFunction(int BlockX, int BlockY, int SearchParam, int bits_per_pixel, int nPel, arch_t arch);
   ExhaustiveSearchFunction_t ExhaustiveSearchFunctions[MAX_SUPPORTED_EXH_SEARCHPARAM + 1]; // the function pointer
 
   //std::vector <VECTOR>              /* motion vectors of the blocks */
@@ -277,6 +288,15 @@ private:
   short *_outfilebuf;
   int *_vecPrev;
   bool _meander_flag;
+
+  // Tile grid of the wavefront search. Only depends on the plane size, so
+  // the vectors don't depend on the number of threads.
+  MTFlowGraphWavefront _tile_graph;
+  int _tile_w;                    // in blocks
+  int _tile_h;
+  // Partial sums of each tile, added in tile order after the search
+  std::vector <bigsad_t> _tile_plane_sad_arr;
+  std::vector <bigsad_t> _tile_luma_change_arr;
   int _pnew;
   sad_t _lsad;
   MVClip *	_mv_clip_ptr;
@@ -290,9 +310,6 @@ private:
   int      iTMAvg; // trymany averaging modes, -1 - default - minimumSAD(DM)
   int      iMDp; // MotionDistorion predictor used, -1 - hierarchy predictor, 0 and higher - AMAvg averaging of some predictors
 
-  uint64_t checked_mv_vectors[MAX_PREDICTOR]; // 2.7.46
-  int iNumCheckedVectors; // 2.7.46
-
   // AreaMode globals
   int iAreaMode; // 2.7.46
   int iAMDiffSAD;
@@ -335,6 +352,8 @@ private:
     bigsad_t sumLumaChange;     // partial luma change sum
     int blky_beg;               // First line of blocks to process from this thread
     int blky_end;               // Last line of blocks + 1 to process from this thread
+    int blkx_beg;               // First column of blocks predictors may be taken from
+    int blkx_end;               // Last column of blocks + 1 predictors may be taken from
 
     // Current block
     const uint8_t* pSrc[3];     // the alignment of this array is important for speed for some reason (cacheline?)
@@ -347,6 +366,9 @@ private:
     VECTOR predictors[MAX_PREDICTOR];   /* set of predictors for the current block */
     VECTOR MDpredictor;         /* predictor for MotionDistortion measurement */
 
+    uint64_t checked_mv_vectors[MAX_PREDICTOR]; // 2.7.46, predictors already checked for the current block
+    int iNumCheckedVectors; // 2.7.46
+
     int nDxMin;                 /* minimum x coordinate for the vector */ //need to be in order DxMin, DyMin for ClipMV faster load
     int nDyMin;                 /* minimum y coordinate for the vector */
     int nDxMax;                 /* maximum x corrdinate for the vector */
@@ -591,6 +613,13 @@ private:
   void ExhaustiveSearch16x16_uint8_np1_sp2_avx2(WorkingArea& workarea, int mvx, int mvy); // minsadbw only version
   void ExhaustiveSearch16x16_uint8_SO2_np1_sp2_avx2(WorkingArea& workarea, int mvx, int mvy); // minsadbw only version
 
+  // Multi-candidate versions for the other cases: 4x4 to 32x32 blocks, 8 to 16 bit,
+  // any nPel. V is the vector class, see PlaneOfBlocks_exa.h
+  template <class V, typename pixel_t, int BW, int BH, int SP>
+  void ExhaustiveSearch_mc(WorkingArea& workarea, int mvx, int mvy);
+  static ExhaustiveSearchFunction_t get_ExhaustiveSearchFunction_mc_avx2(int BlockX, int BlockY, int SearchParam, int pixelsize);
+  static ExhaustiveSearchFunction_t get_ExhaustiveSearchFunction_mc_avx512(int BlockX, int BlockY, int SearchParam, int pixelsize);
+
 
   // END OF DTL test function
 
@@ -686,15 +715,21 @@ private:
   // MV_FORCEINLINE static unsigned int SquareDifferenceNorm(const VECTOR& v1, const VECTOR& v2); // not used
   MV_FORCEINLINE static unsigned int SquareDifferenceNorm(const VECTOR& v1, const int v2x, const int v2y);
   MV_FORCEINLINE bool IsInFrame(int i);
-  MV_FORCEINLINE bool IsVectorChecked(uint64_t xy); // 2.7.46
+  MV_FORCEINLINE static bool IsVectorChecked(WorkingArea &workarea, uint64_t xy); // 2.7.46
   MV_FORCEINLINE bool IsVectorsCoherent(VECTOR_XY* vectors_coh_check, int cnt);
 
   template<typename pixel_t>
   void Refine(WorkingArea &workarea);
 
+  template<typename pixel_t>
+  MV_FORCEINLINE void search_mv_block(WorkingArea &workarea, int *pBlkData, short *outfilebuf);
+
   template<typename pixel_t>
   void	search_mv_slice(Slicer::TaskData &td);
 
+  template<typename pixel_t>
+  void	search_mv_tile(SchedulerTiles::TaskData &td);
+
   template<typename pixel_t>
   void	search_mv_slice_rv(Slicer::TaskData& td); // temp test of reverset V scan
 
@@ -727,6 +762,9 @@ private:
   template<typename pixel_t>
   MV_FORCEINLINE sad_t GetDMLuma(WorkingArea& workarea, int vx, int vy); // Luma only
 
+  template<typename pixel_t>
+  MV_FORCEINLINE sad_t GetDMLumaBounded(WorkingArea& workarea, int vx, int vy, sad_t cost, int penalty); // Luma only, early termination
+
 };
 
 MV_FORCEINLINE float fDiffAngleVect(int x1, int y1, int x2, int y2); // temp here - need to be moved for common header with MDegrain
@@ -2014,3 +2014,78 @@ ymm8_r1 = _mm256_slli_epi64(ymm8_r1, 48);
 
 }
 
+
+// Vector class for the multi-candidate exhaustive search of PlaneOfBlocks_exa.h
+class ExaVecAvx2
+{
+public:
+  typedef __m256i vec_t;
+  enum { VBYTES = 32 };
+
+  static MV_FORCEINLINE __m256i zero() { return _mm256_setzero_si256(); }
+
+  template <int CB, int R>
+  static MV_FORCEINLINE __m256i load_rows(const uint8_t* p, int pitch)
+  {
+    if constexpr (CB == 32)
+    {
+      return _mm256_loadu_si256((const __m256i*)p);
+    }
+    else if constexpr (CB == 16)
+    {
+      static_assert(R == 2, "unsupported row count");
+      return _mm256_loadu2_m128i((const __m128i*)(p + pitch), (const __m128i*)p);
+    }
+    else if constexpr (CB == 8)
+    {
+      static_assert(R == 4, "unsupported row count");
+      const __m128i lo = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)p), _mm_loadl_epi64((const __m128i*)(p + pitch)));
+      const __m128i hi = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(p + pitch * 2)), _mm_loadl_epi64((const __m128i*)(p + pitch * 3)));
+      return _mm256_set_m128i(hi, lo);
+    }
+    else
+    {
+      static_assert(CB == 4 && R == 4, "unsupported row count");
+      const __m128i lo = _mm_setr_epi32(*(const int*)p, *(const int*)(p + pitch), *(const int*)(p + pitch * 2), *(const int*)(p + pitch * 3));
+      return _mm256_set_m128i(_mm_setzero_si128(), lo);
+    }
+  }
+
+  template <typename pixel_t>
+  static MV_FORCEINLINE __m256i sad_acc(__m256i acc, __m256i a, __m256i b)
+  {
+    if constexpr (sizeof(pixel_t) == 1)
+    {
+      return _mm256_add_epi32(acc, _mm256_sad_epu8(a, b));
+    }
+    else
+    {
+      // No vpsadw: |a - b| with saturated subtractions, then widened to 32 bits
+      const __m256i d = _mm256_or_si256(_mm256_subs_epu16(a, b), _mm256_subs_epu16(b, a));
+      acc = _mm256_add_epi32(acc, _mm256_srli_epi32(d, 16));
+      return _mm256_add_epi32(acc, _mm256_and_si256(d, _mm256_set1_epi32(0xFFFF)));
+    }
+  }
+
+  static MV_FORCEINLINE int hsum(__m256i acc)
+  {
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+  }
+
+  static MV_FORCEINLINE void cleanup() { _mm256_zeroupper(); }
+};
+
+#include "PlaneOfBlocks_exa.h"
+
+PlaneOfBlocks::ExhaustiveSearchFunction_t PlaneOfBlocks::get_ExhaustiveSearchFunction_mc_avx2(int BlockX, int BlockY, int SearchParam, int pixelsize)
+{
+  std::map<std::tuple<int, int, int, int>, ExhaustiveSearchFunction_t> func_fn;
+
+  EXA_MC_FN_ALL(ExaVecAvx2)
+
+  auto it = func_fn.find(std::make_tuple(BlockX, BlockY, SearchParam, pixelsize));
+  return (it == func_fn.end()) ? nullptr : it->second;
+}
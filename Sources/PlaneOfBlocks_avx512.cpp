@@ -1617,3 +1617,100 @@ void PlaneOfBlocks::ExhaustiveSearch8x8_uint8_16Blks_Z_np1_sp1_avx512(WorkingAre
   }
 
 }
+
+// Vector class for the multi-candidate exhaustive search of PlaneOfBlocks_exa.h
+class ExaVecAvx512
+{
+public:
+  typedef __m512i vec_t;
+  enum { VBYTES = 64 };
+
+  static MV_FORCEINLINE __m512i zero() { return _mm512_setzero_si512(); }
+
+  // 2 rows of 8 bytes or 4 rows of 4 bytes
+  template <int CB>
+  static MV_FORCEINLINE __m128i load_128(const uint8_t* p, int pitch)
+  {
+    if constexpr (CB == 8)
+    {
+      return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)p), _mm_loadl_epi64((const __m128i*)(p + pitch)));
+    }
+    else
+    {
+      return _mm_setr_epi32(*(const int*)p, *(const int*)(p + pitch), *(const int*)(p + pitch * 2), *(const int*)(p + pitch * 3));
+    }
+  }
+
+  template <int CB, int R>
+  static MV_FORCEINLINE __m512i load_rows(const uint8_t* p, int pitch)
+  {
+    if constexpr (CB == 64)
+    {
+      return _mm512_loadu_si512((const void*)p);
+    }
+    else if constexpr (CB == 32)
+    {
+      static_assert(R == 2, "unsupported row count");
+      const __m512i lo = _mm512_castsi256_si512(_mm256_loadu_si256((const __m256i*)p));
+      return _mm512_inserti64x4(lo, _mm256_loadu_si256((const __m256i*)(p + pitch)), 1);
+    }
+    else if constexpr (CB == 16)
+    {
+      static_assert(R == 4, "unsupported row count");
+      __m512i v = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)p));
+      v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(p + pitch)), 1);
+      v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(p + pitch * 2)), 2);
+      return _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(p + pitch * 3)), 3);
+    }
+    else
+    {
+      // 8-byte rows: 4 or 8 rows. 4-byte rows: 4 rows only
+      constexpr int RP = 16 / CB; // rows per 128-bit lane
+      static_assert((CB == 8 && (R == 4 || R == 8)) || (CB == 4 && R == 4), "unsupported row count");
+      __m512i v = _mm512_setzero_si512();
+      v = _mm512_inserti32x4(v, load_128<CB>(p, pitch), 0);
+      if constexpr (R > RP)
+      {
+        v = _mm512_inserti32x4(v, load_128<CB>(p + pitch * RP, pitch), 1);
+      }
+      if constexpr (R > RP * 2)
+      {
+        v = _mm512_inserti32x4(v, load_128<CB>(p + pitch * RP * 2, pitch), 2);
+        v = _mm512_inserti32x4(v, load_128<CB>(p + pitch * RP * 3, pitch), 3);
+      }
+      return v;
+    }
+  }
+
+  template <typename pixel_t>
+  static MV_FORCEINLINE __m512i sad_acc(__m512i acc, __m512i a, __m512i b)
+  {
+    if constexpr (sizeof(pixel_t) == 1)
+    {
+      return _mm512_add_epi32(acc, _mm512_sad_epu8(a, b));
+    }
+    else
+    {
+      // No vpsadw: |a - b| with saturated subtractions, then widened to 32 bits
+      const __m512i d = _mm512_or_si512(_mm512_subs_epu16(a, b), _mm512_subs_epu16(b, a));
+      acc = _mm512_add_epi32(acc, _mm512_srli_epi32(d, 16));
+      return _mm512_add_epi32(acc, _mm512_and_si512(d, _mm512_set1_epi32(0xFFFF)));
+    }
+  }
+
+  static MV_FORCEINLINE int hsum(__m512i acc) { return _mm512_reduce_add_epi32(acc); }
+
+  static MV_FORCEINLINE void cleanup() { _mm256_zeroupper(); }
+};
+
+#include "PlaneOfBlocks_exa.h"
+
+PlaneOfBlocks::ExhaustiveSearchFunction_t PlaneOfBlocks::get_ExhaustiveSearchFunction_mc_avx512(int BlockX, int BlockY, int SearchParam, int pixelsize)
+{
+  std::map<std::tuple<int, int, int, int>, ExhaustiveSearchFunction_t> func_fn;
+
+  EXA_MC_FN_ALL(ExaVecAvx512)
+
+  auto it = func_fn.find(std::make_tuple(BlockX, BlockY, SearchParam, pixelsize));
+  return (it == func_fn.end()) ? nullptr : it->second;
+}
@@ -0,0 +1,184 @@
+// Multi-candidate exhaustive search, any block size up to 32x32, 8 to 16 bit
+// and any nPel. Shared by PlaneOfBlocks_avx2.cpp and PlaneOfBlocks_avx512.cpp.
+
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef __PLANEOFBLOCKS_EXA__
+#define __PLANEOFBLOCKS_EXA__
+
+// The including file provides the vector class V:
+//   vec_t                         vector type
+//   VBYTES                        vector size in bytes
+//   zero ()
+//   load_rows <CB, R> (p, pitch)  R rows of CB bytes packed in a vector,
+//                                 zero-padded when R * CB < VBYTES
+//   sad_acc <pixel_t> (acc, a, b) acc + SAD (a, b), in 32-bit lanes
+//   hsum (acc)                    sum of the 32-bit lanes
+//   cleanup ()                    called once the vectors are not used any more
+
+#include "PlaneOfBlocks.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <type_traits>
+
+#include <stdint.h>
+
+// SADs of the source block against NX horizontally adjacent positions of
+// the reference plane, starting at pRef.
+// The source rows are loaded once for all the positions.
+template <class V, typename pixel_t, int BW, int BH, int NX>
+static MV_FORCEINLINE void ExaSadRow(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, int sad_arr[])
+{
+  constexpr int RB = BW * int(sizeof(pixel_t)); // bytes per row
+  constexpr int CB = std::min(RB, int(V::VBYTES)); // bytes per row and vector
+  constexpr int NC = RB / CB; // vectors per row
+  constexpr int R = std::min(int(V::VBYTES) / CB, BH); // rows per vector
+  static_assert(RB % CB == 0 && BH % R == 0, "unsupported block size");
+
+  typename V::vec_t acc[NX];
+  for (int i = 0; i < NX; ++i)
+    acc[i] = V::zero();
+
+  for (int y = 0; y < BH; y += R)
+  {
+    for (int c = 0; c < NC; ++c)
+    {
+      const typename V::vec_t src = V::template load_rows<CB, R>(pSrc + c * CB, nSrcPitch);
+      for (int i = 0; i < NX; ++i)
+      {
+        const typename V::vec_t ref = V::template load_rows<CB, R>(pRef + i * int(sizeof(pixel_t)) + c * CB, nRefPitch);
+        acc[i] = V::template sad_acc<pixel_t>(acc[i], src, ref);
+      }
+    }
+    pSrc += nSrcPitch * R;
+    pRef += nRefPitch * R;
+  }
+
+  for (int i = 0; i < NX; ++i)
+    sad_arr[i] = V::hsum(acc[i]);
+}
+
+template <class V, typename pixel_t, int BW, int BH>
+static void ExaSadRowN(int nx, const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, int sad_arr[])
+{
+  switch (nx)
+  {
+  case 1: ExaSadRow<V, pixel_t, BW, BH, 1>(pSrc, nSrcPitch, pRef, nRefPitch, sad_arr); break;
+  case 2: ExaSadRow<V, pixel_t, BW, BH, 2>(pSrc, nSrcPitch, pRef, nRefPitch, sad_arr); break;
+  case 3: ExaSadRow<V, pixel_t, BW, BH, 3>(pSrc, nSrcPitch, pRef, nRefPitch, sad_arr); break;
+  case 4: ExaSadRow<V, pixel_t, BW, BH, 4>(pSrc, nSrcPitch, pRef, nRefPitch, sad_arr); break;
+  case 5: ExaSadRow<V, pixel_t, BW, BH, 5>(pSrc, nSrcPitch, pRef, nRefPitch, sad_arr); break;
+  case 6: ExaSadRow<V, pixel_t, BW, BH, 6>(pSrc, nSrcPitch, pRef, nRefPitch, sad_arr); break;
+  case 7: ExaSadRow<V, pixel_t, BW, BH, 7>(pSrc, nSrcPitch, pRef, nRefPitch, sad_arr); break;
+  case 8: ExaSadRow<V, pixel_t, BW, BH, 8>(pSrc, nSrcPitch, pRef, nRefPitch, sad_arr); break;
+  case 9: ExaSadRow<V, pixel_t, BW, BH, 9>(pSrc, nSrcPitch, pRef, nRefPitch, sad_arr); break;
+  default: assert(false); break;
+  }
+}
+
+template <class V, typename pixel_t, int BW, int BH, int SP>
+void PlaneOfBlocks::ExhaustiveSearch_mc(WorkingArea& workarea, int mvx, int mvy)
+{
+  // Same window as the C versions: radius 4 checks 8 rows only
+  constexpr int Y_HI = (SP == 4) ? 3 : SP;
+  constexpr int NX = SP * 2 + 1;
+  constexpr int NY = SP + 1 + Y_HI;
+
+  if (!workarea.IsVectorOK(mvx - SP, mvy - SP) || !workarea.IsVectorOK(mvx + SP, mvy + Y_HI))
+  {
+    return;
+  }
+
+  // With nPel > 1, the positions sharing the same sub-pixel phase are
+  // adjacent pixels of a single sub-plane. Each phase is processed on its own.
+  int sad_arr[NY][NX];
+  int row_arr[NX];
+  const int step = nPel;
+  for (int py = 0; py < std::min(step, NY); ++py)
+  {
+    for (int px = 0; px < std::min(step, NX); ++px)
+    {
+      const int nx = (NX - px + step - 1) / step;
+      const uint8_t* pRef = GetRefBlock(workarea, mvx - SP + px, mvy - SP + py);
+      for (int j = py; j < NY; j += step)
+      {
+        ExaSadRowN<V, pixel_t, BW, BH>(nx, workarea.pSrc[0], nSrcPitch[0], pRef, nRefPitch[0], row_arr);
+        for (int i = 0; i < nx; ++i)
+        {
+          sad_arr[j][px + i * step] = row_arr[i];
+        }
+        pRef += nRefPitch[0];
+      }
+    }
+  }
+  V::cleanup();
+
+  // Reversed scan like the C versions, to keep the same choice between equal SADs
+  int minsad = INT_MAX;
+  int x_minsad = 0;
+  int y_minsad = 0;
+  for (int j = NY - 1; j >= 0; --j)
+  {
+    for (int i = NX - 1; i >= 0; --i)
+    {
+      if (sad_arr[j][i] < minsad)
+      {
+        minsad = sad_arr[j][i];
+        x_minsad = i - SP;
+        y_minsad = j - SP;
+      }
+    }
+  }
+
+  typedef typename std::conditional < sizeof(pixel_t) == 1, sad_t, bigsad_t >::type safe_sad_t;
+  const sad_t cost = minsad + sad_t((penaltyNew * (safe_sad_t)minsad) >> 8);
+  if (cost >= workarea.nMinCost) return;
+
+  workarea.bestMV.x = mvx + x_minsad;
+  workarea.bestMV.y = mvy + y_minsad;
+  workarea.nMinCost = cost;
+  workarea.bestMV.sad = minsad;
+}
+
+// Block sizes and search radius covered by ExhaustiveSearch_mc, for the
+// dispatchers of the including files.
+static_assert(MAX_SUPPORTED_EXH_SEARCHPARAM == 4, "EXA_MC_FN must cover all the search radius");
+#define EXA_MC_FN(V, x, y) \
+  func_fn[std::make_tuple(x, y, 1, 1)] = &PlaneOfBlocks::ExhaustiveSearch_mc<V, uint8_t, x, y, 1>; \
+  func_fn[std::make_tuple(x, y, 2, 1)] = &PlaneOfBlocks::ExhaustiveSearch_mc<V, uint8_t, x, y, 2>; \
+  func_fn[std::make_tuple(x, y, 3, 1)] = &PlaneOfBlocks::ExhaustiveSearch_mc<V, uint8_t, x, y, 3>; \
+  func_fn[std::make_tuple(x, y, 4, 1)] = &PlaneOfBlocks::ExhaustiveSearch_mc<V, uint8_t, x, y, 4>; \
+  func_fn[std::make_tuple(x, y, 1, 2)] = &PlaneOfBlocks::ExhaustiveSearch_mc<V, uint16_t, x, y, 1>; \
+  func_fn[std::make_tuple(x, y, 2, 2)] = &PlaneOfBlocks::ExhaustiveSearch_mc<V, uint16_t, x, y, 2>; \
+  func_fn[std::make_tuple(x, y, 3, 2)] = &PlaneOfBlocks::ExhaustiveSearch_mc<V, uint16_t, x, y, 3>; \
+  func_fn[std::make_tuple(x, y, 4, 2)] = &PlaneOfBlocks::ExhaustiveSearch_mc<V, uint16_t, x, y, 4>;
+
+#define EXA_MC_FN_ALL(V) \
+  EXA_MC_FN(V, 4, 4) \
+  EXA_MC_FN(V, 8, 4) \
+  EXA_MC_FN(V, 8, 8) \
+  EXA_MC_FN(V, 8, 16) \
+  EXA_MC_FN(V, 16, 8) \
+  EXA_MC_FN(V, 16, 16) \
+  EXA_MC_FN(V, 16, 32) \
+  EXA_MC_FN(V, 32, 16) \
+  EXA_MC_FN(V, 32, 32)
+
+#endif // __PLANEOFBLOCKS_EXA__
@@ -25,6 +25,7 @@
 #include "types.h"
 #include <stdint.h>
 #include "emmintrin.h"
+#include <math.h>
 
 
 //SSIMFunction* get_ssim_function(int BlockX, int BlockY, int bits_per_pixel, arch_t arch);
@@ -37,17 +38,64 @@ SSIMFunction* get_ssim_function_s(int BlockX, int BlockY, int bits_per_pixel, ar
 
 SSIMFunction* get_ssim_function_full(int BlockX, int BlockY, int bits_per_pixel, arch_t arch);
 
-float mvt_ssim_full_4x4_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_full_8x8_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_full_16x16_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
+// Sums over a block, one pass over the pixels gives all the SSIM terms
+struct SSIM_MOMENTS {
+  double sumX;
+  double sumY;
+  double sumXX;
+  double sumYY;
+  double sumXY;
+};
 
-float mvt_ssim_l_4x4_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_l_8x8_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_l_16x16_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
+typedef void (MOMENTSFunction)(const uint8_t* pSrc, int nSrcPitch,
+  const uint8_t* pRef, int nRefPitch, SSIM_MOMENTS* pMoments);
 
-float mvt_ssim_cs_4x4_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_cs_8x8_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_cs_16x16_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
+MOMENTSFunction* get_moments_function(int BlockX, int BlockY, int bits_per_pixel, arch_t arch);
+
+// Moments of one source block against nRefs reference blocks
+typedef void (MOMENTSBATCHFunction)(const uint8_t* pSrc, int nSrcPitch,
+  const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, SSIM_MOMENTS* pMoments);
+
+MOMENTSBATCHFunction* get_moments_batch_function(int BlockX, int BlockY, int bits_per_pixel, arch_t arch);
+
+struct SSIM_TERMS {
+  float l; // luma
+  float c; // contrast
+  float s; // structure
+};
+
+// SSIM terms of a block of iN pixels from its moments.
+// Integer samples are centered on the rounded mean, float ones on the mean.
+static inline void SSIMTerms(const SSIM_MOMENTS& m, int iN, int pixelsize, SSIM_TERMS& t)
+{
+  const float k1 = 0.01f;
+  const float k2 = 0.03f;
+  const float L = (pixelsize == 1) ? 256.0f : (pixelsize == 2) ? 65536.0f : 1.0f;
+  const float c1 = (k1 * L) * (k1 * L);
+  const float c2 = (k2 * L) * (k2 * L);
+  const float c3 = c2 / 2.0f;
+
+  const float fuX = (float)m.sumX / (float)(iN);
+  const float fuY = (float)m.sumY / (float)(iN);
+
+  t.l = (2.0f * fuX * fuY + c1) / (fuX * fuX + fuY * fuY + c1);
+
+  double muX = m.sumX / iN;
+  double muY = m.sumY / iN;
+  if (pixelsize < 4)
+  {
+    muX = (int)(fuX + 0.5f);
+    muY = (int)(fuY + 0.5f);
+  }
+
+  // sums of the centered products, exact for integer samples
+  const float fsX = (float)(m.sumXX - 2.0 * muX * m.sumX + iN * muX * muX);
+  const float fsY = (float)(m.sumYY - 2.0 * muY * m.sumY + iN * muY * muY);
+  const float fsXY = (float)(m.sumXY - muY * m.sumX - muX * m.sumY + iN * muX * muY);
+
+  t.c = (2.0f * fsX * fsY + c2) / (fsX * fsX + fsY * fsY + c2);
+  t.s = (fsXY + c3) / (sqrtf(fsX * fsY) + c3);
+}
 
 
 #endif
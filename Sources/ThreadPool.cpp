@@ -0,0 +1,368 @@
+/*****************************************************************************
+
+        ThreadPool.cpp
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#if defined (_WIN32)
+ #define NOGDI
+ #define NOMINMAX
+ #define WIN32_LEAN_AND_MEAN
+ #include "Windows.h"
+#else
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <new>
+
+#include <cassert>
+#include <climits>
+#include <cstdlib>
+
+
+
+// Worker index of the current thread, -1 if not a worker
+static thread_local int	ThreadPool_worker_index = -1;
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*
+==============================================================================
+Name: ctor
+Input parameters:
+	- nbr_threads: number of worker threads, > 0.
+	- pin_flag: pins each worker to a logical CPU.
+Throws: std::system_error if a thread cannot be created.
+==============================================================================
+*/
+
+ThreadPool::ThreadPool (int nbr_threads, bool pin_flag)
+:	_worker_arr ()
+,	_disp_pool ()
+,	_task_pool ()
+,	_nbr_queued (0)
+,	_nbr_sleeping (0)
+,	_next_queue (0)
+,	_quit_flag (false)
+,	_sleep_mutex ()
+,	_sleep_cv ()
+,	_done_mutex ()
+,	_done_cv ()
+{
+	assert (nbr_threads > 0);
+
+	_disp_pool.expand_to (64);
+	_task_pool.expand_to (256);
+
+#if defined (_WIN32)
+	// The workers may outlive the module when the host unloads it while the
+	// process keeps running: keep it loaded until the process exits.
+	::HMODULE      hnd = 0;
+	::GetModuleHandleExW (
+		  GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS
+		| GET_MODULE_HANDLE_EX_FLAG_PIN,
+		reinterpret_cast <::LPCWSTR> (&ThreadPool_worker_index),
+		&hnd
+	);
+#endif
+
+	// All the queues must exist before any worker starts stealing
+	for (int index = 0; index < nbr_threads; ++index)
+	{
+		_worker_arr.push_back (WorkerUPtr (new Worker));
+	}
+	for (int index = 0; index < nbr_threads; ++index)
+	{
+		_worker_arr [index]->_thread = std::thread (
+			&ThreadPool::worker_loop, this, index, pin_flag
+		);
+	}
+}
+
+
+
+ThreadPool::~ThreadPool ()
+{
+	{
+		std::lock_guard <std::mutex>  lock (_sleep_mutex);
+		_quit_flag = true;
+	}
+	_sleep_cv.notify_all ();
+
+	for (auto &worker_uptr : _worker_arr)
+	{
+#if defined (_WIN32)
+		// At process exit, the workers are already terminated and joining
+		// them from the DLL detach would wait on the loader lock.
+		worker_uptr->_thread.detach ();
+#else
+		worker_uptr->_thread.join ();
+#endif
+	}
+}
+
+
+
+// Returns 0 if MVTOOLS_THREADS is not set: one thread per logical CPU.
+int	ThreadPool::get_nbr_threads_from_env ()
+{
+	int            nbr_threads = 0;
+
+	const char *   val_0 = getenv ("MVTOOLS_THREADS");
+	if (val_0 != 0)
+	{
+		nbr_threads = std::max (atoi (val_0), 0);
+	}
+	if (nbr_threads == 0)
+	{
+		nbr_threads = std::max (int (std::thread::hardware_concurrency ()), 1);
+	}
+
+	return (nbr_threads);
+}
+
+
+
+bool	ThreadPool::get_pin_flag_from_env ()
+{
+	const char *   val_0 = getenv ("MVTOOLS_AFFINITY");
+
+	return (val_0 != 0 && atoi (val_0) != 0);
+}
+
+
+
+int	ThreadPool::get_nbr_threads () const
+{
+	return (int (_worker_arr.size ()));
+}
+
+
+
+avstp_TaskDispatcher *	ThreadPool::create_dispatcher ()
+{
+	DispPool::CellType * cell_ptr = _disp_pool.take_cell (true);
+	if (cell_ptr == 0)
+	{
+		throw std::bad_alloc ();
+	}
+	cell_ptr->_val._nbr_pending.store (0, std::memory_order_relaxed);
+
+	return (reinterpret_cast <avstp_TaskDispatcher *> (cell_ptr));
+}
+
+
+
+void	ThreadPool::destroy_dispatcher (avstp_TaskDispatcher *td_ptr)
+{
+	assert (td_ptr != 0);
+	assert (use_disp (td_ptr)._nbr_pending.load () == 0);
+
+	_disp_pool.return_cell (*reinterpret_cast <DispPool::CellType *> (td_ptr));
+}
+
+
+
+int	ThreadPool::enqueue_task (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr)
+{
+	if (td_ptr == 0 || task_ptr == 0)
+	{
+		return (avstp_Err_INVALID_ARG);
+	}
+
+	TaskPool::CellType * cell_ptr = _task_pool.take_cell (true);
+	if (cell_ptr == 0)
+	{
+		return (avstp_Err_EXCEPTION);
+	}
+	cell_ptr->_val._task_ptr      = task_ptr;
+	cell_ptr->_val._user_data_ptr = user_data_ptr;
+	cell_ptr->_val._td_ptr        = td_ptr;
+
+	use_disp (td_ptr)._nbr_pending.fetch_add (1, std::memory_order_relaxed);
+
+	// Workers keep their own tasks, other threads spread them
+	int            index = ThreadPool_worker_index;
+	if (index < 0)
+	{
+		index = int (_next_queue.fetch_add (1, std::memory_order_relaxed)
+		             % (unsigned int) (_worker_arr.size ()));
+	}
+	_nbr_queued.fetch_add (1);
+	_worker_arr [index]->_queue.enqueue (*cell_ptr);
+
+	if (_nbr_sleeping.load () > 0)
+	{
+		std::lock_guard <std::mutex>  lock (_sleep_mutex);
+		_sleep_cv.notify_one ();
+	}
+
+	return (avstp_Err_OK);
+}
+
+
+
+int	ThreadPool::wait_completion (avstp_TaskDispatcher *td_ptr)
+{
+	if (td_ptr == 0)
+	{
+		return (avstp_Err_INVALID_ARG);
+	}
+
+	Dispatcher &   disp  = use_disp (td_ptr);
+	const int      index = ThreadPool_worker_index;
+
+	while (disp._nbr_pending.load (std::memory_order_acquire) > 0)
+	{
+		if (! run_one_task (std::max (index, 0)))
+		{
+			if (index >= 0)
+			{
+				// A worker must not block, the tasks it waits for may need it
+				std::this_thread::yield ();
+			}
+			else
+			{
+				std::unique_lock <std::mutex>  lock (_done_mutex);
+				_done_cv.wait (lock, [&disp] () {
+					return (disp._nbr_pending.load (std::memory_order_acquire) <= 0);
+				});
+			}
+		}
+	}
+
+	return (avstp_Err_OK);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+void	ThreadPool::worker_loop (int index, bool pin_flag)
+{
+	ThreadPool_worker_index = index;
+	if (pin_flag)
+	{
+		pin_current_thread (index);
+	}
+
+	while (! _quit_flag.load ())
+	{
+		if (! run_one_task (index))
+		{
+			std::unique_lock <std::mutex>  lock (_sleep_mutex);
+			_nbr_sleeping.fetch_add (1);
+			_sleep_cv.wait (lock, [this] () {
+				return (_nbr_queued.load () > 0 || _quit_flag.load ());
+			});
+			_nbr_sleeping.fetch_sub (1);
+		}
+	}
+}
+
+
+
+// Pops a task from the queue at index, or steals one from the other queues,
+// and runs it. Returns false if no task was found.
+bool	ThreadPool::run_one_task (int index)
+{
+	const int      nbr_queues = int (_worker_arr.size ());
+	TaskPool::CellType * cell_ptr = 0;
+	for (int cnt = 0; cnt < nbr_queues && cell_ptr == 0; ++cnt)
+	{
+		cell_ptr = _worker_arr [(index + cnt) % nbr_queues]->_queue.dequeue ();
+	}
+	if (cell_ptr == 0)
+	{
+		return (false);
+	}
+	_nbr_queued.fetch_sub (1);
+
+	const Task     task = cell_ptr->_val;
+	_task_pool.return_cell (*cell_ptr);
+
+	try
+	{
+		task._task_ptr (task._td_ptr, task._user_data_ptr);
+	}
+	catch (...)
+	{
+		assert (false);
+	}
+
+	// The dispatcher may be destroyed as soon as the counter reaches 0
+	if (use_disp (task._td_ptr)._nbr_pending.fetch_sub (1, std::memory_order_acq_rel) == 1)
+	{
+		std::lock_guard <std::mutex>  lock (_done_mutex);
+		_done_cv.notify_all ();
+	}
+
+	return (true);
+}
+
+
+
+void	ThreadPool::pin_current_thread (int index)
+{
+	const int      nbr_cpu =
+		std::max (int (std::thread::hardware_concurrency ()), 1);
+	const int      cpu     = index % nbr_cpu;
+
+#if defined (_WIN32)
+	if (cpu < int (sizeof (DWORD_PTR) * CHAR_BIT))
+	{
+		::SetThreadAffinityMask (::GetCurrentThread (), DWORD_PTR (1) << cpu);
+	}
+#elif defined (__linux__)
+	cpu_set_t      cpu_set;
+	CPU_ZERO (&cpu_set);
+	CPU_SET (cpu, &cpu_set);
+	pthread_setaffinity_np (pthread_self (), sizeof (cpu_set), &cpu_set);
+#else
+	(void) cpu;
+#endif
+}
+
+
+
+ThreadPool::Dispatcher &	ThreadPool::use_disp (avstp_TaskDispatcher *td_ptr)
+{
+	return (reinterpret_cast <DispPool::CellType *> (td_ptr)->_val);
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,170 @@
+/*****************************************************************************
+
+        ThreadPool.h
+
+Built-in work-stealing thread pool implementing the AVSTP task dispatcher
+semantics. AvstpWrapper uses it when avstp.dll cannot be found.
+
+Each worker owns a lock-free task queue. Tasks enqueued from a worker go to
+its own queue, tasks enqueued from other threads are spread over the queues
+in turn. An idle worker first empties its own queue then steals from the
+others. Threads waiting for the completion of a dispatcher help processing
+the queued tasks, so nested dispatchers cannot deadlock the pool.
+
+Settings, read from the environment when the pool is created:
+   MVTOOLS_THREADS=<n>   Number of worker threads. 0 or unset: one per
+                         logical CPU. 1: no pool, single-threaded fallback.
+   MVTOOLS_AFFINITY=1    Pins worker i to logical CPU i (modulo the number
+                         of CPUs).
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (ThreadPool_HEADER_INCLUDED)
+#define	ThreadPool_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include "conc/CellPool.h"
+#include "conc/LockFreeQueue.h"
+#include "avstp.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+class ThreadPool
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	explicit       ThreadPool (int nbr_threads, bool pin_flag);
+	virtual        ~ThreadPool ();
+
+	static int     get_nbr_threads_from_env ();
+	static bool    get_pin_flag_from_env ();
+
+	int            get_nbr_threads () const;
+	avstp_TaskDispatcher *
+	               create_dispatcher ();
+	void           destroy_dispatcher (avstp_TaskDispatcher *td_ptr);
+	int            enqueue_task (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr);
+	int            wait_completion (avstp_TaskDispatcher *td_ptr);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	// Counts the tasks enqueued and not completed yet
+	class Dispatcher
+	{
+	public:
+		std::atomic <int>
+		               _nbr_pending { 0 };
+	};
+
+	class Task
+	{
+	public:
+		avstp_TaskPtr  _task_ptr      = 0;
+		void *         _user_data_ptr = 0;
+		avstp_TaskDispatcher *
+		               _td_ptr        = 0;
+	};
+
+	typedef conc::CellPool <Dispatcher> DispPool;
+	typedef conc::CellPool <Task> TaskPool;
+	typedef conc::LockFreeQueue <Task> TaskQueue;
+
+	class Worker
+	{
+	public:
+		TaskQueue      _queue;
+		std::thread    _thread;
+	};
+	typedef std::unique_ptr <Worker> WorkerUPtr;
+
+	void           worker_loop (int index, bool pin_flag);
+	bool           run_one_task (int index);
+	static void    pin_current_thread (int index);
+
+	static Dispatcher &
+	               use_disp (avstp_TaskDispatcher *td_ptr);
+
+	std::vector <WorkerUPtr>
+	               _worker_arr;
+	DispPool       _disp_pool;
+	TaskPool       _task_pool;
+	std::atomic <int>
+	               _nbr_queued;     // Tasks in the queues, not started yet
+	std::atomic <int>
+	               _nbr_sleeping;   // Idle workers waiting on _sleep_cv
+	std::atomic <unsigned int>
+	               _next_queue;     // Queue for the next external enqueue
+	std::atomic <bool>
+	               _quit_flag;
+	std::mutex     _sleep_mutex;
+	std::condition_variable
+	               _sleep_cv;
+	std::mutex     _done_mutex;
+	std::condition_variable
+	               _done_cv;        // Signaled when a dispatcher completes
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	               ThreadPool ()                               = delete;
+	               ThreadPool (const ThreadPool &other)        = delete;
+	               ThreadPool (ThreadPool &&other)             = delete;
+	ThreadPool &   operator = (const ThreadPool &other)        = delete;
+	ThreadPool &   operator = (ThreadPool &&other)             = delete;
+	bool           operator == (const ThreadPool &other) const = delete;
+	bool           operator != (const ThreadPool &other) const = delete;
+
+};	// class ThreadPool
+
+
+
+//#include "ThreadPool.hpp"
+
+
+
+#endif	// ThreadPool_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
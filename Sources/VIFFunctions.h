@@ -25,6 +25,7 @@
 #include "types.h"
 #include <stdint.h>
 #include "emmintrin.h"
+#include "SSIMFunctions.h"
 
 #define SIGMA_SQ_NOISE 5.0f
 
@@ -49,20 +50,50 @@ VIFFunction* get_vif_function_e(int BlockX, int BlockY, int bits_per_pixel, arch
 
 VIFFunction* get_vif_function_full(int BlockX, int BlockY, int bits_per_pixel, arch_t arch);
 
+// Full VIF of one source block against nRefs reference blocks
+typedef void (VIFBATCHFunction)(const uint8_t* pSrc, int nSrcPitch,
+  const uint8_t* const* ppRef, const int* pRefPitch, int nRefs, DWT2DFunction* pDWT2D, float* pVIF);
 
-float mvt_vif_full_8x8_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch, DWT2DFunction* pDWT2D);
-/*
-float mvt_ssim_full_4x4_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
+VIFBATCHFunction* get_vif_function_full_batch(int BlockX, int BlockY, int bits_per_pixel, arch_t arch);
 
-float mvt_ssim_full_16x16_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
 
-float mvt_ssim_l_4x4_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_l_8x8_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_l_16x16_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
+// VIF of a subband from its variances and covariance
+static inline float VIFSubband(float fsX, float fsY, float fsXY)
+{
+  const float fSigm_sq_N = SIGMA_SQ_NOISE; // some default ?
+  const float fEps = 1e-20f;
+  const float fg = fsXY / (fsX + fEps);
+  const float fsV = fsY - fg * fsXY;
+  return logf(1 + (fg * fsX) / (fsV + fSigm_sq_N)) / logf(1 + fsX / fSigm_sq_N);
+}
+
+// Approximation subband variances from its moments, integer coefficients
+// are centered on the truncated mean like VIF_DWT_FULL_C
+static inline void VIFApproxVariances(const SSIM_MOMENTS& m, int iN, bool float_flag, float& fsX, float& fsY, float& fsXY)
+{
+  double muX = m.sumX / iN;
+  double muY = m.sumY / iN;
+  if (!float_flag)
+  {
+    muX = (int)((float)m.sumX / (float)(iN));
+    muY = (int)((float)m.sumY / (float)(iN));
+  }
+  fsX = (float)(m.sumXX - 2.0 * muX * m.sumX + iN * muX * muX) / (float)iN;
+  fsY = (float)(m.sumYY - 2.0 * muY * m.sumY + iN * muY * muY) / (float)iN;
+  fsXY = (float)(m.sumXY - muY * m.sumX - muX * m.sumY + iN * muX * muY) / (float)iN;
+}
+
+// Weighted approximation and edges VIF, range [0..1] forced
+static inline float VIFCombine(float fVIFa, float fVIFe)
+{
+  const float fAWeight = 0.85f;
+  float fVIF = fVIFa * fAWeight + (1.0f - fAWeight) * fVIFe;
+  if (fVIF > 1.0f)
+    fVIF = 1.0f;
+  if (fVIF < 0.0f)
+    fVIF = 0.0f;
+  return fVIF;
+}
 
-float mvt_ssim_cs_4x4_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_cs_8x8_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-float mvt_ssim_cs_16x16_8_avx2(const uint8_t* pSrc, int nSrcPitch, const uint8_t* pRef, int nRefPitch);
-*/
 
 #endif
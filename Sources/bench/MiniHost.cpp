@@ -0,0 +1,1279 @@
+// MVTools2 benchmark helper: minimal in-process Avisynth host
+// See MiniHost.h
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+// This translation unit is the "core" side of avisynth.h: the class members
+// which a plugin reaches through AVS_Linkage are defined here, like
+// avisynth.cpp does in the real host. Do not include plugin headers here.
+#define BUILDING_AVSCORE 1
+#include "avisynth.h"
+
+#include "MiniHost.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+
+namespace
+{
+
+long atomic_add(volatile long* p, long v)
+{
+#if defined(_MSC_VER)
+  return _InterlockedExchangeAdd(p, v) + v;
+#else
+  return __sync_add_and_fetch(p, v);
+#endif
+}
+
+void* aligned_malloc(size_t size, size_t align)
+{
+#if defined(_MSC_VER)
+  return _aligned_malloc(size, align);
+#else
+  void* ptr = nullptr;
+  return posix_memalign(&ptr, align, size) == 0 ? ptr : nullptr;
+#endif
+}
+
+void aligned_free(void* ptr)
+{
+#if defined(_MSC_VER)
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
+int align_up(int x, int align)
+{
+  return (x + align - 1) & ~(align - 1);
+}
+
+// Function and argument names are case insensitive in scripts
+int strcasecmp_ascii(const char* a, const char* b)
+{
+  for (; *a != '\0' && std::tolower((unsigned char)(*a)) == std::tolower((unsigned char)(*b)); ++a, ++b)
+  {
+  }
+  return std::tolower((unsigned char)(*a)) - std::tolower((unsigned char)(*b));
+}
+
+bool is_plane_u(int plane)
+{
+  return (plane & (PLANAR_U | PLANAR_B)) != 0;
+}
+
+bool is_plane_v(int plane)
+{
+  return (plane & (PLANAR_V | PLANAR_R)) != 0;
+}
+
+unsigned gcd(unsigned a, unsigned b)
+{
+  while (b != 0)
+  {
+    const unsigned t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+} // namespace
+
+
+
+/**********************************************************************/
+// struct VideoInfo
+
+bool VideoInfo::HasVideo() const { return width != 0; }
+bool VideoInfo::HasAudio() const { return audio_samples_per_second != 0; }
+bool VideoInfo::IsRGB() const { return (pixel_type & CS_BGR) != 0; }
+bool VideoInfo::IsRGB24() const { return (pixel_type & CS_BGR24) == CS_BGR24 && (pixel_type & CS_Sample_Bits_Mask) == CS_Sample_Bits_8 && !IsPlanar(); }
+bool VideoInfo::IsRGB32() const { return (pixel_type & CS_BGR32) == CS_BGR32 && (pixel_type & CS_Sample_Bits_Mask) == CS_Sample_Bits_8 && !IsPlanar(); }
+bool VideoInfo::IsYUV() const { return (pixel_type & CS_YUV) != 0; }
+bool VideoInfo::IsYUY2() const { return (pixel_type & CS_YUY2) == CS_YUY2; }
+bool VideoInfo::IsYV24() const { return (pixel_type & CS_PLANAR_MASK) == (CS_YV24 & CS_PLANAR_FILTER); }
+bool VideoInfo::IsYV16() const { return (pixel_type & CS_PLANAR_MASK) == (CS_YV16 & CS_PLANAR_FILTER); }
+bool VideoInfo::IsYV12() const { return (pixel_type & CS_PLANAR_MASK) == (CS_YV12 & CS_PLANAR_FILTER); }
+bool VideoInfo::IsYV411() const { return (pixel_type & CS_PLANAR_MASK) == (CS_YV411 & CS_PLANAR_FILTER); }
+bool VideoInfo::IsY8() const { return (pixel_type & CS_PLANAR_MASK) == (CS_Y8 & CS_PLANAR_FILTER); }
+
+bool VideoInfo::IsColorSpace(int c_space) const
+{
+  return IsPlanar() ? ((pixel_type & CS_PLANAR_MASK) == (c_space & CS_PLANAR_FILTER)) : ((pixel_type & c_space) == c_space);
+}
+
+bool VideoInfo::Is(int property) const { return (image_type & property) == property; }
+bool VideoInfo::IsPlanar() const { return (pixel_type & CS_PLANAR) != 0; }
+bool VideoInfo::IsFieldBased() const { return (image_type & IT_FIELDBASED) != 0; }
+bool VideoInfo::IsParityKnown() const { return (image_type & IT_FIELDBASED) != 0 && (image_type & (IT_BFF | IT_TFF)) != 0; }
+bool VideoInfo::IsBFF() const { return (image_type & IT_BFF) != 0; }
+bool VideoInfo::IsTFF() const { return (image_type & IT_TFF) != 0; }
+
+bool VideoInfo::IsVPlaneFirst() const
+{
+  return !IsY() && IsPlanar() && (pixel_type & (CS_VPlaneFirst | CS_UPlaneFirst)) == CS_VPlaneFirst;
+}
+
+int VideoInfo::BytesFromPixels(int pixels) const
+{
+  if (IsPlanar())
+    return pixels * ComponentSize();
+  return int((int64_t(pixels) * BitsPerPixel()) >> 3);
+}
+
+int VideoInfo::RowSize(int plane) const
+{
+  const int rowsize = BytesFromPixels(width);
+  switch (plane)
+  {
+  case PLANAR_U: case PLANAR_V:
+    return (IsPlanar() && !IsY() && !IsPlanarRGB() && !IsPlanarRGBA()) ? rowsize >> GetPlaneWidthSubsampling(plane) : 0;
+  case PLANAR_U_ALIGNED: case PLANAR_V_ALIGNED:
+    return (IsPlanar() && !IsY() && !IsPlanarRGB() && !IsPlanarRGBA()) ? align_up(rowsize >> GetPlaneWidthSubsampling(plane), FRAME_ALIGN) : 0;
+  case PLANAR_Y_ALIGNED:
+  case PLANAR_R_ALIGNED: case PLANAR_G_ALIGNED: case PLANAR_B_ALIGNED:
+    return align_up(rowsize, FRAME_ALIGN);
+  case PLANAR_A:
+    return (IsYUVA() || IsPlanarRGBA()) ? rowsize : 0;
+  case PLANAR_A_ALIGNED:
+    return (IsYUVA() || IsPlanarRGBA()) ? align_up(rowsize, FRAME_ALIGN) : 0;
+  }
+  return rowsize;
+}
+
+int VideoInfo::BMPSize() const
+{
+  const int luma = height * align_up(RowSize(), 4);
+  if (!IsPlanar() || IsY())
+    return luma;
+  const int chroma = (height >> GetPlaneHeightSubsampling(PLANAR_U))
+    * align_up(BytesFromPixels(width) >> GetPlaneWidthSubsampling(PLANAR_U), 4);
+  return luma + 2 * chroma + ((IsYUVA() || IsPlanarRGBA()) ? luma : 0);
+}
+
+int64_t VideoInfo::AudioSamplesFromFrames(int frames) const
+{
+  return (fps_numerator && HasVideo()) ? (int64_t(frames) * audio_samples_per_second * fps_denominator / fps_numerator) : 0;
+}
+
+int VideoInfo::FramesFromAudioSamples(int64_t samples) const
+{
+  return (fps_denominator && HasAudio()) ? int((samples * fps_numerator) / fps_denominator / audio_samples_per_second) : 0;
+}
+
+int64_t VideoInfo::AudioSamplesFromBytes(int64_t bytes) const
+{
+  return HasAudio() ? bytes / BytesPerAudioSample() : 0;
+}
+
+int64_t VideoInfo::BytesFromAudioSamples(int64_t samples) const { return samples * BytesPerAudioSample(); }
+int VideoInfo::AudioChannels() const { return HasAudio() ? nchannels : 0; }
+int VideoInfo::SampleType() const { return sample_type; }
+bool VideoInfo::IsSampleType(int testtype) const { return (sample_type & testtype) != 0; }
+int VideoInfo::SamplesPerSecond() const { return audio_samples_per_second; }
+int VideoInfo::BytesPerAudioSample() const { return nchannels * BytesPerChannelSample(); }
+
+void VideoInfo::SetFieldBased(bool isfieldbased)
+{
+  if (isfieldbased)
+    image_type |= IT_FIELDBASED;
+  else
+    image_type &= ~IT_FIELDBASED;
+}
+
+void VideoInfo::Set(int property) { image_type |= property; }
+void VideoInfo::Clear(int property) { image_type &= ~property; }
+
+int VideoInfo::GetPlaneWidthSubsampling(int plane) const
+{
+  if (plane == PLANAR_Y || plane == PLANAR_Y_ALIGNED || IsRGB() || IsY() || (plane & (PLANAR_A | PLANAR_R | PLANAR_G | PLANAR_B)) != 0)
+    return 0;
+  if (IsYUY2())
+    return 1;
+  return ((pixel_type >> CS_Shift_Sub_Width) + 1) & 3;
+}
+
+int VideoInfo::GetPlaneHeightSubsampling(int plane) const
+{
+  if (plane == PLANAR_Y || plane == PLANAR_Y_ALIGNED || IsRGB() || IsY() || IsYUY2() || (plane & (PLANAR_A | PLANAR_R | PLANAR_G | PLANAR_B)) != 0)
+    return 0;
+  return ((pixel_type >> CS_Shift_Sub_Height) + 1) & 3;
+}
+
+int VideoInfo::BitsPerPixel() const
+{
+  const int bits = ComponentSize() * 8;
+  if (!IsPlanar())
+  {
+    if (IsYUY2())
+      return 16;
+    return bits * ((pixel_type & CS_RGBA_TYPE) ? 4 : 3);
+  }
+  if (IsY())
+    return bits;
+  if (IsPlanarRGB())
+    return bits * 3;
+  if (IsPlanarRGBA())
+    return bits * 4;
+  const int chroma = 2 * bits / (1 << (GetPlaneWidthSubsampling(PLANAR_U) + GetPlaneHeightSubsampling(PLANAR_U)));
+  return bits + chroma + (IsYUVA() ? bits : 0);
+}
+
+int VideoInfo::BytesPerChannelSample() const
+{
+  switch (sample_type)
+  {
+  case SAMPLE_INT8: return 1;
+  case SAMPLE_INT16: return 2;
+  case SAMPLE_INT24: return 3;
+  case SAMPLE_INT32: return 4;
+  case SAMPLE_FLOAT: return 4;
+  }
+  return 0;
+}
+
+void VideoInfo::SetFPS(unsigned numerator, unsigned denominator)
+{
+  if (numerator == 0 || denominator == 0)
+  {
+    fps_numerator = 0;
+    fps_denominator = 1;
+    return;
+  }
+  const unsigned g = gcd(numerator, denominator);
+  fps_numerator = numerator / g;
+  fps_denominator = denominator / g;
+}
+
+void VideoInfo::MulDivFPS(unsigned multiplier, unsigned divisor)
+{
+  uint64_t num = uint64_t(fps_numerator) * multiplier;
+  uint64_t den = uint64_t(fps_denominator) * divisor;
+  while (num > 0xFFFFFFFFull || den > 0xFFFFFFFFull)
+  {
+    num >>= 1;
+    den >>= 1;
+  }
+  SetFPS(unsigned(num), unsigned(den));
+}
+
+bool VideoInfo::IsSameColorspace(const VideoInfo& vi) const
+{
+  if (vi.pixel_type == pixel_type)
+    return true;
+  return IsYV12() && vi.IsYV12();
+}
+
+int VideoInfo::NumComponents() const
+{
+  if (pixel_type == CS_UNKNOWN)
+    return 0;
+  if (IsPlanarRGBA() || IsYUVA())
+    return 4;
+  if (IsRGB())
+    return (pixel_type & CS_RGBA_TYPE) ? 4 : 3;
+  return IsY() ? 1 : 3;
+}
+
+int VideoInfo::ComponentSize() const
+{
+  switch (pixel_type & CS_Sample_Bits_Mask)
+  {
+  case CS_Sample_Bits_8: return 1;
+  case CS_Sample_Bits_32: return 4;
+  }
+  return 2;
+}
+
+int VideoInfo::BitsPerComponent() const
+{
+  switch (pixel_type & CS_Sample_Bits_Mask)
+  {
+  case CS_Sample_Bits_8: return 8;
+  case CS_Sample_Bits_10: return 10;
+  case CS_Sample_Bits_12: return 12;
+  case CS_Sample_Bits_14: return 14;
+  case CS_Sample_Bits_16: return 16;
+  case CS_Sample_Bits_32: return 32;
+  }
+  return 0;
+}
+
+static int planar_layout(int pixel_type)
+{
+  return pixel_type & VideoInfo::CS_PLANAR_MASK & ~VideoInfo::CS_Sample_Bits_Mask;
+}
+
+bool VideoInfo::Is444() const
+{
+  const int l = planar_layout(pixel_type);
+  return l == (CS_GENERIC_YUV444 & CS_PLANAR_FILTER) || l == (CS_GENERIC_YUVA444 & CS_PLANAR_FILTER);
+}
+
+bool VideoInfo::Is422() const
+{
+  const int l = planar_layout(pixel_type);
+  return l == (CS_GENERIC_YUV422 & CS_PLANAR_FILTER) || l == (CS_GENERIC_YUVA422 & CS_PLANAR_FILTER);
+}
+
+bool VideoInfo::Is420() const
+{
+  const int l = planar_layout(pixel_type);
+  return l == (CS_GENERIC_YUV420 & CS_PLANAR_FILTER) || l == (CS_GENERIC_YUVA420 & CS_PLANAR_FILTER);
+}
+
+bool VideoInfo::IsY() const { return planar_layout(pixel_type) == (CS_GENERIC_Y & CS_PLANAR_FILTER); }
+bool VideoInfo::IsRGB48() const { return !IsPlanar() && (pixel_type & CS_BGR48) == CS_BGR48 && (pixel_type & CS_RGBA_TYPE) == 0 && (pixel_type & CS_Sample_Bits_Mask) == CS_Sample_Bits_16; }
+bool VideoInfo::IsRGB64() const { return !IsPlanar() && (pixel_type & CS_BGR64) == CS_BGR64 && (pixel_type & CS_Sample_Bits_Mask) == CS_Sample_Bits_16; }
+bool VideoInfo::IsYUVA() const { return (pixel_type & CS_YUVA) != 0; }
+bool VideoInfo::IsPlanarRGB() const { return IsPlanar() && IsRGB() && (pixel_type & CS_RGB_TYPE) != 0; }
+bool VideoInfo::IsPlanarRGBA() const { return IsPlanar() && IsRGB() && (pixel_type & CS_RGBA_TYPE) != 0; }
+
+
+
+/**********************************************************************/
+// class VideoFrameBuffer
+
+VideoFrameBuffer::VideoFrameBuffer(int size, int margin, Device* _device)
+  : data(static_cast<BYTE*>(aligned_malloc(size_t(size) + margin, FRAME_ALIGN)))
+  , data_size(size)
+  , sequence_number(0)
+  , refcount(0)
+  , device(_device)
+{
+  if (data == nullptr)
+    throw AvisynthError("MiniHost: out of memory");
+}
+
+VideoFrameBuffer::VideoFrameBuffer()
+  : data(nullptr), data_size(0), sequence_number(0), refcount(0), device(nullptr)
+{
+}
+
+VideoFrameBuffer::~VideoFrameBuffer()
+{
+  aligned_free(data);
+}
+
+const BYTE* VideoFrameBuffer::GetReadPtr() const { return data; }
+BYTE* VideoFrameBuffer::GetWritePtr() { atomic_add(&sequence_number, 1); return data; }
+int VideoFrameBuffer::GetDataSize() const { return data_size; }
+int VideoFrameBuffer::GetSequenceNumber() const { return sequence_number; }
+int VideoFrameBuffer::GetRefcount() const { return refcount; }
+
+
+
+/**********************************************************************/
+// class VideoFrame
+
+VideoFrame::VideoFrame(VideoFrameBuffer* _vfb, AVSMap* avsmap, int _offset, int _pitch, int _row_size, int _height)
+  : refcount(0), vfb(_vfb), offset(_offset), pitch(_pitch), row_size(_row_size), height(_height)
+  , offsetU(_offset), offsetV(_offset), pitchUV(0), row_sizeUV(0), heightUV(0)
+  , offsetA(0), pitchA(0), row_sizeA(0), properties(avsmap)
+{
+  atomic_add(&vfb->refcount, 1);
+}
+
+VideoFrame::VideoFrame(VideoFrameBuffer* _vfb, AVSMap* avsmap, int _offset, int _pitch, int _row_size, int _height,
+  int _offsetU, int _offsetV, int _pitchUV, int _row_sizeUV, int _heightUV)
+  : refcount(0), vfb(_vfb), offset(_offset), pitch(_pitch), row_size(_row_size), height(_height)
+  , offsetU(_offsetU), offsetV(_offsetV), pitchUV(_pitchUV), row_sizeUV(_row_sizeUV), heightUV(_heightUV)
+  , offsetA(0), pitchA(0), row_sizeA(0), properties(avsmap)
+{
+  atomic_add(&vfb->refcount, 1);
+}
+
+VideoFrame::VideoFrame(VideoFrameBuffer* _vfb, AVSMap* avsmap, int _offset, int _pitch, int _row_size, int _height,
+  int _offsetU, int _offsetV, int _pitchUV, int _row_sizeUV, int _heightUV, int _offsetA)
+  : refcount(0), vfb(_vfb), offset(_offset), pitch(_pitch), row_size(_row_size), height(_height)
+  , offsetU(_offsetU), offsetV(_offsetV), pitchUV(_pitchUV), row_sizeUV(_row_sizeUV), heightUV(_heightUV)
+  , offsetA(_offsetA), pitchA(_pitch), row_sizeA(_row_size), properties(avsmap)
+{
+  atomic_add(&vfb->refcount, 1);
+}
+
+void* VideoFrame::operator new(size_t size)
+{
+  return ::operator new(size);
+}
+
+void VideoFrame::AddRef()
+{
+  atomic_add(&refcount, 1);
+}
+
+void VideoFrame::Release()
+{
+  if (atomic_add(&refcount, -1) == 0)
+    delete this;
+}
+
+void VideoFrame::DESTRUCTOR()
+{
+  if (vfb != nullptr && atomic_add(&vfb->refcount, -1) == 0)
+    delete vfb;
+  vfb = nullptr;
+}
+
+VideoFrame::~VideoFrame() { DESTRUCTOR(); }
+
+int VideoFrame::GetPitch(int plane) const
+{
+  if (plane & PLANAR_A)
+    return pitchA;
+  if (is_plane_u(plane) || is_plane_v(plane))
+    return pitchUV;
+  return pitch;
+}
+
+int VideoFrame::GetRowSize(int plane) const
+{
+  const bool aligned = (plane & PLANAR_ALIGNED) != 0;
+  int pitch_p = pitch;
+  int row_p = row_size;
+  if (plane & PLANAR_A)
+  {
+    pitch_p = pitchA;
+    row_p = row_sizeA;
+  }
+  else if (is_plane_u(plane) || is_plane_v(plane))
+  {
+    pitch_p = pitchUV;
+    row_p = pitchUV ? row_sizeUV : 0;
+  }
+  if (aligned)
+  {
+    const int r = align_up(row_p, FRAME_ALIGN);
+    return r <= pitch_p ? r : row_p;
+  }
+  return row_p;
+}
+
+int VideoFrame::GetHeight(int plane) const
+{
+  if (plane & PLANAR_A)
+    return pitchA ? height : 0;
+  if (is_plane_u(plane) || is_plane_v(plane))
+    return pitchUV ? heightUV : 0;
+  return height;
+}
+
+VideoFrameBuffer* VideoFrame::GetFrameBuffer() const { return vfb; }
+
+int VideoFrame::GetOffset(int plane) const
+{
+  if (plane & PLANAR_A)
+    return offsetA;
+  if (is_plane_u(plane))
+    return offsetU;
+  if (is_plane_v(plane))
+    return offsetV;
+  return offset;
+}
+
+const BYTE* VideoFrame::GetReadPtr(int plane) const { return vfb->GetReadPtr() + GetOffset(plane); }
+bool VideoFrame::IsWritable() const { return refcount == 1 && vfb->refcount == 1; }
+BYTE* VideoFrame::GetWritePtr(int plane) const { return IsWritable() ? vfb->GetWritePtr() + GetOffset(plane) : nullptr; }
+
+
+
+/**********************************************************************/
+// class IClip, PClip, PVideoFrame
+
+void IClip::AddRef() { atomic_add(&refcnt, 1); }
+void IClip::Release() { if (atomic_add(&refcnt, -1) == 0) delete this; }
+
+IClip* PClip::GetPointerWithAddRef() const { if (p) p->AddRef(); return p; }
+void PClip::Init(IClip* x) { if (x) x->AddRef(); p = x; }
+void PClip::Set(IClip* x) { if (x) x->AddRef(); if (p) p->Release(); p = x; }
+
+PClip::PClip() { CONSTRUCTOR0(); }
+PClip::PClip(const PClip& x) { CONSTRUCTOR1(x); }
+PClip::PClip(IClip* x) { CONSTRUCTOR2(x); }
+void PClip::operator=(IClip* x) { OPERATOR_ASSIGN0(x); }
+void PClip::operator=(const PClip& x) { OPERATOR_ASSIGN1(x); }
+PClip::~PClip() { DESTRUCTOR(); }
+
+void PClip::CONSTRUCTOR0() { p = nullptr; }
+void PClip::CONSTRUCTOR1(const PClip& x) { Init(x.p); }
+void PClip::CONSTRUCTOR2(IClip* x) { Init(x); }
+void PClip::OPERATOR_ASSIGN0(IClip* x) { Set(x); }
+void PClip::OPERATOR_ASSIGN1(const PClip& x) { Set(x.p); }
+void PClip::DESTRUCTOR() { if (p) p->Release(); }
+
+void PVideoFrame::Init(VideoFrame* x) { if (x) x->AddRef(); p = x; }
+void PVideoFrame::Set(VideoFrame* x) { if (x) x->AddRef(); if (p) p->Release(); p = x; }
+
+PVideoFrame::PVideoFrame() { CONSTRUCTOR0(); }
+PVideoFrame::PVideoFrame(const PVideoFrame& x) { CONSTRUCTOR1(x); }
+PVideoFrame::PVideoFrame(VideoFrame* x) { CONSTRUCTOR2(x); }
+void PVideoFrame::operator=(VideoFrame* x) { OPERATOR_ASSIGN0(x); }
+void PVideoFrame::operator=(const PVideoFrame& x) { OPERATOR_ASSIGN1(x); }
+PVideoFrame::~PVideoFrame() { DESTRUCTOR(); }
+
+void PVideoFrame::CONSTRUCTOR0() { p = nullptr; }
+void PVideoFrame::CONSTRUCTOR1(const PVideoFrame& x) { Init(x.p); }
+void PVideoFrame::CONSTRUCTOR2(VideoFrame* x) { Init(x); }
+void PVideoFrame::OPERATOR_ASSIGN0(VideoFrame* x) { Set(x); }
+void PVideoFrame::OPERATOR_ASSIGN1(const PVideoFrame& x) { Set(x.p); }
+void PVideoFrame::DESTRUCTOR() { if (p) p->Release(); }
+
+
+
+/**********************************************************************/
+// class AVSValue
+// Arrays are deep copied, as in Avisynth+ (NEW_AVSVALUE)
+
+AVSValue::AVSValue() { CONSTRUCTOR0(); }
+AVSValue::AVSValue(IClip* c) { CONSTRUCTOR1(c); }
+AVSValue::AVSValue(const PClip& c) { CONSTRUCTOR2(c); }
+AVSValue::AVSValue(bool b) { CONSTRUCTOR3(b); }
+AVSValue::AVSValue(int i) { CONSTRUCTOR4(i); }
+AVSValue::AVSValue(float f) { CONSTRUCTOR5(f); }
+AVSValue::AVSValue(double f) { CONSTRUCTOR6(f); }
+AVSValue::AVSValue(const char* s) { CONSTRUCTOR7(s); }
+AVSValue::AVSValue(const AVSValue* a, int size) { CONSTRUCTOR8(a, size); }
+AVSValue::AVSValue(const AVSValue& a, int size) { CONSTRUCTOR8(&a, size); }
+AVSValue::AVSValue(const AVSValue& v) { CONSTRUCTOR9(v); }
+AVSValue::~AVSValue() { DESTRUCTOR(); }
+AVSValue& AVSValue::operator=(const AVSValue& v) { return OPERATOR_ASSIGN(v); }
+
+void AVSValue::CONSTRUCTOR0() { type = 'v'; array_size = 0; clip = nullptr; }
+void AVSValue::CONSTRUCTOR1(IClip* c) { type = 'c'; array_size = 0; clip = c; if (c) c->AddRef(); }
+void AVSValue::CONSTRUCTOR2(const PClip& c) { type = 'c'; array_size = 0; clip = c.GetPointerWithAddRef(); }
+void AVSValue::CONSTRUCTOR3(bool b) { type = 'b'; array_size = 0; clip = nullptr; boolean = b; }
+void AVSValue::CONSTRUCTOR4(int i) { type = 'i'; array_size = 0; clip = nullptr; integer = i; }
+void AVSValue::CONSTRUCTOR5(float f) { type = 'f'; array_size = 0; clip = nullptr; floating_pt = f; }
+void AVSValue::CONSTRUCTOR6(double f) { type = 'f'; array_size = 0; clip = nullptr; floating_pt = float(f); }
+void AVSValue::CONSTRUCTOR7(const char* s) { type = 's'; array_size = 0; string = s; }
+
+void AVSValue::CONSTRUCTOR8(const AVSValue* a, int size)
+{
+  type = 'a';
+  array_size = short(size);
+  AVSValue* arr = (size > 0) ? new AVSValue[size] : nullptr;
+  for (int i = 0; i < size; ++i)
+    arr[i] = a[i];
+  array = arr;
+}
+
+void AVSValue::CONSTRUCTOR9(const AVSValue& v) { Assign(&v, true); }
+
+void AVSValue::DESTRUCTOR()
+{
+  if (type == 'c' && clip)
+    clip->Release();
+  else if (type == 'a')
+    delete[] array;
+  type = 'v';
+}
+
+AVSValue& AVSValue::OPERATOR_ASSIGN(const AVSValue& v)
+{
+  Assign(&v, false);
+  return *this;
+}
+
+void AVSValue::Assign(const AVSValue* src, bool init)
+{
+  if (!init && src == this)
+    return;
+
+  // Takes the new references first, src may be owned by the old content
+  IClip* const old_clip = (!init && type == 'c') ? clip : nullptr;
+  const AVSValue* const old_array = (!init && type == 'a') ? array : nullptr;
+
+  const short src_type = src->type;
+  const short src_size = src->array_size;
+  switch (src_type)
+  {
+  case 'c':
+    clip = src->clip;
+    if (clip)
+      clip->AddRef();
+    break;
+  case 'a':
+  {
+    AVSValue* arr = (src_size > 0) ? new AVSValue[src_size] : nullptr;
+    for (int i = 0; i < src_size; ++i)
+      arr[i] = src->array[i];
+    array = arr;
+    break;
+  }
+  case 'b': boolean = src->boolean; break;
+  case 'i': integer = src->integer; break;
+  case 'f': floating_pt = src->floating_pt; break;
+  case 's': string = src->string; break;
+  default: clip = nullptr; break;
+  }
+  type = src_type;
+  array_size = src_size;
+
+  if (old_clip)
+    old_clip->Release();
+  delete[] old_array;
+}
+
+const AVSValue& AVSValue::OPERATOR_INDEX(int index) const
+{
+  return (IsArray() && index >= 0 && index < array_size) ? array[index] : *this;
+}
+
+bool AVSValue::Defined() const { return type != 'v'; }
+bool AVSValue::IsClip() const { return type == 'c'; }
+bool AVSValue::IsBool() const { return type == 'b'; }
+bool AVSValue::IsInt() const { return type == 'i'; }
+bool AVSValue::IsFloat() const { return type == 'f' || type == 'i'; }
+bool AVSValue::IsString() const { return type == 's'; }
+bool AVSValue::IsArray() const { return type == 'a'; }
+bool AVSValue::IsFunction() const { return type == 'n'; }
+
+PClip AVSValue::AsClip() const { return IsClip() ? PClip(clip) : PClip(); }
+bool AVSValue::AsBool1() const { return boolean; }
+int AVSValue::AsInt1() const { return integer; }
+const char* AVSValue::AsString1() const { return IsString() ? string : nullptr; }
+double AVSValue::AsFloat1() const { return IsInt() ? double(integer) : double(floating_pt); }
+
+bool AVSValue::AsBool2(bool def) const { return IsBool() ? boolean : def; }
+int AVSValue::AsInt2(int def) const { return IsInt() ? integer : def; }
+double AVSValue::AsDblDef(double def) const { return IsFloat() ? AsFloat1() : def; }
+double AVSValue::AsFloat2(float def) const { return IsFloat() ? AsFloat1() : double(def); }
+const char* AVSValue::AsString2(const char* def) const { return IsString() ? string : def; }
+
+int AVSValue::ArraySize() const { return IsArray() ? array_size : 1; }
+
+
+
+/**********************************************************************/
+// class ScriptEnvironment
+// Named like the core class: VideoFrame and VideoFrameBuffer grant it
+// access to their constructors.
+
+class ScriptEnvironment
+  : public IScriptEnvironment
+{
+public:
+
+  explicit ScriptEnvironment(int cpu_flags);
+  ~ScriptEnvironment() override;
+
+  int __stdcall GetCPUFlags() override { return _cpu_flags; }
+
+  char* __stdcall SaveString(const char* s, int length) override;
+  char* Sprintf(const char* fmt, ...) override;
+  char* __stdcall VSprintf(const char* fmt, va_list val) override;
+#ifdef AVS_WINDOWS
+  __declspec(noreturn) void ThrowError(const char* fmt, ...) override;
+#else
+  void ThrowError(const char* fmt, ...) override;
+#endif
+
+  void __stdcall AddFunction(const char* name, const char* params, ApplyFunc apply, void* user_data) override;
+  bool __stdcall FunctionExists(const char* name) override { return find_function(name) != nullptr; }
+  AVSValue __stdcall Invoke(const char* name, const AVSValue args, const char* const* arg_names) override;
+
+  AVSValue __stdcall GetVar(const char*) override { throw NotFound(); }
+  bool __stdcall SetVar(const char*, const AVSValue&) override { return false; }
+  bool __stdcall SetGlobalVar(const char*, const AVSValue&) override { return false; }
+
+  void __stdcall PushContext(int) override {}
+  void __stdcall PopContext() override {}
+
+  PVideoFrame __stdcall NewVideoFrame(const VideoInfo& vi, int align) override;
+  bool __stdcall MakeWritable(PVideoFrame* pvf) override;
+  void __stdcall BitBlt(BYTE* dstp, int dst_pitch, const BYTE* srcp, int src_pitch, int row_size, int height) override;
+
+  void __stdcall AtExit(ShutdownFunc function, void* user_data) override;
+  void __stdcall CheckVersion(int version) override;
+
+  PVideoFrame __stdcall Subframe(PVideoFrame src, int rel_offset, int new_pitch, int new_row_size, int new_height) override;
+  int __stdcall SetMemoryMax(int) override { return 0; }
+  int __stdcall SetWorkingDir(const char*) override { return -1; }
+  void* __stdcall ManageCache(int, void*) override { return nullptr; }
+  bool __stdcall PlanarChromaAlignment(PlanarChromaAlignmentMode) override { return true; }
+  PVideoFrame __stdcall SubframePlanar(PVideoFrame src, int rel_offset, int new_pitch, int new_row_size,
+    int new_height, int rel_offsetU, int rel_offsetV, int new_pitchUV) override;
+
+  void __stdcall DeleteScriptEnvironment() override { delete this; }
+  void __stdcall ApplyMessage(PVideoFrame*, const VideoInfo&, const char*, int, int, int, int) override {}
+  const AVS_Linkage* __stdcall GetAVSLinkage() override { return minihost::get_linkage(); }
+  AVSValue __stdcall GetVarDef(const char*, const AVSValue& def) override { return def; }
+
+  PVideoFrame __stdcall SubframePlanarA(PVideoFrame src, int rel_offset, int new_pitch, int new_row_size,
+    int new_height, int rel_offsetU, int rel_offsetV, int new_pitchUV, int rel_offsetA) override;
+
+  // Frame properties (interface v8) are not supported
+  void __stdcall copyFrameProps(const PVideoFrame&, PVideoFrame&) override {}
+  const AVSMap* __stdcall getFramePropsRO(const PVideoFrame&) override { return nullptr; }
+  AVSMap* __stdcall getFramePropsRW(PVideoFrame&) override { return nullptr; }
+  int __stdcall propNumKeys(const AVSMap*) override { return 0; }
+  const char* __stdcall propGetKey(const AVSMap*, int) override { return nullptr; }
+  int __stdcall propNumElements(const AVSMap*, const char*) override { return -1; }
+  char __stdcall propGetType(const AVSMap*, const char*) override { return PROPTYPE_UNSET; }
+  int64_t __stdcall propGetInt(const AVSMap*, const char*, int, int* error) override { return prop_unset(error), 0; }
+  double __stdcall propGetFloat(const AVSMap*, const char*, int, int* error) override { return prop_unset(error), 0.0; }
+  const char* __stdcall propGetData(const AVSMap*, const char*, int, int* error) override { return prop_unset(error), nullptr; }
+  int __stdcall propGetDataSize(const AVSMap*, const char*, int, int* error) override { return prop_unset(error), 0; }
+  PClip __stdcall propGetClip(const AVSMap*, const char*, int, int* error) override { prop_unset(error); return PClip(); }
+  const PVideoFrame __stdcall propGetFrame(const AVSMap*, const char*, int, int* error) override { prop_unset(error); return PVideoFrame(); }
+  int __stdcall propDeleteKey(AVSMap*, const char*) override { return 0; }
+  int __stdcall propSetInt(AVSMap*, const char*, int64_t, int) override { return 1; }
+  int __stdcall propSetFloat(AVSMap*, const char*, double, int) override { return 1; }
+  int __stdcall propSetData(AVSMap*, const char*, const char*, int, int) override { return 1; }
+  int __stdcall propSetClip(AVSMap*, const char*, PClip&, int) override { return 1; }
+  int __stdcall propSetFrame(AVSMap*, const char*, const PVideoFrame&, int) override { return 1; }
+  const int64_t* __stdcall propGetIntArray(const AVSMap*, const char*, int* error) override { return prop_unset(error), nullptr; }
+  const double* __stdcall propGetFloatArray(const AVSMap*, const char*, int* error) override { return prop_unset(error), nullptr; }
+  int __stdcall propSetIntArray(AVSMap*, const char*, const int64_t*, int) override { return 1; }
+  int __stdcall propSetFloatArray(AVSMap*, const char*, const double*, int) override { return 1; }
+  AVSMap* __stdcall createMap() override { return nullptr; }
+  void __stdcall freeMap(AVSMap*) override {}
+  void __stdcall clearMap(AVSMap*) override {}
+
+  PVideoFrame __stdcall NewVideoFrameP(const VideoInfo& vi, PVideoFrame*, int align) override { return NewVideoFrame(vi, align); }
+
+  size_t __stdcall GetEnvProperty(AvsEnvProperty prop) override;
+  void* __stdcall Allocate(size_t nBytes, size_t alignment, AvsAllocType) override { return aligned_malloc(nBytes, std::max(alignment, sizeof(void*))); }
+  void __stdcall Free(void* ptr) override { aligned_free(ptr); }
+
+  bool __stdcall GetVarTry(const char*, AVSValue*) const override { return false; }
+  bool __stdcall GetVarBool(const char*, bool def) const override { return def; }
+  int __stdcall GetVarInt(const char*, int def) const override { return def; }
+  double __stdcall GetVarDouble(const char*, double def) const override { return def; }
+  const char* __stdcall GetVarString(const char*, const char* def) const override { return def; }
+  int64_t __stdcall GetVarLong(const char*, int64_t def) const override { return def; }
+
+  bool __stdcall InvokeTry(AVSValue*, const char*, const AVSValue&, const char* const*) override { return false; }
+  AVSValue __stdcall Invoke2(const AVSValue&, const char*, const AVSValue, const char* const*) override { throw NotFound(); }
+  bool __stdcall Invoke2Try(AVSValue*, const AVSValue&, const char*, const AVSValue, const char* const*) override { return false; }
+  AVSValue __stdcall Invoke3(const AVSValue&, const PFunction&, const AVSValue, const char* const*) override { throw NotFound(); }
+  bool __stdcall Invoke3Try(AVSValue*, const AVSValue&, const PFunction&, const AVSValue, const char* const*) override { return false; }
+
+private:
+
+  static void prop_unset(int* error) { if (error) *error = GETPROPERROR_UNSET; }
+
+  // Function registered by the plugin, params split into arguments
+  struct Function
+  {
+    struct Arg
+    {
+      std::string name; // empty for unnamed arguments
+      char type;
+      bool array;
+    };
+    std::string name;
+    std::vector<Arg> args;
+    ApplyFunc apply;
+    void* user_data;
+  };
+
+  const Function* find_function(const char* name);
+
+  PVideoFrame make_frame(int size, int offset, int pitch, int row_size, int height,
+    int offsetU, int offsetV, int pitchUV, int row_sizeUV, int heightUV, int offsetA);
+
+  const int _cpu_flags;
+
+  std::mutex _string_mutex;
+  std::deque<std::string> _strings;
+
+  std::vector<std::pair<ShutdownFunc, void*>> _at_exit;
+
+  std::mutex _function_mutex;
+  std::deque<Function> _functions;
+};
+
+ScriptEnvironment::ScriptEnvironment(int cpu_flags)
+  : _cpu_flags(cpu_flags)
+{
+}
+
+ScriptEnvironment::~ScriptEnvironment()
+{
+  for (auto it = _at_exit.rbegin(); it != _at_exit.rend(); ++it)
+    it->first(it->second, this);
+}
+
+char* ScriptEnvironment::SaveString(const char* s, int length)
+{
+  if (s == nullptr)
+    return nullptr;
+  std::lock_guard<std::mutex> lock(_string_mutex);
+  _strings.emplace_back(s, (length < 0) ? std::strlen(s) : size_t(length));
+  return &_strings.back()[0];
+}
+
+char* ScriptEnvironment::Sprintf(const char* fmt, ...)
+{
+  va_list val;
+  va_start(val, fmt);
+  char* s = VSprintf(fmt, val);
+  va_end(val);
+  return s;
+}
+
+char* ScriptEnvironment::VSprintf(const char* fmt, va_list val)
+{
+  va_list val2;
+  va_copy(val2, val);
+  const int len = vsnprintf(nullptr, 0, fmt, val2);
+  va_end(val2);
+  if (len < 0)
+    return SaveString(fmt, -1);
+  std::vector<char> buf(size_t(len) + 1);
+  vsnprintf(buf.data(), buf.size(), fmt, val);
+  return SaveString(buf.data(), len);
+}
+
+void ScriptEnvironment::ThrowError(const char* fmt, ...)
+{
+  va_list val;
+  va_start(val, fmt);
+  const char* msg = VSprintf(fmt, val);
+  va_end(val);
+  throw AvisynthError(msg);
+}
+
+void ScriptEnvironment::AtExit(ShutdownFunc function, void* user_data)
+{
+  std::lock_guard<std::mutex> lock(_string_mutex);
+  _at_exit.emplace_back(function, user_data);
+}
+
+// params as in the core: type letters c, i, f, b, s or . (any), optionally
+// preceded by [name] and followed by * or + (array)
+void ScriptEnvironment::AddFunction(const char* name, const char* params, ApplyFunc apply, void* user_data)
+{
+  Function f;
+  f.name = name;
+  f.apply = apply;
+  f.user_data = user_data;
+  for (const char* p = params; *p != '\0'; ++p)
+  {
+    Function::Arg arg;
+    if (*p == '[')
+    {
+      const char* end = std::strchr(p, ']');
+      if (end == nullptr || end[1] == '\0')
+        ThrowError("MiniHost: %s: malformed parameter list", name);
+      arg.name.assign(p + 1, end);
+      p = end + 1;
+    }
+    arg.type = *p;
+    arg.array = (p[1] == '*' || p[1] == '+');
+    if (arg.array)
+      ++p;
+    f.args.push_back(arg);
+  }
+
+  std::lock_guard<std::mutex> lock(_function_mutex);
+  _functions.push_back(f);
+}
+
+const ScriptEnvironment::Function* ScriptEnvironment::find_function(const char* name)
+{
+  std::lock_guard<std::mutex> lock(_function_mutex);
+  for (auto it = _functions.rbegin(); it != _functions.rend(); ++it)
+  {
+    if (strcasecmp_ascii(it->name.c_str(), name) == 0)
+      return &*it;
+  }
+  return nullptr;
+}
+
+// Unnamed arguments fill the parameters in order, named ones go to the
+// parameter of the same name. Values are not converted.
+AVSValue ScriptEnvironment::Invoke(const char* name, const AVSValue args, const char* const* arg_names)
+{
+  const Function* f = find_function(name);
+  if (f == nullptr)
+    throw NotFound();
+
+  std::vector<AVSValue> slots(f->args.size());
+  const int nbr_args = args.IsArray() ? args.ArraySize() : 1;
+  size_t pos = 0;
+  for (int i = 0; i < nbr_args; ++i)
+  {
+    const AVSValue& val = args.IsArray() ? args[i] : args;
+    size_t index = pos;
+    if (arg_names != nullptr && arg_names[i] != nullptr)
+    {
+      for (index = 0; index < f->args.size(); ++index)
+      {
+        if (strcasecmp_ascii(f->args[index].name.c_str(), arg_names[i]) == 0)
+          break;
+      }
+      if (index == f->args.size())
+        ThrowError("MiniHost: %s does not have a named argument \"%s\"", f->name.c_str(), arg_names[i]);
+    }
+    else if (pos++ >= f->args.size())
+      ThrowError("MiniHost: too many arguments for %s", f->name.c_str());
+
+    slots[index] = (f->args[index].array && !val.IsArray()) ? AVSValue(&val, 1) : val;
+  }
+
+  for (size_t index = 0; index < f->args.size(); ++index)
+  {
+    if (f->args[index].name.empty() && !slots[index].Defined())
+      ThrowError("MiniHost: %s: argument %d is missing", f->name.c_str(), int(index) + 1);
+  }
+
+  return f->apply(AVSValue(slots.data(), int(slots.size())), f->user_data, this);
+}
+
+void ScriptEnvironment::CheckVersion(int version)
+{
+  // Interface v6 (Avisynth+ without frame properties)
+  if (version > 6)
+    ThrowError("MiniHost: interface version %d not supported", version);
+}
+
+PVideoFrame ScriptEnvironment::make_frame(int size, int offset, int pitch, int row_size, int height,
+  int offsetU, int offsetV, int pitchUV, int row_sizeUV, int heightUV, int offsetA)
+{
+  // Margin lets SIMD code read a little past the last row, as in the core
+  VideoFrameBuffer* vfb = new VideoFrameBuffer(size, FRAME_ALIGN * 4, nullptr);
+  VideoFrame* vf = (offsetA >= 0)
+    ? new VideoFrame(vfb, nullptr, offset, pitch, row_size, height, offsetU, offsetV, pitchUV, row_sizeUV, heightUV, offsetA)
+    : new VideoFrame(vfb, nullptr, offset, pitch, row_size, height, offsetU, offsetV, pitchUV, row_sizeUV, heightUV);
+  return PVideoFrame(vf);
+}
+
+PVideoFrame ScriptEnvironment::NewVideoFrame(const VideoInfo& vi, int align)
+{
+  align = std::max(align, int(FRAME_ALIGN));
+  const int row_size = vi.BytesFromPixels(vi.width);
+  const int pitch = align_up(row_size, align);
+  const int height = vi.height;
+  const int size_y = pitch * height;
+
+  if (!vi.IsPlanar() || vi.IsY())
+    return make_frame(size_y, 0, pitch, row_size, height, 0, 0, 0, 0, 0, -1);
+
+  int row_sizeUV = row_size;
+  int heightUV = height;
+  if (!vi.IsPlanarRGB() && !vi.IsPlanarRGBA())
+  {
+    row_sizeUV = row_size >> vi.GetPlaneWidthSubsampling(PLANAR_U);
+    heightUV = height >> vi.GetPlaneHeightSubsampling(PLANAR_U);
+  }
+  const int pitchUV = align_up(row_sizeUV, align);
+  const int size_uv = pitchUV * heightUV;
+  const bool alpha = vi.IsYUVA() || vi.IsPlanarRGBA();
+
+  const int offsetU = size_y;
+  const int offsetV = offsetU + size_uv;
+  const int offsetA = alpha ? offsetV + size_uv : -1;
+  const int size = size_y + 2 * size_uv + (alpha ? size_y : 0);
+  return make_frame(size, 0, pitch, row_size, height, offsetU, offsetV, pitchUV, row_sizeUV, heightUV, offsetA);
+}
+
+bool ScriptEnvironment::MakeWritable(PVideoFrame* pvf)
+{
+  const VideoFrame* src = (*pvf).operator->();
+  if (src->IsWritable())
+    return false;
+  const VideoFrameBuffer* vfb = src->vfb;
+  PVideoFrame dst = make_frame(vfb->data_size, src->offset, src->pitch, src->row_size, src->height,
+    src->offsetU, src->offsetV, src->pitchUV, src->row_sizeUV, src->heightUV,
+    src->pitchA ? src->offsetA : -1);
+  std::memcpy(dst->vfb->data, vfb->data, size_t(vfb->data_size));
+  *pvf = dst;
+  return true;
+}
+
+void ScriptEnvironment::BitBlt(BYTE* dstp, int dst_pitch, const BYTE* srcp, int src_pitch, int row_size, int height)
+{
+  if (height <= 0 || row_size <= 0)
+    return;
+  if (height == 1 || (dst_pitch == src_pitch && src_pitch == row_size))
+  {
+    std::memcpy(dstp, srcp, size_t(src_pitch) * (height - 1) + row_size);
+    return;
+  }
+  for (int y = 0; y < height; ++y)
+  {
+    std::memcpy(dstp, srcp, size_t(row_size));
+    dstp += dst_pitch;
+    srcp += src_pitch;
+  }
+}
+
+PVideoFrame ScriptEnvironment::Subframe(PVideoFrame src, int rel_offset, int new_pitch, int new_row_size, int new_height)
+{
+  return PVideoFrame(new VideoFrame(src->vfb, nullptr, src->offset + rel_offset, new_pitch, new_row_size, new_height));
+}
+
+PVideoFrame ScriptEnvironment::SubframePlanar(PVideoFrame src, int rel_offset, int new_pitch, int new_row_size,
+  int new_height, int rel_offsetU, int rel_offsetV, int new_pitchUV)
+{
+  const VideoFrame* s = src.operator->();
+  const int wsub = (s->row_size && s->row_sizeUV) ? s->row_size / s->row_sizeUV : 1;
+  const int hsub = (s->height && s->heightUV) ? s->height / s->heightUV : 1;
+  return PVideoFrame(new VideoFrame(s->vfb, nullptr, s->offset + rel_offset, new_pitch, new_row_size, new_height,
+    s->offsetU + rel_offsetU, s->offsetV + rel_offsetV, new_pitchUV, new_row_size / wsub, new_height / hsub));
+}
+
+PVideoFrame ScriptEnvironment::SubframePlanarA(PVideoFrame src, int rel_offset, int new_pitch, int new_row_size,
+  int new_height, int rel_offsetU, int rel_offsetV, int new_pitchUV, int rel_offsetA)
+{
+  const VideoFrame* s = src.operator->();
+  const int wsub = (s->row_size && s->row_sizeUV) ? s->row_size / s->row_sizeUV : 1;
+  const int hsub = (s->height && s->heightUV) ? s->height / s->heightUV : 1;
+  return PVideoFrame(new VideoFrame(s->vfb, nullptr, s->offset + rel_offset, new_pitch, new_row_size, new_height,
+    s->offsetU + rel_offsetU, s->offsetV + rel_offsetV, new_pitchUV, new_row_size / wsub, new_height / hsub,
+    s->offsetA + rel_offsetA));
+}
+
+size_t ScriptEnvironment::GetEnvProperty(AvsEnvProperty prop)
+{
+  switch (prop)
+  {
+  case AEP_PHYSICAL_CPUS:
+  case AEP_LOGICAL_CPUS:
+    return std::max(1u, std::thread::hardware_concurrency());
+  case AEP_THREADPOOL_THREADS:
+  case AEP_FILTERCHAIN_THREADS:
+    return 1;
+  case AEP_VERSION:
+    return 6;
+  case AEP_FRAME_ALIGN:
+  case AEP_PLANE_ALIGN:
+    return FRAME_ALIGN;
+  default:
+    return 0;
+  }
+}
+
+
+
+/**********************************************************************/
+
+namespace minihost
+{
+
+const AVS_Linkage* get_linkage()
+{
+  static const AVS_Linkage linkage = []()
+  {
+    AVS_Linkage l = {};
+    l.Size = sizeof(AVS_Linkage);
+
+    l.HasVideo = &VideoInfo::HasVideo;
+    l.HasAudio = &VideoInfo::HasAudio;
+    l.IsRGB = &VideoInfo::IsRGB;
+    l.IsRGB24 = &VideoInfo::IsRGB24;
+    l.IsRGB32 = &VideoInfo::IsRGB32;
+    l.IsYUV = &VideoInfo::IsYUV;
+    l.IsYUY2 = &VideoInfo::IsYUY2;
+    l.IsYV24 = &VideoInfo::IsYV24;
+    l.IsYV16 = &VideoInfo::IsYV16;
+    l.IsYV12 = &VideoInfo::IsYV12;
+    l.IsYV411 = &VideoInfo::IsYV411;
+    l.IsY8 = &VideoInfo::IsY8;
+    l.IsColorSpace = &VideoInfo::IsColorSpace;
+    l.Is = &VideoInfo::Is;
+    l.IsPlanar = &VideoInfo::IsPlanar;
+    l.IsFieldBased = &VideoInfo::IsFieldBased;
+    l.IsParityKnown = &VideoInfo::IsParityKnown;
+    l.IsBFF = &VideoInfo::IsBFF;
+    l.IsTFF = &VideoInfo::IsTFF;
+    l.IsVPlaneFirst = &VideoInfo::IsVPlaneFirst;
+    l.BytesFromPixels = &VideoInfo::BytesFromPixels;
+    l.RowSize = &VideoInfo::RowSize;
+    l.BMPSize = &VideoInfo::BMPSize;
+    l.AudioSamplesFromFrames = &VideoInfo::AudioSamplesFromFrames;
+    l.FramesFromAudioSamples = &VideoInfo::FramesFromAudioSamples;
+    l.AudioSamplesFromBytes = &VideoInfo::AudioSamplesFromBytes;
+    l.BytesFromAudioSamples = &VideoInfo::BytesFromAudioSamples;
+    l.AudioChannels = &VideoInfo::AudioChannels;
+    l.SampleType = &VideoInfo::SampleType;
+    l.IsSampleType = &VideoInfo::IsSampleType;
+    l.SamplesPerSecond = &VideoInfo::SamplesPerSecond;
+    l.BytesPerAudioSample = &VideoInfo::BytesPerAudioSample;
+    l.SetFieldBased = &VideoInfo::SetFieldBased;
+    l.Set = &VideoInfo::Set;
+    l.Clear = &VideoInfo::Clear;
+    l.GetPlaneWidthSubsampling = &VideoInfo::GetPlaneWidthSubsampling;
+    l.GetPlaneHeightSubsampling = &VideoInfo::GetPlaneHeightSubsampling;
+    l.BitsPerPixel = &VideoInfo::BitsPerPixel;
+    l.BytesPerChannelSample = &VideoInfo::BytesPerChannelSample;
+    l.SetFPS = &VideoInfo::SetFPS;
+    l.MulDivFPS = &VideoInfo::MulDivFPS;
+    l.IsSameColorspace = &VideoInfo::IsSameColorspace;
+
+    l.VFBGetReadPtr = &VideoFrameBuffer::GetReadPtr;
+    l.VFBGetWritePtr = &VideoFrameBuffer::GetWritePtr;
+    l.GetDataSize = &VideoFrameBuffer::GetDataSize;
+    l.GetSequenceNumber = &VideoFrameBuffer::GetSequenceNumber;
+    l.GetRefcount = &VideoFrameBuffer::GetRefcount;
+
+    l.GetPitch = &VideoFrame::GetPitch;
+    l.GetRowSize = &VideoFrame::GetRowSize;
+    l.GetHeight = &VideoFrame::GetHeight;
+    l.GetFrameBuffer = &VideoFrame::GetFrameBuffer;
+    l.GetOffset = &VideoFrame::GetOffset;
+    l.VFGetReadPtr = &VideoFrame::GetReadPtr;
+    l.IsWritable = &VideoFrame::IsWritable;
+    l.VFGetWritePtr = &VideoFrame::GetWritePtr;
+    l.VideoFrame_DESTRUCTOR = &VideoFrame::DESTRUCTOR;
+
+    l.PClip_CONSTRUCTOR0 = &PClip::CONSTRUCTOR0;
+    l.PClip_CONSTRUCTOR1 = &PClip::CONSTRUCTOR1;
+    l.PClip_CONSTRUCTOR2 = &PClip::CONSTRUCTOR2;
+    l.PClip_OPERATOR_ASSIGN0 = &PClip::OPERATOR_ASSIGN0;
+    l.PClip_OPERATOR_ASSIGN1 = &PClip::OPERATOR_ASSIGN1;
+    l.PClip_DESTRUCTOR = &PClip::DESTRUCTOR;
+
+    l.PVideoFrame_CONSTRUCTOR0 = &PVideoFrame::CONSTRUCTOR0;
+    l.PVideoFrame_CONSTRUCTOR1 = &PVideoFrame::CONSTRUCTOR1;
+    l.PVideoFrame_CONSTRUCTOR2 = &PVideoFrame::CONSTRUCTOR2;
+    l.PVideoFrame_OPERATOR_ASSIGN0 = &PVideoFrame::OPERATOR_ASSIGN0;
+    l.PVideoFrame_OPERATOR_ASSIGN1 = &PVideoFrame::OPERATOR_ASSIGN1;
+    l.PVideoFrame_DESTRUCTOR = &PVideoFrame::DESTRUCTOR;
+
+    l.AVSValue_CONSTRUCTOR0 = &AVSValue::CONSTRUCTOR0;
+    l.AVSValue_CONSTRUCTOR1 = &AVSValue::CONSTRUCTOR1;
+    l.AVSValue_CONSTRUCTOR2 = &AVSValue::CONSTRUCTOR2;
+    l.AVSValue_CONSTRUCTOR3 = &AVSValue::CONSTRUCTOR3;
+    l.AVSValue_CONSTRUCTOR4 = &AVSValue::CONSTRUCTOR4;
+    l.AVSValue_CONSTRUCTOR5 = &AVSValue::CONSTRUCTOR5;
+    l.AVSValue_CONSTRUCTOR6 = &AVSValue::CONSTRUCTOR6;
+    l.AVSValue_CONSTRUCTOR7 = &AVSValue::CONSTRUCTOR7;
+    l.AVSValue_CONSTRUCTOR8 = &AVSValue::CONSTRUCTOR8;
+    l.AVSValue_CONSTRUCTOR9 = &AVSValue::CONSTRUCTOR9;
+    l.AVSValue_DESTRUCTOR = &AVSValue::DESTRUCTOR;
+    l.AVSValue_OPERATOR_ASSIGN = &AVSValue::OPERATOR_ASSIGN;
+    l.AVSValue_OPERATOR_INDEX = &AVSValue::OPERATOR_INDEX;
+    l.Defined = &AVSValue::Defined;
+    l.IsClip = &AVSValue::IsClip;
+    l.IsBool = &AVSValue::IsBool;
+    l.IsInt = &AVSValue::IsInt;
+    l.IsFloat = &AVSValue::IsFloat;
+    l.IsString = &AVSValue::IsString;
+    l.IsArray = &AVSValue::IsArray;
+    l.AsClip = &AVSValue::AsClip;
+    l.AsBool1 = &AVSValue::AsBool1;
+    l.AsInt1 = &AVSValue::AsInt1;
+    l.AsString1 = &AVSValue::AsString1;
+    l.AsFloat1 = &AVSValue::AsFloat1;
+    l.AsBool2 = &AVSValue::AsBool2;
+    l.AsInt2 = &AVSValue::AsInt2;
+    l.AsDblDef = &AVSValue::AsDblDef;
+    l.AsFloat2 = &AVSValue::AsFloat2;
+    l.AsString2 = &AVSValue::AsString2;
+    l.ArraySize = &AVSValue::ArraySize;
+
+    l.NumComponents = &VideoInfo::NumComponents;
+    l.ComponentSize = &VideoInfo::ComponentSize;
+    l.BitsPerComponent = &VideoInfo::BitsPerComponent;
+    l.Is444 = &VideoInfo::Is444;
+    l.Is422 = &VideoInfo::Is422;
+    l.Is420 = &VideoInfo::Is420;
+    l.IsY = &VideoInfo::IsY;
+    l.IsRGB48 = &VideoInfo::IsRGB48;
+    l.IsRGB64 = &VideoInfo::IsRGB64;
+    l.IsYUVA = &VideoInfo::IsYUVA;
+    l.IsPlanarRGB = &VideoInfo::IsPlanarRGB;
+    l.IsPlanarRGBA = &VideoInfo::IsPlanarRGBA;
+
+    l.IsFunction = &AVSValue::IsFunction;
+
+    // Frame properties, PFunction and PDevice entries stay null: filters
+    // only use them after a successful CheckVersion(8).
+    return l;
+  }();
+  return &linkage;
+}
+
+int detect_cpu_flags()
+{
+  int flags = CPUF_FPU;
+#if defined(_MSC_VER) && !defined(__clang__)
+  int r1[4], r7[4];
+  __cpuid(r1, 1);
+  __cpuidex(r7, 7, 0);
+  const bool osxsave = (r1[2] & (1 << 27)) != 0;
+  const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+  const bool os_avx = (xcr0 & 0x06) == 0x06;
+  const bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+  if (r1[3] & (1 << 23)) flags |= CPUF_MMX;
+  if (r1[3] & (1 << 25)) flags |= CPUF_SSE | CPUF_INTEGER_SSE;
+  if (r1[3] & (1 << 26)) flags |= CPUF_SSE2;
+  if (r1[2] & (1 << 0)) flags |= CPUF_SSE3;
+  if (r1[2] & (1 << 9)) flags |= CPUF_SSSE3;
+  if (r1[2] & (1 << 19)) flags |= CPUF_SSE4_1;
+  if (r1[2] & (1 << 20)) flags |= CPUF_SSE4_2;
+  if (os_avx && (r1[2] & (1 << 28))) flags |= CPUF_AVX;
+  if (os_avx && (r1[2] & (1 << 12))) flags |= CPUF_FMA3;
+  if (os_avx && (r7[1] & (1 << 5))) flags |= CPUF_AVX2;
+  if (os_avx512 && (r7[1] & (1 << 16))) flags |= CPUF_AVX512F;
+  if (os_avx512 && (r7[1] & (1 << 30))) flags |= CPUF_AVX512BW;
+  if (os_avx512 && (r7[1] & (1 << 17))) flags |= CPUF_AVX512DQ;
+  if (os_avx512 && (r7[1] & (1 << 31))) flags |= CPUF_AVX512VL;
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("mmx")) flags |= CPUF_MMX;
+  if (__builtin_cpu_supports("sse")) flags |= CPUF_SSE | CPUF_INTEGER_SSE;
+  if (__builtin_cpu_supports("sse2")) flags |= CPUF_SSE2;
+  if (__builtin_cpu_supports("sse3")) flags |= CPUF_SSE3;
+  if (__builtin_cpu_supports("ssse3")) flags |= CPUF_SSSE3;
+  if (__builtin_cpu_supports("sse4.1")) flags |= CPUF_SSE4_1;
+  if (__builtin_cpu_supports("sse4.2")) flags |= CPUF_SSE4_2;
+  if (__builtin_cpu_supports("avx")) flags |= CPUF_AVX;
+  if (__builtin_cpu_supports("fma")) flags |= CPUF_FMA3;
+  if (__builtin_cpu_supports("avx2")) flags |= CPUF_AVX2;
+  if (__builtin_cpu_supports("avx512f")) flags |= CPUF_AVX512F;
+  if (__builtin_cpu_supports("avx512bw")) flags |= CPUF_AVX512BW;
+  if (__builtin_cpu_supports("avx512dq")) flags |= CPUF_AVX512DQ;
+  if (__builtin_cpu_supports("avx512vl")) flags |= CPUF_AVX512VL;
+#endif
+  return flags;
+}
+
+IScriptEnvironment* create_env(int cpu_flags)
+{
+  return new ScriptEnvironment(cpu_flags);
+}
+
+void delete_env(IScriptEnvironment* env)
+{
+  if (env)
+    env->DeleteScriptEnvironment();
+}
+
+} // namespace minihost
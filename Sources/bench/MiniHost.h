@@ -0,0 +1,54 @@
+// MVTools2 benchmark helper: minimal in-process Avisynth host
+//
+// Just enough of the Avisynth+ core (AVS_Linkage table, VideoFrame and
+// VideoFrameBuffer management, AVSValue/PClip/PVideoFrame reference counting
+// and an IScriptEnvironment) to construct the plugin filters directly and
+// pull frames from them without avisynth.dll/libavisynth.so.
+//
+// Limitations:
+//   - planar YUV/Y/RGB and packed frames only, no frame properties
+//     (CheckVersion(8) throws, so filters take their pre-v8 code paths)
+//   - functions registered with AddFunction() can be called with Invoke(),
+//     the arguments are only matched to the parameters, not converted;
+//     no script variables
+//   - frames are plain aligned allocations, there is no frame pool
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#ifndef MVTOOLS_BENCH_MINIHOST_H
+#define MVTOOLS_BENCH_MINIHOST_H
+
+class IScriptEnvironment;
+struct AVS_Linkage;
+
+namespace minihost
+{
+
+// Linkage table to be assigned to the plugin's AVS_linkage before any
+// filter is created.
+const AVS_Linkage* get_linkage();
+
+// CPUF_* flags of the running CPU, as reported by Avisynth+
+int detect_cpu_flags();
+
+// cpu_flags: value returned by GetCPUFlags(), usually detect_cpu_flags().
+// The environment is thread safe and must outlive every clip created with it.
+IScriptEnvironment* create_env(int cpu_flags);
+void delete_env(IScriptEnvironment* env);
+
+} // namespace minihost
+
+#endif
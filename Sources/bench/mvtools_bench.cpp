@@ -0,0 +1,705 @@
+// MVTools2 kernel micro-benchmark
+//
+// Standalone executable, no Avisynth host is needed: links the plugin objects
+// and calls the function selectors directly:
+//   get_sad_function, get_satd_function, get_overlaps_function,
+//   get_copy_function, get_luma_function, MDegrainN::get_denoiseN_function
+// for every block size, bit depth and arch_t supported by the running CPU.
+//
+// For each combination it reports
+//   - which implementation the selector really returned (the selectors fall
+//     back silently to a lower arch or to C when no SIMD version exists)
+//   - cycles/block (rdtsc), Mpixels/s and speedup against the C reference
+//   - bit exact cross-check against the C reference output
+//
+// Usage: mvtools_bench [-k sad|satd|overlaps|copy|luma|degrain|all]
+//                      [-b blkx]x[blky] [-d bits] [-n iterations] [-t trad] [-csv]
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "CopyCode.h"
+#include "def.h"
+#include "MDegrainN.h"
+#include "MVDegrain3.h"
+#include "overlap.h"
+#include "SADFunctions.h"
+#include "types.h"
+#include "Variance.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+
+
+namespace
+{
+
+// same block size list as in the selectors (SADFunctions.cpp, CopyCode.cpp, overlap.cpp, Variance.cpp, MDegrainN.cpp)
+const int BLOCK_SIZES[][2] = {
+  { 64, 64 }, { 64, 48 }, { 64, 32 }, { 64, 16 },
+  { 48, 64 }, { 48, 48 }, { 48, 24 }, { 48, 12 },
+  { 32, 64 }, { 32, 32 }, { 32, 24 }, { 32, 16 }, { 32, 8 },
+  { 24, 48 }, { 24, 32 }, { 24, 24 }, { 24, 12 }, { 24, 6 },
+  { 16, 64 }, { 16, 32 }, { 16, 16 }, { 16, 12 }, { 16, 8 }, { 16, 4 }, { 16, 2 }, { 16, 1 },
+  { 12, 48 }, { 12, 24 }, { 12, 16 }, { 12, 12 }, { 12, 6 }, { 12, 3 },
+  { 8, 32 }, { 8, 16 }, { 8, 8 }, { 8, 4 }, { 8, 2 }, { 8, 1 },
+  { 6, 24 }, { 6, 12 }, { 6, 6 }, { 6, 3 },
+  { 4, 8 }, { 4, 4 }, { 4, 2 }, { 4, 1 },
+  { 3, 6 }, { 3, 3 },
+  { 2, 4 }, { 2, 2 }, { 2, 1 }
+};
+
+const arch_t ARCH_LIST[] = { NO_SIMD, USE_SSE2, USE_SSE41, USE_AVX, USE_AVX2, USE_AVX512 };
+
+const char* arch_name(arch_t arch)
+{
+  switch (arch)
+  {
+  case NO_SIMD: return "C";
+  case USE_MMX: return "MMX";
+  case USE_SSE2: return "SSE2";
+  case USE_SSE41: return "SSE41";
+  case USE_SSE42: return "SSE42";
+  case USE_AVX: return "AVX";
+  case USE_AVX2: return "AVX2";
+  case USE_AVX512: return "AVX512";
+  }
+  return "?";
+}
+
+bool cpu_supports(arch_t arch)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  int r1[4], r7[4];
+  __cpuid(r1, 1);
+  __cpuidex(r7, 7, 0);
+  const bool osxsave = (r1[2] & (1 << 27)) != 0;
+  const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+  const bool os_avx = (xcr0 & 0x06) == 0x06;
+  const bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+  switch (arch)
+  {
+  case NO_SIMD: return true;
+  case USE_MMX: return (r1[3] & (1 << 23)) != 0;
+  case USE_SSE2: return (r1[3] & (1 << 26)) != 0;
+  case USE_SSE41: return (r1[2] & (1 << 19)) != 0;
+  case USE_SSE42: return (r1[2] & (1 << 20)) != 0;
+  case USE_AVX: return os_avx && (r1[2] & (1 << 28)) != 0;
+  case USE_AVX2: return os_avx && (r7[1] & (1 << 5)) != 0 && (r1[2] & (1 << 12)) != 0; // AVX2 + FMA3
+  case USE_AVX512: return os_avx512 && (r7[1] & (1 << 16)) != 0 && (r7[1] & (1 << 30)) != 0; // F + BW
+  }
+  return false;
+#else
+  __builtin_cpu_init();
+  switch (arch)
+  {
+  case NO_SIMD: return true;
+  case USE_MMX: return __builtin_cpu_supports("mmx");
+  case USE_SSE2: return __builtin_cpu_supports("sse2");
+  case USE_SSE41: return __builtin_cpu_supports("sse4.1");
+  case USE_SSE42: return __builtin_cpu_supports("sse4.2");
+  case USE_AVX: return __builtin_cpu_supports("avx");
+  case USE_AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  case USE_AVX512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+  }
+  return false;
+#endif
+}
+
+MV_FORCEINLINE uint64_t read_tsc()
+{
+  return __rdtsc();
+}
+
+// Aligned, zero initialized byte buffer
+class AlignedBuf
+{
+public:
+  explicit AlignedBuf(size_t size)
+    : _size(size)
+    , _ptr(static_cast<uint8_t*>(_aligned_malloc((size + 63) & ~size_t(63), 64)))
+  {
+    memset(_ptr, 0, _size);
+  }
+  ~AlignedBuf() { _aligned_free(_ptr); }
+  AlignedBuf(const AlignedBuf&) = delete;
+  AlignedBuf& operator = (const AlignedBuf&) = delete;
+  uint8_t* get() const { return _ptr; }
+  size_t size() const { return _size; }
+private:
+  size_t _size;
+  uint8_t* _ptr;
+};
+
+struct Options
+{
+  std::string kernel = "all";
+  int blkx = 0; // 0: all
+  int blky = 0;
+  int bits = 0; // 0: all
+  int iterations = 20000;
+  int trad = 6;
+  bool csv = false;
+};
+
+// Test planes: a large plane so that the blocks are not always served from the same cache lines.
+// Blocks are taken from NUM_POSITIONS different places, like in a real block search.
+enum { PLANE_PITCH = 4096, PLANE_HEIGHT = 128, NUM_POSITIONS = 32 };
+
+class Planes
+{
+public:
+  Planes(int bits, int num_refs, uint32_t seed)
+    : _src(PLANE_PITCH * PLANE_HEIGHT)
+  {
+    std::mt19937 rng(seed);
+    fill(_src, bits, rng, nullptr);
+    for (int i = 0; i < num_refs; i++)
+    {
+      _ref.emplace_back(new AlignedBuf(PLANE_PITCH * PLANE_HEIGHT));
+      fill(*_ref.back(), bits, rng, &_src); // refs are noisy versions of src, like real motion compensated blocks
+    }
+    for (int i = 0; i < NUM_POSITIONS; i++)
+    {
+      // keep 64-byte aligned offsets half of the time, unaligned for the other half
+      const int x = (int)((rng() % (PLANE_PITCH / 2 - 64 * 4)) & ((i & 1) ? ~0 : ~63));
+      const int y = (int)(rng() % (PLANE_HEIGHT - MAX_BLOCK_SIZE));
+      _offset[i] = y * PLANE_PITCH + x;
+    }
+  }
+  ~Planes()
+  {
+    for (auto p : _ref)
+      delete p;
+  }
+  const uint8_t* src(int pos) const { return _src.get() + _offset[pos]; }
+  const uint8_t* ref(int r, int pos) const { return _ref[r]->get() + _offset[pos]; }
+
+private:
+  static void fill(AlignedBuf& buf, int bits, std::mt19937& rng, const AlignedBuf* base)
+  {
+    const size_t size = buf.size();
+    if (bits == 32)
+    {
+      float* p = reinterpret_cast<float*>(buf.get());
+      const float* b = base ? reinterpret_cast<const float*>(base->get()) : nullptr;
+      std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+      std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+      for (size_t i = 0; i < size / sizeof(float); i++)
+        p[i] = b ? std::min(1.0f, std::max(0.0f, b[i] + noise(rng))) : dist(rng);
+    }
+    else if (bits > 8)
+    {
+      const int max_pixel_value = (1 << bits) - 1;
+      uint16_t* p = reinterpret_cast<uint16_t*>(buf.get());
+      const uint16_t* b = base ? reinterpret_cast<const uint16_t*>(base->get()) : nullptr;
+      const int noise = max_pixel_value / 16;
+      for (size_t i = 0; i < size / sizeof(uint16_t); i++)
+      {
+        int v = b ? b[i] + (int)(rng() % (2 * noise + 1)) - noise : (int)(rng() % (max_pixel_value + 1));
+        p[i] = (uint16_t)std::min(max_pixel_value, std::max(0, v));
+      }
+    }
+    else
+    {
+      uint8_t* p = buf.get();
+      const uint8_t* b = base ? base->get() : nullptr;
+      for (size_t i = 0; i < size; i++)
+      {
+        int v = b ? b[i] + (int)(rng() % 33) - 16 : (int)(rng() % 256);
+        p[i] = (uint8_t)std::min(255, std::max(0, v));
+      }
+    }
+  }
+
+  AlignedBuf _src;
+  std::vector<AlignedBuf*> _ref;
+  int _offset[NUM_POSITIONS];
+};
+
+struct Timing
+{
+  double cycles_per_block;
+  double mpixels_per_sec;
+};
+
+// Runs fn(pos) iterations times, cycling over the block positions.
+template <typename F>
+Timing measure(int iterations, int blkx, int blky, F&& fn)
+{
+  // warm up
+  for (int i = 0; i < NUM_POSITIONS; i++)
+    fn(i);
+  const auto t0 = std::chrono::steady_clock::now();
+  const uint64_t c0 = read_tsc();
+  for (int i = 0; i < iterations; i++)
+    fn(i % NUM_POSITIONS);
+  const uint64_t c1 = read_tsc();
+  const auto t1 = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration<double>(t1 - t0).count();
+  Timing t;
+  t.cycles_per_block = (double)(c1 - c0) / iterations;
+  t.mpixels_per_sec = seconds > 0 ? (double)blkx * blky * iterations / seconds / 1e6 : 0;
+  return t;
+}
+
+// Prevents the compiler from dropping the result of pure kernels (SAD, SATD, luma)
+volatile unsigned int g_sink;
+
+class Reporter
+{
+public:
+  explicit Reporter(bool csv) : _csv(csv)
+  {
+    if (_csv)
+      printf("kernel,blkx,blky,bits,arch,resolved,cycles_per_block,mpixels_per_sec,speedup_vs_c,check\n");
+    else
+      printf("%-10s %7s %5s %-7s %-8s %12s %10s %8s  %s\n",
+        "kernel", "block", "bits", "arch", "resolved", "cycles/blk", "Mpix/s", "speedup", "check");
+  }
+
+  void row(const char* kernel, int blkx, int blky, const char* bits, arch_t arch, const char* resolved,
+    const Timing& t, double c_cycles, const char* check)
+  {
+    const double speedup = t.cycles_per_block > 0 ? c_cycles / t.cycles_per_block : 0;
+    if (_csv)
+      printf("%s,%d,%d,%s,%s,%s,%.1f,%.1f,%.2f,%s\n",
+        kernel, blkx, blky, bits, arch_name(arch), resolved, t.cycles_per_block, t.mpixels_per_sec, speedup, check);
+    else
+    {
+      char blk[16];
+      snprintf(blk, sizeof(blk), "%dx%d", blkx, blky);
+      printf("%-10s %7s %5s %-7s %-8s %12.1f %10.1f %7.2fx  %s\n",
+        kernel, blk, bits, arch_name(arch), resolved, t.cycles_per_block, t.mpixels_per_sec, speedup, check);
+    }
+    fflush(stdout);
+  }
+
+  void fallback(const char* kernel, int blkx, int blky, const char* bits, arch_t arch, const char* resolved)
+  {
+    if (_csv)
+      printf("%s,%d,%d,%s,%s,%s,,,,\n", kernel, blkx, blky, bits, arch_name(arch), resolved);
+    else
+    {
+      char blk[16];
+      snprintf(blk, sizeof(blk), "%dx%d", blkx, blky);
+      printf("%-10s %7s %5s %-7s %-8s %12s\n", kernel, blk, bits, arch_name(arch), resolved, "(fallback)");
+    }
+  }
+
+private:
+  bool _csv;
+};
+
+// Common driver: Fn is the function pointer type, get(arch) calls the selector,
+// run(fn, pos) executes the kernel once, verify(fn) returns true if it matches the C reference.
+template <typename Fn, typename Get, typename Run, typename Verify>
+void bench_kernel(Reporter& rep, const Options& opt, const char* kernel, int blkx, int blky, const char* bits,
+  Get&& get, Run&& run, Verify&& verify)
+{
+  Fn* fn_c = get(NO_SIMD);
+  if (fn_c == nullptr)
+    return; // block size/bit depth combination is not supported at all
+
+  Fn* resolved_fn[sizeof(ARCH_LIST) / sizeof(ARCH_LIST[0])] = {};
+  double c_cycles = 0;
+  for (size_t a = 0; a < sizeof(ARCH_LIST) / sizeof(ARCH_LIST[0]); a++)
+  {
+    const arch_t arch = ARCH_LIST[a];
+    if (!cpu_supports(arch))
+      continue;
+    Fn* fn = get(arch);
+    resolved_fn[a] = fn;
+    if (fn == nullptr)
+      continue;
+
+    // find the lowest arch which served the same function: that is what we really run
+    size_t resolved = a;
+    for (size_t b = 0; b < a; b++)
+    {
+      if (resolved_fn[b] == fn)
+      {
+        resolved = b;
+        break;
+      }
+    }
+    // a fallback which was already measured is only listed, not measured again
+    if (resolved != a)
+    {
+      rep.fallback(kernel, blkx, blky, bits, arch, arch_name(ARCH_LIST[resolved]));
+      continue;
+    }
+
+    const Timing t = measure(opt.iterations, blkx, blky, [&](int pos) { run(fn, pos); });
+    if (arch == NO_SIMD)
+      c_cycles = t.cycles_per_block;
+    const char* check = (fn == fn_c) ? "ref" : (verify(fn) ? "OK" : "MISMATCH");
+    rep.row(kernel, blkx, blky, bits, arch, arch_name(arch), t, c_cycles, check);
+  }
+}
+
+bool want(const Options& opt, const char* kernel)
+{
+  return opt.kernel == "all" || opt.kernel == kernel;
+}
+
+bool want_block(const Options& opt, int blkx, int blky)
+{
+  return (opt.blkx == 0 || opt.blkx == blkx) && (opt.blky == 0 || opt.blky == blky);
+}
+
+bool want_bits(const Options& opt, int bits)
+{
+  return opt.bits == 0 || opt.bits == bits;
+}
+
+void bench_sad_satd(Reporter& rep, const Options& opt, bool satd)
+{
+  const int bits_list[] = { 8, 10, 12, 14, 16 };
+  for (int bits : bits_list)
+  {
+    if (!want_bits(opt, bits))
+      continue;
+    // SATD selector is pixelsize based, only the full bit depths have meaning there
+    if (satd && bits != 8 && bits != 16)
+      continue;
+    const int pixelsize = bits == 8 ? 1 : 2;
+    const Planes planes(bits, 1, 12345);
+    char bits_str[8];
+    snprintf(bits_str, sizeof(bits_str), "%d", bits);
+    for (auto& bs : BLOCK_SIZES)
+    {
+      const int blkx = bs[0];
+      const int blky = bs[1];
+      if (!want_block(opt, blkx, blky))
+        continue;
+      auto get = [&](arch_t arch) {
+        return satd ? get_satd_function(blkx, blky, pixelsize, arch) : get_sad_function(blkx, blky, bits, arch);
+      };
+      SADFunction* fn_c = get(NO_SIMD);
+      bench_kernel<SADFunction>(rep, opt, satd ? "satd" : "sad", blkx, blky, bits_str,
+        get,
+        [&](SADFunction* fn, int pos) {
+          g_sink = fn(planes.src(pos), PLANE_PITCH, planes.ref(0, pos), PLANE_PITCH);
+        },
+        [&](SADFunction* fn) {
+          for (int pos = 0; pos < NUM_POSITIONS; pos++)
+          {
+            if (fn(planes.src(pos), PLANE_PITCH, planes.ref(0, pos), PLANE_PITCH) !=
+              fn_c(planes.src(pos), PLANE_PITCH, planes.ref(0, pos), PLANE_PITCH))
+              return false;
+          }
+          return true;
+        });
+    }
+  }
+}
+
+void bench_copy(Reporter& rep, const Options& opt)
+{
+  const int bits_list[] = { 8, 16, 32 };
+  for (int bits : bits_list)
+  {
+    if (!want_bits(opt, bits))
+      continue;
+    const int pixelsize = bits == 8 ? 1 : bits == 16 ? 2 : 4;
+    const Planes planes(bits, 0, 23456);
+    AlignedBuf dst(PLANE_PITCH * MAX_BLOCK_SIZE);
+    AlignedBuf dst_c(PLANE_PITCH * MAX_BLOCK_SIZE);
+    char bits_str[8];
+    snprintf(bits_str, sizeof(bits_str), "%d", bits);
+    for (auto& bs : BLOCK_SIZES)
+    {
+      const int blkx = bs[0];
+      const int blky = bs[1];
+      if (!want_block(opt, blkx, blky))
+        continue;
+      auto get = [&](arch_t arch) { return get_copy_function(blkx, blky, pixelsize, arch); };
+      COPYFunction* fn_c = get(NO_SIMD);
+      bench_kernel<COPYFunction>(rep, opt, "copy", blkx, blky, bits_str,
+        get,
+        [&](COPYFunction* fn, int pos) {
+          fn(dst.get(), PLANE_PITCH, planes.src(pos), PLANE_PITCH);
+        },
+        [&](COPYFunction* fn) {
+          for (int pos = 0; pos < NUM_POSITIONS; pos++)
+          {
+            memset(dst.get(), 0, dst.size());
+            memset(dst_c.get(), 0, dst_c.size());
+            fn(dst.get(), PLANE_PITCH, planes.src(pos), PLANE_PITCH);
+            fn_c(dst_c.get(), PLANE_PITCH, planes.src(pos), PLANE_PITCH);
+            if (memcmp(dst.get(), dst_c.get(), dst.size()) != 0)
+              return false;
+          }
+          return true;
+        });
+    }
+  }
+}
+
+void bench_luma(Reporter& rep, const Options& opt)
+{
+  const int bits_list[] = { 8, 16 };
+  for (int bits : bits_list)
+  {
+    if (!want_bits(opt, bits))
+      continue;
+    const int pixelsize = bits == 8 ? 1 : 2;
+    const Planes planes(bits, 0, 34567);
+    char bits_str[8];
+    snprintf(bits_str, sizeof(bits_str), "%d", bits);
+    for (auto& bs : BLOCK_SIZES)
+    {
+      const int blkx = bs[0];
+      const int blky = bs[1];
+      if (!want_block(opt, blkx, blky))
+        continue;
+      auto get = [&](arch_t arch) { return get_luma_function(blkx, blky, pixelsize, arch); };
+      LUMAFunction* fn_c = get(NO_SIMD);
+      bench_kernel<LUMAFunction>(rep, opt, "luma", blkx, blky, bits_str,
+        get,
+        [&](LUMAFunction* fn, int pos) {
+          g_sink = fn(planes.src(pos), PLANE_PITCH);
+        },
+        [&](LUMAFunction* fn) {
+          for (int pos = 0; pos < NUM_POSITIONS; pos++)
+          {
+            if (fn(planes.src(pos), PLANE_PITCH) != fn_c(planes.src(pos), PLANE_PITCH))
+              return false;
+          }
+          return true;
+        });
+    }
+  }
+}
+
+void bench_overlaps(Reporter& rep, const Options& opt)
+{
+  const int bits_list[] = { 8, 16, 32 };
+  for (int bits : bits_list)
+  {
+    if (!want_bits(opt, bits))
+      continue;
+    const int pixelsize = bits == 8 ? 1 : bits == 16 ? 2 : 4;
+    const Planes planes(bits, 0, 45678);
+    // accumulator is short for 8 bit, int for 16 bit, float for float; pitch is in accumulator elements
+    const int dst_pitch = MAX_BLOCK_SIZE * 2;
+    AlignedBuf dst(dst_pitch * MAX_BLOCK_SIZE * sizeof(float));
+    AlignedBuf dst_c(dst_pitch * MAX_BLOCK_SIZE * sizeof(float));
+    char bits_str[8];
+    snprintf(bits_str, sizeof(bits_str), "%d", bits);
+    for (auto& bs : BLOCK_SIZES)
+    {
+      const int blkx = bs[0];
+      const int blky = bs[1];
+      if (!want_block(opt, blkx, blky))
+        continue;
+      // real overlap window, half block overlap when possible
+      OverlapWindows ow(blkx, blky, blkx / 2, blky / 2);
+      short* win = ow.GetWindow(4); // middle window: nonzero weights everywhere
+      if (bits == 32)
+        win = reinterpret_cast<short*>(ow.GetWindowF(4));
+      auto get = [&](arch_t arch) { return get_overlaps_function(blkx, blky, pixelsize, false, arch); };
+      OverlapsFunction* fn_c = get(NO_SIMD);
+      bench_kernel<OverlapsFunction>(rep, opt, "overlaps", blkx, blky, bits_str,
+        get,
+        [&](OverlapsFunction* fn, int pos) {
+          fn(reinterpret_cast<uint16_t*>(dst.get()), dst_pitch, planes.src(pos), PLANE_PITCH, win, blkx);
+        },
+        [&](OverlapsFunction* fn) {
+          for (int pos = 0; pos < NUM_POSITIONS; pos++)
+          {
+            memset(dst.get(), 0, dst.size());
+            memset(dst_c.get(), 0, dst_c.size());
+            fn(reinterpret_cast<uint16_t*>(dst.get()), dst_pitch, planes.src(pos), PLANE_PITCH, win, blkx);
+            fn_c(reinterpret_cast<uint16_t*>(dst_c.get()), dst_pitch, planes.src(pos), PLANE_PITCH, win, blkx);
+            if (memcmp(dst.get(), dst_c.get(), dst.size()) != 0)
+              return false;
+          }
+          return true;
+        });
+    }
+  }
+}
+
+void bench_degrain(Reporter& rep, const Options& opt)
+{
+  struct DegrainType
+  {
+    const char* name;
+    int bits;
+    bool lsb_flag;
+    bool out16_flag;
+  };
+  const DegrainType types[] = {
+    { "8", 8, false, false },
+    { "8lsb", 8, true, false },
+    { "8o16", 8, false, true },
+    { "10", 10, false, false },
+    { "16", 16, false, false },
+    { "32", 32, false, false }
+  };
+  const int trad = std::max(1, std::min((int)MDegrainN::MAX_TEMP_RAD, opt.trad));
+  const int num_refs = trad * 2;
+
+  // equal weights, sum is 1 << DEGRAIN_WEIGHT_BITS, src gets the rest
+  std::vector<int> wall(num_refs + 1);
+  const int wref = (1 << DEGRAIN_WEIGHT_BITS) / (num_refs + 1);
+  wall[0] = (1 << DEGRAIN_WEIGHT_BITS) - wref * num_refs;
+  for (int i = 1; i <= num_refs; i++)
+    wall[i] = wref;
+
+  for (auto& type : types)
+  {
+    if (!want_bits(opt, type.bits))
+      continue;
+    const Planes planes(type.bits, num_refs, 56789);
+    AlignedBuf dst(PLANE_PITCH * MAX_BLOCK_SIZE);
+    AlignedBuf dst_lsb(PLANE_PITCH * MAX_BLOCK_SIZE);
+    AlignedBuf dst_c(PLANE_PITCH * MAX_BLOCK_SIZE);
+    AlignedBuf dst_lsb_c(PLANE_PITCH * MAX_BLOCK_SIZE);
+    std::vector<int> pitch(num_refs, PLANE_PITCH);
+    std::vector<const BYTE*> refs(num_refs);
+    char bits_str[16];
+    snprintf(bits_str, sizeof(bits_str), "%s", type.name);
+
+    // the kernels advance the ref pointers in place
+    auto call = [&](MDegrainN::DenoiseNFunction* fn, BYTE* pdst, BYTE* pdst_lsb, int pos) {
+      for (int r = 0; r < num_refs; r++)
+        refs[r] = planes.ref(r, pos);
+      fn(pdst, pdst_lsb, PLANE_PITCH, planes.src(pos), PLANE_PITCH, refs.data(), pitch.data(), wall.data(), trad);
+    };
+
+    for (auto& bs : BLOCK_SIZES)
+    {
+      const int blkx = bs[0];
+      const int blky = bs[1];
+      if (!want_block(opt, blkx, blky))
+        continue;
+      auto get = [&](arch_t arch) {
+        return MDegrainN::get_denoiseN_function(blkx, blky, type.bits, type.lsb_flag, type.out16_flag, arch);
+      };
+      MDegrainN::DenoiseNFunction* fn_c = get(NO_SIMD);
+      bench_kernel<MDegrainN::DenoiseNFunction>(rep, opt, "degrainN", blkx, blky, bits_str,
+        get,
+        [&](MDegrainN::DenoiseNFunction* fn, int pos) {
+          call(fn, dst.get(), dst_lsb.get(), pos);
+        },
+        [&](MDegrainN::DenoiseNFunction* fn) {
+          for (int pos = 0; pos < NUM_POSITIONS; pos++)
+          {
+            memset(dst.get(), 0, dst.size());
+            memset(dst_c.get(), 0, dst_c.size());
+            memset(dst_lsb.get(), 0, dst_lsb.size());
+            memset(dst_lsb_c.get(), 0, dst_lsb_c.size());
+            call(fn, dst.get(), dst_lsb.get(), pos);
+            call(fn_c, dst_c.get(), dst_lsb_c.get(), pos);
+            if (memcmp(dst.get(), dst_c.get(), dst.size()) != 0 ||
+              memcmp(dst_lsb.get(), dst_lsb_c.get(), dst_lsb.size()) != 0)
+              return false;
+          }
+          return true;
+        });
+    }
+  }
+}
+
+void usage()
+{
+  printf(
+    "mvtools_bench: MVTools2 kernel micro-benchmark\n"
+    "  -k <kernel>   sad, satd, overlaps, copy, luma, degrain or all (default: all)\n"
+    "  -b <WxH>      only this block size, e.g. 16x16 (default: all)\n"
+    "  -d <bits>     only this bit depth: 8, 10, 12, 14, 16 or 32 (default: all)\n"
+    "  -n <count>    iterations per measurement (default: 20000)\n"
+    "  -t <trad>     MDegrainN temporal radius (default: 6)\n"
+    "  -csv          comma separated output\n");
+}
+
+} // namespace
+
+
+
+int main(int argc, char** argv)
+{
+  Options opt;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "-k" && has_value)
+      opt.kernel = argv[++i];
+    else if (arg == "-b" && has_value)
+    {
+      if (sscanf(argv[++i], "%dx%d", &opt.blkx, &opt.blky) != 2)
+      {
+        usage();
+        return 1;
+      }
+    }
+    else if (arg == "-d" && has_value)
+      opt.bits = atoi(argv[++i]);
+    else if (arg == "-n" && has_value)
+      opt.iterations = std::max(1, atoi(argv[++i]));
+    else if (arg == "-t" && has_value)
+      opt.trad = atoi(argv[++i]);
+    else if (arg == "-csv")
+      opt.csv = true;
+    else
+    {
+      usage();
+      return arg == "-h" || arg == "--help" ? 0 : 1;
+    }
+  }
+  if (opt.kernel == "degrainN")
+    opt.kernel = "degrain";
+
+  if (!opt.csv)
+  {
+    printf("CPU support:");
+    for (arch_t arch : ARCH_LIST)
+      printf(" %s:%s", arch_name(arch), cpu_supports(arch) ? "yes" : "no");
+    printf("\n'resolved' is the implementation really returned by the function selector, (fallback) rows are not measured again.\n\n");
+  }
+
+  Reporter rep(opt.csv);
+  if (want(opt, "sad"))
+    bench_sad_satd(rep, opt, false);
+  if (want(opt, "satd"))
+    bench_sad_satd(rep, opt, true);
+  if (want(opt, "overlaps"))
+    bench_overlaps(rep, opt);
+  if (want(opt, "copy"))
+    bench_copy(rep, opt);
+  if (want(opt, "luma"))
+    bench_luma(rep, opt);
+  if (want(opt, "degrain"))
+    bench_degrain(rep, opt);
+
+  return 0;
+}
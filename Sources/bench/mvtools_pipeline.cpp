@@ -0,0 +1,938 @@
+// MVTools2 end-to-end pipeline benchmark
+//
+// Headless runner for the usual denoising chain
+//   MSuper -> MAnalyse(multi=true, delta=tr) -> MDegrainN(tr)
+// without an Avisynth installation: the plugin registers its functions in
+// the minimal host of MiniHost.cpp, the filters are invoked by name with
+// named arguments (so script defaults apply and the argument positions
+// are taken from the registered signatures), and frames are pulled by 1..N
+// worker threads
+// the way the Avisynth+ prefetcher does:
+//   - MT_MULTI_INSTANCE filters get one instance per worker,
+//     MT_SERIALIZED filters one instance behind a mutex, others are shared
+//   - a frame cache shared by all workers sits after each stage
+//
+// Input is a synthetic panning texture with per-frame noise, or a raw planar
+// YUV/Y file (native endian, 2 bytes per sample above 8 bits, float for 32).
+// With -strips the synthetic texture moves in strips at different speeds
+// instead, so that neighbouring blocks get different vectors.
+//
+// Reported for each thread count:
+//   - output frames/s and per-frame latency percentiles (p50/p90/p99/max)
+//   - for each filter: frames computed, cache hits and self time (time spent
+//     in the filter itself, upstream stages excluded), as ms/frame and
+//     frames/s of one thread
+//   - peak RSS of the run (Linux resets the peak between runs, elsewhere
+//     it is the process peak so far)
+//
+// -seekcheck runs no benchmark: it pulls all the frames in order from one
+// chain, then in a shuffled order from a new chain, and exits with 1 if any
+// output frame differs. Seeking must not change the output.
+//
+// Usage: mvtools_pipeline [-i file.yuv] [-w width] [-h height] [-f 420|422|444|y]
+//                         [-d bits] [-n frames] [-T maxthreads|t1,t2,...]
+//                         [-blk size] [-ov overlap] [-levels levels] [-pel pel] [-search type]
+//                         [-sp searchparam] [-tr tr] [-thsad thSAD] [-batch] [-tiles]
+//                         [-strips] [-nosimd] [-csv] [-seekcheck]
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "avisynth.h"
+#include "MiniHost.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+
+// Interface.cpp
+extern "C" const char* __stdcall AvisynthPluginInit3(IScriptEnvironment* env, const AVS_Linkage* const vectors);
+
+
+
+namespace
+{
+
+// Filter registered by the plugin, args and names as in a script call
+// (names[i] == nullptr for the unnamed arguments)
+template <int N>
+AVSValue invoke(IScriptEnvironment* env, const char* name, const AVSValue (&args)[N], const char* const (&names)[N])
+{
+  return env->Invoke(name, AVSValue(args, N), names);
+}
+
+int64_t now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Worker index of the calling thread, selects the filter instance
+thread_local int tl_worker = 0;
+
+// Time spent in upstream stages during the current GetFrame() call,
+// subtracted from the caller's self time
+thread_local int64_t tl_upstream_ns = 0;
+
+
+
+struct Options
+{
+  std::string infile;
+  int width = 1280;
+  int height = 720;
+  int format = 420; // 420, 422, 444 or 0 for Y only
+  int bits = 8;
+  int frames = 100;
+  std::vector<int> threads;
+  int blksize = 8;
+  int overlap = 0;
+  int levels = 0;
+  int pel = 2;
+  int search = 4;
+  int searchparam = 2;
+  int tr = 2;
+  int thsad = 400;
+  bool nosimd = false;
+  bool batch = false;
+  bool tiles = false;
+  bool strips = false;
+  bool csv = false;
+  bool seekcheck = false;
+};
+
+int pixel_type(int format, int bits)
+{
+  static const int types[4][6] = {
+    // 8, 10, 12, 14, 16, 32 bits
+    { VideoInfo::CS_YV12, VideoInfo::CS_YUV420P10, VideoInfo::CS_YUV420P12, VideoInfo::CS_YUV420P14, VideoInfo::CS_YUV420P16, VideoInfo::CS_YUV420PS },
+    { VideoInfo::CS_YV16, VideoInfo::CS_YUV422P10, VideoInfo::CS_YUV422P12, VideoInfo::CS_YUV422P14, VideoInfo::CS_YUV422P16, VideoInfo::CS_YUV422PS },
+    { VideoInfo::CS_YV24, VideoInfo::CS_YUV444P10, VideoInfo::CS_YUV444P12, VideoInfo::CS_YUV444P14, VideoInfo::CS_YUV444P16, VideoInfo::CS_YUV444PS },
+    { VideoInfo::CS_Y8, VideoInfo::CS_Y10, VideoInfo::CS_Y12, VideoInfo::CS_Y14, VideoInfo::CS_Y16, VideoInfo::CS_Y32 }
+  };
+  const int f = (format == 420) ? 0 : (format == 422) ? 1 : (format == 444) ? 2 : 3;
+  const int b = (bits == 8) ? 0 : (bits == 32) ? 5 : (bits - 8) / 2;
+  return types[f][b];
+}
+
+const char* format_name(int format)
+{
+  return (format == 420) ? "YUV420" : (format == 422) ? "YUV422" : (format == 444) ? "YUV444" : "Y";
+}
+
+
+
+// Frame source: synthetic or raw planar file
+class SourceClip
+  : public IClip
+{
+public:
+
+  SourceClip(const Options& opt, IScriptEnvironment* env);
+  ~SourceClip() override;
+
+  PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
+  bool __stdcall GetParity(int) override { return false; }
+  void __stdcall GetAudio(void*, int64_t, int64_t, IScriptEnvironment*) override {}
+  int __stdcall SetCacheHints(int cachehints, int) override
+  {
+    return cachehints == CACHE_GET_MTMODE ? MT_NICE_FILTER : 0;
+  }
+  const VideoInfo& __stdcall GetVideoInfo() override { return _vi; }
+
+  int get_file_frames() const { return _file_frames; }
+
+private:
+
+  struct Texture
+  {
+    int w = 0;
+    int h = 0;
+    std::vector<float> data; // tileable, range 0..1
+  };
+
+  void make_texture(Texture& tex, int w, int h, uint32_t seed);
+  void render_plane(uint8_t* dst, int pitch, int plane_idx, int n) const;
+
+  VideoInfo _vi;
+  bool _strips;
+  int _nplanes;
+  int _bytes;
+  Texture _tex[3];
+
+  FILE* _file = nullptr;
+  int64_t _frame_bytes = 0;
+  int _file_frames = 0;
+  std::mutex _file_mutex;
+};
+
+const int PLANES[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
+
+SourceClip::SourceClip(const Options& opt, IScriptEnvironment* env)
+  : _vi()
+  , _strips(opt.strips)
+  , _nplanes(opt.format == 0 ? 1 : 3)
+  , _bytes(opt.bits == 8 ? 1 : opt.bits == 32 ? 4 : 2)
+{
+  _vi.width = opt.width;
+  _vi.height = opt.height;
+  _vi.pixel_type = pixel_type(opt.format, opt.bits);
+  _vi.num_frames = opt.frames;
+  _vi.SetFPS(25, 1);
+
+  if (!opt.infile.empty())
+  {
+    _file = fopen(opt.infile.c_str(), "rb");
+    if (_file == nullptr)
+      env->ThrowError("Source: cannot open %s", opt.infile.c_str());
+    for (int p = 0; p < _nplanes; ++p)
+      _frame_bytes += int64_t(_vi.width >> _vi.GetPlaneWidthSubsampling(PLANES[p]))
+        * (_vi.height >> _vi.GetPlaneHeightSubsampling(PLANES[p])) * _bytes;
+#if defined(_MSC_VER)
+    _fseeki64(_file, 0, SEEK_END);
+    const int64_t size = _ftelli64(_file);
+#else
+    fseeko(_file, 0, SEEK_END);
+    const int64_t size = ftello(_file);
+#endif
+    _file_frames = int(size / _frame_bytes);
+    if (_file_frames <= 0)
+      env->ThrowError("Source: %s is smaller than one %dx%d frame", opt.infile.c_str(), _vi.width, _vi.height);
+    _vi.num_frames = std::min(_vi.num_frames, _file_frames);
+  }
+  else
+  {
+    for (int p = 0; p < _nplanes; ++p)
+      make_texture(_tex[p],
+        _vi.width >> _vi.GetPlaneWidthSubsampling(PLANES[p]),
+        _vi.height >> _vi.GetPlaneHeightSubsampling(PLANES[p]),
+        0x1234567u * (p + 1));
+  }
+}
+
+SourceClip::~SourceClip()
+{
+  if (_file != nullptr)
+    fclose(_file);
+}
+
+// White noise smoothed by a circular box blur: tileable, so the panning
+// source has no seams and every block has a unique match.
+void SourceClip::make_texture(Texture& tex, int w, int h, uint32_t seed)
+{
+  tex.w = w;
+  tex.h = h;
+  tex.data.resize(size_t(w) * h);
+  uint32_t s = seed;
+  for (auto& v : tex.data)
+  {
+    s = s * 1664525u + 1013904223u;
+    v = float(s >> 8) / float(1 << 24);
+  }
+  const int r = 2;
+  std::vector<float> tmp(tex.data.size());
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    for (int y = 0; y < h; ++y)
+      for (int x = 0; x < w; ++x)
+      {
+        float sum = 0;
+        for (int k = -r; k <= r; ++k)
+          sum += tex.data[size_t(y) * w + (x + k + w) % w];
+        tmp[size_t(y) * w + x] = sum / (2 * r + 1);
+      }
+    for (int y = 0; y < h; ++y)
+      for (int x = 0; x < w; ++x)
+      {
+        float sum = 0;
+        for (int k = -r; k <= r; ++k)
+          sum += tmp[size_t((y + k + h) % h) * w + x];
+        tex.data[size_t(y) * w + x] = sum / (2 * r + 1);
+      }
+  }
+  // stretch the (narrow) blurred distribution back to most of the range
+  for (auto& v : tex.data)
+    v = std::min(std::max((v - 0.5f) * 6.0f + 0.5f, 0.05f), 0.95f);
+}
+
+// Pan of 4 luma samples right and 2 down per frame, plus uniform noise.
+// With -strips, each quarter of the height pans horizontally at -4, -2, 2
+// or 4 luma samples per frame, and each quarter of the width moves down by
+// 0 to 3 luma samples per frame.
+void SourceClip::render_plane(uint8_t* dst, int pitch, int plane_idx, int n) const
+{
+  static const int strip_dx[4] = { -4, -2, 2, 4 };
+  const Texture& tex = _tex[plane_idx];
+  const int plane = PLANES[plane_idx];
+  const int xsub = _vi.GetPlaneWidthSubsampling(plane);
+  const int ysub = _vi.GetPlaneHeightSubsampling(plane);
+  const int bits = _vi.BitsPerComponent();
+  const float maxval = (bits == 32) ? 1.0f : float((1 << bits) - 1);
+  const float chroma_offset = (bits == 32 && plane_idx > 0) ? 0.5f : 0.0f;
+  const float noise_amp = 0.03f;
+  uint32_t s = uint32_t(n) * 2654435761u + uint32_t(plane_idx) * 40503u + 1;
+
+  for (int y = 0; y < tex.h; ++y)
+  {
+    const int dx = (_strips ? strip_dx[y * 4 / tex.h] * n : 4 * n) / (1 << xsub);
+    for (int x = 0; x < tex.w; ++x)
+    {
+      const int dy = (_strips ? (x * 4 / tex.w) * n : 2 * n) >> ysub;
+      const int sx = ((x - dx) % tex.w + tex.w) % tex.w;
+      const int sy = ((y - dy) % tex.h + tex.h) % tex.h;
+      s ^= s << 13;
+      s ^= s >> 17;
+      s ^= s << 5;
+      const float noise = (float(s >> 8) / float(1 << 24) - 0.5f) * 2 * noise_amp;
+      const float v = std::min(std::max(tex.data[size_t(sy) * tex.w + sx] + noise, 0.0f), 1.0f);
+      if (_bytes == 1)
+        dst[x] = uint8_t(v * maxval + 0.5f);
+      else if (_bytes == 2)
+        reinterpret_cast<uint16_t*>(dst)[x] = uint16_t(v * maxval + 0.5f);
+      else
+        reinterpret_cast<float*>(dst)[x] = v - chroma_offset;
+    }
+    dst += pitch;
+  }
+}
+
+PVideoFrame SourceClip::GetFrame(int n, IScriptEnvironment* env)
+{
+  n = std::min(std::max(n, 0), _vi.num_frames - 1);
+  PVideoFrame dst = env->NewVideoFrame(_vi);
+
+  if (_file == nullptr)
+  {
+    for (int p = 0; p < _nplanes; ++p)
+      render_plane(dst->GetWritePtr(PLANES[p]), dst->GetPitch(PLANES[p]), p, n);
+    return dst;
+  }
+
+  std::lock_guard<std::mutex> lock(_file_mutex);
+#if defined(_MSC_VER)
+  _fseeki64(_file, _frame_bytes * n, SEEK_SET);
+#else
+  fseeko(_file, _frame_bytes * n, SEEK_SET);
+#endif
+  for (int p = 0; p < _nplanes; ++p)
+  {
+    uint8_t* ptr = dst->GetWritePtr(PLANES[p]);
+    const int pitch = dst->GetPitch(PLANES[p]);
+    const int row_size = dst->GetRowSize(PLANES[p]);
+    const int height = dst->GetHeight(PLANES[p]);
+    for (int y = 0; y < height; ++y, ptr += pitch)
+    {
+      if (fread(ptr, 1, row_size, _file) != size_t(row_size))
+        env->ThrowError("Source: read error in frame %d", n);
+    }
+  }
+  return dst;
+}
+
+
+
+// One pipeline stage: the filter instances, an optional frame cache shared
+// by all workers, and the timing counters.
+class StageClip
+  : public IClip
+{
+public:
+
+  StageClip(const char* name, int cache_size)
+    : _name(name), _cache_size(cache_size)
+  {
+  }
+
+  // First instance decides how many are needed, returns false when it is
+  // the only one (shared or serialized filter)
+  bool add_instance(const PClip& clip);
+
+  PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
+  bool __stdcall GetParity(int n) override { return _instances[0]->GetParity(n); }
+  void __stdcall GetAudio(void*, int64_t, int64_t, IScriptEnvironment*) override {}
+  int __stdcall SetCacheHints(int cachehints, int) override
+  {
+    return cachehints == CACHE_GET_MTMODE ? MT_NICE_FILTER : 0;
+  }
+  const VideoInfo& __stdcall GetVideoInfo() override { return _instances[0]->GetVideoInfo(); }
+
+  const char* name() const { return _name; }
+  int nbr_instances() const { return int(_instances.size()); }
+  int computed() const { return _computed; }
+  int hits() const { return _hits; }
+  double self_s() const { return double(_self_ns) * 1e-9; }
+
+private:
+
+  struct Entry
+  {
+    PVideoFrame frame;
+    bool ready = false;
+  };
+
+  PVideoFrame get_cached(int n, IScriptEnvironment* env);
+  PVideoFrame compute(int n, IScriptEnvironment* env);
+
+  const char* _name;
+  const int _cache_size;
+  std::vector<PClip> _instances;
+  bool _serialized = false;
+  std::mutex _serial_mutex;
+
+  std::mutex _cache_mutex;
+  std::condition_variable _cache_cond;
+  std::unordered_map<int, Entry> _cache;
+  std::list<int> _lru; // ready entries, oldest first
+
+  std::atomic<int> _computed{ 0 };
+  std::atomic<int> _hits{ 0 };
+  std::atomic<int64_t> _self_ns{ 0 };
+};
+
+bool StageClip::add_instance(const PClip& clip)
+{
+  _instances.push_back(clip);
+  if (_instances.size() > 1)
+    return true;
+  const int mode = clip->SetCacheHints(CACHE_GET_MTMODE, 0);
+  _serialized = (mode == MT_SERIALIZED);
+  return mode == MT_MULTI_INSTANCE;
+}
+
+PVideoFrame StageClip::GetFrame(int n, IScriptEnvironment* env)
+{
+  const int64_t t0 = now_ns();
+  PVideoFrame frame = (_cache_size > 0) ? get_cached(n, env) : compute(n, env);
+  tl_upstream_ns += now_ns() - t0;
+  return frame;
+}
+
+PVideoFrame StageClip::get_cached(int n, IScriptEnvironment* env)
+{
+  std::unique_lock<std::mutex> lock(_cache_mutex);
+  for (auto it = _cache.find(n); it != _cache.end(); it = _cache.find(n))
+  {
+    if (it->second.ready)
+    {
+      ++_hits;
+      _lru.remove(n);
+      _lru.push_back(n);
+      return it->second.frame;
+    }
+    _cache_cond.wait(lock); // being computed by another worker
+  }
+  _cache[n] = Entry();
+  lock.unlock();
+
+  PVideoFrame frame;
+  try
+  {
+    frame = compute(n, env);
+  }
+  catch (...)
+  {
+    lock.lock();
+    _cache.erase(n);
+    _cache_cond.notify_all();
+    throw;
+  }
+
+  lock.lock();
+  Entry& e = _cache[n];
+  e.frame = frame;
+  e.ready = true;
+  _lru.push_back(n);
+  while (int(_lru.size()) > _cache_size)
+  {
+    _cache.erase(_lru.front());
+    _lru.pop_front();
+  }
+  _cache_cond.notify_all();
+  return frame;
+}
+
+PVideoFrame StageClip::compute(int n, IScriptEnvironment* env)
+{
+  std::unique_lock<std::mutex> serial_lock(_serial_mutex, std::defer_lock);
+  if (_serialized)
+    serial_lock.lock();
+
+  const int64_t upstream_saved = tl_upstream_ns;
+  tl_upstream_ns = 0;
+  const int64_t t0 = now_ns();
+
+  const PClip& inst = _instances[(_instances.size() == 1) ? 0 : tl_worker];
+  PVideoFrame frame = inst->GetFrame(n, env);
+
+  _self_ns += now_ns() - t0 - tl_upstream_ns;
+  ++_computed;
+  tl_upstream_ns = upstream_saved;
+  return frame;
+}
+
+
+
+struct RunResult
+{
+  int threads = 0;
+  int frames = 0;
+  double wall_s = 0;
+  double lat_ms[4] = {}; // p50, p90, p99, max
+  double peak_rss_mb = 0;
+  std::vector<const StageClip*> stages;
+};
+
+// Linux: VmHWM can be reset, so each run gets its own peak
+void reset_peak_rss()
+{
+#if defined(__linux__)
+  FILE* f = fopen("/proc/self/clear_refs", "w");
+  if (f != nullptr)
+  {
+    fputs("5", f);
+    fclose(f);
+  }
+#endif
+}
+
+double peak_rss_mb()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    return double(pmc.PeakWorkingSetSize) / (1024.0 * 1024.0);
+  return 0;
+#else
+#if defined(__linux__)
+  FILE* f = fopen("/proc/self/status", "r");
+  if (f != nullptr)
+  {
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f) != nullptr)
+    {
+      if (std::strncmp(line, "VmHWM:", 6) == 0)
+        kb = std::strtol(line + 6, nullptr, 10);
+    }
+    fclose(f);
+    if (kb >= 0)
+      return double(kb) / 1024.0;
+  }
+#endif
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+  return double(ru.ru_maxrss) / (1024.0 * 1024.0); // bytes
+#else
+  return double(ru.ru_maxrss) / 1024.0; // kilobytes
+#endif
+#endif
+}
+
+double percentile(const std::vector<int64_t>& sorted, double p)
+{
+  if (sorted.empty())
+    return 0;
+  const size_t idx = std::min(sorted.size() - 1, size_t(p / 100.0 * double(sorted.size())));
+  return double(sorted[idx]) * 1e-6;
+}
+
+// Builds the filter chain for nthreads workers, returns the stages from
+// source to MDegrainN. The stages are kept alive in 'keep'.
+std::vector<StageClip*> build_chain(const Options& opt, IScriptEnvironment* env, int nthreads, std::vector<PClip>& keep)
+{
+  // enough for the 2*tr+1 frames window of every worker in flight
+  const int window = 2 * opt.tr + nthreads + 2;
+
+  PClip source_clip = new SourceClip(opt, env);
+
+  StageClip* source = new StageClip("source", window);
+  keep.push_back(source);
+  source->add_instance(source_clip);
+
+  StageClip* super = new StageClip("MSuper", window);
+  keep.push_back(super);
+  for (int t = 0; t < nthreads; ++t)
+  {
+    const AVSValue args[] = { PClip(source), opt.pel };
+    const char* const names[] = { nullptr, "pel" };
+    if (!super->add_instance(invoke(env, "MSuper", args, names).AsClip()))
+      break;
+  }
+
+  StageClip* analyse = new StageClip("MAnalyse", nthreads + 2);
+  keep.push_back(analyse);
+  for (int t = 0; t < nthreads; ++t)
+  {
+    const AVSValue args[] = { PClip(super), opt.blksize, opt.levels, opt.search, opt.searchparam, opt.tr, opt.overlap, true, opt.batch, opt.tiles };
+    const char* const names[] = { nullptr, "blksize", "levels", "search", "searchparam", "delta", "overlap", "multi", "batch", "tiles" };
+    if (!analyse->add_instance(invoke(env, "MAnalyse", args, names).AsClip()))
+      break;
+  }
+
+  StageClip* degrain = new StageClip("MDegrainN", 0);
+  keep.push_back(degrain);
+  for (int t = 0; t < nthreads; ++t)
+  {
+    const AVSValue args[] = { PClip(source), PClip(super), PClip(analyse), opt.tr, opt.thsad };
+    const char* const names[] = { nullptr, nullptr, nullptr, nullptr, "thSAD" };
+    if (!degrain->add_instance(invoke(env, "MDegrainN", args, names).AsClip()))
+      break;
+  }
+
+  return { source, super, analyse, degrain };
+}
+
+// Builds the filter chain for nthreads workers, pulls all frames and
+// collects the timings. The stages are kept alive in 'keep'.
+RunResult run_pipeline(const Options& opt, IScriptEnvironment* env, int nthreads, std::vector<PClip>& keep)
+{
+  RunResult res;
+  res.threads = nthreads;
+
+  const std::vector<StageClip*> stages = build_chain(opt, env, nthreads, keep);
+  StageClip* degrain = stages.back();
+  const int frames = degrain->GetVideoInfo().num_frames;
+  res.stages.assign(stages.begin(), stages.end());
+
+  std::vector<int64_t> latency(frames, 0);
+  std::atomic<int> next_frame{ 0 };
+  std::mutex error_mutex;
+  std::string error;
+
+  reset_peak_rss();
+  const int64_t t_start = now_ns();
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < nthreads; ++t)
+  {
+    workers.emplace_back([&, t]()
+    {
+      tl_worker = t;
+      tl_upstream_ns = 0;
+      try
+      {
+        for (int n = next_frame++; n < frames; n = next_frame++)
+        {
+          const int64_t t0 = now_ns();
+          PVideoFrame frame = degrain->GetFrame(n, env);
+          latency[n] = now_ns() - t0;
+        }
+      }
+      catch (const AvisynthError& e)
+      {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        error = e.msg;
+        next_frame = frames;
+      }
+    });
+  }
+  for (auto& w : workers)
+    w.join();
+
+  res.wall_s = double(now_ns() - t_start) * 1e-9;
+  res.peak_rss_mb = peak_rss_mb();
+  if (!error.empty())
+    env->ThrowError("%s", error.c_str());
+
+  res.frames = frames;
+  std::sort(latency.begin(), latency.end());
+  res.lat_ms[0] = percentile(latency, 50);
+  res.lat_ms[1] = percentile(latency, 90);
+  res.lat_ms[2] = percentile(latency, 99);
+  res.lat_ms[3] = latency.empty() ? 0 : double(latency.back()) * 1e-6;
+  return res;
+}
+
+// FNV-1a over the visible samples of all planes
+uint64_t hash_frame(const PVideoFrame& frame, const VideoInfo& vi)
+{
+  uint64_t h = 14695981039346656037ull;
+  const int nplanes = vi.IsY() ? 1 : 3;
+  for (int p = 0; p < nplanes; ++p)
+  {
+    const uint8_t* ptr = frame->GetReadPtr(PLANES[p]);
+    const int pitch = frame->GetPitch(PLANES[p]);
+    const int row_size = frame->GetRowSize(PLANES[p]);
+    const int height = frame->GetHeight(PLANES[p]);
+    for (int y = 0; y < height; ++y, ptr += pitch)
+    {
+      for (int x = 0; x < row_size; ++x)
+        h = (h ^ ptr[x]) * 1099511628211ull;
+    }
+  }
+  return h;
+}
+
+// Pulls all frames in order from one chain and in a shuffled order from a
+// new one, one worker each. Returns false if any output frame differs.
+bool seek_check(const Options& opt, IScriptEnvironment* env)
+{
+  std::vector<uint64_t> hashes[2];
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    std::vector<PClip> keep;
+    StageClip* degrain = build_chain(opt, env, 1, keep).back();
+    const VideoInfo& vi = degrain->GetVideoInfo();
+
+    std::vector<int> order(vi.num_frames);
+    for (int n = 0; n < vi.num_frames; ++n)
+      order[n] = n;
+    if (pass > 0)
+      std::shuffle(order.begin(), order.end(), std::mt19937(12345));
+
+    hashes[pass].resize(vi.num_frames);
+    for (int n : order)
+      hashes[pass][n] = hash_frame(degrain->GetFrame(n, env), vi);
+  }
+
+  int nbr_diff = 0;
+  for (int n = 0; n < int(hashes[0].size()); ++n)
+  {
+    if (hashes[0][n] != hashes[1][n])
+    {
+      printf("frame %d: %016llx in order, %016llx shuffled\n", n,
+        (unsigned long long)hashes[0][n], (unsigned long long)hashes[1][n]);
+      ++nbr_diff;
+    }
+  }
+  printf("Seek check: %d of %d frames differ\n", nbr_diff, int(hashes[0].size()));
+  return nbr_diff == 0;
+}
+
+void print_table_header()
+{
+  printf("%7s %8s %8s %8s %8s %8s %8s %10s\n",
+    "threads", "fps", "wall_s", "p50_ms", "p90_ms", "p99_ms", "max_ms", "peakRSS_MB");
+}
+
+void print_result(const RunResult& r, bool csv)
+{
+  if (csv)
+  {
+    printf("%d,pipeline,1,%d,0,%.4f,%.3f,%.2f,%.3f,%.3f,%.3f,%.3f,%.1f\n",
+      r.threads, r.frames, r.wall_s, r.wall_s * 1e3 / r.frames, r.frames / r.wall_s,
+      r.lat_ms[0], r.lat_ms[1], r.lat_ms[2], r.lat_ms[3], r.peak_rss_mb);
+    for (const StageClip* s : r.stages)
+    {
+      const int c = std::max(s->computed(), 1);
+      printf("%d,%s,%d,%d,%d,%.4f,%.3f,%.2f,,,,,\n",
+        r.threads, s->name(), s->nbr_instances(), s->computed(), s->hits(), s->self_s(),
+        s->self_s() * 1e3 / c, s->self_s() > 0 ? s->computed() / s->self_s() : 0.0);
+    }
+    return;
+  }
+
+  print_table_header();
+  printf("%7d %8.2f %8.3f %8.2f %8.2f %8.2f %8.2f %10.1f\n",
+    r.threads, r.frames / r.wall_s, r.wall_s, r.lat_ms[0], r.lat_ms[1], r.lat_ms[2], r.lat_ms[3], r.peak_rss_mb);
+  printf("        %-10s %4s %7s %7s %9s %9s %9s %6s\n",
+    "stage", "inst", "frames", "hits", "self_s", "ms/frame", "frames/s", "share");
+  double total = 0;
+  for (const StageClip* s : r.stages)
+    total += s->self_s();
+  for (const StageClip* s : r.stages)
+  {
+    const int c = std::max(s->computed(), 1);
+    printf("        %-10s %4d %7d %7d %9.3f %9.3f %9.2f %5.1f%%\n",
+      s->name(), s->nbr_instances(), s->computed(), s->hits(), s->self_s(),
+      s->self_s() * 1e3 / c, s->self_s() > 0 ? s->computed() / s->self_s() : 0.0,
+      total > 0 ? 100.0 * s->self_s() / total : 0.0);
+  }
+  printf("\n");
+}
+
+void usage()
+{
+  fprintf(stderr,
+    "Usage: mvtools_pipeline [-i file.yuv] [-w width] [-h height] [-f 420|422|444|y]\n"
+    "                        [-d 8|10|12|14|16|32] [-n frames] [-T maxthreads|t1,t2,...]\n"
+    "                        [-blk size] [-ov overlap] [-levels levels] [-pel pel] [-search type]\n"
+    "                        [-sp searchparam] [-tr tr] [-thsad thSAD] [-batch] [-tiles] [-strips]\n"
+    "                        [-nosimd] [-csv] [-seekcheck]\n"
+    "Runs MSuper -> MAnalyse(multi=true, delta=tr) -> MDegrainN(tr), other parameters\n"
+    "are the script defaults. Without -i a %dx%d synthetic panning clip is used.\n"
+    "-T N runs 1..N threads (default: number of logical CPUs, at most 8).\n"
+    "-batch sets MAnalyse(batch=true), -tiles sets MAnalyse(tiles=true).\n"
+    "-strips moves the synthetic clip in strips at different speeds instead of a pan.\n"
+    "-seekcheck compares the output frames pulled in order and in a shuffled order\n"
+    "instead of benchmarking, and fails if they differ.\n"
+    "Note: MDegrainN with tr <= 6 and thSAD2 == thSAD uses the MDegrain1..6 code path,\n"
+    "exactly as in scripts.\n",
+    Options().width, Options().height);
+}
+
+bool parse_args(int argc, char** argv, Options& opt)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string a = argv[i];
+    const bool has_val = (i + 1 < argc);
+    if (a == "-csv")
+      opt.csv = true;
+    else if (a == "-nosimd")
+      opt.nosimd = true;
+    else if (a == "-batch")
+      opt.batch = true;
+    else if (a == "-tiles")
+      opt.tiles = true;
+    else if (a == "-strips")
+      opt.strips = true;
+    else if (a == "-seekcheck")
+      opt.seekcheck = true;
+    else if (!has_val)
+      return false;
+    else if (a == "-i")
+      opt.infile = argv[++i];
+    else if (a == "-w")
+      opt.width = atoi(argv[++i]);
+    else if (a == "-h")
+      opt.height = atoi(argv[++i]);
+    else if (a == "-f")
+    {
+      const std::string f = argv[++i];
+      opt.format = (f == "y" || f == "Y") ? 0 : atoi(f.c_str());
+    }
+    else if (a == "-d")
+      opt.bits = atoi(argv[++i]);
+    else if (a == "-n")
+      opt.frames = atoi(argv[++i]);
+    else if (a == "-T")
+    {
+      const std::string t = argv[++i];
+      opt.threads.clear();
+      if (t.find(',') == std::string::npos)
+      {
+        for (int k = 1; k <= atoi(t.c_str()); ++k)
+          opt.threads.push_back(k);
+      }
+      else
+      {
+        for (size_t pos = 0; pos != std::string::npos; )
+        {
+          opt.threads.push_back(atoi(t.c_str() + pos));
+          pos = t.find(',', pos);
+          pos = (pos == std::string::npos) ? pos : pos + 1;
+        }
+      }
+    }
+    else if (a == "-blk")
+      opt.blksize = atoi(argv[++i]);
+    else if (a == "-ov")
+      opt.overlap = atoi(argv[++i]);
+    else if (a == "-levels")
+      opt.levels = atoi(argv[++i]);
+    else if (a == "-pel")
+      opt.pel = atoi(argv[++i]);
+    else if (a == "-search")
+      opt.search = atoi(argv[++i]);
+    else if (a == "-sp")
+      opt.searchparam = atoi(argv[++i]);
+    else if (a == "-tr")
+      opt.tr = atoi(argv[++i]);
+    else if (a == "-thsad")
+      opt.thsad = atoi(argv[++i]);
+    else
+      return false;
+  }
+
+  if (opt.threads.empty())
+  {
+    const int ncpu = std::max(1, std::min(int(std::thread::hardware_concurrency()), 8));
+    for (int k = 1; k <= ncpu; ++k)
+      opt.threads.push_back(k);
+  }
+  const bool bits_ok = opt.bits == 8 || opt.bits == 10 || opt.bits == 12 || opt.bits == 14 || opt.bits == 16 || opt.bits == 32;
+  const bool format_ok = opt.format == 420 || opt.format == 422 || opt.format == 444 || opt.format == 0;
+  const bool threads_ok = std::all_of(opt.threads.begin(), opt.threads.end(), [](int t) { return t > 0; });
+  return bits_ok && format_ok && threads_ok && opt.width > 0 && opt.height > 0 && opt.frames > 0 && opt.tr > 0;
+}
+
+} // namespace
+
+
+
+int main(int argc, char** argv)
+{
+  Options opt;
+  if (!parse_args(argc, argv, opt))
+  {
+    usage();
+    return 1;
+  }
+
+  IScriptEnvironment* env = minihost::create_env(opt.nosimd ? 0 : minihost::detect_cpu_flags());
+  AvisynthPluginInit3(env, minihost::get_linkage()); // sets AVS_linkage, registers the filters
+
+  int ret = 0;
+  try
+  {
+    if (opt.seekcheck)
+      ret = seek_check(opt, env) ? 0 : 1;
+    else
+    {
+      if (opt.csv)
+        printf("threads,stage,instances,frames,hits,seconds,ms_per_frame,fps,lat_p50_ms,lat_p90_ms,lat_p99_ms,lat_max_ms,peak_rss_mb\n");
+      else
+      {
+        printf("MVTools2 pipeline benchmark: %dx%d %s %d bits, %d frames, %s\n",
+          opt.width, opt.height, format_name(opt.format), opt.bits, opt.frames,
+          opt.infile.empty() ? "synthetic source" : opt.infile.c_str());
+        printf("MSuper(pel=%d) -> MAnalyse(blksize=%d, overlap=%d, levels=%d, search=%d, searchparam=%d, multi, delta=%d%s%s)"
+          " -> MDegrainN(tr=%d, thSAD=%d)%s\n\n",
+          opt.pel, opt.blksize, opt.overlap, opt.levels, opt.search, opt.searchparam, opt.tr,
+          opt.batch ? ", batch" : "", opt.tiles ? ", tiles" : "", opt.tr, opt.thsad,
+          opt.nosimd ? ", no SIMD" : "");
+      }
+
+      for (int nthreads : opt.threads)
+      {
+        std::vector<PClip> keep;
+        const RunResult r = run_pipeline(opt, env, nthreads, keep);
+        print_result(r, opt.csv);
+        fflush(stdout);
+      }
+    }
+  }
+  catch (const AvisynthError& e)
+  {
+    fprintf(stderr, "Error: %s\n", e.msg);
+    ret = 1;
+  }
+
+  minihost::delete_env(env);
+  return ret;
+}
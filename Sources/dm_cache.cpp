@@ -17,57 +17,134 @@
 
 #include "dm_cache.h"
 #include <malloc.h>
+#include <utility>
 
 DM_cache::DM_cache(int _size)
 {
-  size = _size;
-  pBuff = (DM2FRAMES*)malloc(sizeof(DM2FRAMES) * size);
+  size = (_size > 0) ? _size : 1;
+
+  // keep the load factor of the hash table <= 1/2
+  int table_size = 4;
+  while (table_size < size * 2)
+  {
+    table_size <<= 1;
+  }
+  mask = table_size - 1;
+
+  pBuff = (DM2FRAMES*)_aligned_malloc(sizeof(DM2FRAMES) * size, 64);
+  pTable = (int*)_aligned_malloc(sizeof(int) * table_size, 64);
 
   Invalidate();
 }
 
 DM_cache::~DM_cache()
 {
-  free(pBuff);
+  _aligned_free(pBuff);
+  _aligned_free(pTable);
 }
 
 void DM_cache::Invalidate(void)
 {
-  for (int i = 0; i < size; i++)
+  for (int i = 0; i <= mask; i++)
   {
-    pBuff[i].bValid = false;
+    pTable[i] = -1;
   }
+  count = 0;
+  head = 0;
 }
 
-bool DM_cache::Get(int iFr0, int iFr1, int *iDM)
+// returns the hash table slot of the pair, or the empty slot ending its probe sequence
+// iFr0 <= iFr1
+int DM_cache::FindSlot(int iFr0, int iFr1) const
+{
+  int iSlot = Hash(iFr0, iFr1);
+  while (pTable[iSlot] >= 0)
+  {
+    const DM2FRAMES& entry = pBuff[pTable[iSlot]];
+    if (entry.fr0 == iFr0 && entry.fr1 == iFr1)
+    {
+      break;
+    }
+    iSlot = (iSlot + 1) & mask;
+  }
+
+  return iSlot;
+}
+
+// removes a slot from the hash table, moving back the following entries
+// of the cluster so that no probe sequence is broken (no tombstones)
+void DM_cache::Erase(int iSlot)
 {
-  // search over all buff to find this frames pair (both forward or backward DM)
-  for (int i = 0; i < size; i++)
+  int iNext = iSlot;
+  for (;;)
   {
-    if (((pBuff[i].fr0 == iFr0) && (pBuff[i].fr1 == iFr1) || (pBuff[i].fr0 == iFr1) && (pBuff[i].fr1 == iFr0)) && pBuff[i].bValid)
+    iNext = (iNext + 1) & mask;
+    if (pTable[iNext] < 0)
+    {
+      break;
+    }
+    const DM2FRAMES& entry = pBuff[pTable[iNext]];
+    const int iHome = Hash(entry.fr0, entry.fr1);
+    // move the entry back if its home slot is not in ]iSlot, iNext]
+    if (((iNext - iHome) & mask) >= ((iNext - iSlot) & mask))
     {
-      *iDM = pBuff[i].dm;
-      return true;
+      pTable[iSlot] = pTable[iNext];
+      iSlot = iNext;
     }
   }
+  pTable[iSlot] = -1;
+}
+
+bool DM_cache::Get(int iFr0, int iFr1, int *iDM)
+{
+  // same DM for both forward or backward pair
+  if (iFr0 > iFr1)
+  {
+    std::swap(iFr0, iFr1);
+  }
+
+  const int iIdx = pTable[FindSlot(iFr0, iFr1)];
+  if (iIdx >= 0)
+  {
+    *iDM = pBuff[iIdx].dm;
+    return true;
+  }
 
   return false;
 }
 
 void DM_cache::PushNew(int iFr0, int iFr1, int iDM)
 {
-  // make shift to 1 value to the beginning of list
-  // skip first storage
-  for (int i = 0; i < size - 1; i++)
+  if (iFr0 > iFr1)
   {
-    pBuff[i] = pBuff[i + 1]; // do = opertor copy all ?
+    std::swap(iFr0, iFr1);
   }
 
-  // add to the end
-  pBuff[size - 1].fr0 = iFr0;
-  pBuff[size - 1].fr1 = iFr1;
-  pBuff[size - 1].dm = iDM;
-  pBuff[size - 1].bValid = true;
+  int iSlot = FindSlot(iFr0, iFr1);
+  if (pTable[iSlot] >= 0)
+  {
+    // already cached, refresh the value
+    pBuff[pTable[iSlot]].dm = iDM;
+    return;
+  }
 
-}
+  if (count == size)
+  {
+    // full: evict the oldest pair, stored at the head of the ring
+    const DM2FRAMES& oldest = pBuff[head];
+    Erase(FindSlot(oldest.fr0, oldest.fr1));
+    count--;
+    // erasing may have moved the probe sequence end
+    iSlot = FindSlot(iFr0, iFr1);
+  }
+
+  DM2FRAMES& entry = pBuff[head];
+  entry.fr0 = iFr0;
+  entry.fr1 = iFr1;
+  entry.dm = iDM;
+  entry.pad = 0;
+  pTable[iSlot] = head;
 
+  head = (head + 1 == size) ? 0 : head + 1;
+  count++;
+}
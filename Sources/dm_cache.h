@@ -23,20 +23,37 @@
 #define	__MV_DM_cache__
 
 #include <stdint.h>
+#include "def.h"
 #include "types.h"
 
+// Dissimilarity metric of a pair of frames, the pair is unordered:
+// fr0 <= fr1 in the stored entries. 16 bytes, 4 entries per cache line.
 struct DM2FRAMES
 {
   int fr0;
   int fr1;
   int dm; // do it enough ? may be sad_t ?
-  bool bValid;
+  int pad;
 };
 
+// Fixed capacity cache. Lookup goes through an open-addressed hash table
+// (linear probing) indexing the entries, which are stored in a ring buffer:
+// when full, a new pair evicts the oldest one.
 class DM_cache
 {
-  int size;
-  DM2FRAMES* pBuff;
+  int size;         // max number of entries
+  int count;        // valid entries
+  int head;         // ring position of the oldest entry / next insertion
+  int mask;         // hash table size - 1
+  DM2FRAMES* pBuff; // ring buffer
+  int* pTable;      // hash table of ring indexes, -1 = empty slot
+
+  MV_FORCEINLINE int Hash(int iFr0, int iFr1) const
+  {
+    return int((uint32_t(iFr0) * 0x9E3779B1u ^ uint32_t(iFr1) * 0x85EBCA77u) >> 7) & mask;
+  }
+  int FindSlot(int iFr0, int iFr1) const;
+  void Erase(int iSlot);
 
 public:
   DM_cache(int _size);
@@ -49,4 +66,3 @@ void Invalidate(void);
 };
 
 #endif	// __MV_DM_cache__
-
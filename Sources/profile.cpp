@@ -0,0 +1,244 @@
+// See legal notice in Copying.txt for more information
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
+// http://www.gnu.org/copyleft/gpl.html .
+
+#include "profile.h"
+
+#ifdef _WIN32
+#define NOGDI
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include "windows.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+
+
+std::atomic <uint64_t>	MVProfiler::_id_counter(0);
+
+static const char * const	stage_name_arr[MVPROF_COUNT] =
+{
+  "GetFrame",
+  "super load",
+  "pyramid reduce",
+  "pyramid refine",
+  "planar convert",
+  "prediction",
+  "search level 0",
+  "search level 1",
+  "search level 2",
+  "search level 3",
+  "search level 4",
+  "search level 5",
+  "search level 6",
+  "search level 7+",
+  "recalculate",
+  "degrain blend",
+  "overlap blend",
+  "nlimit",
+  "MV filter",
+  "MPB",
+  "MEL",
+  "compensation",
+  "mask",
+  "resize",
+  "flow interpolation"
+};
+
+
+
+std::unique_ptr <MVProfiler>	MVProfiler::create(const char *filter_name_0)
+{
+  const char *	env_0 = getenv("MVTOOLS_PROFILE");
+  if (env_0 == 0 || env_0[0] == '\0' || strcmp(env_0, "0") == 0)
+  {
+    return std::unique_ptr <MVProfiler>();
+  }
+
+  const std::string	dest = (strcmp(env_0, "1") == 0) ? std::string() : std::string(env_0);
+
+  return std::unique_ptr <MVProfiler>(new MVProfiler(filter_name_0, dest));
+}
+
+
+
+MVProfiler::MVProfiler(const char *filter_name_0, const std::string &dest)
+  : _filter_name(filter_name_0)
+  , _dest(dest)
+  , _id(++_id_counter)
+  , _mutex()
+  , _counters_arr()
+{
+}
+
+
+
+MVProfiler::~MVProfiler()
+{
+  const std::string	report = get_report();
+
+  if (_dest.empty())
+  {
+#ifdef _WIN32
+    OutputDebugStringA(report.c_str());
+#else
+    fputs(report.c_str(), stderr);
+#endif
+  }
+  else
+  {
+    FILE *	f_ptr = fopen(_dest.c_str(), "a");
+    if (f_ptr != 0)
+    {
+      fputs(report.c_str(), f_ptr);
+      fclose(f_ptr);
+    }
+  }
+}
+
+
+
+void	MVProfiler::add(MVProfileStage stage, int64_t dur_ns)
+{
+  ThreadCounters &	counters = use_thread_counters();
+
+  // Single writer, no need for an atomic read-modify-write
+  counters._ns[stage].store(
+    counters._ns[stage].load(std::memory_order_relaxed) + dur_ns,
+    std::memory_order_relaxed
+  );
+  counters._calls[stage].store(
+    counters._calls[stage].load(std::memory_order_relaxed) + 1,
+    std::memory_order_relaxed
+  );
+}
+
+
+
+// Each thread keeps its own (profiler id -> counters) list. The same thread
+// usually runs several filters of the chain in turn, so the list is short but
+// not reduced to a single entry. Entries of destroyed profilers are never
+// matched again, the oldest entry is dropped when the list grows too much.
+// A dropped entry of a live profiler is found again in _counters_arr by its
+// owner thread, so a thread never gets two counter sets for one profiler.
+MVProfiler::ThreadCounters &	MVProfiler::use_thread_counters()
+{
+  typedef std::pair <uint64_t, ThreadCounters *> IdCounters;
+  thread_local std::vector <IdCounters>	tl_list;
+
+  for (auto &entry : tl_list)
+  {
+    if (entry.first == _id)
+    {
+      return *entry.second;
+    }
+  }
+
+  const std::thread::id	thread_id = std::this_thread::get_id();
+  ThreadCounters *	counters_ptr = 0;
+  {
+    std::lock_guard <std::mutex>	lock(_mutex);
+    for (const auto &counters_uptr : _counters_arr)
+    {
+      if (counters_uptr->_owner == thread_id)
+      {
+        counters_ptr = counters_uptr.get();
+        break;
+      }
+    }
+    if (counters_ptr == 0)
+    {
+      counters_ptr = new ThreadCounters;
+      counters_ptr->_owner = thread_id;
+      for (int stage = 0; stage < MVPROF_COUNT; ++stage)
+      {
+        counters_ptr->_ns[stage].store(0, std::memory_order_relaxed);
+        counters_ptr->_calls[stage].store(0, std::memory_order_relaxed);
+      }
+      _counters_arr.push_back(std::unique_ptr <ThreadCounters>(counters_ptr));
+    }
+  }
+
+  if (tl_list.size() >= 256)
+  {
+    tl_list.erase(tl_list.begin());
+  }
+  tl_list.push_back(IdCounters(_id, counters_ptr));
+
+  return *counters_ptr;
+}
+
+
+
+std::string	MVProfiler::get_report() const
+{
+  int64_t	ns_arr[MVPROF_COUNT] = { 0 };
+  int64_t	calls_arr[MVPROF_COUNT] = { 0 };
+  int		nbr_threads = 0;
+  {
+    std::lock_guard <std::mutex>	lock(_mutex);
+    nbr_threads = int(_counters_arr.size());
+    for (const auto &counters_uptr : _counters_arr)
+    {
+      for (int stage = 0; stage < MVPROF_COUNT; ++stage)
+      {
+        ns_arr[stage] += counters_uptr->_ns[stage].load(std::memory_order_relaxed);
+        calls_arr[stage] += counters_uptr->_calls[stage].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  const int64_t	nbr_frames = calls_arr[MVPROF_GETFRAME];
+  const double	total_ns = double(ns_arr[MVPROF_GETFRAME]);
+
+  char	line_0[256];
+  snprintf(
+    line_0, sizeof(line_0),
+    "MVTools profile: %s #%llu, %lld frames, %d thread(s)\n",
+    _filter_name.c_str(), (unsigned long long)_id, (long long)nbr_frames,
+    nbr_threads
+  );
+  std::string	report(line_0);
+  snprintf(
+    line_0, sizeof(line_0),
+    "  %-20s %12s %12s %10s %7s\n",
+    "stage", "calls", "total ms", "ms/frame", "share"
+  );
+  report += line_0;
+
+  for (int stage = 0; stage < MVPROF_COUNT; ++stage)
+  {
+    if (calls_arr[stage] == 0)
+    {
+      continue;
+    }
+    const double	ms = double(ns_arr[stage]) * 1e-6;
+    snprintf(
+      line_0, sizeof(line_0),
+      "  %-20s %12lld %12.1f %10.3f %6.1f%%\n",
+      stage_name_arr[stage], (long long)calls_arr[stage], ms,
+      (nbr_frames > 0) ? ms / double(nbr_frames) : 0.0,
+      (total_ns > 0) ? double(ns_arr[stage]) * 100.0 / total_ns : 0.0
+    );
+    report += line_0;
+  }
+
+  return report;
+}
@@ -1,3 +1,5 @@
+// Runtime per-stage profiling of the filters
+
 // See legal notice in Copying.txt for more information
 
 // This program is free software; you can redistribute it and/or modify
@@ -19,100 +21,169 @@
 #ifndef	__MV_profile__
 #define	__MV_profile__
 
+// Enabled at runtime with the MVTOOLS_PROFILE environment variable, read when
+// a filter instance is created:
+//   MVTOOLS_PROFILE=1       breakdown sent to the debug output (stderr if not Windows)
+//   MVTOOLS_PROFILE=<file>  breakdown appended to <file>
+// Every filter instance owns its MVProfiler. Counters are kept per thread and
+// per stage without locking, they are summed and dumped when the instance is
+// destroyed. Stage times are inclusive: MVPROF_GETFRAME contains all the other
+// stages and the upstream GetFrame calls, blending contains nlimit, MPB and
+// MEL, and MEL contains the MV filtering of its blocks.
+// When disabled, the profiler pointer is null and a scope costs one test.
 
+#include "def.h"
 
-// profiling
-#define MOTION_PROFILE_ME              0
-#define MOTION_PROFILE_LUMA_VAR        1
-#define MOTION_PROFILE_COMPENSATION    2
-#define MOTION_PROFILE_INTERPOLATION   3
-#define MOTION_PROFILE_PREDICTION      4
-#define MOTION_PROFILE_2X              5
-#define MOTION_PROFILE_MASK            6
-#define MOTION_PROFILE_RESIZE          7
-#define MOTION_PROFILE_FLOWINTER       8
-#define MOTION_PROFILE_YUY2CONVERT     9
-#define MOTION_PROFILE_COUNT           10
-
-
-
-#ifdef MOTION_PROFILE
-
-
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include <emmintrin.h>
-#include	"debugprintf.h"
 
-extern int ProfTimeTable[MOTION_PROFILE_COUNT];
-extern int ProfResults[MOTION_PROFILE_COUNT * 2];
-extern int64_t ProfCumulatedResults[MOTION_PROFILE_COUNT * 2];
 
-#define PROFILE_START(x) \
-{ \
-   ProfTimeTable[x] =_rdtsc();
-}
-
-#define PROFILE_STOP(x) \
-{ \
-   ProfResults[2 * x] += _rdtsc() - ProfTimeTable[x]; \
-   ProfResults[2 * x + 1]++; \
-}
-
-inline static void PROFILE_INIT()
-{
-   for ( int i = 0; i < MOTION_PROFILE_COUNT; i++ )
-   {
-      ProfTimeTable[i]                 = 0;
-      ProfResults[2 * i]               = 0;
-      ProfResults[2 * i + 1]           = 0;
-      ProfCumulatedResults[2 * i]      = 0;
-      ProfCumulatedResults[2 * i + 1]  = 0;
-   }
-}
-inline static void PROFILE_CUMULATE()
+enum MVProfileStage
 {
-   for ( int i = 0; i < MOTION_PROFILE_COUNT; i++ )
-   {
-      ProfCumulatedResults[2 * i]     += ProfResults[2 * i];
-      ProfCumulatedResults[2 * i + 1] += ProfResults[2 * i + 1];
-      ProfResults[2 * i]     = 0;
-      ProfResults[2 * i + 1] = 0;
-   }
-}
-inline static void PROFILE_SHOW()
+  MVPROF_GETFRAME = 0,     // whole GetFrame
+  MVPROF_SUPER_LOAD,       // super frame planes to MVGroupOfFrames
+  MVPROF_SUPER_REDUCE,     // MSuper: hierarchical levels reduce and padding
+  MVPROF_SUPER_REFINE,     // MSuper: subpel planes interpolation
+  MVPROF_PLANAR_CONVERT,   // YUY2 to/from planar
+  MVPROF_PREDICTION,       // interlevel predictors and global MV
+  MVPROF_SEARCH_LEVEL,     // PlaneOfBlocks::SearchMVs, finest level,
+  MVPROF_SEARCH_LEVEL_LAST = MVPROF_SEARCH_LEVEL + 7, // coarser levels, last slot collects the rest
+  MVPROF_RECALCULATE,      // PlaneOfBlocks::RecalculateMVs
+  MVPROF_DEGRAIN_BLEND,    // degrain blending, no overlap
+  MVPROF_OVERLAP_BLEND,    // blending with overlap windows and normalisation
+  MVPROF_NLIMIT,           // nlimit, nlimitc
+  MVPROF_MV_FILTER,        // MDegrainN MV LPF and median filtering
+  MVPROF_MPB,              // multi-pass blending
+  MVPROF_MEL,              // MEL (pmode=1) blending
+  MVPROF_COMPENSATION,     // motion compensation
+  MVPROF_MASK,             // occlusion and motion masks
+  MVPROF_RESIZE,           // vector and mask fields upsizing
+  MVPROF_FLOW_INTER,       // flow interpolation
+
+  MVPROF_COUNT
+};
+
+inline MVProfileStage mvprof_search_stage(int level)
 {
-   int64_t nTotal = 0;
-   for ( int i = 0; i < MOTION_PROFILE_COUNT; i++ )
-      nTotal += ProfCumulatedResults[2*i];
-
-   DebugPrintf("ME            : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_ME] * 100.0f / (nTotal + 1));
-   DebugPrintf("LUMA & VAR    : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_LUMA_VAR] * 100.0f / (nTotal + 1));
-   DebugPrintf("COMPENSATION  : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_COMPENSATION] * 100.0f / (nTotal + 1));
-   DebugPrintf("INTERPOLATION : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_INTERPOLATION] * 100.0f / (nTotal + 1));
-   DebugPrintf("PREDICTION    : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_PREDICTION] * 100.0f / (nTotal + 1));
-   DebugPrintf("2X            : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_2X] * 100.0f / (nTotal + 1));
-   DebugPrintf("MASK          : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_MASK] * 100.0f / (nTotal + 1));
-   DebugPrintf("RESIZE        : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_RESIZE] * 100.0f / (nTotal + 1));
-   DebugPrintf("FLOWINTER     : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_FLOWINTER] * 100.0f / (nTotal + 1));
-   DebugPrintf("YUY2CONVERT     : %2.1f %%", (double)ProfCumulatedResults[2 * MOTION_PROFILE_YUY2CONVERT] * 100.0f / (nTotal + 1));
+  const int last = MVPROF_SEARCH_LEVEL_LAST - MVPROF_SEARCH_LEVEL;
+  return MVProfileStage(MVPROF_SEARCH_LEVEL + (level < last ? level : last));
 }
 
 
 
-#else	// MOTION_PROFILE
-
-
-
-#define PROFILE_START(x)
-#define PROFILE_STOP(x)
-#define PROFILE_INIT()
-#define PROFILE_CUMULATE()
-#define PROFILE_SHOW()
-
-
-
-#endif	// MOTION_PROFILE
-
-
-
-#endif	// __MV_profile__
\ No newline at end of file
+class MVProfiler
+{
+public:
+
+  // Returns 0 when profiling is not enabled
+  static std::unique_ptr <MVProfiler>
+                 create(const char *filter_name_0);
+
+                 MVProfiler(const char *filter_name_0, const std::string &dest);
+                 ~MVProfiler();
+
+  static MV_FORCEINLINE int64_t
+                 get_time_ns()
+  {
+    return std::chrono::duration_cast <std::chrono::nanoseconds> (
+      std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+  }
+
+  void           add(MVProfileStage stage, int64_t dur_ns);
+  std::string    get_report() const;
+
+private:
+
+  // Written by a single thread, read by the report
+  class alignas(64) ThreadCounters
+  {
+  public:
+    std::thread::id
+                   _owner;   // the writer, set at creation
+    std::atomic <int64_t>
+                   _ns[MVPROF_COUNT];
+    std::atomic <int64_t>
+                   _calls[MVPROF_COUNT];
+  };
+
+  ThreadCounters &
+                 use_thread_counters();
+
+  const std::string
+                 _filter_name;
+  const std::string
+                 _dest;
+  const uint64_t _id;      // unique, instance addresses may be recycled
+  mutable std::mutex
+                 _mutex;   // protects _counters_arr
+  std::vector <std::unique_ptr <ThreadCounters> >
+                 _counters_arr;
+
+  static std::atomic <uint64_t>
+                 _id_counter;
+
+private:
+
+                 MVProfiler(const MVProfiler &other) = delete;
+  MVProfiler &   operator = (const MVProfiler &other) = delete;
+};
+
+
+
+// Times the enclosing scope, or the start() - stop() intervals
+class MVProfileScope
+{
+public:
+  MV_FORCEINLINE MVProfileScope(MVProfiler *prof_ptr, MVProfileStage stage, bool start_flag = true)
+    : _prof_ptr(prof_ptr)
+    , _stage(stage)
+    , _running_flag(false)
+    , _start_ns(0)
+  {
+    if (start_flag)
+    {
+      start();
+    }
+  }
+  MV_FORCEINLINE ~MVProfileScope()
+  {
+    stop();
+  }
+  MV_FORCEINLINE void start()
+  {
+    if (_prof_ptr != 0)
+    {
+      _start_ns = MVProfiler::get_time_ns();
+      _running_flag = true;
+    }
+  }
+  MV_FORCEINLINE void stop()
+  {
+    if (_running_flag)
+    {
+      _prof_ptr->add(_stage, MVProfiler::get_time_ns() - _start_ns);
+      _running_flag = false;
+    }
+  }
+
+private:
+  MVProfiler *   _prof_ptr;
+  MVProfileStage _stage;
+  bool           _running_flag;
+  int64_t        _start_ns;
+
+  MVProfileScope(const MVProfileScope &other) = delete;
+  MVProfileScope & operator = (const MVProfileScope &other) = delete;
+};
+
+
+
+#endif	// __MV_profile__